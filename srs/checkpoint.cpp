@@ -0,0 +1,342 @@
+/**
+ * @file checkpoint.cpp
+ * @brief Реализация контрольных точек процесса
+ */
+
+#include "checkpoint.h"
+#include "config.h"
+#include "rectification.h"
+#include "distillation.h"
+#include "temp_sensors.h"
+#include "telemetry.h"
+#include "fs_gate.h"
+#include <LittleFS.h>
+#include <rom/crc.h>
+
+// Сигнатура слота контрольной точки
+#define CHECKPOINT_MAGIC 0x434B5031  // "CKP1"
+
+// Размер CRC-защищенной части слота
+#define CHECKPOINT_CRC_SIZE offsetof(ProcessCheckpoint, crc)
+
+// Прерванный процесс, ожидающий решения
+static ProcessCheckpoint pendingCheckpoint;
+static bool checkpointPending = false;
+
+// Состояние кольца
+static bool checkpointReady = false;
+static int nextSlot = 0;
+static uint32_t nextSequence = 1;
+static unsigned long lastCheckpointTime = 0;
+static unsigned long checkpointWrites = 0;
+static unsigned long lastRestoreTime = 0;
+
+// Запись из цикла процесса и остановка процесса из веб-сервера: выбор слота,
+// порядкового номера и запись выполняются под одной блокировкой
+static SemaphoreHandle_t checkpointMutex = NULL;
+
+static void lockCheckpoint() {
+    if (checkpointMutex != NULL) {
+        xSemaphoreTake(checkpointMutex, portMAX_DELAY);
+    }
+}
+
+static void unlockCheckpoint() {
+    if (checkpointMutex != NULL) {
+        xSemaphoreGive(checkpointMutex);
+    }
+}
+
+// Проверка целостности слота
+static bool isCheckpointValid(const ProcessCheckpoint& cp) {
+    return cp.magic == CHECKPOINT_MAGIC &&
+           cp.crc == crc32_le(0, (const uint8_t*)&cp, CHECKPOINT_CRC_SIZE);
+}
+
+// Запись контрольной точки в очередной слот кольца (под lockCheckpoint())
+static bool writeCheckpoint(ProcessCheckpoint& cp) {
+    if (!checkpointReady) {
+        return false;
+    }
+
+    cp.magic = CHECKPOINT_MAGIC;
+    cp.sequence = nextSequence;
+    cp.crc = crc32_le(0, (const uint8_t*)&cp, CHECKPOINT_CRC_SIZE);
+
+    // Во время записи образа файловой системы контрольная точка не пишется
+    if (!beginFileAccess()) {
+        return false;
+    }
+    File file = LittleFS.open(CHECKPOINT_FILE, "r+");
+    if (!file) {
+        endFileAccess();
+        Serial.println("Ошибка открытия файла контрольных точек");
+        return false;
+    }
+
+    bool ok = file.seek(nextSlot * sizeof(ProcessCheckpoint)) &&
+              file.write((const uint8_t*)&cp, sizeof(cp)) == sizeof(cp);
+    file.close();
+    endFileAccess();
+
+    if (!ok) {
+        Serial.println("Ошибка записи контрольной точки");
+        return false;
+    }
+
+    nextSlot = (nextSlot + 1) % CHECKPOINT_SLOTS;
+    nextSequence++;
+    checkpointWrites++;
+    lastCheckpointTime = millis();
+    return true;
+}
+
+// Создание файла кольца нужного размера
+static bool createCheckpointFile() {
+    File file = LittleFS.open(CHECKPOINT_FILE, "w");
+    if (!file) {
+        return false;
+    }
+
+    ProcessCheckpoint empty;
+    memset(&empty, 0, sizeof(empty));
+    for (int i = 0; i < CHECKPOINT_SLOTS; i++) {
+        if (file.write((const uint8_t*)&empty, sizeof(empty)) != sizeof(empty)) {
+            file.close();
+            return false;
+        }
+    }
+    file.close();
+    return true;
+}
+
+// Инициализация контрольных точек
+bool initCheckpoint() {
+    if (checkpointMutex == NULL) {
+        checkpointMutex = xSemaphoreCreateMutex();
+    }
+
+    if (!LittleFS.begin(true)) {
+        Serial.println("Ошибка монтирования LittleFS для контрольных точек");
+        return false;
+    }
+
+    File file = LittleFS.open(CHECKPOINT_FILE, "r");
+    if (!file || file.size() != CHECKPOINT_SLOTS * sizeof(ProcessCheckpoint)) {
+        if (file) {
+            file.close();
+        }
+        if (!createCheckpointFile()) {
+            Serial.println("Ошибка создания файла контрольных точек");
+            return false;
+        }
+        checkpointReady = true;
+        Serial.println("Создан файл контрольных точек");
+        return true;
+    }
+
+    // Ищем слот с наибольшим порядковым номером
+    int latestSlot = -1;
+    ProcessCheckpoint cp;
+    for (int i = 0; i < CHECKPOINT_SLOTS; i++) {
+        if (file.read((uint8_t*)&cp, sizeof(cp)) != sizeof(cp)) {
+            break;
+        }
+        if (!isCheckpointValid(cp)) {
+            continue;
+        }
+        if (latestSlot < 0 || cp.sequence > pendingCheckpoint.sequence) {
+            pendingCheckpoint = cp;
+            latestSlot = i;
+        }
+    }
+    file.close();
+
+    checkpointReady = true;
+
+    if (latestSlot < 0) {
+        return true;
+    }
+
+    nextSlot = (latestSlot + 1) % CHECKPOINT_SLOTS;
+    nextSequence = pendingCheckpoint.sequence + 1;
+    checkpointPending = (pendingCheckpoint.process != CHECKPOINT_NONE);
+
+    if (checkpointPending) {
+        Serial.print("Найден прерванный процесс: ");
+        Serial.print(pendingCheckpoint.process == CHECKPOINT_RECTIFICATION ? "ректификация" : "дистилляция");
+        Serial.print(", фаза ");
+        Serial.print(pendingCheckpoint.phase);
+        Serial.print(", время работы ");
+        Serial.print(pendingCheckpoint.uptime);
+        Serial.println(" с");
+    }
+
+    return true;
+}
+
+// Сохранение контрольной точки запущенного процесса
+void saveCheckpoint() {
+    ProcessCheckpoint cp;
+    memset(&cp, 0, sizeof(cp));
+
+    // Состояние процесса читается под блокировкой: процесс, остановленный
+    // до нее, не записывается, а остановленный после нее запишет отметку
+    // clearCheckpoint() с большим порядковым номером
+    lockCheckpoint();
+
+    if (isRectificationRunning()) {
+        cp.process = CHECKPOINT_RECTIFICATION;
+        fillRectificationCheckpoint(cp);
+    } else if (isDistillationRunning()) {
+        cp.process = CHECKPOINT_DISTILLATION;
+        fillDistillationCheckpoint(cp);
+    } else {
+        unlockCheckpoint();
+        return;
+    }
+
+    // Завершенный процесс уже отмечен clearCheckpoint()
+    if (cp.process == CHECKPOINT_RECTIFICATION ? cp.phase >= RECT_PHASE_COMPLETED
+                                               : cp.phase >= DIST_PHASE_COMPLETED) {
+        unlockCheckpoint();
+        return;
+    }
+
+    // Новый процесс заменяет прерванный
+    checkpointPending = false;
+    writeCheckpoint(cp);
+    unlockCheckpoint();
+}
+
+// Периодическое сохранение
+void updateCheckpoint() {
+    if (millis() - lastCheckpointTime >= CHECKPOINT_INTERVAL_SEC * 1000UL) {
+        saveCheckpoint();
+    }
+}
+
+// Запись отметки об остановке процесса
+void clearCheckpoint() {
+    ProcessCheckpoint cp;
+    memset(&cp, 0, sizeof(cp));
+    cp.process = CHECKPOINT_NONE;
+
+    lockCheckpoint();
+    checkpointPending = false;
+    writeCheckpoint(cp);
+    unlockCheckpoint();
+}
+
+// Проверка наличия процесса, ожидающего решения
+bool hasPendingCheckpoint() {
+    return checkpointPending;
+}
+
+// Получение контрольной точки прерванного процесса
+const ProcessCheckpoint& getPendingCheckpoint() {
+    return pendingCheckpoint;
+}
+
+// Оценка возможности продолжения по текущим температурам
+CheckpointDecision evaluateCheckpoint() {
+    if (!checkpointPending) {
+        return CHECKPOINT_DECISION_NONE;
+    }
+
+    if (!isSensorConnected(TEMP_CUBE)) {
+        return CHECKPOINT_DECISION_ABORT;
+    }
+    if (pendingCheckpoint.process == CHECKPOINT_RECTIFICATION && !isSensorConnected(TEMP_REFLUX)) {
+        return CHECKPOINT_DECISION_ABORT;
+    }
+
+    float cubeTemp = getTemperature(TEMP_CUBE);
+
+    // Куб остыл: брага могла измениться, безопаснее начать процесс заново
+    if (cubeTemp < CHECKPOINT_MIN_RESUME_TEMP) {
+        return CHECKPOINT_DECISION_ABORT;
+    }
+
+    // При нагреве фаза продолжается сама собой при любой температуре
+    bool heating = pendingCheckpoint.process == CHECKPOINT_RECTIFICATION ?
+                   pendingCheckpoint.phase == RECT_PHASE_HEATING :
+                   pendingCheckpoint.phase == DIST_PHASE_HEATING;
+    if (heating ||
+        cubeTemp >= pendingCheckpoint.cubeTemp - CHECKPOINT_MAX_TEMP_DROP) {
+        return CHECKPOINT_DECISION_RESUME;
+    }
+
+    return CHECKPOINT_DECISION_RESUME_FROM_HEATING;
+}
+
+// Продолжение прерванного процесса
+bool resumeFromCheckpoint() {
+    CheckpointDecision decision = evaluateCheckpoint();
+    if (decision != CHECKPOINT_DECISION_RESUME && decision != CHECKPOINT_DECISION_RESUME_FROM_HEATING) {
+        return false;
+    }
+
+    if (isRectificationRunning() || isDistillationRunning()) {
+        return false;
+    }
+
+    unsigned long startTime = micros();
+    bool fromHeating = (decision == CHECKPOINT_DECISION_RESUME_FROM_HEATING);
+    bool restored = false;
+
+    if (pendingCheckpoint.process == CHECKPOINT_RECTIFICATION) {
+        restored = restoreRectificationFromCheckpoint(pendingCheckpoint, fromHeating);
+    } else if (pendingCheckpoint.process == CHECKPOINT_DISTILLATION) {
+        restored = restoreDistillationFromCheckpoint(pendingCheckpoint, fromHeating);
+    }
+
+    if (!restored) {
+        return false;
+    }
+
+    checkpointPending = false;
+    resumeTelemetryRun(pendingCheckpoint.process);
+    saveCheckpoint();
+    lastRestoreTime = micros() - startTime;
+
+    Serial.print("Процесс продолжен (");
+    Serial.print(getCheckpointDecisionName(decision));
+    Serial.print("), восстановление заняло ");
+    Serial.print(lastRestoreTime);
+    Serial.println(" мкс");
+    return true;
+}
+
+// Отказ от продолжения прерванного процесса
+void discardCheckpoint() {
+    if (!checkpointPending) {
+        return;
+    }
+    clearCheckpoint();
+    Serial.println("Прерванный процесс отменен");
+}
+
+// Получение имени решения о продолжении
+const char* getCheckpointDecisionName(CheckpointDecision decision) {
+    switch (decision) {
+        case CHECKPOINT_DECISION_RESUME:
+            return "resume";
+        case CHECKPOINT_DECISION_RESUME_FROM_HEATING:
+            return "resumeFromHeating";
+        case CHECKPOINT_DECISION_ABORT:
+            return "abort";
+        default:
+            return "none";
+    }
+}
+
+// Получение времени восстановления последнего продолжения процесса
+unsigned long getCheckpointRestoreTime() {
+    return lastRestoreTime;
+}
+
+// Получение количества записей контрольных точек
+unsigned long getCheckpointWriteCount() {
+    return checkpointWrites;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file checkpoint.h
+ * @brief Контрольные точки процесса и продолжение после сбоя питания
+ *
+ * Состояние запущенного процесса (фаза, время, объемы отбора, состояние
+ * орошения) периодически и при каждой смене фазы записывается в кольцо
+ * слотов фиксированного размера в файле на LittleFS. Каждый слот имеет
+ * порядковый номер и CRC, поэтому прерванная запись портит только один
+ * слот, а предыдущая контрольная точка остается действительной.
+ *
+ * После перезагрузки последняя действительная контрольная точка
+ * сверяется с текущими температурами, и оператор выбирает продолжение
+ * процесса или отказ от него.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <Arduino.h>
+
+// Файл кольца контрольных точек
+#define CHECKPOINT_FILE "/checkpoint.bin"
+
+// Тип процесса в контрольной точке
+enum CheckpointProcess {
+    CHECKPOINT_NONE = 0,             // Процесс не запущен
+    CHECKPOINT_RECTIFICATION,        // Ректификация
+    CHECKPOINT_DISTILLATION          // Дистилляция
+};
+
+// Решение о продолжении процесса
+enum CheckpointDecision {
+    CHECKPOINT_DECISION_NONE = 0,    // Нет сохраненного процесса
+    CHECKPOINT_DECISION_RESUME,      // Продолжить с сохраненной фазы
+    CHECKPOINT_DECISION_RESUME_FROM_HEATING, // Куб остыл: нагрев заново с сохранением объемов
+    CHECKPOINT_DECISION_ABORT        // Продолжение небезопасно
+};
+
+// Флаги состояния в контрольной точке
+#define CHECKPOINT_FLAG_PAUSED       0x01  // Процесс на паузе
+#define CHECKPOINT_FLAG_REFLUX       0x02  // Орошение включено
+#define CHECKPOINT_FLAG_HEADS_MODE   0x04  // Отбор голов (дистилляция)
+#define CHECKPOINT_FLAG_BODY_STOPPED 0x08  // Отбор тела остановлен (режим "старт-стоп")
+
+// Контрольная точка процесса (один слот кольца)
+struct ProcessCheckpoint {
+    uint32_t magic;            // Сигнатура слота
+    uint32_t sequence;         // Порядковый номер записи
+    uint8_t process;           // Тип процесса (CheckpointProcess)
+    uint8_t phase;             // Фаза процесса
+    uint8_t flags;             // Флаги состояния (CHECKPOINT_FLAG_*)
+    uint8_t reserved;
+    uint32_t uptime;           // Время работы процесса (секунды)
+    uint32_t phaseTime;        // Время работы фазы (секунды)
+    int32_t volumes[3];        // Объемы: головы/тело/хвосты или головы/продукт (мл)
+    float cubeTemp;            // Температура куба на момент записи
+    float refluxTemp;          // Температура узла отбора на момент записи
+    float bodyFlowRate;        // Текущая скорость отбора тела
+    float lockedBodyTemp;      // Зафиксированная температура тела
+    uint16_t startStopCount;   // Количество остановок отбора тела
+    uint16_t reserved2;
+    uint32_t crc;              // CRC32 всех предыдущих полей
+};
+
+/**
+ * @brief Инициализация контрольных точек
+ *
+ * Подготавливает файл кольца и находит последнюю действительную
+ * контрольную точку. Если в ней записан запущенный процесс, он
+ * становится ожидающим решения оператора.
+ *
+ * @return true если инициализация прошла успешно
+ */
+bool initCheckpoint();
+
+/**
+ * @brief Сохранение контрольной точки запущенного процесса
+ */
+void saveCheckpoint();
+
+/**
+ * @brief Периодическое сохранение, вызывается в цикле обработки процесса
+ *
+ * Записывает контрольную точку раз в CHECKPOINT_INTERVAL_SEC секунд.
+ */
+void updateCheckpoint();
+
+/**
+ * @brief Запись отметки об остановке процесса
+ *
+ * Вызывается при остановке или завершении процесса, чтобы после
+ * перезагрузки он не предлагался к продолжению.
+ */
+void clearCheckpoint();
+
+/**
+ * @brief Проверка наличия процесса, ожидающего решения о продолжении
+ *
+ * @return true если найден прерванный процесс
+ */
+bool hasPendingCheckpoint();
+
+/**
+ * @brief Получение контрольной точки прерванного процесса
+ *
+ * @return const ProcessCheckpoint& Контрольная точка
+ */
+const ProcessCheckpoint& getPendingCheckpoint();
+
+/**
+ * @brief Оценка возможности продолжения по текущим температурам
+ *
+ * @return CheckpointDecision Рекомендуемое решение
+ */
+CheckpointDecision evaluateCheckpoint();
+
+/**
+ * @brief Продолжение прерванного процесса
+ *
+ * Выполняет решение, рассчитанное evaluateCheckpoint().
+ *
+ * @return true если процесс продолжен
+ */
+bool resumeFromCheckpoint();
+
+/**
+ * @brief Отказ от продолжения прерванного процесса
+ */
+void discardCheckpoint();
+
+/**
+ * @brief Получение имени решения о продолжении
+ *
+ * @param decision Решение
+ * @return const char* Имя решения
+ */
+const char* getCheckpointDecisionName(CheckpointDecision decision);
+
+/**
+ * @brief Получение времени восстановления последнего продолжения процесса
+ *
+ * @return Время от команды продолжения до записи новой контрольной точки (мкс)
+ */
+unsigned long getCheckpointRestoreTime();
+
+/**
+ * @brief Получение количества записей контрольных точек с момента загрузки
+ *
+ * @return Количество записей
+ */
+unsigned long getCheckpointWriteCount();
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,200 @@
+/**
+ * @file column_monitor.cpp
+ * @brief Реализация статистического анализа температур колонны
+ */
+
+#include "column_monitor.h"
+#include <math.h>
+
+// Отсчет температур
+struct ColumnSample {
+    unsigned long time;                      // Время отсчета (мс)
+    float values[COLUMN_CHANNEL_COUNT];      // Температуры по каналам (NAN - нет данных)
+};
+
+// Кольцевой буфер отсчетов
+static ColumnSample samples[COLUMN_MONITOR_MAX_SAMPLES];
+static int sampleHead = 0;      // Индекс следующей записи
+static int sampleCount = 0;     // Количество отсчетов в буфере
+static unsigned long lastSampleTime = 0;
+
+// Максимальная длина окна, которую вмещает буфер (мс)
+static const unsigned long maxWindowMs =
+    (unsigned long)(COLUMN_MONITOR_MAX_SAMPLES - 1) * COLUMN_MONITOR_SAMPLE_INTERVAL;
+
+// Ограничение длины окна емкостью буфера
+static unsigned long windowToMs(unsigned long windowSec) {
+    unsigned long windowMs = windowSec * 1000UL;
+    return windowMs > maxWindowMs ? maxWindowMs : windowMs;
+}
+
+// Получение отсчета по индексу от самого нового (0 - последний)
+static const ColumnSample& sampleFromNewest(int i) {
+    int index = sampleHead - 1 - i;
+    if (index < 0) {
+        index += COLUMN_MONITOR_MAX_SAMPLES;
+    }
+    return samples[index];
+}
+
+// Сброс накопленной выборки
+void resetColumnMonitor() {
+    sampleHead = 0;
+    sampleCount = 0;
+    lastSampleTime = 0;
+}
+
+// Добавление отсчета температур
+void updateColumnMonitor(float refluxTemp, float columnTemp) {
+    unsigned long now = millis();
+    if (sampleCount > 0 && now - lastSampleTime < COLUMN_MONITOR_SAMPLE_INTERVAL) {
+        return;
+    }
+    lastSampleTime = now;
+
+    ColumnSample& sample = samples[sampleHead];
+    sample.time = now;
+    sample.values[COLUMN_CHANNEL_REFLUX] = refluxTemp;
+    sample.values[COLUMN_CHANNEL_COLUMN] = columnTemp;
+
+    sampleHead = (sampleHead + 1) % COLUMN_MONITOR_MAX_SAMPLES;
+    if (sampleCount < COLUMN_MONITOR_MAX_SAMPLES) {
+        sampleCount++;
+    }
+}
+
+// Расчет статистики канала за последние windowSec секунд
+ColumnChannelStats getColumnChannelStats(ColumnChannel channel, unsigned long windowSec) {
+    ColumnChannelStats stats = { false, 0, 0.0f, 0.0f, 0.0f };
+    if (sampleCount == 0) {
+        return stats;
+    }
+
+    unsigned long windowMs = windowToMs(windowSec);
+    unsigned long newestTime = sampleFromNewest(0).time;
+
+    // Первый проход: средние значения времени и температуры
+    float sumX = 0.0f;
+    float sumY = 0.0f;
+    int n = 0;
+    for (int i = 0; i < sampleCount; i++) {
+        const ColumnSample& sample = sampleFromNewest(i);
+        if (newestTime - sample.time > windowMs) {
+            break;
+        }
+        float value = sample.values[channel];
+        if (isnan(value)) {
+            continue;
+        }
+        // Время в минутах относительно последнего отсчета
+        sumX -= (newestTime - sample.time) / 60000.0f;
+        sumY += value;
+        n++;
+    }
+
+    stats.samples = n;
+    if (n < 3) {
+        return stats;
+    }
+
+    float meanX = sumX / n;
+    float meanY = sumY / n;
+
+    // Второй проход: центрированные суммы для дисперсии и наклона
+    float sxx = 0.0f;
+    float sxy = 0.0f;
+    float syy = 0.0f;
+    for (int i = 0; i < sampleCount; i++) {
+        const ColumnSample& sample = sampleFromNewest(i);
+        if (newestTime - sample.time > windowMs) {
+            break;
+        }
+        float value = sample.values[channel];
+        if (isnan(value)) {
+            continue;
+        }
+        float dx = -(float)(newestTime - sample.time) / 60000.0f - meanX;
+        float dy = value - meanY;
+        sxx += dx * dx;
+        sxy += dx * dy;
+        syy += dy * dy;
+    }
+
+    stats.valid = true;
+    stats.mean = meanY;
+    stats.stdDev = sqrtf(syy / n);
+    stats.slope = (sxx > 0.0f) ? sxy / sxx : 0.0f;
+    return stats;
+}
+
+// Проверка, заполнено ли окно заданной длины
+bool isColumnWindowFilled(unsigned long windowSec) {
+    if (sampleCount < 3) {
+        return false;
+    }
+
+    unsigned long windowMs = windowToMs(windowSec);
+    unsigned long span = sampleFromNewest(0).time - sampleFromNewest(sampleCount - 1).time;
+
+    // Допускаем недобор на один интервал отсчетов
+    return span + COLUMN_MONITOR_SAMPLE_INTERVAL >= windowMs;
+}
+
+// Оценка признака: 1 при значении не выше порога, 0 при двукратном превышении
+static float thresholdScore(float value, float limit) {
+    if (limit <= 0.0f) {
+        return 0.0f;
+    }
+    float score = 2.0f - value / limit;
+    if (score > 1.0f) return 1.0f;
+    if (score < 0.0f) return 0.0f;
+    return score;
+}
+
+// Проверка стабильности колонны
+bool isColumnStable(unsigned long windowSec, float maxStdDev, float maxSlope) {
+    if (!isColumnWindowFilled(windowSec)) {
+        return false;
+    }
+
+    int checkedChannels = 0;
+    for (int channel = 0; channel < COLUMN_CHANNEL_COUNT; channel++) {
+        ColumnChannelStats stats = getColumnChannelStats((ColumnChannel)channel, windowSec);
+
+        // Канал без данных (датчик не подключен) не учитываем
+        if (stats.samples == 0) {
+            continue;
+        }
+        if (!stats.valid || stats.stdDev > maxStdDev || fabsf(stats.slope) > maxSlope) {
+            return false;
+        }
+        checkedChannels++;
+    }
+
+    return checkedChannels > 0;
+}
+
+// Оценка уверенности в окончании отбора голов
+float getHeadsEndConfidence(unsigned long windowSec, float maxSlope, float maxDelta) {
+    if (!isColumnWindowFilled(windowSec)) {
+        return 0.0f;
+    }
+
+    ColumnChannelStats reflux = getColumnChannelStats(COLUMN_CHANNEL_REFLUX, windowSec);
+    if (!reflux.valid) {
+        return 0.0f;
+    }
+
+    // Выход температуры узла отбора на плато
+    float plateauScore = thresholdScore(fabsf(reflux.slope), maxSlope);
+
+    ColumnChannelStats column = getColumnChannelStats(COLUMN_CHANNEL_COLUMN, windowSec);
+    if (!column.valid) {
+        return plateauScore * 0.75f;
+    }
+
+    // Сближение температур колонны и узла отбора
+    float deltaScore = thresholdScore(fabsf(column.mean - reflux.mean), maxDelta);
+
+    return plateauScore * deltaScore;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file column_monitor.h
+ * @brief Статистический анализ температур колонны
+ *
+ * Модуль накапливает выборку температур узла отбора и колонны в скользящем
+ * окне и рассчитывает по ней среднее, стандартное отклонение и наклон
+ * (скорость изменения по методу наименьших квадратов). На основе этих
+ * величин определяется момент стабилизации колонны.
+ */
+
+#ifndef COLUMN_MONITOR_H
+#define COLUMN_MONITOR_H
+
+#include <Arduino.h>
+
+// Интервал между отсчетами в окне (мс)
+#define COLUMN_MONITOR_SAMPLE_INTERVAL 5000
+
+// Максимальное количество отсчетов в окне (10 минут при интервале 5 с)
+#define COLUMN_MONITOR_MAX_SAMPLES 120
+
+// Каналы анализа
+enum ColumnChannel {
+    COLUMN_CHANNEL_REFLUX = 0,   // Температура узла отбора
+    COLUMN_CHANNEL_COLUMN,       // Температура колонны
+    COLUMN_CHANNEL_COUNT
+};
+
+// Статистика канала в окне
+struct ColumnChannelStats {
+    bool valid;          // Статистика рассчитана (достаточно отсчетов)
+    int samples;         // Количество отсчетов в окне
+    float mean;          // Среднее значение (°C)
+    float stdDev;        // Стандартное отклонение (°C)
+    float slope;         // Наклон (°C/мин)
+};
+
+/**
+ * @brief Сброс накопленной выборки
+ */
+void resetColumnMonitor();
+
+/**
+ * @brief Добавление отсчета температур
+ *
+ * Отсчеты прореживаются до COLUMN_MONITOR_SAMPLE_INTERVAL, поэтому функцию
+ * можно вызывать в каждом цикле обработки процесса. Для отключенного
+ * датчика передается NAN.
+ *
+ * @param refluxTemp Температура узла отбора
+ * @param columnTemp Температура колонны
+ */
+void updateColumnMonitor(float refluxTemp, float columnTemp);
+
+/**
+ * @brief Расчет статистики канала за последние windowSec секунд
+ *
+ * @param channel Канал анализа
+ * @param windowSec Длина окна в секундах
+ * @return ColumnChannelStats Статистика канала
+ */
+ColumnChannelStats getColumnChannelStats(ColumnChannel channel, unsigned long windowSec);
+
+/**
+ * @brief Проверка, заполнено ли окно заданной длины
+ *
+ * @param windowSec Длина окна в секундах
+ * @return true если выборка охватывает все окно
+ */
+bool isColumnWindowFilled(unsigned long windowSec);
+
+/**
+ * @brief Проверка стабильности колонны
+ *
+ * Колонна считается стабильной, если окно заполнено и для каждого
+ * подключенного канала отклонение и модуль наклона не превышают порогов.
+ *
+ * @param windowSec Длина окна в секундах
+ * @param maxStdDev Допустимое стандартное отклонение (°C)
+ * @param maxSlope Допустимый модуль наклона (°C/мин)
+ * @return true если колонна стабильна
+ */
+bool isColumnStable(unsigned long windowSec, float maxStdDev, float maxSlope);
+
+/**
+ * @brief Оценка уверенности в окончании отбора голов
+ *
+ * Учитывает выход температуры узла отбора на плато (модуль наклона) и
+ * разность температур колонны и узла отбора. Каждый признак дает оценку
+ * от 0 до 1: 1 при значении не выше порога, 0 при двукратном превышении.
+ * Без датчика колонны оценка по плато ограничивается 0.75.
+ *
+ * @param windowSec Длина окна в секундах
+ * @param maxSlope Порог наклона температуры узла отбора (°C/мин)
+ * @param maxDelta Порог разности температур колонны и узла отбора (°C)
+ * @return float Уверенность от 0 до 1
+ */
+float getHeadsEndConfidence(unsigned long windowSec, float maxSlope, float maxDelta);
+
+#endif // COLUMN_MONITOR_H
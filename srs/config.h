@@ -49,9 +49,84 @@
 #define SAFETY_MIN_WATER_OUT_TEMP_DEFAULT 5.0f  // Мин. температура выхода воды
 #define SAFETY_MAX_WATER_OUT_TEMP_DEFAULT 50.0f // Макс. температура выхода воды
 #define SAFETY_CHECK_INTERVAL 1000              // Интервал проверки безопасности (мс)
+#define SAFETY_TASK_STACK_SIZE 4096             // Размер стека задачи безопасности
+#define SAFETY_TASK_PRIORITY (configMAX_PRIORITIES - 1) // Приоритет задачи безопасности (наивысший)
+#define SAFETY_TASK_CORE 1                      // Ядро задачи безопасности
+#define SAFETY_TASK_MAX_WAIT_MS 1000            // Максимальное ожидание нового снимка датчиков (мс)
+#define SAFETY_SNAPSHOT_TIMEOUT_MS 15000        // Допустимый возраст снимка датчиков при работе процесса (мс)
+#define SAFETY_SNAPSHOT_HYSTERESIS_S 5.0f       // Гистерезис возраста снимка датчиков (с)
+
+// Настройки контрольных точек процесса
+#define CHECKPOINT_INTERVAL_SEC 30              // Интервал сохранения контрольной точки (секунды)
+#define CHECKPOINT_SLOTS 16                     // Количество слотов в кольце контрольных точек
+#define CHECKPOINT_MAX_TEMP_DROP 5.0f           // Допустимое падение температуры куба для продолжения с той же фазы
+#define CHECKPOINT_MIN_RESUME_TEMP 40.0f        // Минимальная температура куба для продолжения процесса
+
+// Настройки журнала телеметрии процесса
+#define TELEMETRY_SAMPLE_INTERVAL 1000          // Период отсчетов полной частоты (мс)
+#define TELEMETRY_RAM_SAMPLES 900               // Отсчетов полной частоты в ОЗУ (15 минут)
+#define TELEMETRY_LOG_10S_RECORDS 2160          // Записей по 10 с в журнале на LittleFS (6 часов)
+#define TELEMETRY_LOG_60S_RECORDS 1440          // Записей по 1 мин в журнале на LittleFS (24 часа)
+#define TELEMETRY_DEFAULT_POINTS 500            // Количество точек в ответе по умолчанию
+#define TELEMETRY_MAX_POINTS 1000               // Максимальное количество точек в ответе
+#define TELEMETRY_LOG_SEGMENTS 4                // Файлов-сегментов в кольце журнала на LittleFS
+#define TELEMETRY_WRITE_QUEUE 8                 // Агрегатов в очереди записи на LittleFS
+#define TELEMETRY_TASK_STACK_SIZE 4096          // Размер стека задачи записи телеметрии
+#define TELEMETRY_TASK_PRIORITY 1               // Приоритет задачи записи телеметрии (ниже задач управления)
+#define TELEMETRY_TASK_CORE 0                   // Ядро задачи записи телеметрии
+
+// Настройки журнала событий
+#define EVENT_LOG_RING_SIZE 64                  // Записей в кольце журнала (степень двойки)
+#define EVENT_LOG_TEXT_SIZE 88                  // Размер текста записи (байт)
+#define EVENT_LOG_FILE_MAX_SIZE 65536           // Размер файла журнала до ротации (байт)
+#define EVENT_LOG_DRAIN_INTERVAL_MS 50          // Период вывода накопленных записей (мс)
+#define EVENT_LOG_TASK_STACK_SIZE 4096          // Размер стека задачи журнала
+#define EVENT_LOG_TASK_PRIORITY 1               // Приоритет задачи журнала (ниже задач управления)
+#define EVENT_LOG_TASK_CORE 0                   // Ядро задачи журнала
+
+// Пул буферов ответов JSON
+#define JSON_BUFFER_COUNT 3                     // Буферов в пуле (одновременно отправляемых ответов)
+#define JSON_BUFFER_SIZE 4096                   // Размер буфера ответа (байт)
+#define WS_RPC_DOC_SIZE 2048                    // Размер документа для разбора сообщения RPC
+#define SETTINGS_BODY_MAX_SIZE 4096             // Максимальный размер тела POST /api/settings (байт)
+#define SETTINGS_DOC_SIZE 4096                  // Размер документа для разбора настроек
+#define WS_RPC_MAX_BATCH 16                     // Максимум вызовов в одном пакете RPC
+
+// Рассылка WebSocket
+#define WS_MAX_CLIENTS 8                        // Одновременно подключенных клиентов
+#define WS_CLIENT_BUDGET_BYTES 8192             // Допустимый объем неотправленных данных клиента (байт)
+#define WS_CLIENT_STALL_MS 15000                // Время сверх бюджета до отключения клиента (мс)
+
+// Поток событий SSE (/events)
+#define SSE_SAMPLES_PER_EVENT 20                // Отсчетов телеметрии в одном событии
+#define SSE_BACKFILL_MAX_SAMPLES 120            // Отсчетов, досылаемых при переподключении
+#define SSE_MAX_PENDING 8                       // Сообщений в очереди клиента, сверх которых статус пропускается
+
+// Страница метрик Prometheus (/metrics)
+#define METRICS_BUFFER_SIZE 12288               // Размер буфера текста метрик (байт)
+
+// Мост MQTT
+#define MQTT_SAMPLES_PER_MESSAGE 20             // Отсчетов телеметрии в одном сообщении
+#define MQTT_FLUSH_MESSAGES 5                   // Сообщений телеметрии за один проход при досылке буфера
+#define MQTT_RECONNECT_MIN_MS 2000              // Начальный интервал повторного подключения (мс)
+#define MQTT_RECONNECT_MAX_MS 60000             // Наибольший интервал повторного подключения (мс)
+#define MQTT_KEEPALIVE_S 30                     // Интервал keep-alive (секунды)
+#define MQTT_COMMAND_DOC_SIZE 512               // Размер документа для разбора параметров команды
+
+// Обновление по сети (/api/ota)
+#define OTA_HEALTH_CHECK_MS 60000               // Время проверки новой прошивки до отмены отката (мс)
+#define OTA_FILE_ACCESS_TIMEOUT_MS 1000         // Ожидание окончания обращений к LittleFS перед записью ее образа (мс)
 
 // Другие константы
 #define SERIAL_BAUD_RATE 115200    // Скорость последовательного порта
 #define MAX_STRING_LENGTH 64       // Максимальная длина строк
 
+// Типы уведомлений веб-интерфейса
+enum NotificationType {
+    NOTIFY_INFO,
+    NOTIFY_SUCCESS,
+    NOTIFY_WARNING,
+    NOTIFY_ERROR
+};
+
 #endif // CONFIG_H
\ No newline at end of file
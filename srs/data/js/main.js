@@ -2,9 +2,8 @@
 let socket = null;
 const socketUrl = `ws://${window.location.host}/ws`;
 
-// Данные о температуре и мощности для графиков
+// Серии графика: данные серий строятся из кольца chartSeries при перерисовке
 let temperatureData = {
-    labels: [],
     datasets: [
         {
             label: 'Куб',
@@ -56,16 +55,117 @@ let distillationSettings = {};
 let pumpSettings = {};
 let sensorSettings = [];
 
-// Таймер для обновления данных графика
-let chartUpdateTimer = null;
+// Емкость кольца графика: 12 часов (наибольший период) при отсчете раз в секунду
+const CHART_CAPACITY = 43200;
+
+// Точек на график текущего процесса, загружаемый при открытии страницы.
+// Контроллер прореживает журнал до этого числа, дальше точки по ширине
+// графика выбирает LTTB на клиенте
+const CHART_HISTORY_POINTS = 300;
+
+// Отсчеты графика: время (мс) и значения серий в порядке temperatureData.datasets
+let chartSeries = null;
+
+// Перерисовка графика запрошена и ждет кадра
+let chartRedrawPending = false;
+
+// Время ожидания ответа на вызов RPC (мс)
+const RPC_TIMEOUT_MS = 10000;
+
+// Вызовы RPC через WebSocket: ответ сопоставляется с вызовом по id,
+// вызовы до открытия соединения ставятся в очередь
+const rpc = {
+    nextId: 1,
+    pending: new Map(),
+    queue: [],
+
+    // Вызов одного метода; возвращает Promise с результатом
+    call(method, params) {
+        const request = { id: this.nextId++, method: method, params: params || {} };
+        const promise = this.register(request.id);
+        this.send(request);
+        return promise;
+    },
+
+    // Пакет вызовов [[метод, параметры], ...] одним сообщением;
+    // возвращает Promise.allSettled по вызовам в том же порядке
+    batch(calls) {
+        const requests = calls.map(([method, params]) => ({ id: this.nextId++, method: method, params: params || {} }));
+        const promises = requests.map(request => this.register(request.id));
+        this.send(requests);
+        return Promise.allSettled(promises);
+    },
+
+    register(id) {
+        return new Promise((resolve, reject) => {
+            const timer = setTimeout(() => {
+                this.pending.delete(id);
+                reject(new Error('Нет ответа от контроллера'));
+            }, RPC_TIMEOUT_MS);
+            this.pending.set(id, { resolve, reject, timer });
+        });
+    },
+
+    send(message) {
+        if (socket && socket.readyState === WebSocket.OPEN) {
+            socket.send(JSON.stringify(message));
+        } else {
+            this.queue.push(message);
+        }
+    },
+
+    // Отправка накопленных вызовов после открытия соединения
+    flush() {
+        while (this.queue.length > 0 && socket && socket.readyState === WebSocket.OPEN) {
+            socket.send(JSON.stringify(this.queue.shift()));
+        }
+    },
+
+    // Обработка сообщения {"type":"rpc",...}
+    handle(message) {
+        if (Array.isArray(message.responses)) {
+            message.responses.forEach(response => this.complete(response));
+        } else if (message.id !== null && message.id !== undefined) {
+            this.complete(message);
+        } else if (message.error) {
+            console.error('Ошибка RPC:', message.error.message);
+        }
+    },
+
+    complete(response) {
+        const entry = this.pending.get(response.id);
+        if (!entry) {
+            return;
+        }
+        clearTimeout(entry.timer);
+        this.pending.delete(response.id);
+        if (response.error) {
+            entry.reject(new Error(response.error.message));
+        } else {
+            entry.resolve(response.result);
+        }
+    },
+
+    // Отправленные вызовы без ответа теряются при закрытии соединения
+    failAll() {
+        this.pending.forEach((entry, id) => {
+            if (!this.queue.some(message => [].concat(message).some(request => request.id === id))) {
+                clearTimeout(entry.timer);
+                entry.reject(new Error('Соединение с контроллером закрыто'));
+                this.pending.delete(id);
+            }
+        });
+    }
+};
 
 // Инициализация приложения
 document.addEventListener('DOMContentLoaded', () => {
     // Инициализация интерфейса
     setupUI();
     
-    // Инициализация графика
+    // Инициализация графика и загрузка графика текущего процесса
     initializeChart();
+    loadChartHistory();
     
     // Инициализация WebSocket
     connectWebSocket();
@@ -238,12 +338,22 @@ function setupUI() {
 // Инициализация графика температур
 function initializeChart() {
     const ctx = document.getElementById('temp-chart').getContext('2d');
+    chartSeries = new SeriesRing(CHART_CAPACITY, temperatureData.datasets.length);
     tempChart = new Chart(ctx, {
         type: 'line',
         data: temperatureData,
         options: {
             responsive: true,
             maintainAspectRatio: false,
+            // Данные уже прорежены и отсортированы по времени
+            animation: false,
+            parsing: false,
+            normalized: true,
+            elements: {
+                point: {
+                    radius: 0
+                }
+            },
             interaction: {
                 mode: 'index',
                 intersect: false,
@@ -323,17 +433,236 @@ function initializeChart() {
 // Переключение отображения серий данных
 function toggleDataset(index, visible) {
     tempChart.data.datasets[index].hidden = !visible;
-    tempChart.update();
+    scheduleChartRedraw();
 }
 
 // Обновление временного диапазона графика
 function updateChartTimeRange(minutes) {
-    const now = new Date();
-    const minTime = new Date(now.getTime() - minutes * 60000);
-    
+    scheduleChartRedraw();
+}
+
+// Кольцо отсчетов в типизированных массивах: добавление без сдвига
+// массивов, отсутствующее значение хранится как NaN
+class SeriesRing {
+    constructor(capacity, seriesCount) {
+        this.capacity = capacity;
+        this.times = new Float64Array(capacity);
+        this.values = [];
+        for (let i = 0; i < seriesCount; i++) {
+            this.values.push(new Float32Array(capacity));
+        }
+        this.start = 0;
+        this.length = 0;
+    }
+
+    // Позиция в массивах для индекса от самого старого отсчета
+    position(index) {
+        return (this.start + index) % this.capacity;
+    }
+
+    timeAt(index) {
+        return this.times[this.position(index)];
+    }
+
+    valueAt(series, index) {
+        return this.values[series][this.position(index)];
+    }
+
+    // Добавление отсчета; отсчет не новее последнего отбрасывается
+    push(time, values) {
+        if (this.length > 0 && time <= this.timeAt(this.length - 1)) {
+            return;
+        }
+        const position = this.position(this.length);
+        this.times[position] = time;
+        for (let i = 0; i < this.values.length; i++) {
+            const value = values[i];
+            this.values[i][position] = value === null || value === undefined ? NaN : value;
+        }
+        if (this.length < this.capacity) {
+            this.length++;
+        } else {
+            this.start = (this.start + 1) % this.capacity;
+        }
+    }
+
+    // Добавление более старых отсчетов перед имеющимися (загрузка истории)
+    prepend(times, rows) {
+        const count = this.length;
+        const keptTimes = new Float64Array(count);
+        const keptRows = [];
+        for (let i = 0; i < count; i++) {
+            keptTimes[i] = this.timeAt(i);
+            keptRows.push(this.values.map((series, s) => this.valueAt(s, i)));
+        }
+        this.start = 0;
+        this.length = 0;
+        for (let i = 0; i < times.length; i++) {
+            if (count === 0 || times[i] < keptTimes[0]) {
+                this.push(times[i], rows[i]);
+            }
+        }
+        for (let i = 0; i < count; i++) {
+            this.push(keptTimes[i], keptRows[i]);
+        }
+    }
+
+    // Индекс первого отсчета не старше time
+    lowerBound(time) {
+        let low = 0;
+        let high = this.length;
+        while (low < high) {
+            const middle = (low + high) >> 1;
+            if (this.timeAt(middle) < time) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+}
+
+// Прореживание серии на отрезке [from, to) методом LTTB (Largest Triangle
+// Three Buckets) до threshold точек: в каждой корзине остается точка,
+// образующая наибольший треугольник с выбранной точкой предыдущей корзины
+// и средним следующей, поэтому пики и провалы сохраняются. Корзина без
+// значений дает разрыв линии (y: null).
+function decimateSeries(ring, series, from, to, threshold) {
+    const count = to - from;
+    const points = [];
+    if (count <= threshold) {
+        for (let i = from; i < to; i++) {
+            const y = ring.valueAt(series, i);
+            points.push({ x: ring.timeAt(i), y: Number.isNaN(y) ? null : y });
+        }
+        return points;
+    }
+
+    const bucketSize = (count - 2) / (threshold - 2);
+    let selectedX = ring.timeAt(from);
+    let selectedY = ring.valueAt(series, from);
+    points.push({ x: selectedX, y: Number.isNaN(selectedY) ? null : selectedY });
+
+    for (let bucket = 0; bucket < threshold - 2; bucket++) {
+        const bucketStart = from + 1 + Math.floor(bucket * bucketSize);
+        const bucketEnd = from + 1 + Math.floor((bucket + 1) * bucketSize);
+
+        // Среднее следующей корзины (для последней - последняя точка)
+        const nextStart = bucketEnd;
+        const nextEnd = Math.min(from + 1 + Math.floor((bucket + 2) * bucketSize), to);
+        let averageX = 0;
+        let averageY = 0;
+        let averageCount = 0;
+        for (let i = nextStart; i < nextEnd; i++) {
+            const y = ring.valueAt(series, i);
+            if (!Number.isNaN(y)) {
+                averageX += ring.timeAt(i);
+                averageY += y;
+                averageCount++;
+            }
+        }
+        if (averageCount > 0) {
+            averageX /= averageCount;
+            averageY /= averageCount;
+        } else {
+            averageX = ring.timeAt(Math.min(nextStart, to - 1));
+            averageY = Number.isNaN(selectedY) ? 0 : selectedY;
+        }
+
+        let bestIndex = -1;
+        let bestArea = -1;
+        for (let i = bucketStart; i < bucketEnd; i++) {
+            const y = ring.valueAt(series, i);
+            if (Number.isNaN(y)) {
+                continue;
+            }
+            const x = ring.timeAt(i);
+            const area = Number.isNaN(selectedY) ? Math.abs(y - averageY) :
+                Math.abs((selectedX - averageX) * (y - selectedY) - (selectedX - x) * (averageY - selectedY));
+            if (area > bestArea) {
+                bestArea = area;
+                bestIndex = i;
+            }
+        }
+
+        if (bestIndex < 0) {
+            points.push({ x: ring.timeAt(bucketStart), y: null });
+            selectedY = NaN;
+            continue;
+        }
+        selectedX = ring.timeAt(bestIndex);
+        selectedY = ring.valueAt(series, bestIndex);
+        points.push({ x: selectedX, y: selectedY });
+    }
+
+    const lastY = ring.valueAt(series, to - 1);
+    points.push({ x: ring.timeAt(to - 1), y: Number.isNaN(lastY) ? null : lastY });
+    return points;
+}
+
+// Перерисовка графика не чаще кадра; в скрытой вкладке кадров нет,
+// и график не перерисовывается
+function scheduleChartRedraw() {
+    if (chartRedrawPending || !tempChart) {
+        return;
+    }
+    chartRedrawPending = true;
+    requestAnimationFrame(() => {
+        chartRedrawPending = false;
+        redrawChart();
+    });
+}
+
+// Построение видимых серий из кольца: только выбранный период,
+// не больше точек, чем пикселей по ширине графика
+function redrawChart() {
+    const minutes = parseInt(document.getElementById('chart-range-select').value);
+    const now = Date.now();
+    const minTime = now - minutes * 60000;
+    const from = chartSeries.lowerBound(minTime);
+    const to = chartSeries.length;
+    const width = tempChart.chartArea ? tempChart.chartArea.width : tempChart.width;
+    const threshold = Math.max(3, Math.floor(width));
+
+    tempChart.data.datasets.forEach((dataset, index) => {
+        dataset.data = dataset.hidden ? [] : decimateSeries(chartSeries, index, from, to, threshold);
+    });
     tempChart.options.scales.x.min = minTime;
     tempChart.options.scales.x.max = now;
-    tempChart.update();
+    tempChart.update('none');
+}
+
+// Загрузка графика текущего процесса из журнала телеметрии (/api/telemetry).
+// Время отсчетов в журнале отсчитывается от начала процесса; последний
+// отсчет считается снятым в момент ответа
+function loadChartHistory() {
+    fetch(`/api/telemetry?points=${CHART_HISTORY_POINTS}`)
+    .then(response => response.json())
+    .then(history => {
+        if (!history.running || !history.points || history.points.length === 0) {
+            return;
+        }
+        const now = Date.now();
+        const lastTime = history.points[history.points.length - 1][0];
+        const maxPower = systemSettings.maxHeaterPower || 3000;
+        const times = [];
+        const rows = [];
+        // Точка: [время, фаза, значения, ...]; у агрегатов значения - средние.
+        // Каналы: куб, царга, узел отбора, ..., мощность (Вт)
+        history.points.forEach(point => {
+            const values = point[2];
+            const power = values[history.channels.length - 2];
+            times.push(now - (lastTime - point[0]) * 1000);
+            rows.push([values[0], values[1], values[2],
+                       power === null ? null : Math.round(power * 100 / maxPower)]);
+        });
+        chartSeries.prepend(times, rows);
+        scheduleChartRedraw();
+    })
+    .catch(error => {
+        console.error('Ошибка загрузки истории графика:', error);
+    });
 }
 
 // Подключение к WebSocket
@@ -347,6 +676,7 @@ function connectWebSocket() {
     socket.onopen = function(event) {
         console.log('WebSocket соединение установлено');
         updateConnectionStatus(true);
+        rpc.flush();
         
         // Запрашиваем статус при подключении
         requestSystemStatus();
@@ -355,6 +685,7 @@ function connectWebSocket() {
     socket.onclose = function(event) {
         console.log('WebSocket соединение закрыто');
         updateConnectionStatus(false);
+        rpc.failAll();
         
         // Попытка переподключения через 5 секунд
         setTimeout(connectWebSocket, 5000);
@@ -394,6 +725,9 @@ function updateConnectionStatus(connected) {
 // Обработка сообщений от WebSocket
 function handleWebSocketMessage(message) {
     switch (message.type) {
+        case 'rpc':
+            rpc.handle(message);
+            break;
         case 'status':
             updateSystemStatus(message.data);
             break;
@@ -568,28 +902,10 @@ function updateTemperatures(tempData) {
             tempData.product.toFixed(1) + '°C';
     }
     
-    // Обновляем данные для графика
-    const timestamp = tempData.timestamp ? new Date(tempData.timestamp) : new Date();
-    
-    temperatureData.labels.push(timestamp);
-    temperatureData.datasets[0].data.push({x: timestamp, y: tempData.cube !== undefined ? tempData.cube : null});
-    temperatureData.datasets[1].data.push({x: timestamp, y: tempData.reflux !== undefined ? tempData.reflux : null});
-    temperatureData.datasets[2].data.push({x: timestamp, y: tempData.product !== undefined ? tempData.product : null});
-    temperatureData.datasets[3].data.push({x: timestamp, y: tempData.power !== undefined ? tempData.power : null});
-    
-    // Ограничиваем количество точек на графике
-    const maxDataPoints = 3600; // максимум данных за час при шаге в 1 секунду
-    
-    if (temperatureData.labels.length > maxDataPoints) {
-        temperatureData.labels.shift();
-        temperatureData.datasets.forEach(dataset => {
-            dataset.data.shift();
-        });
-    }
-    
-    // Обновляем график
-    const chartRangeValue = parseInt(document.getElementById('chart-range-select').value);
-    updateChartTimeRange(chartRangeValue);
+    // Добавляем отсчет в кольцо графика; перерисовка - в ближайшем кадре
+    const timestamp = tempData.timestamp ? new Date(tempData.timestamp).getTime() : Date.now();
+    chartSeries.push(timestamp, [tempData.cube, tempData.reflux, tempData.product, tempData.power]);
+    scheduleChartRedraw();
 }
 
 // Отображение уведомления
@@ -630,95 +946,57 @@ function showNotification(message, type = 'info') {
     };
 }
 
-// Загрузка настроек
+// Загрузка настроек и сведений о системе одним пакетом RPC
 function loadSettings() {
-    // Загрузка системных настроек
-    fetch('/api/settings/system')
-        .then(response => response.json())
-        .then(data => {
-            if (data.success) {
-                systemSettings = data.settings;
-                updateSystemSettingsForm(systemSettings);
-            } else {
-                console.error('Ошибка загрузки системных настроек:', data.message);
-            }
-        })
-        .catch(error => {
-            console.error('Ошибка при загрузке системных настроек:', error);
-        });
-    
-    // Загрузка настроек ректификации
-    fetch('/api/settings/rectification')
-        .then(response => response.json())
-        .then(data => {
-            if (data.success) {
-                rectificationSettings = data.settings;
-                updateRectificationSettingsForm(rectificationSettings);
-            } else {
-                console.error('Ошибка загрузки настроек ректификации:', data.message);
-            }
-        })
-        .catch(error => {
-            console.error('Ошибка при загрузке настроек ректификации:', error);
-        });
-    
-    // Загрузка настроек дистилляции
-    fetch('/api/settings/distillation')
-        .then(response => response.json())
-        .then(data => {
-            if (data.success) {
-                distillationSettings = data.settings;
-                updateDistillationSettingsForm(distillationSettings);
-            } else {
-                console.error('Ошибка загрузки настроек дистилляции:', data.message);
-            }
-        })
-        .catch(error => {
-            console.error('Ошибка при загрузке настроек дистилляции:', error);
-        });
-    
-    // Загрузка настроек насоса
-    fetch('/api/settings/pump')
-        .then(response => response.json())
-        .then(data => {
-            if (data.success) {
-                pumpSettings = data.settings;
-                updatePumpSettingsForm(pumpSettings);
-            } else {
-                console.error('Ошибка загрузки настроек насоса:', data.message);
-            }
-        })
-        .catch(error => {
-            console.error('Ошибка при загрузке настроек насоса:', error);
-        });
-    
-    // Загрузка информации о системе
-    fetch('/api/system/info')
-        .then(response => response.json())
-        .then(data => {
-            if (data.success) {
-                updateSystemInfo(data);
-            } else {
-                console.error('Ошибка загрузки информации о системе:', data.message);
-            }
-        })
-        .catch(error => {
-            console.error('Ошибка при загрузке информации о системе:', error);
-        });
-    
-    // Загрузка информации о датчиках
-    fetch('/api/sensors/info')
-        .then(response => response.json())
-        .then(data => {
-            if (data.success) {
-                updateSensorInfo(data.sensors);
-            } else {
-                console.error('Ошибка загрузки информации о датчиках:', data.message);
-            }
-        })
-        .catch(error => {
-            console.error('Ошибка при загрузке информации о датчиках:', error);
-        });
+    rpc.batch([
+        ['settings.get', { section: 'heater' }],
+        ['settings.get', { section: 'rectification' }],
+        ['settings.get', { section: 'distillation' }],
+        ['settings.get', { section: 'pump' }],
+        ['system.info'],
+        ['sensors.info']
+    ]).then(([heater, rectification, distillation, pump, info, sensors]) => {
+        if (heater.status === 'fulfilled') {
+            systemSettings.maxHeaterPower = heater.value.maxPowerWatts;
+            updateSystemSettingsForm(systemSettings);
+        } else {
+            console.error('Ошибка загрузки настроек нагревателя:', heater.reason.message);
+        }
+        
+        if (rectification.status === 'fulfilled') {
+            rectificationSettings = rectification.value;
+            updateRectificationSettingsForm(rectificationSettings);
+        } else {
+            console.error('Ошибка загрузки настроек ректификации:', rectification.reason.message);
+        }
+        
+        if (distillation.status === 'fulfilled') {
+            distillationSettings = distillation.value;
+            updateDistillationSettingsForm(distillationSettings);
+        } else {
+            console.error('Ошибка загрузки настроек дистилляции:', distillation.reason.message);
+        }
+        
+        if (pump.status === 'fulfilled') {
+            pumpSettings = pump.value;
+            updatePumpSettingsForm(pumpSettings);
+        } else {
+            console.error('Ошибка загрузки настроек насоса:', pump.reason.message);
+        }
+        
+        if (info.status === 'fulfilled') {
+            updateSystemInfo(info.value);
+        } else {
+            console.error('Ошибка загрузки информации о системе:', info.reason.message);
+        }
+        
+        if (sensors.status === 'fulfilled') {
+            sensorSettings = sensors.value;
+            updateSensorInfo(sensorSettings);
+        } else {
+            console.error('Ошибка загрузки информации о датчиках:', sensors.reason.message);
+        }
+    });
 }
 
 // Обновление формы системных настроек
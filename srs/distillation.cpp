@@ -6,6 +6,10 @@
 #include "settings.h"
 #include "display.h"
 #include "utils.h"
+#include "checkpoint.h"
+#include "safety.h"
+#include "telemetry.h"
+#include "event_log.h"
 #include <Arduino.h>
 
 // Фазы дистилляции
@@ -73,6 +77,12 @@ bool startDistillation() {
         return false;
     }
     
+    // Зафиксированная аварийная остановка снимается только оператором
+    if (getSafetyRuleAction() >= SAFETY_ACTION_STOP) {
+        Serial.println("Ошибка: Аварийная остановка не сброшена");
+        return false;
+    }
+    
     // Проверяем наличие датчика температуры куба
     if (!isSensorConnected(TEMP_CUBE)) {
         Serial.println("Ошибка: Не подключен датчик куба");
@@ -117,7 +127,11 @@ bool startDistillation() {
     distillationRunning = true;
     distillationPaused = false;
     
-    Serial.println("Процесс дистилляции запущен");
+    // Новая запись телеметрии и первая контрольная точка процесса
+    startTelemetryRun(CHECKPOINT_DISTILLATION);
+    saveCheckpoint();
+    
+    logRecord(EV_DIST_STARTED);
     
     return true;
 }
@@ -142,7 +156,13 @@ void stopDistillation() {
     distillationPaused = false;
     setDistillationPhase(DIST_PHASE_IDLE);
     
-    Serial.println("Процесс дистилляции остановлен");
+    // Остановленный процесс не предлагается к продолжению
+    clearCheckpoint();
+    
+    // Остановка по правилу безопасности выполнена
+    acknowledgeSafetyStop();
+    
+    logRecord(EV_DIST_STOPPED);
 }
 
 // Пауза процесса дистилляции
@@ -165,7 +185,9 @@ void pauseDistillation() {
     
     distillationPaused = true;
     
-    Serial.println("Процесс дистилляции на паузе");
+    saveCheckpoint();
+    
+    logRecord(EV_DIST_PAUSED);
 }
 
 // Возобновление процесса дистилляции
@@ -201,7 +223,7 @@ void resumeDistillation() {
     
     distillationPaused = false;
     
-    Serial.println("Процесс дистилляции возобновлен");
+    logRecord(EV_DIST_RESUMED);
 }
 
 // Обработка процесса дистилляции
@@ -213,7 +235,7 @@ void processDistillation() {
     
     // Проверяем условия безопасности
     if (!checkDistillationSafety()) {
-        Serial.println("Сработала защита! Процесс дистилляции остановлен");
+        logRecord(EV_DIST_SAFETY_STOP);
         setDistillationPhase(DIST_PHASE_ERROR);
         stopDistillation();
         return;
@@ -244,6 +266,12 @@ void processDistillation() {
             stopDistillation();
             break;
     }
+    
+    // Телеметрия и периодическая контрольная точка
+    if (distillationRunning) {
+        updateTelemetry();
+        updateCheckpoint();
+    }
 }
 
 // Обработка фазы нагрева для дистилляции
@@ -303,9 +331,7 @@ void processDistillationPhase() {
             pumpResetExtractedVolume();
             pumpStart(sysSettings.distillationSettings.flowRate);
             
-            Serial.print("Отбор голов завершен. Собрано: ");
-            Serial.print(distHeadsCollected);
-            Serial.println(" мл.");
+            logRecord(EV_DIST_HEADS_DONE, distHeadsCollected);
         }
     } else {
         // Увеличиваем счетчик отбора продукта
@@ -315,15 +341,11 @@ void processDistillationPhase() {
 
 // Проверка условий безопасности для дистилляции
 bool checkDistillationSafety() {
-    // Проверка максимальной температуры куба
-    if (distLastCubeTemp > sysSettings.distillationSettings.maxCubeTemp) {
-        Serial.println("Превышена максимальная температура куба!");
-        return false;
-    }
+    // Правила безопасности оцениваются общим движком с набором правил режима
+    updateSafety();
     
-    // Проверка наличия датчика температуры куба
-    if (!isSensorConnected(TEMP_CUBE)) {
-        Serial.println("Датчик куба отключен!");
+    // Сработавшее правило записывает в журнал задача безопасности
+    if (getSafetyRuleAction() >= SAFETY_ACTION_STOP) {
         return false;
     }
     
@@ -344,10 +366,7 @@ void setDistillationPhase(DistillationPhase phase) {
     currentDistPhase = phase;
     distPhaseStartTime = millis();
     
-    Serial.print("Изменение фазы дистилляции: ");
-    Serial.print(distPhaseNames[prevPhase]);
-    Serial.print(" -> ");
-    Serial.println(distPhaseNames[currentDistPhase]);
+    logRecord(EV_DIST_PHASE, distPhaseNames[prevPhase], distPhaseNames[currentDistPhase]);
     
     // Действия при переходе на новую фазу
     switch (phase) {
@@ -376,11 +395,17 @@ void setDistillationPhase(DistillationPhase phase) {
             setHeaterPower(0);
             valveClose();
             pumpStop();
+            clearCheckpoint();
             break;
         default:
             break;
     }
     
+    // Смена фазы запущенного процесса сохраняется сразу
+    if (distillationRunning && (phase == DIST_PHASE_HEATING || phase == DIST_PHASE_DISTILLATION)) {
+        saveCheckpoint();
+    }
+    
     // Обновляем информацию на дисплее
     updateDisplay();
 }
@@ -459,4 +484,73 @@ float getDistillationColumnTemp() {
 // Получение текущей температуры продукта
 float getDistillationProductTemp() {
     return distLastProductTemp;
-}
\ No newline at end of file
+}
+
+// Заполнение контрольной точки текущим состоянием дистилляции
+void fillDistillationCheckpoint(ProcessCheckpoint& cp) {
+    cp.phase = currentDistPhase;
+    cp.uptime = getDistillationUptime();
+    cp.phaseTime = getDistillationPhaseTime();
+    cp.volumes[0] = distHeadsCollected;
+    cp.volumes[1] = distProductCollected;
+    cp.volumes[2] = 0;
+    cp.cubeTemp = distLastCubeTemp;
+    cp.refluxTemp = distLastProductTemp;
+    
+    if (distillationPaused) {
+        cp.flags |= CHECKPOINT_FLAG_PAUSED;
+    }
+    if (distHeadsMode) {
+        cp.flags |= CHECKPOINT_FLAG_HEADS_MODE;
+    }
+}
+
+// Восстановление дистилляции из контрольной точки
+bool restoreDistillationFromCheckpoint(const ProcessCheckpoint& cp, bool fromHeating) {
+    if (distillationRunning) {
+        return false;
+    }
+    
+    DistillationPhase phase = fromHeating ? DIST_PHASE_HEATING : (DistillationPhase)cp.phase;
+    if (phase != DIST_PHASE_HEATING && phase != DIST_PHASE_DISTILLATION) {
+        return false;
+    }
+    
+    // Восстанавливаем счетчики и общее время процесса
+    distStartTime = millis() - cp.uptime * 1000UL;
+    distPauseTime = 0;
+    distHeadsCollected = cp.volumes[0];
+    distProductCollected = cp.volumes[1];
+    
+    // Последние показания задачи опроса датчиков: восстановление вызывается
+    // из обработчика запроса, и опрос шины 1-Wire здесь мешал бы этой задаче
+    distLastCubeTemp = getTemperature(TEMP_CUBE);
+    distLastColumnTemp = getTemperature(TEMP_COLUMN);
+    distLastProductTemp = getTemperature(TEMP_REFLUX);
+    
+    // Вход в фазу выполняет действия с нагревателем, клапаном и насосом
+    currentDistPhase = DIST_PHASE_IDLE;
+    setDistillationPhase(phase);
+    
+    if (phase == (DistillationPhase)cp.phase) {
+        distPhaseStartTime = millis() - cp.phaseTime * 1000UL;
+    }
+    
+    // Режим отбора голов берем из контрольной точки, а не из настроек
+    if (phase == DIST_PHASE_DISTILLATION) {
+        distHeadsMode = (cp.flags & CHECKPOINT_FLAG_HEADS_MODE) != 0;
+        pumpStart(distHeadsMode ? sysSettings.distillationSettings.headsFlowRate
+                                : sysSettings.distillationSettings.flowRate);
+    }
+    
+    distillationRunning = true;
+    distillationPaused = false;
+    
+    if (cp.flags & CHECKPOINT_FLAG_PAUSED) {
+        pauseDistillation();
+    }
+    
+    Serial.println("Процесс дистилляции восстановлен из контрольной точки");
+    
+    return true;
+}
@@ -11,6 +11,8 @@
 
 #include <Arduino.h>
 
+struct ProcessCheckpoint;
+
 // Фазы дистилляции
 enum DistillationPhase {
     DIST_PHASE_IDLE = 0,         // Процесс не запущен
@@ -136,6 +138,22 @@ float getDistillationColumnTemp();
  */
 float getDistillationProductTemp();
 
+/**
+ * @brief Заполнение контрольной точки текущим состоянием дистилляции
+ * 
+ * @param cp Контрольная точка
+ */
+void fillDistillationCheckpoint(ProcessCheckpoint& cp);
+
+/**
+ * @brief Восстановление дистилляции из контрольной точки
+ * 
+ * @param cp Контрольная точка прерванного процесса
+ * @param fromHeating true если куб остыл и процесс продолжается с нагрева
+ * @return true если процесс восстановлен
+ */
+bool restoreDistillationFromCheckpoint(const ProcessCheckpoint& cp, bool fromHeating);
+
 // Приватные функции (не включаются в заголовочный файл для внешнего использования)
 void processDistHeatingPhase();
 void processDistillationPhase();
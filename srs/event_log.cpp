@@ -0,0 +1,356 @@
+/**
+ * @file event_log.cpp
+ * @brief Реализация журнала событий
+ */
+
+#include "event_log.h"
+#include "web.h"
+#include "fs_gate.h"
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+#include <atomic>
+
+// Файлы журнала на LittleFS
+#define EVENT_LOG_FILE "/events.log"
+#define EVENT_LOG_OLD_FILE "/events.old.log"
+
+#define EVENT_LOG_RING_MASK (EVENT_LOG_RING_SIZE - 1)
+
+// Описание события
+struct LogEventInfo {
+    uint8_t module;
+    uint8_t level;
+    const char* format;
+};
+
+static const LogEventInfo eventInfo[EV_COUNT] = {
+#define EVENT_LOG_INFO(id, module, level, format) { module, level, format },
+    EVENT_LOG_EVENTS(EVENT_LOG_INFO)
+#undef EVENT_LOG_INFO
+};
+
+static const char* const moduleNames[LOG_MODULE_COUNT] = {
+    "system", "process", "heater", "pump", "valve", "safety", "sensors", "web", "storage"
+};
+
+static const char* const levelNames[] = { "none", "error", "warn", "info", "debug" };
+
+// Уровень подробности модулей, меняется во время работы
+static volatile uint8_t moduleLevels[LOG_MODULE_COUNT] = {
+    LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO,
+    LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO, LOG_LEVEL_INFO
+};
+
+// Ячейка кольца. sequence равен началу круга, на котором ячейка свободна,
+// и на единицу больше, когда запись этого круга готова к чтению.
+// Нулевая инициализация соответствует пустому кольцу.
+struct LogSlot {
+    std::atomic<uint32_t> sequence;
+    LogRecord record;
+};
+
+static LogSlot ring[EVENT_LOG_RING_SIZE];
+static std::atomic<uint32_t> enqueuePos(0);
+static std::atomic<uint32_t> droppedRecords(0);
+
+// Позиция чтения, используется только задачей журнала
+static uint32_t dequeuePos = 0;
+static uint32_t reportedDropped = 0;
+
+static TaskHandle_t eventLogTaskHandle = NULL;
+
+// Начало круга для позиции в кольце
+static inline uint32_t lapStart(uint32_t pos) {
+    return pos & ~(uint32_t)EVENT_LOG_RING_MASK;
+}
+
+// Захват ячейки и запись в нее; несколько задач могут писать одновременно
+static bool enqueueRecord(const LogRecord& record) {
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    LogSlot* slot;
+    while (true) {
+        slot = &ring[pos & EVENT_LOG_RING_MASK];
+        uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(sequence - lapStart(pos));
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Ячейка еще не прочитана с прошлого круга - кольцо заполнено
+            droppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            // Позицию уже заняла другая задача
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->record = record;
+    slot->sequence.store(lapStart(pos) + 1, std::memory_order_release);
+    return true;
+}
+
+// Чтение следующей записи (только задача журнала)
+static bool dequeueRecord(LogRecord& record) {
+    LogSlot& slot = ring[dequeuePos & EVENT_LOG_RING_MASK];
+    if (slot.sequence.load(std::memory_order_acquire) != lapStart(dequeuePos) + 1) {
+        return false;
+    }
+    record = slot.record;
+    slot.sequence.store(lapStart(dequeuePos) + EVENT_LOG_RING_SIZE, std::memory_order_release);
+    dequeuePos++;
+    return true;
+}
+
+// Добавление записи в кольцо
+bool pushLogRecord(LogEventId event, const LogValue* args, uint8_t count) {
+    if (event >= EV_COUNT) {
+        return false;
+    }
+    const LogEventInfo& info = eventInfo[event];
+    if (info.level > moduleLevels[info.module]) {
+        return false;
+    }
+
+    LogRecord record;
+    record.time = millis();
+    record.event = event;
+    record.level = info.level;
+    record.module = info.module;
+    if (count > EVENT_LOG_MAX_ARGS) {
+        count = EVENT_LOG_MAX_ARGS;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        record.args[i] = args[i];
+    }
+    return enqueueRecord(record);
+}
+
+// Запись произвольного текста
+bool logText(LogModule module, LogLevel level, const char* text) {
+    if (module >= LOG_MODULE_COUNT || level > moduleLevels[module]) {
+        return false;
+    }
+
+    LogRecord record;
+    record.time = millis();
+    record.event = EV_TEXT;
+    record.level = level;
+    record.module = module;
+
+    // Обрезка по границе символа UTF-8
+    size_t length = strlen(text);
+    if (length >= EVENT_LOG_TEXT_SIZE) {
+        length = EVENT_LOG_TEXT_SIZE - 1;
+        while (length > 0 && ((uint8_t)text[length] & 0xC0) == 0x80) {
+            length--;
+        }
+    }
+    memcpy(record.text, text, length);
+    record.text[length] = '\0';
+    return enqueueRecord(record);
+}
+
+// Форматирование сообщения записи по таблице событий
+static void formatMessage(const LogRecord& record, char* buffer, size_t size) {
+    if (record.event == EV_TEXT) {
+        snprintf(buffer, size, "%s", record.text);
+        return;
+    }
+
+    const char* format = eventInfo[record.event].format;
+    size_t length = 0;
+    uint8_t arg = 0;
+    while (*format && length + 1 < size) {
+        if (format[0] != '%' || format[1] == '\0') {
+            buffer[length++] = *format++;
+            continue;
+        }
+
+        char spec = format[1];
+        format += 2;
+        if (spec == '%') {
+            buffer[length++] = '%';
+            continue;
+        }
+
+        LogValue value;
+        value.i = 0;
+        if (arg < EVENT_LOG_MAX_ARGS) {
+            value = record.args[arg++];
+        }
+
+        int written;
+        switch (spec) {
+            case 'd': written = snprintf(buffer + length, size - length, "%ld", (long)value.i); break;
+            case 'u': written = snprintf(buffer + length, size - length, "%lu", (unsigned long)value.u); break;
+            case 'f': written = snprintf(buffer + length, size - length, "%.2f", value.f); break;
+            case 's': written = snprintf(buffer + length, size - length, "%s", value.s ? value.s : ""); break;
+            default:  written = 0; break;
+        }
+        if (written > 0) {
+            length += (size_t)written < size - length ? written : size - length - 1;
+        }
+    }
+    buffer[length] = '\0';
+}
+
+// Форматирование строки журнала для последовательного порта и файла
+static size_t formatLine(const LogRecord& record, const char* message, char* buffer, size_t size) {
+    unsigned long seconds = record.time / 1000;
+    int written = snprintf(buffer, size, "[%02lu:%02lu:%02lu.%03lu] %c %s: %s\n",
+                           seconds / 3600, (seconds / 60) % 60, seconds % 60,
+                           (unsigned long)(record.time % 1000),
+                           (char)toupper(levelNames[record.level][0]),
+                           moduleNames[record.module], message);
+    if (written < 0) {
+        return 0;
+    }
+    return (size_t)written < size ? written : size - 1;
+}
+
+// Ротация файла журнала при превышении размера
+static void rotateLogFile() {
+    File file = LittleFS.open(EVENT_LOG_FILE, "r");
+    if (!file) {
+        return;
+    }
+    size_t size = file.size();
+    file.close();
+
+    if (size >= EVENT_LOG_FILE_MAX_SIZE) {
+        LittleFS.remove(EVENT_LOG_OLD_FILE);
+        LittleFS.rename(EVENT_LOG_FILE, EVENT_LOG_OLD_FILE);
+    }
+}
+
+// Вывод накопленных записей
+static void drainEventLog() {
+    static char message[160];
+    static char line[200];
+    static char json[320];
+
+    // Вывод в файл пропускается, пока доступ к файлам закрыт (запись образа
+    // файловой системы); в Serial и WebSocket записи выводятся всегда
+    bool fileAccess = beginFileAccess();
+    File file;
+    LogRecord record;
+
+    while (dequeueRecord(record)) {
+        formatMessage(record, message, sizeof(message));
+        size_t length = formatLine(record, message, line, sizeof(line));
+
+        Serial.print(line);
+
+        if (fileAccess) {
+            if (!file) {
+                file = LittleFS.open(EVENT_LOG_FILE, "a");
+            }
+            if (file) {
+                file.write((const uint8_t*)line, length);
+            }
+        }
+
+        StaticJsonDocument<384> doc;
+        doc["type"] = "log";
+        doc["time"] = record.time;
+        doc["level"] = levelNames[record.level];
+        doc["module"] = moduleNames[record.module];
+        doc["message"] = (const char*)message;
+        size_t jsonLength = serializeJson(doc, json, sizeof(json));
+        sendLogToClients(json, jsonLength);
+    }
+
+    if (file) {
+        file.close();
+        rotateLogFile();
+    }
+    if (fileAccess) {
+        endFileAccess();
+    }
+
+    uint32_t dropped = droppedRecords.load(std::memory_order_relaxed);
+    if (dropped != reportedDropped) {
+        Serial.print("Журнал событий: потеряно записей при переполнении - ");
+        Serial.println(dropped - reportedDropped);
+        reportedDropped = dropped;
+    }
+}
+
+#ifdef ESP32
+// Задача журнала: периодически выводит накопленные записи
+static void eventLogTask(void* parameter) {
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(EVENT_LOG_DRAIN_INTERVAL_MS));
+        drainEventLog();
+    }
+}
+#endif
+
+// Запуск задачи журнала
+void initEventLog() {
+    rotateLogFile();
+
+    #ifdef ESP32
+    if (eventLogTaskHandle != NULL) {
+        return;
+    }
+    BaseType_t result = xTaskCreatePinnedToCore(eventLogTask, "event_log", EVENT_LOG_TASK_STACK_SIZE, NULL,
+                                                EVENT_LOG_TASK_PRIORITY, &eventLogTaskHandle, EVENT_LOG_TASK_CORE);
+    if (result != pdPASS) {
+        eventLogTaskHandle = NULL;
+        Serial.println("Ошибка запуска задачи журнала событий");
+        return;
+    }
+    Serial.println("Журнал событий запущен");
+    #endif
+}
+
+// Установка уровня подробности модуля
+void setLogLevel(LogModule module, LogLevel level) {
+    if (module < LOG_MODULE_COUNT && level <= LOG_LEVEL_DEBUG) {
+        moduleLevels[module] = level;
+    }
+}
+
+// Получение уровня подробности модуля
+LogLevel getLogLevel(LogModule module) {
+    return module < LOG_MODULE_COUNT ? (LogLevel)moduleLevels[module] : LOG_LEVEL_NONE;
+}
+
+// Получение имени модуля
+const char* getLogModuleName(LogModule module) {
+    return module < LOG_MODULE_COUNT ? moduleNames[module] : "unknown";
+}
+
+// Получение имени уровня
+const char* getLogLevelName(LogLevel level) {
+    return level <= LOG_LEVEL_DEBUG ? levelNames[level] : "unknown";
+}
+
+// Поиск модуля по имени
+LogModule findLogModule(const char* name) {
+    for (int i = 0; i < LOG_MODULE_COUNT; i++) {
+        if (strcmp(moduleNames[i], name) == 0) {
+            return (LogModule)i;
+        }
+    }
+    return LOG_MODULE_COUNT;
+}
+
+// Поиск уровня по имени
+bool findLogLevel(const char* name, LogLevel& level) {
+    for (int i = 0; i <= LOG_LEVEL_DEBUG; i++) {
+        if (strcmp(levelNames[i], name) == 0) {
+            level = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Количество записей, отброшенных из-за переполнения кольца
+uint32_t getEventLogDropped() {
+    return droppedRecords.load(std::memory_order_relaxed);
+}
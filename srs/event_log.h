@@ -0,0 +1,209 @@
+/**
+ * @file event_log.h
+ * @brief Журнал событий с отложенным форматированием
+ *
+ * Задачи управления не форматируют строки и не ждут последовательный порт:
+ * событие записывается как запись фиксированного размера (время, код
+ * события, аргументы) в кольцо без блокировок, в которое могут писать
+ * несколько задач одновременно. Задача журнала с низким приоритетом
+ * форматирует накопленные записи по таблице событий и выводит их в
+ * последовательный порт, файл на LittleFS и клиентам WebSocket.
+ *
+ * При переполнении кольца новая запись отбрасывается, количество потерь
+ * выводится задачей журнала. Уровень подробности задается для каждого
+ * модуля во время работы.
+ */
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Уровни подробности
+enum LogLevel {
+    LOG_LEVEL_NONE = 0,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG
+};
+
+// Модули
+enum LogModule {
+    LOG_MODULE_SYSTEM = 0,
+    LOG_MODULE_PROCESS,
+    LOG_MODULE_HEATER,
+    LOG_MODULE_PUMP,
+    LOG_MODULE_VALVE,
+    LOG_MODULE_SAFETY,
+    LOG_MODULE_SENSORS,
+    LOG_MODULE_WEB,
+    LOG_MODULE_STORAGE,
+    LOG_MODULE_COUNT
+};
+
+// События: X(код, модуль, уровень, формат)
+// Формат: %d - целое, %u - беззнаковое, %f - число с плавающей точкой,
+// %s - строка, которая должна жить все время работы (литерал или таблица).
+#define EVENT_LOG_EVENTS(X) \
+    X(EV_TEXT,                  LOG_MODULE_SYSTEM,  LOG_LEVEL_INFO,  "%s") \
+    X(EV_PI_SENSOR_MISSING,     LOG_MODULE_HEATER,  LOG_LEVEL_ERROR, "Ошибка PI-регулятора: датчик не подключен") \
+    X(EV_PI_UPDATE,             LOG_MODULE_HEATER,  LOG_LEVEL_DEBUG, "PI: цель=%f°C, текущая=%f°C, ошибка=%f, P=%f, I=%f, выход=%f") \
+    X(EV_VALVE_REFLUX,          LOG_MODULE_VALVE,   LOG_LEVEL_DEBUG, "Фаза орошения - клапан закрыт") \
+    X(EV_VALVE_COLLECT,         LOG_MODULE_VALVE,   LOG_LEVEL_DEBUG, "Фаза отбора - клапан открыт") \
+    X(EV_VALVE_REFLUX_SET,      LOG_MODULE_VALVE,   LOG_LEVEL_INFO,  "Установлен режим орошения: соотношение %f, период %d с") \
+    X(EV_RECT_STARTED,          LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Процесс ректификации запущен") \
+    X(EV_RECT_STOPPED,          LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Процесс ректификации остановлен") \
+    X(EV_RECT_PAUSED,           LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Процесс ректификации на паузе") \
+    X(EV_RECT_RESUMED,          LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Процесс ректификации возобновлен") \
+    X(EV_RECT_SAFETY_STOP,      LOG_MODULE_PROCESS, LOG_LEVEL_ERROR, "Сработала защита! Процесс ректификации остановлен") \
+    X(EV_RECT_PHASE,            LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Изменение фазы ректификации: %s -> %s") \
+    X(EV_RECT_STABILIZED_EARLY, LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Колонна стабилизировалась досрочно, сэкономлено %u с") \
+    X(EV_RECT_HEADS_DONE,       LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Отбор голов завершен: отобрано %d мл, детектор: не срабатывал") \
+    X(EV_RECT_HEADS_DONE_DETECTED, LOG_MODULE_PROCESS, LOG_LEVEL_INFO, "Отбор голов завершен: отобрано %d мл, детектор: %d мл") \
+    X(EV_RECT_HEADS_END_DETECTED, LOG_MODULE_PROCESS, LOG_LEVEL_INFO, "Детектор окончания голов сработал: уверенность %f, отобрано %d мл") \
+    X(EV_RECT_BODY_RESUMED,     LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Колонна восстановилась, отбор тела возобновлен со скоростью %f") \
+    X(EV_RECT_BODY_MIN_RATE,    LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Остановка отбора на минимальной скорости, переход к хвостам") \
+    X(EV_RECT_START_STOP,       LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Старт-стоп: остановка #%d, новая скорость отбора %f") \
+    X(EV_DIST_STARTED,          LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Процесс дистилляции запущен") \
+    X(EV_DIST_STOPPED,          LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Процесс дистилляции остановлен") \
+    X(EV_DIST_PAUSED,           LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Процесс дистилляции на паузе") \
+    X(EV_DIST_RESUMED,          LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Процесс дистилляции возобновлен") \
+    X(EV_DIST_SAFETY_STOP,      LOG_MODULE_PROCESS, LOG_LEVEL_ERROR, "Сработала защита! Процесс дистилляции остановлен") \
+    X(EV_DIST_PHASE,            LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Изменение фазы дистилляции: %s -> %s") \
+    X(EV_DIST_HEADS_DONE,       LOG_MODULE_PROCESS, LOG_LEVEL_INFO,  "Отбор голов завершен. Собрано: %d мл.") \
+    X(EV_SAFETY_RULE_TRIPPED,   LOG_MODULE_SAFETY,  LOG_LEVEL_WARN,  "Сработало правило безопасности %s: значение %f, порог %f") \
+    X(EV_WS_CLIENT_STALLED,     LOG_MODULE_WEB,     LOG_LEVEL_WARN,  "Клиент WebSocket #%u отключен: %u байт не отправлено в течение %u с") \
+    X(EV_MQTT_CONNECTED,        LOG_MODULE_WEB,     LOG_LEVEL_INFO,  "Подключено к брокеру MQTT, к досылке %u отсчетов") \
+    X(EV_MQTT_DISCONNECTED,     LOG_MODULE_WEB,     LOG_LEVEL_WARN,  "Связь с брокером MQTT потеряна (причина %d)") \
+    X(EV_MQTT_SAMPLES_LOST,     LOG_MODULE_WEB,     LOG_LEVEL_WARN,  "MQTT: %u отсчетов вытеснены из кольца телеметрии до отправки") \
+    X(EV_OTA_STARTED,           LOG_MODULE_SYSTEM,  LOG_LEVEL_INFO,  "Обновление (%s): прием образа %u байт") \
+    X(EV_OTA_DONE,              LOG_MODULE_SYSTEM,  LOG_LEVEL_INFO,  "Обновление (%s): образ записан и проверен, перезагрузка") \
+    X(EV_OTA_FAILED,            LOG_MODULE_SYSTEM,  LOG_LEVEL_ERROR, "Обновление (%s) не выполнено: %s") \
+    X(EV_OTA_CONFIRMED,         LOG_MODULE_SYSTEM,  LOG_LEVEL_INFO,  "Новая прошивка прошла проверку, откат отменен") \
+    X(EV_OTA_ROLLBACK,          LOG_MODULE_SYSTEM,  LOG_LEVEL_ERROR, "Новая прошивка не прошла проверку (%s), откат к предыдущей")
+
+// Коды событий
+enum LogEventId {
+#define EVENT_LOG_ID(id, module, level, format) id,
+    EVENT_LOG_EVENTS(EVENT_LOG_ID)
+#undef EVENT_LOG_ID
+    EV_COUNT
+};
+
+// Аргумент записи
+union LogValue {
+    int32_t i;
+    uint32_t u;
+    float f;
+    const char* s;
+};
+
+// Максимальное количество аргументов записи
+#define EVENT_LOG_MAX_ARGS (EVENT_LOG_TEXT_SIZE / sizeof(LogValue))
+
+// Запись журнала
+struct LogRecord {
+    uint32_t time;             // Время (мс от запуска)
+    uint16_t event;            // Код события (LogEventId)
+    uint8_t level;             // Уровень (для текстовых записей может отличаться от таблицы)
+    uint8_t module;            // Модуль
+    union {
+        LogValue args[EVENT_LOG_MAX_ARGS];
+        char text[EVENT_LOG_TEXT_SIZE];  // Текст записи EV_TEXT
+    };
+};
+
+inline LogValue logValue(int value) { LogValue v; v.i = value; return v; }
+inline LogValue logValue(long value) { LogValue v; v.i = value; return v; }
+inline LogValue logValue(unsigned int value) { LogValue v; v.u = value; return v; }
+inline LogValue logValue(unsigned long value) { LogValue v; v.u = value; return v; }
+inline LogValue logValue(bool value) { LogValue v; v.i = value; return v; }
+inline LogValue logValue(float value) { LogValue v; v.f = value; return v; }
+inline LogValue logValue(double value) { LogValue v; v.f = (float)value; return v; }
+inline LogValue logValue(const char* value) { LogValue v; v.s = value; return v; }
+
+/**
+ * @brief Запуск задачи журнала
+ *
+ * Записи, сделанные до запуска, сохраняются в кольце и выводятся после него.
+ * Файловый вывод требует смонтированной LittleFS.
+ */
+void initEventLog();
+
+/**
+ * @brief Добавление записи в кольцо
+ *
+ * Не блокируется и не форматирует строки; при отключенном уровне модуля
+ * или заполненном кольце запись отбрасывается.
+ *
+ * @param event Код события
+ * @param args Аргументы
+ * @param count Количество аргументов
+ * @return true если запись добавлена
+ */
+bool pushLogRecord(LogEventId event, const LogValue* args, uint8_t count);
+
+/**
+ * @brief Запись события с аргументами
+ */
+template<typename... Args>
+inline bool logRecord(LogEventId event, Args... args) {
+    LogValue values[] = { logValue(args)... };
+    return pushLogRecord(event, values, sizeof...(args));
+}
+
+inline bool logRecord(LogEventId event) {
+    return pushLogRecord(event, NULL, 0);
+}
+
+/**
+ * @brief Запись произвольного текста
+ *
+ * Текст копируется в запись и обрезается до EVENT_LOG_TEXT_SIZE байт.
+ */
+bool logText(LogModule module, LogLevel level, const char* text);
+
+/**
+ * @brief Установка уровня подробности модуля
+ */
+void setLogLevel(LogModule module, LogLevel level);
+
+/**
+ * @brief Получение уровня подробности модуля
+ */
+LogLevel getLogLevel(LogModule module);
+
+/**
+ * @brief Получение имени модуля
+ */
+const char* getLogModuleName(LogModule module);
+
+/**
+ * @brief Получение имени уровня
+ */
+const char* getLogLevelName(LogLevel level);
+
+/**
+ * @brief Поиск модуля по имени
+ *
+ * @return Модуль или LOG_MODULE_COUNT, если имя неизвестно
+ */
+LogModule findLogModule(const char* name);
+
+/**
+ * @brief Поиск уровня по имени
+ *
+ * @param name Имя уровня
+ * @param level Найденный уровень
+ * @return true если имя известно
+ */
+bool findLogLevel(const char* name, LogLevel& level);
+
+/**
+ * @brief Количество записей, отброшенных из-за переполнения кольца
+ */
+uint32_t getEventLogDropped();
+
+#endif // EVENT_LOG_H
@@ -0,0 +1,238 @@
+/**
+ * @file event_stream.cpp
+ * @brief Реализация потока событий SSE
+ */
+
+#include "event_stream.h"
+#include "telemetry.h"
+#include "json_writer.h"
+
+// Путь потока событий
+#define EVENT_STREAM_PATH "/events"
+
+// Идентификатор события telemetry: номер записи в старших 12 битах,
+// время последнего отсчета (секунды) в младших 20 битах
+#define EVENT_ID_TIME_BITS 20
+#define EVENT_ID_TIME_MASK ((1UL << EVENT_ID_TIME_BITS) - 1)
+
+// Имена типов в параметре types, по порядку битов EventStreamType
+static const char* const eventTypeNames[] = { "status", "telemetry", "notification", "log" };
+
+#define EVENT_TYPE_COUNT (int)(sizeof(eventTypeNames) / sizeof(eventTypeNames[0]))
+
+// Библиотека не дает сопоставить клиента с запросом, поэтому для каждой
+// комбинации типов свой обработчик: фильтр обработчика сравнивает
+// параметр types с его маской
+static AsyncEventSource* sources[EVENT_STREAM_ALL + 1];
+
+// Позиция потока телеметрии: следующий отсчет для рассылки
+static uint32_t cursorRun = 0;
+static uint32_t cursorNext = 0;
+
+// Показатели
+static uint32_t backfilledSamples = 0;
+static uint32_t resyncCount = 0;
+static uint32_t skippedStatus = 0;
+
+// Маска типов из параметра types; 0 если указан неизвестный тип
+static uint8_t parseEventTypes(AsyncWebServerRequest *request) {
+    if (!request->hasParam("types")) {
+        return EVENT_STREAM_ALL;
+    }
+    const String& value = request->getParam("types")->value();
+    uint8_t mask = 0;
+    int start = 0;
+    while (start <= (int)value.length()) {
+        int end = value.indexOf(',', start);
+        if (end < 0) {
+            end = value.length();
+        }
+        String name = value.substring(start, end);
+        name.trim();
+        int type = 0;
+        while (type < EVENT_TYPE_COUNT && name != eventTypeNames[type]) {
+            type++;
+        }
+        if (type == EVENT_TYPE_COUNT) {
+            return 0;
+        }
+        mask |= 1 << type;
+        start = end + 1;
+    }
+    return mask;
+}
+
+static const char* eventTypeName(EventStreamType type) {
+    for (int i = 0; i < EVENT_TYPE_COUNT; i++) {
+        if (type == (1 << i)) {
+            return eventTypeNames[i];
+        }
+    }
+    return "message";
+}
+
+// Номер записи в идентификаторе события (никогда не 0, чтобы идентификатор не был пустым)
+static uint32_t eventRunTag(uint32_t run) {
+    return (run % 0xFFF) + 1;
+}
+
+static uint32_t sampleEventId(uint32_t run, uint32_t time) {
+    return (eventRunTag(run) << EVENT_ID_TIME_BITS) | (time & EVENT_ID_TIME_MASK);
+}
+
+// Чтение отсчетов начиная с from и отправка событиями telemetry. Если клиент
+// указан - только ему (досылка), иначе всем подписанным.
+// Возвращает время следующего за отправленными отсчета.
+static uint32_t sendSamples(AsyncEventSourceClient *client, uint32_t run, uint32_t from, uint32_t maxSamples) {
+    TelemetrySample samples[SSE_SAMPLES_PER_EVENT];
+    uint32_t sent = 0;
+    while (sent < maxSamples) {
+        int limit = min((uint32_t)SSE_SAMPLES_PER_EVENT, maxSamples - sent);
+        int count = readTelemetrySamples(run, from, samples, limit);
+        if (count == 0) {
+            break;
+        }
+
+        PooledJsonWriter json;
+        writeTelemetrySamples(json, samples, count);
+        if (!json.ok()) {
+            // Без буфера отсчеты останутся в кольце и уйдут на следующем проходе
+            break;
+        }
+        uint32_t id = sampleEventId(run, samples[count - 1].time);
+        if (client != nullptr) {
+            client->send(json.c_str(), "telemetry", id);
+        } else {
+            for (int mask = 1; mask <= EVENT_STREAM_ALL; mask++) {
+                if ((mask & EVENT_STREAM_TELEMETRY) && sources[mask]->count() > 0) {
+                    sources[mask]->send(json.c_str(), "telemetry", id);
+                }
+            }
+        }
+
+        sent += count;
+        from = samples[count - 1].time + 1;
+        if (count < limit) {
+            break;
+        }
+    }
+    return from;
+}
+
+// Досылка отсчетов, пропущенных клиентом с момента Last-Event-ID
+static void backfillClient(AsyncEventSourceClient *client, uint32_t lastId) {
+    uint32_t run, first, last;
+    if (!getTelemetrySampleRange(run, first, last)) {
+        return;
+    }
+
+    // Идентификатор другой записи - процесс начат заново, досылается новая запись
+    uint32_t from = 0;
+    if ((lastId >> EVENT_ID_TIME_BITS) == eventRunTag(run)) {
+        from = (lastId & EVENT_ID_TIME_MASK) + 1;
+        if (from > last) {
+            return;
+        }
+    }
+
+    uint32_t start = from > first ? from : first;
+    if (last - start + 1 > SSE_BACKFILL_MAX_SAMPLES) {
+        start = last + 1 - SSE_BACKFILL_MAX_SAMPLES;
+    }
+    if (start > from) {
+        char range[48];
+        snprintf(range, sizeof(range), "{\"from\":%lu,\"to\":%lu}", (unsigned long)from, (unsigned long)(start - 1));
+        client->send(range, "resync");
+        resyncCount++;
+    }
+
+    uint32_t next = sendSamples(client, run, start, SSE_BACKFILL_MAX_SAMPLES);
+    backfilledSamples += next > start ? next - start : 0;
+}
+
+// Регистрация обработчиков /events на веб-сервере
+void initEventStream(AsyncWebServer& server) {
+    for (int mask = 1; mask <= EVENT_STREAM_ALL; mask++) {
+        AsyncEventSource* source = new AsyncEventSource(EVENT_STREAM_PATH);
+        source->setFilter([mask](AsyncWebServerRequest *request) {
+            return request->url() == EVENT_STREAM_PATH && parseEventTypes(request) == mask;
+        });
+        source->onConnect([mask](AsyncEventSourceClient *client) {
+            if ((mask & EVENT_STREAM_TELEMETRY) && client->lastId() != 0) {
+                backfillClient(client, client->lastId());
+            }
+        });
+        server.addHandler(source);
+        sources[mask] = source;
+    }
+}
+
+// Признак подключенных клиентов
+bool eventStreamActive() {
+    for (int mask = 1; mask <= EVENT_STREAM_ALL; mask++) {
+        if (sources[mask] != nullptr && sources[mask]->count() > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Отправка события клиентам, выбравшим его тип
+void publishEvent(EventStreamType type, const char* data) {
+    const char* name = eventTypeName(type);
+    for (int mask = 1; mask <= EVENT_STREAM_ALL; mask++) {
+        AsyncEventSource* source = sources[mask];
+        if (!(mask & type) || source == nullptr || source->count() == 0) {
+            continue;
+        }
+        if (type == EVENT_STREAM_STATUS && source->avgPacketsWaiting() > SSE_MAX_PENDING) {
+            skippedStatus++;
+            continue;
+        }
+        source->send(data, name);
+    }
+}
+
+// Отправка новых отсчетов телеметрии
+void publishTelemetry() {
+    uint32_t run, first, last;
+    if (!getTelemetrySampleRange(run, first, last)) {
+        return;
+    }
+    if (run != cursorRun) {
+        cursorRun = run;
+        cursorNext = first;
+    }
+    if (cursorNext > last) {
+        return;
+    }
+
+    bool subscribed = false;
+    for (int mask = 1; mask <= EVENT_STREAM_ALL; mask++) {
+        if ((mask & EVENT_STREAM_TELEMETRY) && sources[mask] != nullptr && sources[mask]->count() > 0) {
+            subscribed = true;
+        }
+    }
+    if (!subscribed) {
+        cursorNext = last + 1;
+        return;
+    }
+
+    cursorNext = sendSamples(nullptr, run, cursorNext, last - cursorNext + 1);
+}
+
+// Показатели потока событий
+void writeEventStreamStats(JsonWriter& json) {
+    uint32_t clients = 0;
+    for (int mask = 1; mask <= EVENT_STREAM_ALL; mask++) {
+        if (sources[mask] != nullptr) {
+            clients += sources[mask]->count();
+        }
+    }
+    json.beginObject();
+    json.add("clients", clients);
+    json.add("backfilledSamples", backfilledSamples);
+    json.add("resyncs", resyncCount);
+    json.add("skippedStatus", skippedStatus);
+    json.endObject();
+}
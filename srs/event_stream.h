@@ -0,0 +1,72 @@
+/**
+ * @file event_stream.h
+ * @brief Поток событий SSE (/events)
+ *
+ * Односторонний поток для табло и скриптов, которым не нужен WebSocket.
+ * События формирует тот же источник, что и сообщения WebSocket: статус,
+ * уведомления и записи журнала рассылаются обоим каналам, а отсчеты
+ * телеметрии берутся из кольца в ОЗУ (telemetry.h).
+ *
+ * Типы событий выбираются параметром запроса: /events?types=status,telemetry
+ * (без параметра - все). Событие telemetry содержит массив отсчетов
+ * [[время,фаза,[значения каналов]],...] и идентификатор последнего из них.
+ * Браузер при переподключении передает его в Last-Event-ID, и пропущенные
+ * отсчеты досылаются из кольца. Если пропущено больше, чем хранится в кольце
+ * или досылается за раз, перед ними отправляется событие resync
+ * {"from":..,"to":..} с диапазоном для запроса /api/telemetry.
+ */
+
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "config.h"
+
+class JsonWriter;
+
+// Типы событий (битовая маска фильтра)
+enum EventStreamType {
+    EVENT_STREAM_STATUS = 0x01,         // Статус системы
+    EVENT_STREAM_TELEMETRY = 0x02,      // Отсчеты телеметрии и resync
+    EVENT_STREAM_NOTIFICATION = 0x04,   // Уведомления
+    EVENT_STREAM_LOG = 0x08             // Записи журнала событий
+};
+
+#define EVENT_STREAM_ALL 0x0F
+
+/**
+ * @brief Регистрация обработчиков /events на веб-сервере
+ */
+void initEventStream(AsyncWebServer& server);
+
+/**
+ * @brief Признак подключенных клиентов
+ */
+bool eventStreamActive();
+
+/**
+ * @brief Отправка события клиентам, выбравшим его тип
+ *
+ * Статус не ставится в очередь клиентов, у которых накопилось больше
+ * SSE_MAX_PENDING сообщений: они получат следующий.
+ *
+ * @param type Тип события
+ * @param data Данные события (JSON без переводов строк)
+ */
+void publishEvent(EventStreamType type, const char* data);
+
+/**
+ * @brief Отправка новых отсчетов телеметрии
+ *
+ * Вызывается раз в период рассылки и без клиентов, чтобы позиция потока
+ * следовала за кольцом отсчетов.
+ */
+void publishTelemetry();
+
+/**
+ * @brief Запись показателей потока событий (объект)
+ */
+void writeEventStreamStats(JsonWriter& json);
+
+#endif // EVENT_STREAM_H
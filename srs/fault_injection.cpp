@@ -0,0 +1,284 @@
+/**
+ * @file fault_injection.cpp
+ * @brief Реализация внесения неисправностей
+ */
+
+#include "fault_injection.h"
+
+#ifdef FAULT_INJECTION
+
+#include "temp_sensors.h"
+#include "supervisor.h"
+
+// Таблица сценариев.
+// Порядок полей: имя, тип, датчик, задача, значение, длительность,
+// реакция без процесса, реакция во время процесса, допустимое время реакции.
+static const FaultScenario scenarios[] = {
+    // Обрыв датчика куба: 10 с до признания отключенным + удержание правила
+    {"cube_dropout", FAULT_SENSOR_DROPOUT, TEMP_CUBE, "", 0, 20000,
+     SAFETY_ACTION_NONE, SAFETY_ACTION_STOP, 15000},
+    // Залипание на недопустимой температуре
+    {"cube_stuck_high", FAULT_SENSOR_STUCK, TEMP_CUBE, "", 110.0f, 10000,
+     SAFETY_ACTION_EMERGENCY, SAFETY_ACTION_EMERGENCY, 4000},
+    // Одиночный выброс не должен вызывать срабатывание
+    {"cube_spike", FAULT_SENSOR_SPIKE, TEMP_CUBE, "", 150.0f, 3000,
+     SAFETY_ACTION_NONE, SAFETY_ACTION_NONE, 0},
+    // Периодические ошибки CRC не должны приводить к остановке
+    {"onewire_crc", FAULT_SENSOR_CRC, TEMP_CUBE, "", 0, 8000,
+     SAFETY_ACTION_NONE, SAFETY_ACTION_NONE, 0},
+    // Таймаут PZEM блокирует опрос, но не является аварией
+    {"pzem_timeout", FAULT_PZEM_TIMEOUT, -1, "", 1000.0f, 10000,
+     SAFETY_ACTION_NONE, SAFETY_ACTION_NONE, 0},
+    // Зависание задачи управления
+    {"control_starvation", FAULT_TASK_STARVATION, -1, "control", 3000.0f, 3000,
+     SAFETY_ACTION_EMERGENCY, SAFETY_ACTION_EMERGENCY, 3000},
+    // Зависание опроса датчиков
+    {"temperature_starvation", FAULT_TASK_STARVATION, -1, "temperature", 20000.0f, 20000,
+     SAFETY_ACTION_EMERGENCY, SAFETY_ACTION_EMERGENCY, 6000},
+    // Скачок времени вперед на 5 с и обратно не должен вызывать срабатываний
+    {"clock_jump", FAULT_CLOCK_JUMP, -1, "", 5000.0f, 5000,
+     SAFETY_ACTION_NONE, SAFETY_ACTION_NONE, 0},
+};
+
+#define FAULT_SCENARIO_COUNT (int)(sizeof(scenarios) / sizeof(scenarios[0]))
+
+// Этапы выполнения сценария
+enum FaultStage {
+    FAULT_STAGE_IDLE = 0,        // Сценарий не выполняется
+    FAULT_STAGE_INJECTING,       // Неисправность внесена
+    FAULT_STAGE_OBSERVING        // Неисправность снята, наблюдение за последствиями
+};
+
+static FaultResult results[FAULT_SCENARIO_COUNT];
+static const FaultResult emptyResult = {false, false, false, SAFETY_ACTION_NONE, SAFETY_ACTION_NONE, -1};
+
+// Состояние выполнения (изменяется только задачей безопасности)
+static volatile FaultStage stage = FAULT_STAGE_IDLE;
+static volatile int activeIndex = -1;
+static unsigned long stageStart = 0;
+static bool runAll = false;
+
+// Запрос запуска из веб-сервера (-1 - нет запроса, FAULT_SCENARIO_COUNT - все сценарии)
+static volatile int requestedIndex = -1;
+
+// Состояние подмены показаний
+static volatile bool spikeDone = false;
+static volatile bool starvationDone = false;
+static volatile uint8_t crcCounter = 0;
+
+// Текущая внесенная неисправность
+static const FaultScenario* activeFault() {
+    if (stage != FAULT_STAGE_INJECTING || activeIndex < 0) {
+        return NULL;
+    }
+    return &scenarios[activeIndex];
+}
+
+// Наиболее серьезная текущая реакция системы безопасности
+static SafetyAction currentOutcome() {
+    if (getSupervisorFault().active) {
+        return SAFETY_ACTION_EMERGENCY;
+    }
+    return getSafetyRuleAction();
+}
+
+// Получение количества сценариев
+int getFaultScenarioCount() {
+    return FAULT_SCENARIO_COUNT;
+}
+
+// Получение сценария
+const FaultScenario& getFaultScenario(int index) {
+    return scenarios[constrain(index, 0, FAULT_SCENARIO_COUNT - 1)];
+}
+
+// Получение результата сценария
+const FaultResult& getFaultResult(int index) {
+    if (index < 0 || index >= FAULT_SCENARIO_COUNT) {
+        return emptyResult;
+    }
+    return results[index];
+}
+
+// Запуск сценария по имени
+bool startFaultScenario(const char* name) {
+    if (stage != FAULT_STAGE_IDLE || requestedIndex >= 0) {
+        return false;
+    }
+
+    if (strcmp(name, "all") == 0) {
+        requestedIndex = FAULT_SCENARIO_COUNT;
+        return true;
+    }
+
+    for (int i = 0; i < FAULT_SCENARIO_COUNT; i++) {
+        if (strcmp(scenarios[i].name, name) == 0) {
+            requestedIndex = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Проверка, выполняется ли сценарий
+bool isFaultInjectionActive() {
+    return stage != FAULT_STAGE_IDLE || requestedIndex >= 0;
+}
+
+// Внесение неисправности сценария
+static void beginScenario(int index) {
+    const FaultScenario& scenario = scenarios[index];
+    FaultResult& result = results[index];
+
+    // Неисправность задачи от предыдущего сценария не должна засчитываться
+    clearSupervisorFault();
+
+    result.done = false;
+    result.passed = false;
+    result.running = (getSafetyMode() != SAFETY_MODE_IDLE);
+    result.expected = result.running ? scenario.expectedRunning : scenario.expectedIdle;
+    result.observed = SAFETY_ACTION_NONE;
+    result.reactionTime = -1;
+
+    spikeDone = false;
+    starvationDone = false;
+    crcCounter = 0;
+
+    activeIndex = index;
+    stageStart = millis();
+    stage = FAULT_STAGE_INJECTING;
+
+    Serial.print("Внесение неисправности: ");
+    Serial.println(scenario.name);
+}
+
+// Завершение сценария и оценка результата
+static void finishScenario() {
+    const FaultScenario& scenario = scenarios[activeIndex];
+    FaultResult& result = results[activeIndex];
+
+    if (result.expected == SAFETY_ACTION_NONE) {
+        result.passed = (result.observed == SAFETY_ACTION_NONE);
+    } else {
+        result.passed = result.reactionTime >= 0 && (unsigned long)result.reactionTime <= scenario.maxReaction;
+    }
+    result.done = true;
+
+    Serial.print("Сценарий ");
+    Serial.print(scenario.name);
+    Serial.print(result.passed ? ": успешно" : ": ОШИБКА");
+    Serial.print(", реакция ");
+    Serial.print(result.observed);
+    Serial.print(" (ожидалась ");
+    Serial.print(result.expected);
+    Serial.print("), время ");
+    Serial.print(result.reactionTime);
+    Serial.println(" мс");
+
+    int next = activeIndex + 1;
+    stage = FAULT_STAGE_IDLE;
+    activeIndex = -1;
+
+    if (runAll && next < FAULT_SCENARIO_COUNT) {
+        beginScenario(next);
+    } else {
+        runAll = false;
+    }
+}
+
+// Обработка сценария
+void updateFaultInjection() {
+    if (stage == FAULT_STAGE_IDLE) {
+        int request = requestedIndex;
+        if (request < 0) {
+            return;
+        }
+        requestedIndex = -1;
+        runAll = (request == FAULT_SCENARIO_COUNT);
+        beginScenario(runAll ? 0 : request);
+        return;
+    }
+
+    const FaultScenario& scenario = scenarios[activeIndex];
+    FaultResult& result = results[activeIndex];
+    unsigned long elapsed = millis() - stageStart;
+
+    // Фиксируем наиболее серьезную реакцию и время до ожидаемой
+    SafetyAction outcome = currentOutcome();
+    if (outcome > result.observed) {
+        result.observed = outcome;
+    }
+    if (result.expected != SAFETY_ACTION_NONE && result.reactionTime < 0 && outcome >= result.expected) {
+        result.reactionTime = elapsed;
+    }
+
+    if (stage == FAULT_STAGE_INJECTING && elapsed >= scenario.duration) {
+        // Снятие неисправности, последствия наблюдаются до конца паузы
+        stage = FAULT_STAGE_OBSERVING;
+    } else if (stage == FAULT_STAGE_OBSERVING && elapsed >= scenario.duration + FAULT_SETTLE_TIME) {
+        finishScenario();
+    }
+}
+
+// Подмена показания датчика температуры
+float injectTemperatureFault(int sensor, float temp) {
+    const FaultScenario* fault = activeFault();
+    if (fault == NULL || fault->sensor != sensor) {
+        return temp;
+    }
+
+    switch (fault->type) {
+        case FAULT_SENSOR_DROPOUT:
+            return -127.0f;
+        case FAULT_SENSOR_STUCK:
+            return fault->value;
+        case FAULT_SENSOR_SPIKE:
+            if (!spikeDone) {
+                spikeDone = true;
+                return fault->value;
+            }
+            return temp;
+        case FAULT_SENSOR_CRC:
+            // Библиотека возвращает -127 при ошибке CRC
+            return (crcCounter++ & 1) ? -127.0f : temp;
+        default:
+            return temp;
+    }
+}
+
+// Подмена показания PZEM
+float injectPzemFault(float value) {
+    const FaultScenario* fault = activeFault();
+    if (fault == NULL || fault->type != FAULT_PZEM_TIMEOUT) {
+        return value;
+    }
+
+    // Библиотека ждет ответ до таймаута и возвращает NAN
+    vTaskDelay(pdMS_TO_TICKS((unsigned long)fault->value));
+    return NAN;
+}
+
+// Задержка задачи при внесенном голодании
+void injectTaskFault(const char* task) {
+    const FaultScenario* fault = activeFault();
+    if (fault == NULL || fault->type != FAULT_TASK_STARVATION || starvationDone) {
+        return;
+    }
+    if (strcmp(fault->task, task) != 0) {
+        return;
+    }
+
+    starvationDone = true;
+    vTaskDelay(pdMS_TO_TICKS((unsigned long)fault->value));
+}
+
+// Получение сдвига шкалы времени системы безопасности
+unsigned long getFaultClockOffset() {
+    const FaultScenario* fault = activeFault();
+    if (fault == NULL || fault->type != FAULT_CLOCK_JUMP) {
+        return 0;
+    }
+    return (unsigned long)fault->value;
+}
+
+#endif // FAULT_INJECTION
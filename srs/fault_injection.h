@@ -0,0 +1,140 @@
+/**
+ * @file fault_injection.h
+ * @brief Внесение неисправностей для проверки контура безопасности
+ *
+ * Модуль собирается только в отладочной сборке с флагом FAULT_INJECTION
+ * (окружение esp32dev_fault в platformio.ini). Сценарии из встроенной
+ * таблицы подменяют показания датчиков (обрыв, залипание, выброс, ошибки
+ * CRC шины 1-Wire), ответы PZEM, задерживают задачи и сдвигают шкалу
+ * времени системы безопасности. Для каждого сценария фиксируется
+ * наиболее серьезная реакция системы безопасности и время от внесения
+ * неисправности до нее, результат сравнивается с ожидаемым.
+ *
+ * Сценарии запускаются на контроллере без процесса или во время
+ * процесса (например, на воде); ожидаемая реакция задана для обоих
+ * случаев.
+ */
+
+#ifndef FAULT_INJECTION_H
+#define FAULT_INJECTION_H
+
+#ifdef FAULT_INJECTION
+
+#include <Arduino.h>
+#include "safety.h"
+
+// Пауза между сценариями при последовательном запуске (мс)
+#define FAULT_SETTLE_TIME 5000
+
+// Типы неисправностей
+enum FaultType {
+    FAULT_NONE = 0,
+    FAULT_SENSOR_DROPOUT,        // Датчик не отвечает (-127)
+    FAULT_SENSOR_STUCK,          // Показание залипло на значении
+    FAULT_SENSOR_SPIKE,          // Одиночный выброс показания
+    FAULT_SENSOR_CRC,            // Ошибки CRC через одно чтение
+    FAULT_PZEM_TIMEOUT,          // PZEM не отвечает (задержка и NAN)
+    FAULT_TASK_STARVATION,       // Задача не получает процессорное время
+    FAULT_CLOCK_JUMP             // Скачок шкалы времени системы безопасности
+};
+
+// Сценарий внесения неисправности
+struct FaultScenario {
+    const char* name;            // Имя сценария
+    FaultType type;              // Тип неисправности
+    int sensor;                  // Датчик (для неисправностей датчиков)
+    const char* task;            // Задача (для FAULT_TASK_STARVATION)
+    float value;                 // Значение (температура, задержка или сдвиг времени в мс)
+    unsigned long duration;      // Длительность неисправности (мс)
+    SafetyAction expectedIdle;   // Ожидаемая реакция без процесса
+    SafetyAction expectedRunning; // Ожидаемая реакция во время процесса
+    unsigned long maxReaction;   // Допустимое время реакции (мс)
+};
+
+// Результат сценария
+struct FaultResult {
+    bool done;                   // Сценарий выполнен
+    bool passed;                 // Реакция совпала с ожидаемой
+    bool running;                // Выполнялся во время процесса
+    SafetyAction expected;       // Ожидаемая реакция
+    SafetyAction observed;       // Наиболее серьезная наблюдаемая реакция
+    long reactionTime;           // Время до ожидаемой реакции (мс, -1 - не было)
+};
+
+/**
+ * @brief Получение количества сценариев
+ *
+ * @return int Количество сценариев в таблице
+ */
+int getFaultScenarioCount();
+
+/**
+ * @brief Получение сценария
+ *
+ * @param index Индекс сценария
+ * @return const FaultScenario& Сценарий
+ */
+const FaultScenario& getFaultScenario(int index);
+
+/**
+ * @brief Получение результата сценария
+ *
+ * @param index Индекс сценария
+ * @return const FaultResult& Результат последнего запуска
+ */
+const FaultResult& getFaultResult(int index);
+
+/**
+ * @brief Запуск сценария по имени
+ *
+ * @param name Имя сценария или "all" для последовательного запуска всех
+ * @return true если сценарий найден и запущен
+ */
+bool startFaultScenario(const char* name);
+
+/**
+ * @brief Проверка, выполняется ли сценарий
+ *
+ * @return true если неисправность внесена или идет пауза между сценариями
+ */
+bool isFaultInjectionActive();
+
+/**
+ * @brief Обработка сценария, вызывается задачей безопасности после проверки правил
+ */
+void updateFaultInjection();
+
+/**
+ * @brief Подмена показания датчика температуры
+ *
+ * @param sensor Индекс датчика
+ * @param temp Показание с учетом калибровки
+ * @return float Показание после внесения неисправности
+ */
+float injectTemperatureFault(int sensor, float temp);
+
+/**
+ * @brief Подмена показания PZEM
+ *
+ * @param value Прочитанное значение
+ * @return float NAN после задержки, если внесен таймаут PZEM
+ */
+float injectPzemFault(float value);
+
+/**
+ * @brief Задержка задачи при внесенном голодании
+ *
+ * @param task Имя задачи (как при регистрации сигнала активности)
+ */
+void injectTaskFault(const char* task);
+
+/**
+ * @brief Получение сдвига шкалы времени системы безопасности
+ *
+ * @return unsigned long Сдвиг (мс)
+ */
+unsigned long getFaultClockOffset();
+
+#endif // FAULT_INJECTION
+
+#endif // FAULT_INJECTION_H
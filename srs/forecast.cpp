@@ -0,0 +1,215 @@
+/**
+ * @file forecast.cpp
+ * @brief Реализация прогноза времени завершения ректификации
+ */
+
+#include "forecast.h"
+#include "settings.h"
+#include "heater.h"
+
+// Текущий прогноз
+static RectificationForecast forecast;
+
+// Состояние измерений
+static unsigned long lastUpdateTime = 0;
+static unsigned long lastEnergyTime = 0;
+static int lastTotalVolume = 0;
+static float lastCubeTemp = 0;
+static float lastRefluxTemp = 0;
+static float refluxTempRate = 0;   // Скорость роста температуры узла отбора (°C/мин)
+static bool ratesValid = false;
+static RectificationPhase ratePhase = RECT_PHASE_IDLE;  // Фаза, в которой измерялась скорость отбора
+
+// Экспоненциальное сглаживание
+static float smooth(float current, float sample) {
+    return current + FORECAST_SMOOTHING * (sample - current);
+}
+
+// Время до достижения температуры при текущей скорости роста (секунды, -1 - нет оценки)
+static long timeToTemp(float current, float target, float ratePerMin) {
+    if (current >= target) {
+        return 0;
+    }
+    if (ratePerMin <= 0.001f) {
+        return -1;
+    }
+    return (long)((target - current) / ratePerMin * 60.0f);
+}
+
+// Время до отбора объема при заданной скорости (секунды, -1 - нет оценки)
+static long timeToVolume(float remainingMl, float rateMlPerHour) {
+    if (remainingMl <= 0) {
+        return 0;
+    }
+    if (rateMlPerHour <= 0.1f) {
+        return -1;
+    }
+    return (long)(remainingMl / rateMlPerHour * 3600.0f);
+}
+
+// Оставшееся время по таймеру фазы (секунды)
+static long timeLeft(long durationSec, long elapsedSec) {
+    return durationSec > elapsedSec ? durationSec - elapsedSec : 0;
+}
+
+// Плановая скорость отбора тела с учетом доли отбора в цикле орошения (мл/ч)
+static float plannedBodyRate() {
+    const RectificationSettings& rs = sysSettings.rectificationSettings;
+    return rs.bodyFlowRate / (rs.refluxRatio + 1.0f);
+}
+
+// Плановая скорость отбора голов: соотношение скоростей насоса не зависит от единиц
+static float plannedHeadsRate() {
+    if (sysSettings.pumpSettings.bodyFlowRate <= 0) {
+        return 0;
+    }
+    return plannedBodyRate() * sysSettings.pumpSettings.headsFlowRate / sysSettings.pumpSettings.bodyFlowRate;
+}
+
+// Оценка оставшегося времени фазы
+static long estimatePhase(RectificationPhase phase, bool current) {
+    const RectificationSettings& rs = sysSettings.rectificationSettings;
+    long elapsed = current ? (long)getRectificationPhaseTime() : 0;
+    float cubeTemp = getRectificationCubeTemp();
+    bool classic = (rs.model == 0);
+
+    switch (phase) {
+        case RECT_PHASE_HEATING:
+            // Нагрев заканчивается, когда пар доходит до узла отбора
+            return current ? timeToTemp(getRectificationRefluxTemp(), rs.headsTemp, refluxTempRate) : 0;
+
+        case RECT_PHASE_STABILIZATION:
+            // Оценка по верхней границе, автоопределение может завершить фазу раньше
+            return timeLeft((long)rs.stabilizationTime * 60, elapsed);
+
+        case RECT_PHASE_HEADS:
+            if (!classic) {
+                return timeLeft((long)rs.headsTargetTime * 60, elapsed);
+            }
+            if (current && ratesValid && forecast.extractionRate > 0) {
+                return timeToVolume(rs.headsVolume - getRectificationHeadsVolume(), forecast.extractionRate);
+            }
+            return timeToVolume(rs.headsVolume - (current ? getRectificationHeadsVolume() : 0), plannedHeadsRate());
+
+        case RECT_PHASE_POST_HEADS_STAB:
+            return classic ? 0 : timeLeft((long)rs.postHeadsStabilizationTime * 60, elapsed);
+
+        case RECT_PHASE_BODY:
+            if (!classic) {
+                // Альтернативная модель: тело до температуры куба для перехода к хвостам
+                return current ? timeToTemp(cubeTemp, rs.tailsCubeTemp, forecast.cubeTempRate) : -1;
+            }
+            if (current && ratesValid && forecast.extractionRate > 0) {
+                return timeToVolume(rs.bodyVolume - getRectificationBodyVolume(), forecast.extractionRate);
+            }
+            return timeToVolume(rs.bodyVolume - (current ? getRectificationBodyVolume() : 0), plannedBodyRate());
+
+        case RECT_PHASE_TAILS:
+            if (current) {
+                return timeToTemp(cubeTemp, rs.endTemp, forecast.cubeTempRate);
+            }
+            return classic ? -1 : timeToTemp(rs.tailsCubeTemp, rs.endTemp, forecast.cubeTempRate);
+
+        default:
+            return 0;
+    }
+}
+
+// Пересчет оставшегося времени по фазам
+static void estimateRemaining() {
+    RectificationPhase currentPhase = getRectificationPhase();
+
+    forecast.totalRemaining = 0;
+    forecast.totalComplete = true;
+
+    for (int i = 0; i < FORECAST_PHASE_COUNT; i++) {
+        RectificationPhase phase = (RectificationPhase)i;
+        bool active = (phase >= RECT_PHASE_HEATING && phase <= RECT_PHASE_TAILS && phase >= currentPhase);
+
+        if (!active) {
+            forecast.phaseRemaining[i] = 0;
+            continue;
+        }
+
+        long remaining = estimatePhase(phase, phase == currentPhase);
+        forecast.phaseRemaining[i] = remaining;
+
+        if (remaining < 0) {
+            forecast.totalComplete = false;
+        } else {
+            forecast.totalRemaining += remaining;
+        }
+    }
+}
+
+// Сброс прогноза перед запуском процесса
+void resetForecast() {
+    memset(&forecast, 0, sizeof(forecast));
+    lastUpdateTime = millis();
+    lastEnergyTime = lastUpdateTime;
+    lastTotalVolume = 0;
+    lastCubeTemp = getRectificationCubeTemp();
+    lastRefluxTemp = getRectificationRefluxTemp();
+    refluxTempRate = 0;
+    ratesValid = false;
+    ratePhase = RECT_PHASE_IDLE;
+}
+
+// Обновление прогноза
+void updateForecast() {
+    unsigned long now = millis();
+
+    // Интегрируем энергию нагревателя при каждом вызове
+    // (длинный интервал означает паузу процесса, нагреватель в это время выключен)
+    unsigned long energyDt = now - lastEnergyTime;
+    if (energyDt < FORECAST_UPDATE_INTERVAL) {
+        forecast.energyWh += getHeaterPowerWatts() * (float)energyDt / 3600000.0f;
+    }
+    lastEnergyTime = now;
+
+    unsigned long dt = now - lastUpdateTime;
+    if (dt < FORECAST_UPDATE_INTERVAL) {
+        return;
+    }
+    lastUpdateTime = now;
+
+    // Скорость отбора по приросту общего объема (мл/ч)
+    int totalVolume = getRectificationTotalVolume();
+    float rate = (totalVolume - lastTotalVolume) * 3600000.0f / dt;
+    lastTotalVolume = totalVolume;
+
+    // Скорости роста температур (°C/мин)
+    float cubeTemp = getRectificationCubeTemp();
+    float refluxTemp = getRectificationRefluxTemp();
+    float cubeRate = (cubeTemp - lastCubeTemp) * 60000.0f / dt;
+    float refluxRate = (refluxTemp - lastRefluxTemp) * 60000.0f / dt;
+    lastCubeTemp = cubeTemp;
+    lastRefluxTemp = refluxTemp;
+
+    // Скорость отбора в новой фазе измеряется заново
+    RectificationPhase phase = getRectificationPhase();
+    if (ratesValid && phase == ratePhase) {
+        forecast.extractionRate = smooth(forecast.extractionRate, rate);
+    } else {
+        forecast.extractionRate = rate;
+        ratePhase = phase;
+    }
+
+    if (ratesValid) {
+        forecast.cubeTempRate = smooth(forecast.cubeTempRate, cubeRate);
+        refluxTempRate = smooth(refluxTempRate, refluxRate);
+    } else {
+        forecast.cubeTempRate = cubeRate;
+        refluxTempRate = refluxRate;
+        ratesValid = true;
+    }
+
+    forecast.energyPerMl = totalVolume > 0 ? forecast.energyWh / totalVolume : 0.0f;
+
+    estimateRemaining();
+}
+
+// Получение текущего прогноза
+const RectificationForecast& getRectificationForecast() {
+    return forecast;
+}
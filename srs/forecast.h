@@ -0,0 +1,58 @@
+/**
+ * @file forecast.h
+ * @brief Прогноз времени завершения и производительности ректификации
+ *
+ * Модуль в ходе процесса оценивает оставшееся время по фазам и общее
+ * время до завершения, исходя из измеренной скорости отбора, оставшихся
+ * целевых объемов и скорости роста температуры куба. Дополнительно
+ * рассчитывается фактическая производительность (мл/ч) и удельный расход
+ * энергии нагревателя (Вт·ч/мл).
+ */
+
+#ifndef FORECAST_H
+#define FORECAST_H
+
+#include <Arduino.h>
+#include "rectification.h"
+
+// Интервал обновления прогноза (мс)
+#define FORECAST_UPDATE_INTERVAL 10000
+
+// Коэффициент экспоненциального сглаживания измеренных скоростей
+#define FORECAST_SMOOTHING 0.2f
+
+// Количество фаз ректификации
+#define FORECAST_PHASE_COUNT (RECT_PHASE_ERROR + 1)
+
+// Результат прогноза
+struct RectificationForecast {
+    long phaseRemaining[FORECAST_PHASE_COUNT];  // Оставшееся время по фазам (секунды, -1 - нет оценки)
+    long totalRemaining;       // Оставшееся время до завершения (секунды, сумма оцененных фаз)
+    bool totalComplete;        // Все предстоящие фазы удалось оценить
+    float extractionRate;      // Фактическая скорость отбора (мл/ч)
+    float energyWh;            // Энергия, затраченная нагревателем (Вт·ч)
+    float energyPerMl;         // Удельный расход энергии (Вт·ч/мл, 0 - нет отбора)
+    float cubeTempRate;        // Скорость роста температуры куба (°C/мин)
+};
+
+/**
+ * @brief Сброс прогноза перед запуском процесса
+ */
+void resetForecast();
+
+/**
+ * @brief Обновление прогноза, вызывается в цикле обработки ректификации
+ *
+ * Энергия интегрируется при каждом вызове, остальные оценки
+ * пересчитываются раз в FORECAST_UPDATE_INTERVAL.
+ */
+void updateForecast();
+
+/**
+ * @brief Получение текущего прогноза
+ *
+ * @return const RectificationForecast& Последний рассчитанный прогноз
+ */
+const RectificationForecast& getRectificationForecast();
+
+#endif // FORECAST_H
@@ -0,0 +1,70 @@
+/**
+ * @file fs_gate.cpp
+ * @brief Реализация общего доступа к файлам LittleFS
+ */
+
+#include "fs_gate.h"
+#include <atomic>
+
+// Начатые обращения к файлам и признак закрытого доступа
+static std::atomic<int> fileUsers(0);
+static std::atomic<bool> fileAccessClosed(false);
+// Задача, ожидающая в closeFileAccess() окончания обращений
+static std::atomic<TaskHandle_t> fileAccessWaiter(nullptr);
+
+// Начало обращения к файлам
+bool beginFileAccess() {
+    // Счетчик увеличивается до проверки, поэтому closeFileAccess() не
+    // пропустит обращение, начатое одновременно с закрытием
+    fileUsers++;
+    if (fileAccessClosed.load()) {
+        endFileAccess();
+        return false;
+    }
+    return true;
+}
+
+// Конец обращения к файлам; последнее обращение будит ожидающую задачу
+void endFileAccess() {
+    if (--fileUsers == 0) {
+        TaskHandle_t waiter = fileAccessWaiter.load();
+        if (waiter != nullptr) {
+            xTaskNotifyGive(waiter);
+        }
+    }
+}
+
+// Закрытие доступа к файлам с ожиданием начатых обращений
+bool closeFileAccess(uint32_t timeoutMs) {
+    fileAccessWaiter = xTaskGetCurrentTaskHandle();
+    fileAccessClosed = true;
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeoutMs);
+    bool idle = true;
+    while (fileUsers.load() > 0) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            idle = false;
+            break;
+        }
+        ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+    }
+    fileAccessWaiter = nullptr;
+
+    if (!idle) {
+        fileAccessClosed = false;
+        Serial.println("Обращения к файловой системе не завершились, доступ не закрыт");
+    }
+    return idle;
+}
+
+// Открытие доступа к файлам
+void openFileAccess() {
+    fileAccessClosed = false;
+}
+
+// Признак закрытого доступа к файлам
+bool isFileAccessClosed() {
+    return fileAccessClosed.load();
+}
@@ -0,0 +1,48 @@
+/**
+ * @file fs_gate.h
+ * @brief Общий доступ к файлам LittleFS
+ *
+ * Каждое обращение к файлам (открытие, запись, закрытие) выполняется между
+ * beginFileAccess() и endFileAccess(). На время записи образа файловой
+ * системы (ota.h) доступ закрывается: новые обращения отказываются,
+ * начатые дожидаются.
+ */
+
+#ifndef FS_GATE_H
+#define FS_GATE_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Начало обращения к файлам
+ * @return false, если доступ закрыт
+ */
+bool beginFileAccess();
+
+/**
+ * @brief Конец обращения к файлам
+ */
+void endFileAccess();
+
+/**
+ * @brief Закрытие доступа к файлам
+ *
+ * Ждет окончания начатых обращений не дольше timeoutMs; если они не
+ * закончились, доступ снова открывается.
+ *
+ * @param timeoutMs Время ожидания (мс)
+ * @return true, если доступ закрыт
+ */
+bool closeFileAccess(uint32_t timeoutMs);
+
+/**
+ * @brief Открытие доступа к файлам
+ */
+void openFileAccess();
+
+/**
+ * @brief Признак закрытого доступа к файлам
+ */
+bool isFileAccessClosed();
+
+#endif // FS_GATE_H
@@ -2,6 +2,7 @@
 #include "power_control.h"
 #include "utils.h"
 #include "temp_sensors.h"
+#include "safety.h"
 
 // Статус нагревателя
 static bool heaterEnabled = false;
@@ -47,6 +48,12 @@ void setHeaterPower(int powerPercent) {
     // Ограничиваем значение в диапазоне 0-100%
     powerPercent = constrain(powerPercent, 0, 100);
     
+    // При зафиксированной остановке нагреватель не включается
+    if (powerPercent > 0 && getSafetyRuleAction() >= SAFETY_ACTION_STOP) {
+        Serial.println("Нагреватель заблокирован аварийной остановкой");
+        powerPercent = 0;
+    }
+    
     if (powerPercent == 0) {
         disableHeater();
     } else {
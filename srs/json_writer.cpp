@@ -0,0 +1,303 @@
+/**
+ * @file json_writer.cpp
+ * @brief Реализация потоковой записи JSON
+ */
+
+#include "json_writer.h"
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+#include <math.h>
+#include <stdarg.h>
+
+// Пул буферов; занятость отмечается атомарно, так как статус пишут
+// и задача веб-сервера, и задача управления
+static char jsonBuffers[JSON_BUFFER_COUNT][JSON_BUFFER_SIZE];
+static std::atomic<bool> jsonBufferUsed[JSON_BUFFER_COUNT];
+static std::atomic<uint8_t> jsonBuffersInUse(0);
+static uint8_t jsonBuffersMaxInUse = 0;
+static std::atomic<uint32_t> jsonPoolExhausted(0);
+static std::atomic<uint32_t> jsonOverflows(0);
+
+// Захват свободного буфера
+static char* acquireJsonBuffer() {
+    for (int i = 0; i < JSON_BUFFER_COUNT; i++) {
+        bool expected = false;
+        if (jsonBufferUsed[i].compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            uint8_t inUse = jsonBuffersInUse.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (inUse > jsonBuffersMaxInUse) {
+                jsonBuffersMaxInUse = inUse;
+            }
+            return jsonBuffers[i];
+        }
+    }
+    jsonPoolExhausted.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+// Возврат буфера в пул
+static void releaseJsonBuffer(char* buffer) {
+    if (buffer == nullptr) {
+        return;
+    }
+    int index = (buffer - jsonBuffers[0]) / JSON_BUFFER_SIZE;
+    jsonBuffersInUse.fetch_sub(1, std::memory_order_relaxed);
+    jsonBufferUsed[index].store(false, std::memory_order_release);
+}
+
+// Ответ, отдающий данные из буфера пула; буфер возвращается при удалении ответа
+class PooledJsonResponse : public AsyncAbstractResponse {
+public:
+    PooledJsonResponse(int code, char* buffer, size_t length) : _buffer(buffer), _offset(0) {
+        _code = code;
+        _contentLength = length;
+        _contentType = "application/json";
+    }
+
+    ~PooledJsonResponse() {
+        releaseJsonBuffer(_buffer);
+    }
+
+    bool _sourceValid() const override {
+        return _buffer != nullptr;
+    }
+
+    size_t _fillBuffer(uint8_t* data, size_t len) override {
+        size_t remaining = _contentLength - _offset;
+        size_t count = len < remaining ? len : remaining;
+        memcpy(data, _buffer + _offset, count);
+        _offset += count;
+        return count;
+    }
+
+private:
+    char* _buffer;
+    size_t _offset;
+};
+
+JsonWriter::JsonWriter(char* buffer, size_t capacity)
+    : buffer_(buffer), capacity_(capacity), length_(0), hasElements_(0), depth_(0), keyWritten_(false), overflow_(false) {
+    if (buffer_ != nullptr && capacity_ > 0) {
+        buffer_[0] = '\0';
+    }
+}
+
+// Запись одного символа; последний байт буфера оставлен под завершающий ноль
+void JsonWriter::write(char c) {
+    if (length_ + 1 >= capacity_) {
+        overflow_ = true;
+        return;
+    }
+    buffer_[length_++] = c;
+    buffer_[length_] = '\0';
+}
+
+void JsonWriter::write(const char* data, size_t length) {
+    if (length_ + length >= capacity_) {
+        overflow_ = true;
+        return;
+    }
+    memcpy(buffer_ + length_, data, length);
+    length_ += length;
+    buffer_[length_] = '\0';
+}
+
+// Строка в кавычках с экранированием; UTF-8 передается как есть
+void JsonWriter::writeString(const char* value) {
+    write('"');
+    for (const char* p = value; *p; p++) {
+        char c = *p;
+        switch (c) {
+            case '"':  write("\\\"", 2); break;
+            case '\\': write("\\\\", 2); break;
+            case '\n': write("\\n", 2); break;
+            case '\r': write("\\r", 2); break;
+            case '\t': write("\\t", 2); break;
+            default:
+                if ((uint8_t)c < 0x20) {
+                    char escaped[7];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", (uint8_t)c);
+                    write(escaped, 6);
+                } else {
+                    write(c);
+                }
+                break;
+        }
+    }
+    write('"');
+}
+
+void JsonWriter::writeNumber(const char* format, ...) {
+    char number[24];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(number, sizeof(number), format, args);
+    va_end(args);
+    if (length > 0) {
+        write(number, (size_t)length < sizeof(number) ? length : sizeof(number) - 1);
+    }
+}
+
+// Разделитель и ключ перед элементом
+void JsonWriter::prefix(const char* key) {
+    if (keyWritten_) {
+        keyWritten_ = false;
+        return;
+    }
+    uint32_t bit = 1UL << depth_;
+    if (hasElements_ & bit) {
+        write(',');
+    }
+    hasElements_ |= bit;
+    if (key != nullptr) {
+        writeString(key);
+        write(':');
+    }
+}
+
+void JsonWriter::key(const char* key) {
+    prefix(key);
+    keyWritten_ = true;
+}
+
+JsonWriterMark JsonWriter::mark() const {
+    JsonWriterMark mark;
+    mark.length = length_;
+    mark.hasElements = hasElements_;
+    mark.depth = depth_;
+    mark.keyWritten = keyWritten_;
+    return mark;
+}
+
+void JsonWriter::rewind(const JsonWriterMark& mark) {
+    if (buffer_ == nullptr) {
+        return;
+    }
+    length_ = mark.length;
+    buffer_[length_] = '\0';
+    hasElements_ = mark.hasElements;
+    depth_ = mark.depth;
+    keyWritten_ = mark.keyWritten;
+    overflow_ = false;
+}
+
+void JsonWriter::beginObject(const char* key) {
+    prefix(key);
+    write('{');
+    if (depth_ < 31) {
+        depth_++;
+    } else {
+        overflow_ = true;
+    }
+    hasElements_ &= ~(1UL << depth_);
+}
+
+void JsonWriter::endObject() {
+    if (depth_ > 0) {
+        depth_--;
+    }
+    write('}');
+}
+
+void JsonWriter::beginArray(const char* key) {
+    prefix(key);
+    write('[');
+    if (depth_ < 31) {
+        depth_++;
+    } else {
+        overflow_ = true;
+    }
+    hasElements_ &= ~(1UL << depth_);
+}
+
+void JsonWriter::endArray() {
+    if (depth_ > 0) {
+        depth_--;
+    }
+    write(']');
+}
+
+void JsonWriter::add(const char* key, const char* value) {
+    prefix(key);
+    if (value == nullptr) {
+        write("null", 4);
+    } else {
+        writeString(value);
+    }
+}
+
+void JsonWriter::add(const char* key, bool value) {
+    prefix(key);
+    if (value) {
+        write("true", 4);
+    } else {
+        write("false", 5);
+    }
+}
+
+void JsonWriter::add(const char* key, int value) {
+    prefix(key);
+    writeNumber("%d", value);
+}
+
+void JsonWriter::add(const char* key, long value) {
+    prefix(key);
+    writeNumber("%ld", value);
+}
+
+void JsonWriter::add(const char* key, unsigned int value) {
+    prefix(key);
+    writeNumber("%u", value);
+}
+
+void JsonWriter::add(const char* key, unsigned long value) {
+    prefix(key);
+    writeNumber("%lu", value);
+}
+
+// NaN и бесконечность в JSON не представимы и записываются как null
+void JsonWriter::add(const char* key, float value) {
+    prefix(key);
+    if (isnan(value) || isinf(value)) {
+        write("null", 4);
+    } else {
+        writeNumber("%.7g", (double)value);
+    }
+}
+
+PooledJsonWriter::PooledJsonWriter() : JsonWriter(acquireJsonBuffer(), JSON_BUFFER_SIZE) {
+    if (buffer_ == nullptr) {
+        capacity_ = 0;
+    }
+}
+
+PooledJsonWriter::~PooledJsonWriter() {
+    releaseJsonBuffer(buffer_);
+}
+
+void PooledJsonWriter::send(AsyncWebServerRequest* request, int code) {
+    if (buffer_ == nullptr) {
+        request->send(503, "application/json", "{\"error\":\"Нет свободного буфера ответа\"}");
+        return;
+    }
+    if (!ok()) {
+        jsonOverflows.fetch_add(1, std::memory_order_relaxed);
+        Serial.print("Ответ JSON не помещается в буфер: ");
+        Serial.println(request->url());
+        request->send(500, "application/json", "{\"error\":\"Ответ не помещается в буфер\"}");
+        return;
+    }
+
+    // Буфер переходит к ответу и вернется в пул после его отправки
+    request->send(new PooledJsonResponse(code, buffer_, length_));
+    buffer_ = nullptr;
+}
+
+// Получение статистики пула буферов JSON
+JsonPoolStats getJsonPoolStats() {
+    JsonPoolStats stats;
+    stats.inUse = jsonBuffersInUse.load(std::memory_order_relaxed);
+    stats.maxInUse = jsonBuffersMaxInUse;
+    stats.exhausted = jsonPoolExhausted.load(std::memory_order_relaxed);
+    stats.overflows = jsonOverflows.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file json_writer.h
+ * @brief Потоковая запись JSON в буферы из пула
+ *
+ * Частые ответы (статус, настройки) формируются без промежуточного
+ * документа ArduinoJson и без String: JSON пишется сразу в буфер
+ * фиксированного размера, взятый из заранее выделенного пула. Буфер
+ * передается ответу веб-сервера и возвращается в пул после отправки,
+ * поэтому обработчик не выделяет память в куче.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+class AsyncWebServerRequest;
+
+// Позиция записи для отката (см. JsonWriter::rewind)
+struct JsonWriterMark {
+    size_t length;
+    uint32_t hasElements;
+    uint8_t depth;
+    bool keyWritten;
+};
+
+/**
+ * @brief Запись JSON в буфер фиксированного размера
+ *
+ * Запятые между элементами расставляются автоматически. При нехватке места
+ * запись прекращается и устанавливается признак переполнения. Ключ
+ * передается для элементов объекта и равен nullptr для элементов массива.
+ */
+class JsonWriter {
+public:
+    JsonWriter(char* buffer, size_t capacity);
+
+    void beginObject(const char* key = nullptr);
+    void endObject();
+    void beginArray(const char* key = nullptr);
+    void endArray();
+
+    /**
+     * @brief Запись ключа, значение которого запишет следующий вызов
+     *
+     * Позволяет передать запись функции, которая пишет значение без ключа.
+     */
+    void key(const char* key);
+
+    void add(const char* key, const char* value);
+    void add(const char* key, bool value);
+    void add(const char* key, int value);
+    void add(const char* key, long value);
+    void add(const char* key, unsigned int value);
+    void add(const char* key, unsigned long value);
+    void add(const char* key, float value);
+    void add(const char* key, double value) { add(key, (float)value); }
+
+    /**
+     * @brief Запись значения без ключа (элемент массива)
+     */
+    template<typename T>
+    void add(T value) { add((const char*)nullptr, value); }
+
+    const char* c_str() const { return buffer_; }
+    size_t length() const { return length_; }
+
+    /**
+     * @brief Признак того, что JSON полностью поместился в буфер
+     */
+    bool ok() const { return buffer_ != nullptr && !overflow_ && depth_ == 0; }
+
+    /**
+     * @brief Признак нехватки места в буфере
+     */
+    bool overflowed() const { return overflow_; }
+
+    /**
+     * @brief Текущая позиция записи
+     */
+    JsonWriterMark mark() const;
+
+    /**
+     * @brief Откат к сохраненной позиции
+     *
+     * Отбрасывает все записанное после mark(), в том числе при переполнении,
+     * чтобы вместо неудавшегося значения можно было записать ошибку.
+     */
+    void rewind(const JsonWriterMark& mark);
+
+protected:
+    char* buffer_;
+    size_t capacity_;
+    size_t length_;
+
+private:
+    void prefix(const char* key);
+    void write(char c);
+    void write(const char* data, size_t length);
+    void writeString(const char* value);
+    void writeNumber(const char* format, ...);
+
+    uint32_t hasElements_;      // Бит на уровень вложенности: уже есть элементы
+    uint8_t depth_;
+    bool keyWritten_;           // Ключ записан методом key(), ждет значения
+    bool overflow_;
+};
+
+/**
+ * @brief Запись JSON в буфер из пула
+ *
+ * Буфер берется из пула в конструкторе и возвращается в деструкторе, если
+ * не был передан ответу методом send(). Если свободных буферов нет,
+ * запись не выполняется, а send() отвечает 503.
+ */
+class PooledJsonWriter : public JsonWriter {
+public:
+    PooledJsonWriter();
+    ~PooledJsonWriter();
+
+    PooledJsonWriter(const PooledJsonWriter&) = delete;
+    PooledJsonWriter& operator=(const PooledJsonWriter&) = delete;
+
+    /**
+     * @brief Отправка JSON в ответ на запрос
+     *
+     * Буфер передается ответу без копирования и возвращается в пул после
+     * отправки. При переполнении отправляется ошибка 500.
+     *
+     * @param request HTTP запрос
+     * @param code Код ответа
+     */
+    void send(AsyncWebServerRequest* request, int code = 200);
+};
+
+/**
+ * @brief Статистика пула буферов JSON
+ */
+struct JsonPoolStats {
+    uint8_t inUse;              // Буферов занято сейчас
+    uint8_t maxInUse;           // Максимум одновременно занятых буферов
+    uint32_t exhausted;         // Запросов, не получивших буфер
+    uint32_t overflows;         // Ответов, не поместившихся в буфер
+};
+
+/**
+ * @brief Получение статистики пула буферов JSON
+ */
+JsonPoolStats getJsonPoolStats();
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,213 @@
+/**
+ * @file metrics.cpp
+ * @brief Реализация страницы метрик Prometheus
+ */
+
+#include "metrics.h"
+#include "settings.h"
+#include "temp_sensors.h"
+#include "heater.h"
+#include "power_control.h"
+#include "pump.h"
+#include "rectification.h"
+#include "distillation.h"
+#include "safety.h"
+#include "supervisor.h"
+#include "ws_broadcast.h"
+#include <stdarg.h>
+#include <math.h>
+
+// Запись текста в буфер; при нехватке места запись прекращается
+struct MetricsOutput {
+    char* buffer;
+    size_t size;
+    size_t length;
+    bool overflow;
+};
+
+static void append(MetricsOutput& out, const char* format, ...) {
+    if (out.overflow) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(out.buffer + out.length, out.size - out.length, format, args);
+    va_end(args);
+    if (written < 0 || (size_t)written >= out.size - out.length) {
+        out.overflow = true;
+        return;
+    }
+    out.length += written;
+}
+
+// Описание метрики: # HELP и # TYPE
+static void family(MetricsOutput& out, const char* name, const char* type, const char* help) {
+    append(out, "# HELP drivevision_%s %s\n# TYPE drivevision_%s %s\n", name, help, name, type);
+}
+
+// Счетчики выводятся целыми без потери разрядов, показания float - с точностью float
+static const char* valueFormat(double value) {
+    return (value == floor(value) && fabs(value) < 1e15) ? "%.0f" : "%.7g";
+}
+
+// Значение без меток
+static void sample(MetricsOutput& out, const char* name, double value) {
+    append(out, "drivevision_%s ", name);
+    append(out, valueFormat(value), value);
+    append(out, "\n");
+}
+
+// Значение с одной меткой (значения меток - имена из таблиц прошивки, без кавычек)
+static void sample(MetricsOutput& out, const char* name, const char* label, const char* labelValue, double value) {
+    append(out, "drivevision_%s{%s=\"%s\"} ", name, label, labelValue);
+    append(out, valueFormat(value), value);
+    append(out, "\n");
+}
+
+// Показания процесса
+static void writeProcessMetrics(MetricsOutput& out) {
+    family(out, "temperature_celsius", "gauge", "Температура датчика (только подключенные датчики)");
+    for (int i = 0; i < MAX_TEMP_SENSORS; i++) {
+        if (sysSettings.tempSensorEnabled[i] && isSensorConnected(i)) {
+            sample(out, "temperature_celsius", "sensor", getTempSensorName(i), getTemperature(i));
+        }
+    }
+    family(out, "sensor_connected", "gauge", "Датчик включен в настройках и отвечает (1/0)");
+    for (int i = 0; i < MAX_TEMP_SENSORS; i++) {
+        sample(out, "sensor_connected", "sensor", getTempSensorName(i),
+               sysSettings.tempSensorEnabled[i] && isSensorConnected(i) ? 1 : 0);
+    }
+
+    family(out, "heater_power_watts", "gauge", "Заданная мощность нагревателя (Вт)");
+    sample(out, "heater_power_watts", getHeaterPowerWatts());
+    family(out, "heater_power_percent", "gauge", "Заданная мощность нагревателя (%)");
+    sample(out, "heater_power_percent", getHeaterPowerPercent());
+    family(out, "heater_enabled", "gauge", "Нагреватель включен (1/0)");
+    sample(out, "heater_enabled", isHeaterEnabled() ? 1 : 0);
+
+    if (sysSettings.pzemEnabled) {
+        family(out, "pzem_voltage_volts", "gauge", "Напряжение сети по PZEM-004T (В)");
+        sample(out, "pzem_voltage_volts", getPzemVoltage());
+        family(out, "pzem_current_amperes", "gauge", "Ток по PZEM-004T (А)");
+        sample(out, "pzem_current_amperes", getPzemCurrent());
+        family(out, "pzem_power_watts", "gauge", "Активная мощность по PZEM-004T (Вт)");
+        sample(out, "pzem_power_watts", getPzemPowerWatts());
+        family(out, "pzem_energy_kwh_total", "counter", "Энергия по счетчику PZEM-004T (кВт*ч)");
+        sample(out, "pzem_energy_kwh_total", getPzemEnergy());
+    }
+
+    family(out, "pump_flow_ml_per_hour", "gauge", "Скорость насоса отбора (мл/ч)");
+    sample(out, "pump_flow_ml_per_hour", isPumpEnabled() ? getCurrentFlowRate() : 0.0);
+
+    family(out, "process_running", "gauge", "Процесс запущен (1/0)");
+    sample(out, "process_running", "process", "rectification", isRectificationRunning() ? 1 : 0);
+    sample(out, "process_running", "process", "distillation", isDistillationRunning() ? 1 : 0);
+    family(out, "process_phase", "gauge",
+           "Фаза процесса (RectificationPhase: 0 ожидание .. 5 тело, 6 хвосты; DistillationPhase: 0 ожидание .. 2 отбор)");
+    sample(out, "process_phase", "process", "rectification", getRectificationPhase());
+    sample(out, "process_phase", "process", "distillation", getDistillationPhase());
+
+    family(out, "rectification_volume_ml", "gauge", "Отобрано при ректификации (мл)");
+    sample(out, "rectification_volume_ml", "fraction", "heads", getRectificationHeadsVolume());
+    sample(out, "rectification_volume_ml", "fraction", "body", getRectificationBodyVolume());
+    sample(out, "rectification_volume_ml", "fraction", "tails", getRectificationTailsVolume());
+    family(out, "distillation_volume_ml", "gauge", "Отобрано при дистилляции (мл)");
+    sample(out, "distillation_volume_ml", "fraction", "heads", getDistillationHeadsVolume());
+    sample(out, "distillation_volume_ml", "fraction", "product", getDistillationProductVolume());
+
+    const SafetyRuleStats& safety = getSafetyRuleStats();
+    family(out, "safety_error_code", "gauge", "Код последней ошибки безопасности (0 - нет ошибок)");
+    sample(out, "safety_error_code", getSafetyErrorCode());
+    family(out, "safety_rule_action", "gauge", "Реакция сработавших правил (0 нет, 1 предупреждение, 2 остановка, 3 авария)");
+    sample(out, "safety_rule_action", getSafetyRuleAction());
+    family(out, "safety_trips_total", "counter", "Срабатывания защиты с отключением выходов");
+    sample(out, "safety_trips_total", safety.trips);
+    family(out, "safety_check_latency_max_seconds", "gauge", "Наибольшая задержка от снимка датчиков до конца проверки");
+    sample(out, "safety_check_latency_max_seconds", safety.maxLatencyMicros / 1e6);
+}
+
+// Внутренние счетчики
+static void writeInternalMetrics(MetricsOutput& out) {
+    int taskCount = getHeartbeatCount();
+    family(out, "task_period_seconds", "gauge", "Последний период цикла задачи");
+    for (int i = 0; i < taskCount; i++) {
+        const HeartbeatStats& hb = getHeartbeatStats(i);
+        sample(out, "task_period_seconds", "task", hb.name, hb.lastPeriod / 1000.0);
+    }
+    family(out, "task_period_avg_seconds", "gauge", "Средний период цикла задачи (сглаженный)");
+    for (int i = 0; i < taskCount; i++) {
+        const HeartbeatStats& hb = getHeartbeatStats(i);
+        sample(out, "task_period_avg_seconds", "task", hb.name, hb.avgPeriod / 1000.0);
+    }
+    family(out, "task_period_max_seconds", "gauge", "Наибольший период цикла задачи");
+    for (int i = 0; i < taskCount; i++) {
+        const HeartbeatStats& hb = getHeartbeatStats(i);
+        sample(out, "task_period_max_seconds", "task", hb.name, hb.maxPeriod / 1000.0);
+    }
+    family(out, "task_loops_total", "counter", "Циклы задачи");
+    for (int i = 0; i < taskCount; i++) {
+        const HeartbeatStats& hb = getHeartbeatStats(i);
+        sample(out, "task_loops_total", "task", hb.name, hb.beats);
+    }
+    family(out, "task_overruns_total", "counter", "Циклы задачи длиннее двух ожидаемых периодов");
+    for (int i = 0; i < taskCount; i++) {
+        const HeartbeatStats& hb = getHeartbeatStats(i);
+        sample(out, "task_overruns_total", "task", hb.name, hb.overruns);
+    }
+    family(out, "task_timeouts_total", "counter", "Пропуски таймаута сигнала активности");
+    for (int i = 0; i < taskCount; i++) {
+        const HeartbeatStats& hb = getHeartbeatStats(i);
+        sample(out, "task_timeouts_total", "task", hb.name, hb.misses);
+    }
+
+    const TempSensorStats& sensors = getTempSensorStats();
+    family(out, "sensor_reads_total", "counter", "Опросы датчиков температуры");
+    sample(out, "sensor_reads_total", sensors.reads);
+    family(out, "sensor_read_seconds", "gauge", "Длительность последнего опроса датчиков");
+    sample(out, "sensor_read_seconds", sensors.lastReadMicros / 1e6);
+    family(out, "sensor_read_max_seconds", "gauge", "Наибольшая длительность опроса датчиков");
+    sample(out, "sensor_read_max_seconds", sensors.maxReadMicros / 1e6);
+    family(out, "sensor_read_errors_total", "counter", "Ошибочные чтения датчика (CRC 1-Wire, нет ответа, вне диапазона)");
+    for (int i = 0; i < MAX_TEMP_SENSORS; i++) {
+        sample(out, "sensor_read_errors_total", "sensor", getTempSensorName(i), sensors.readErrors[i]);
+    }
+
+    family(out, "heap_free_bytes", "gauge", "Свободная память");
+    sample(out, "heap_free_bytes", ESP.getFreeHeap());
+    family(out, "heap_min_free_bytes", "gauge", "Минимум свободной памяти с момента запуска");
+    sample(out, "heap_min_free_bytes", ESP.getMinFreeHeap());
+    family(out, "heap_largest_free_block_bytes", "gauge", "Наибольший свободный блок памяти");
+    sample(out, "heap_largest_free_block_bytes", ESP.getMaxAllocHeap());
+    family(out, "uptime_seconds", "gauge", "Время работы контроллера");
+    sample(out, "uptime_seconds", millis() / 1000);
+
+    WsBroadcastStats ws = getWsBroadcastStats();
+    family(out, "websocket_clients", "gauge", "Подключенные клиенты WebSocket");
+    sample(out, "websocket_clients", ws.clients);
+    family(out, "websocket_queue_bytes", "gauge", "Оценка неотправленных данных WebSocket, сумма по клиентам");
+    sample(out, "websocket_queue_bytes", ws.queuedBytes);
+    family(out, "websocket_queue_max_bytes", "gauge", "Оценка неотправленных данных самого медленного клиента");
+    sample(out, "websocket_queue_max_bytes", ws.maxQueuedBytes);
+    family(out, "websocket_coalesced_total", "counter", "Статусы, пропущенные для клиентов сверх бюджета (текущие клиенты)");
+    sample(out, "websocket_coalesced_total", ws.coalesced);
+    family(out, "websocket_dropped_total", "counter", "Уведомления, отброшенные для клиентов сверх бюджета (текущие клиенты)");
+    sample(out, "websocket_dropped_total", ws.dropped);
+    family(out, "websocket_stalled_disconnects_total", "counter", "Отключенные зависшие клиенты");
+    sample(out, "websocket_stalled_disconnects_total", ws.stalledDisconnects);
+
+    const SettingsStats& settings = getSettingsStats();
+    family(out, "settings_writes_total", "counter", "Записи настроек в EEPROM");
+    sample(out, "settings_writes_total", settings.writes);
+    family(out, "settings_writes_skipped_total", "counter", "Пропущенные записи настроек без изменений");
+    sample(out, "settings_writes_skipped_total", settings.skipped);
+    family(out, "settings_write_errors_total", "counter", "Ошибки записи настроек");
+    sample(out, "settings_write_errors_total", settings.errors);
+}
+
+// Запись текста метрик в буфер
+size_t writeMetrics(char* buffer, size_t size) {
+    MetricsOutput out = { buffer, size, 0, false };
+    writeProcessMetrics(out);
+    writeInternalMetrics(out);
+    return out.overflow ? 0 : out.length;
+}
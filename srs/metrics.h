@@ -0,0 +1,31 @@
+/**
+ * @file metrics.h
+ * @brief Метрики для Prometheus (/metrics)
+ *
+ * Текст в формате Prometheus (text/plain; version=0.0.4) формируется в
+ * буфер фиксированного размера без выделения памяти: показания процесса
+ * (температуры, мощность, PZEM, насос, объемы отбора, фаза, безопасность)
+ * и внутренние счетчики (периоды и переполнения циклов задач, опрос
+ * датчиков, память, очереди WebSocket, записи в NVS). Все метрики имеют
+ * префикс drivevision_.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Тип содержимого страницы метрик
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+/**
+ * @brief Запись текста метрик в буфер
+ *
+ * @param buffer Буфер
+ * @param size Размер буфера
+ * @return Длина текста или 0, если текст не поместился в буфер
+ */
+size_t writeMetrics(char* buffer, size_t size);
+
+#endif // METRICS_H
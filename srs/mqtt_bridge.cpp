@@ -0,0 +1,333 @@
+/**
+ * @file mqtt_bridge.cpp
+ * @brief Реализация моста MQTT
+ */
+
+#include "mqtt_bridge.h"
+#include "settings.h"
+#include "telemetry.h"
+#include "json_writer.h"
+#include "event_log.h"
+#include "web.h"
+#include <WiFi.h>
+#include <AsyncMqttClient.h>
+#include <ArduinoJson.h>
+#include <atomic>
+
+// Размер буфера имени топика
+#define MQTT_TOPIC_SIZE 128
+
+// Показатели моста
+struct MqttBridgeStats {
+    uint32_t connects;          // Подключения к брокеру
+    uint32_t disconnects;       // Потери связи
+    uint32_t statusMessages;    // Опубликованные статусы
+    uint32_t telemetryMessages; // Опубликованные пакеты отсчетов
+    uint32_t samples;           // Опубликованные отсчеты
+    uint32_t lostSamples;       // Отсчеты, вытесненные из кольца до отправки
+    uint32_t commands;          // Принятые команды
+    uint32_t commandErrors;     // Команды, завершившиеся ошибкой
+    uint32_t publishErrors;     // Отказы публикации (нет связи или места в очереди)
+};
+
+static AsyncMqttClient mqttClient;
+
+// Примененные настройки: библиотека хранит указатели на строки,
+// поэтому они не должны меняться при изменении sysSettings
+static MqttSettings active;
+static bool configured = false;
+
+static char clientId[24];
+static char topicPrefix[sizeof(MqttSettings::prefix) + 24];
+static char onlineTopic[MQTT_TOPIC_SIZE];
+static char commandTopic[MQTT_TOPIC_SIZE];
+
+// Состояние соединения меняется в задаче AsyncTCP
+static std::atomic<bool> connected(false);
+static bool wasConnected = false;
+static unsigned long nextAttempt = 0;
+static unsigned long reconnectDelay = MQTT_RECONNECT_MIN_MS;
+
+// Позиция в кольце телеметрии: следующий отсчет для публикации
+static uint32_t cursorRun = 0;
+static uint32_t cursorNext = 0;
+static uint32_t backlog = 0;
+static bool flushPending = false;
+
+static unsigned long lastPublish = 0;
+
+static MqttBridgeStats stats;
+
+// Публикация в топик <prefix>/<suffix>
+static bool publish(const char* suffix, const char* payload, size_t length, uint8_t qos, bool retain = false) {
+    char topic[MQTT_TOPIC_SIZE];
+    snprintf(topic, sizeof(topic), "%s/%s", topicPrefix, suffix);
+    if (mqttClient.publish(topic, qos, retain, payload, length) == 0) {
+        stats.publishErrors++;
+        return false;
+    }
+    return true;
+}
+
+// Публикация ответа на команду
+static void publishReply(const char* method, const char* payload, size_t length) {
+    char suffix[MQTT_TOPIC_SIZE];
+    snprintf(suffix, sizeof(suffix), "reply/%s", method);
+    publish(suffix, payload, length, active.qos);
+}
+
+// Выполнение команды <prefix>/cmd/<метод> через таблицу методов RPC
+static void handleCommand(const char* method, const char* payload, size_t length) {
+    stats.commands++;
+
+    DynamicJsonDocument doc(MQTT_COMMAND_DOC_SIZE);
+    JsonObjectConst params;
+    if (length > 0) {
+        if (deserializeJson(doc, payload, length) || !doc.is<JsonObject>()) {
+            stats.commandErrors++;
+            static const char parseError[] = "{\"error\":{\"code\":400,\"message\":\"Ошибка разбора JSON\"}}";
+            publishReply(method, parseError, sizeof(parseError) - 1);
+            return;
+        }
+        params = doc.as<JsonObjectConst>();
+    }
+
+    PooledJsonWriter json;
+    json.beginObject();
+    JsonWriterMark mark = json.mark();
+    json.key("result");
+    const char* error = nullptr;
+    int code = callRpcMethod(method, params, json, error);
+    if (code == 200 && json.overflowed()) {
+        code = 413;
+        error = "Ответ не помещается в буфер";
+    }
+    if (code != 200) {
+        stats.commandErrors++;
+        json.rewind(mark);
+        json.beginObject("error");
+        json.add("code", code);
+        json.add("message", error != nullptr ? error : "Ошибка выполнения запроса");
+        json.endObject();
+    }
+    json.endObject();
+
+    if (json.ok()) {
+        publishReply(method, json.c_str(), json.length());
+    }
+}
+
+static void onMqttConnect(bool sessionPresent) {
+    mqttClient.subscribe(commandTopic, 1);
+    mqttClient.publish(onlineTopic, 1, true, "1");
+    connected = true;
+}
+
+static void onMqttDisconnect(AsyncMqttClientDisconnectReason reason) {
+    if (connected) {
+        stats.disconnects++;
+        logRecord(EV_MQTT_DISCONNECTED, (int)reason);
+    }
+    connected = false;
+}
+
+static void onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties properties,
+                          size_t len, size_t index, size_t total) {
+    // Сообщения, разбитые на части, не поддерживаются. Сохраненные брокером
+    // команды не выполняются: иначе каждое переподключение повторяло бы их
+    if (index != 0 || len != total || properties.retain) {
+        return;
+    }
+    size_t prefixLength = strlen(commandTopic) - 1;  // Без "+"
+    if (strncmp(topic, commandTopic, prefixLength) != 0 || topic[prefixLength] == '\0') {
+        return;
+    }
+    handleCommand(topic + prefixLength, payload, len);
+}
+
+// Применение настроек из sysSettings.mqttSettings
+static void applySettings() {
+    if (connected) {
+        mqttClient.publish(onlineTopic, 1, true, "0");
+        mqttClient.disconnect();
+    }
+    active = sysSettings.mqttSettings;
+    configured = true;
+
+    if (active.prefix[0] != '\0') {
+        strlcpy(topicPrefix, active.prefix, sizeof(topicPrefix));
+    } else {
+        uint8_t mac[6];
+        WiFi.macAddress(mac);
+        snprintf(topicPrefix, sizeof(topicPrefix), "drivevision/%02x%02x%02x", mac[3], mac[4], mac[5]);
+    }
+    size_t length = strlen(topicPrefix);
+    while (length > 0 && topicPrefix[length - 1] == '/') {
+        topicPrefix[--length] = '\0';
+    }
+    snprintf(onlineTopic, sizeof(onlineTopic), "%s/online", topicPrefix);
+    snprintf(commandTopic, sizeof(commandTopic), "%s/cmd/+", topicPrefix);
+
+    mqttClient.setServer(active.host, active.port);
+    mqttClient.setCredentials(active.user[0] != '\0' ? active.user : nullptr,
+                              active.password[0] != '\0' ? active.password : nullptr);
+    mqttClient.setWill(onlineTopic, 1, true, "0");
+
+    reconnectDelay = MQTT_RECONNECT_MIN_MS;
+    nextAttempt = millis();
+
+    // Публикация начинается с отсчетов, снятых после включения моста
+    uint32_t run, first, last;
+    if (getTelemetrySampleRange(run, first, last)) {
+        cursorRun = run;
+        cursorNext = last + 1;
+    }
+    backlog = 0;
+    flushPending = false;
+
+    if (active.enabled) {
+        Serial.print("MQTT: брокер ");
+        Serial.print(active.host[0] != '\0' ? active.host : "не задан");
+        Serial.print(", топики ");
+        Serial.println(topicPrefix);
+    }
+}
+
+// Публикация новых отсчетов телеметрии, не более maxMessages пакетов.
+// Возвращает количество опубликованных отсчетов
+static uint32_t publishSamples(int maxMessages) {
+    uint32_t run, first, last;
+    flushPending = false;
+    if (!getTelemetrySampleRange(run, first, last)) {
+        return 0;
+    }
+    if (run != cursorRun) {
+        cursorRun = run;
+        cursorNext = first;
+    }
+    if (cursorNext < first) {
+        uint32_t lost = first - cursorNext;
+        stats.lostSamples += lost;
+        logRecord(EV_MQTT_SAMPLES_LOST, lost);
+        cursorNext = first;
+    }
+
+    TelemetrySample samples[MQTT_SAMPLES_PER_MESSAGE];
+    uint32_t published = 0;
+    for (int m = 0; m < maxMessages && cursorNext <= last; m++) {
+        int count = readTelemetrySamples(run, cursorNext, samples, MQTT_SAMPLES_PER_MESSAGE);
+        if (count == 0) {
+            break;
+        }
+
+        PooledJsonWriter json;
+        json.beginObject();
+        json.add("run", run);
+        json.key("samples");
+        writeTelemetrySamples(json, samples, count);
+        json.endObject();
+        // Без буфера или связи отсчеты остаются в кольце до следующего прохода
+        if (!json.ok() || !publish("telemetry", json.c_str(), json.length(), active.qos)) {
+            break;
+        }
+
+        stats.telemetryMessages++;
+        stats.samples += count;
+        published += count;
+        cursorNext = samples[count - 1].time + 1;
+    }
+
+    backlog = cursorNext <= last ? last - cursorNext + 1 : 0;
+    flushPending = backlog > 0;
+    return published;
+}
+
+// Публикация статуса системы
+static void publishStatus() {
+    PooledJsonWriter json;
+    writeStatus(json);
+    if (json.ok() && publish("status", json.c_str(), json.length(), active.qos)) {
+        stats.statusMessages++;
+    }
+}
+
+// Инициализация моста
+void initMqttBridge() {
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    snprintf(clientId, sizeof(clientId), "drivevision-%02x%02x%02x", mac[3], mac[4], mac[5]);
+
+    mqttClient.setClientId(clientId);
+    mqttClient.setKeepAlive(MQTT_KEEPALIVE_S);
+    mqttClient.onConnect(onMqttConnect);
+    mqttClient.onDisconnect(onMqttDisconnect);
+    mqttClient.onMessage(onMqttMessage);
+}
+
+// Обновление моста
+void updateMqttBridge() {
+    if (!configured || memcmp(&active, &sysSettings.mqttSettings, sizeof(MqttSettings)) != 0) {
+        applySettings();
+    }
+    if (!active.enabled || active.host[0] == '\0') {
+        if (connected) {
+            mqttClient.disconnect();
+        }
+        return;
+    }
+
+    unsigned long now = millis();
+    if (!connected) {
+        wasConnected = false;
+        if ((long)(now - nextAttempt) >= 0) {
+            mqttClient.connect();
+            nextAttempt = now + reconnectDelay;
+            reconnectDelay = min(reconnectDelay * 2, (unsigned long)MQTT_RECONNECT_MAX_MS);
+        }
+        return;
+    }
+
+    if (!wasConnected) {
+        // Накопленные без связи отсчеты досылаются сразу после подключения
+        wasConnected = true;
+        reconnectDelay = MQTT_RECONNECT_MIN_MS;
+        stats.connects++;
+        uint32_t published = publishSamples(MQTT_FLUSH_MESSAGES);
+        logRecord(EV_MQTT_CONNECTED, published + backlog);
+        lastPublish = now;
+        publishStatus();
+        return;
+    }
+
+    if (now - lastPublish >= (unsigned long)active.publishInterval * 1000) {
+        lastPublish = now;
+        publishStatus();
+        publishSamples(MQTT_FLUSH_MESSAGES);
+    } else if (flushPending) {
+        publishSamples(MQTT_FLUSH_MESSAGES);
+    }
+}
+
+// Признак подключения к брокеру
+bool isMqttConnected() {
+    return connected;
+}
+
+// Показатели моста
+void writeMqttBridgeStats(JsonWriter& json) {
+    json.beginObject();
+    json.add("enabled", active.enabled);
+    json.add("connected", isMqttConnected());
+    json.add("prefix", topicPrefix);
+    json.add("connects", stats.connects);
+    json.add("disconnects", stats.disconnects);
+    json.add("statusMessages", stats.statusMessages);
+    json.add("telemetryMessages", stats.telemetryMessages);
+    json.add("samples", stats.samples);
+    json.add("backlog", backlog);
+    json.add("lostSamples", stats.lostSamples);
+    json.add("commands", stats.commands);
+    json.add("commandErrors", stats.commandErrors);
+    json.add("publishErrors", stats.publishErrors);
+    json.endObject();
+}
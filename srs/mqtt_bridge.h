@@ -0,0 +1,60 @@
+/**
+ * @file mqtt_bridge.h
+ * @brief Мост MQTT: телеметрия и команды через брокер
+ *
+ * Необязательный клиент MQTT (раздел настроек "mqtt"). Топики строятся от
+ * префикса (по умолчанию drivevision/<MAC>):
+ *   <prefix>/online     - "1" после подключения, "0" завещанием (retain)
+ *   <prefix>/status     - то же сообщение о статусе, что и у WebSocket
+ *   <prefix>/telemetry  - {"run":N,"samples":[[время,фаза,[значения]],...]}
+ *   <prefix>/cmd/<метод>   - команда: метод RPC ("rectification.start",
+ *                            "distillation.pause", "heater.set", ...),
+ *                            в теле - параметры JSON или пусто
+ *   <prefix>/reply/<метод> - ответ {"result":...} или {"error":{"code":..,"message":..}}
+ *
+ * Команды выполняются теми же методами RPC, что и у WebSocket и REST
+ * (rectification.*, distillation.*, heater.set), а не через startProcess(),
+ * stopProcess() (utils.cpp) и setPowerWatts() (power_control.cpp): эти
+ * функции относятся к прежней схеме управления с rectParams/distParams и
+ * sysSettings.maxHeaterPowerWatts, которых нет в SystemSettings (settings.h).
+ *
+ * Статус и новые отсчеты публикуются раз в publishInterval секунд с QoS из
+ * настроек. Пока брокер недоступен, отсчеты остаются в кольце телеметрии в
+ * ОЗУ (telemetry.h, 15 минут): мост хранит позицию последнего отправленного
+ * отсчета и после переподключения досылает накопленное пакетами по
+ * MQTT_SAMPLES_PER_MESSAGE отсчетов. Отсчеты, вытесненные из кольца до
+ * отправки, учитываются в показателях как потерянные.
+ */
+
+#ifndef MQTT_BRIDGE_H
+#define MQTT_BRIDGE_H
+
+#include <Arduino.h>
+#include "config.h"
+
+class JsonWriter;
+
+/**
+ * @brief Инициализация моста (подключение начнется из updateMqttBridge)
+ */
+void initMqttBridge();
+
+/**
+ * @brief Обновление моста: подключение, публикация статуса и отсчетов
+ *
+ * Вызывается из цикла задачи управления. Изменение настроек MQTT
+ * применяется здесь же: соединение разрывается и устанавливается заново.
+ */
+void updateMqttBridge();
+
+/**
+ * @brief Признак подключения к брокеру
+ */
+bool isMqttConnected();
+
+/**
+ * @brief Запись показателей моста (объект)
+ */
+void writeMqttBridgeStats(JsonWriter& json);
+
+#endif // MQTT_BRIDGE_H
@@ -0,0 +1,370 @@
+/**
+ * @file ota.cpp
+ * @brief Реализация обновления по сети
+ */
+
+#include "ota.h"
+#include "rectification.h"
+#include "distillation.h"
+#include "supervisor.h"
+#include "event_log.h"
+#include "fs_gate.h"
+#include "json_writer.h"
+#include <Update.h>
+#include <LittleFS.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+#include <atomic>
+
+// Размер SHA-256 (байт)
+#define OTA_HASH_SIZE 32
+
+// Имена назначений, по порядку OtaTarget
+static const char* const targetNames[] = { "firmware", "filesystem" };
+
+// Владелец текущего обновления; после успешного приема остается занятым
+// до перезагрузки, чтобы не начались новое обновление или процесс
+static std::atomic<const void*> otaOwner(nullptr);
+
+static OtaTarget otaTarget = OTA_TARGET_FIRMWARE;
+static size_t otaSize = 0;
+static size_t otaReceived = 0;
+static const char* otaError = nullptr;
+static bool filesystemUnmounted = false;
+static uint8_t expectedHash[OTA_HASH_SIZE];
+static mbedtls_sha256_context shaContext;
+
+// Отказ в начале приема; ответ отправляется после приема тела запроса
+static const void* beginErrorOwner = nullptr;
+static int beginErrorCode = 0;
+static const char* beginErrorText = nullptr;
+
+// Проверка новой прошивки после обновления
+static bool healthCheckPending = false;
+
+// Проверку прошивки при запуске выполняет updateOtaHealthCheck, а не
+// ядро Arduino (по умолчанию оно сразу отменяет откат)
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
+// Поиск назначения по имени
+bool parseOtaTarget(const char* name, OtaTarget& target) {
+    for (int i = 0; i <= OTA_TARGET_FILESYSTEM; i++) {
+        if (strcmp(targetNames[i], name) == 0) {
+            target = (OtaTarget)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Разбор SHA-256 из шестнадцатеричной строки
+static bool parseHash(const char* text, uint8_t* hash) {
+    if (text == nullptr || strlen(text) != OTA_HASH_SIZE * 2) {
+        return false;
+    }
+    for (int i = 0; i < OTA_HASH_SIZE * 2; i++) {
+        char c = text[i];
+        uint8_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        hash[i / 2] = (i % 2 == 0) ? digit << 4 : hash[i / 2] | digit;
+    }
+    return true;
+}
+
+// Раздел, в который пишется образ
+static const esp_partition_t* targetPartition(OtaTarget target) {
+    if (target == OTA_TARGET_FIRMWARE) {
+        return esp_ota_get_next_update_partition(NULL);
+    }
+    return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, NULL);
+}
+
+// Освобождение обновления; файловая система монтируется снова
+static void releaseOta() {
+    mbedtls_sha256_free(&shaContext);
+    if (filesystemUnmounted) {
+        filesystemUnmounted = false;
+        LittleFS.begin();
+        openFileAccess();
+    }
+    otaOwner = nullptr;
+}
+
+// Проверка возможности обновления без его начала
+int checkOta(OtaTarget target, const char* sha256, size_t size, const char*& error) {
+    uint8_t hash[OTA_HASH_SIZE];
+    if (!parseHash(sha256, hash)) {
+        error = "Параметр sha256: 64 шестнадцатеричных символа";
+        return 400;
+    }
+    if (size == 0) {
+        error = "Пустой образ";
+        return 400;
+    }
+    if (isRectificationRunning() || isDistillationRunning()) {
+        error = "Процесс запущен, обновление недоступно";
+        return 409;
+    }
+    if (isOtaInProgress()) {
+        error = "Обновление уже выполняется";
+        return 409;
+    }
+    const esp_partition_t* partition = targetPartition(target);
+    if (partition == nullptr) {
+        error = "Нет раздела для образа";
+        return 500;
+    }
+    if (size > partition->size) {
+        error = "Образ больше раздела";
+        return 400;
+    }
+    return 200;
+}
+
+// Захват обновления и подготовка записи образа
+static int startOta(const void* owner, OtaTarget target, const char* sha256, size_t size, const char*& error) {
+    int code = checkOta(target, sha256, size, error);
+    if (code != 200) {
+        return code;
+    }
+    const void* expected = nullptr;
+    if (!otaOwner.compare_exchange_strong(expected, owner)) {
+        error = "Обновление уже выполняется";
+        return 409;
+    }
+
+    parseHash(sha256, expectedHash);
+    mbedtls_sha256_init(&shaContext);
+    mbedtls_sha256_starts(&shaContext, 0);
+    otaTarget = target;
+    otaSize = size;
+    otaReceived = 0;
+    otaError = nullptr;
+
+    // Образ файловой системы пишется на место LittleFS: доступ к файлам
+    // закрывается для всех модулей, и файловая система размонтируется до
+    // конца приема. Обращение, не закончившееся вовремя, отменяет прием
+    if (target == OTA_TARGET_FILESYSTEM) {
+        if (!closeFileAccess(OTA_FILE_ACCESS_TIMEOUT_MS)) {
+            error = "Файловая система занята";
+            releaseOta();
+            return 503;
+        }
+        LittleFS.end();
+        filesystemUnmounted = true;
+    }
+
+    if (!Update.begin(size, target == OTA_TARGET_FIRMWARE ? U_FLASH : U_SPIFFS)) {
+        error = "Не удалось начать запись образа";
+        logRecord(EV_OTA_FAILED, targetNames[target], error);
+        releaseOta();
+        return 500;
+    }
+
+    logRecord(EV_OTA_STARTED, targetNames[target], size);
+    return 200;
+}
+
+// Начало приема образа
+int beginOta(const void* owner, OtaTarget target, const char* sha256, size_t size, const char*& error) {
+    int code = startOta(owner, target, sha256, size, error);
+    if (code != 200) {
+        beginErrorOwner = owner;
+        beginErrorCode = code;
+        beginErrorText = error;
+    }
+    return code;
+}
+
+// Ошибка начала приема образа
+int getOtaBeginError(const void* owner, const char*& error) {
+    if (owner == nullptr || owner != beginErrorOwner) {
+        return 0;
+    }
+    beginErrorOwner = nullptr;
+    error = beginErrorText;
+    return beginErrorCode;
+}
+
+// Запись очередной части образа
+bool writeOta(const void* owner, const uint8_t* data, size_t length) {
+    if (!isOtaOwner(owner) || otaError != nullptr) {
+        return false;
+    }
+    if (otaReceived + length > otaSize) {
+        otaError = "Образ больше заявленного размера";
+    } else if (Update.write((uint8_t*)data, length) != length) {
+        otaError = "Ошибка записи во флеш-память";
+    }
+    if (otaError != nullptr) {
+        Update.abort();
+        return false;
+    }
+    mbedtls_sha256_update(&shaContext, data, length);
+    otaReceived += length;
+    return true;
+}
+
+// Завершение приема
+int finishOta(const void* owner, const char*& error, bool& restart) {
+    restart = false;
+    if (!isOtaOwner(owner)) {
+        error = "Обновление не начато";
+        return 500;
+    }
+
+    int code = 200;
+    if (otaError != nullptr) {
+        error = otaError;
+        code = 500;
+    } else if (otaReceived != otaSize) {
+        Update.abort();
+        error = "Образ принят не полностью";
+        code = 400;
+    } else {
+        uint8_t hash[OTA_HASH_SIZE];
+        mbedtls_sha256_finish(&shaContext, hash);
+        if (memcmp(hash, expectedHash, OTA_HASH_SIZE) != 0) {
+            // Прошивка без конца не активируется; файловая система уже
+            // перезаписана и будет отформатирована при запуске
+            Update.abort();
+            error = "SHA-256 образа не совпал";
+            code = 400;
+        } else if (!Update.end()) {
+            error = "Образ не прошел проверку";
+            code = 500;
+        }
+    }
+
+    if (code == 200) {
+        logRecord(EV_OTA_DONE, targetNames[otaTarget]);
+    } else {
+        logRecord(EV_OTA_FAILED, targetNames[otaTarget], error);
+    }
+
+    // После записи в LittleFS ее нельзя смонтировать снова
+    restart = code == 200 || (otaTarget == OTA_TARGET_FILESYSTEM && otaReceived > 0);
+    if (restart) {
+        mbedtls_sha256_free(&shaContext);
+    } else {
+        releaseOta();
+    }
+    return code;
+}
+
+// Прерывание приема
+void abortOta(const void* owner) {
+    if (!isOtaOwner(owner)) {
+        return;
+    }
+    Update.abort();
+    logRecord(EV_OTA_FAILED, targetNames[otaTarget], "соединение прервано");
+
+    if (otaTarget == OTA_TARGET_FILESYSTEM && otaReceived > 0) {
+        Serial.println("Образ файловой системы принят не полностью, перезагрузка");
+        ESP.restart();
+    }
+    releaseOta();
+}
+
+// Признак идущего приема образа
+bool isOtaInProgress() {
+    return otaOwner.load() != nullptr;
+}
+
+// Признак владения текущим обновлением
+bool isOtaOwner(const void* owner) {
+    return owner != nullptr && otaOwner.load() == owner;
+}
+
+// Проверка состояния запущенной прошивки при загрузке
+void initOtaHealthCheck() {
+    esp_ota_img_states_t state;
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    healthCheckPending = esp_ota_get_state_partition(running, &state) == ESP_OK &&
+                         state == ESP_OTA_IMG_PENDING_VERIFY;
+    if (healthCheckPending) {
+        Serial.print("Новая прошивка в разделе ");
+        Serial.print(running->label);
+        Serial.println(" ожидает проверки");
+    }
+}
+
+// Откат к предыдущей прошивке
+static void rollback(const char* reason) {
+    logRecord(EV_OTA_ROLLBACK, reason);
+    Serial.print("Новая прошивка не прошла проверку: ");
+    Serial.println(reason);
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+    // Возврат означает, что предыдущей прошивки нет
+    healthCheckPending = false;
+}
+
+// Проверка новой прошивки
+void updateOtaHealthCheck(bool heartbeatsOk) {
+    if (!healthCheckPending) {
+        return;
+    }
+    if (!heartbeatsOk) {
+        rollback("задача не отвечает");
+        return;
+    }
+    if (millis() < OTA_HEALTH_CHECK_MS) {
+        return;
+    }
+
+    int count = getHeartbeatCount();
+    for (int i = 0; i < count; i++) {
+        if (getHeartbeatStats(i).beats == 0) {
+            rollback("нет сигналов активности задачи");
+            return;
+        }
+    }
+    if (count == 0) {
+        rollback("задачи не запущены");
+        return;
+    }
+
+    esp_ota_mark_app_valid_cancel_rollback();
+    healthCheckPending = false;
+    logRecord(EV_OTA_CONFIRMED);
+}
+
+// Запись состояния обновления
+void writeOtaStatus(JsonWriter& json) {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    const esp_partition_t* invalid = esp_ota_get_last_invalid_partition();
+    const esp_partition_t* next = esp_ota_get_next_update_partition(NULL);
+
+    json.beginObject();
+    json.add("version", FIRMWARE_VERSION);
+    json.add("running", running != nullptr ? running->label : "");
+    json.add("next", next != nullptr ? next->label : "");
+    json.add("maxFirmwareSize", next != nullptr ? next->size : 0);
+    json.add("healthCheckPending", healthCheckPending);
+    if (healthCheckPending) {
+        unsigned long uptime = millis();
+        json.add("healthCheckLeftMs", uptime < OTA_HEALTH_CHECK_MS ? OTA_HEALTH_CHECK_MS - uptime : 0);
+    }
+    if (invalid != nullptr) {
+        json.add("rolledBackFrom", invalid->label);
+    }
+    json.add("inProgress", isOtaInProgress());
+    if (isOtaInProgress()) {
+        json.add("target", targetNames[otaTarget]);
+        json.add("received", otaReceived);
+        json.add("size", otaSize);
+    }
+    json.endObject();
+}
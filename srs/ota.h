@@ -0,0 +1,140 @@
+/**
+ * @file ota.h
+ * @brief Обновление прошивки и файловой системы по сети (/api/ota)
+ *
+ * Образ принимается потоком (тело POST, application/octet-stream) и по
+ * частям пишется во флеш-память через Update без буферизации целиком:
+ * прошивка - в неактивный раздел приложения (partitions.csv), образ
+ * LittleFS - в раздел данных. Вместе с записью считается SHA-256; если он
+ * не совпал с переданным, прошивка не активируется.
+ *
+ * Второго раздела под файловую систему нет, поэтому ее образ пишется на
+ * место размонтированной LittleFS, и после приема контроллер всегда
+ * перезагружается: поврежденный или неверный образ при запуске
+ * форматируется (LittleFS.begin(true)).
+ *
+ * Новая прошивка загружается в состоянии проверки: если за
+ * OTA_HEALTH_CHECK_MS все задачи подали сигналы активности (supervisor.h),
+ * откат отменяется, иначе загрузчик возвращает предыдущую прошивку.
+ */
+
+#ifndef OTA_H
+#define OTA_H
+
+#include <Arduino.h>
+#include "config.h"
+
+class JsonWriter;
+
+// Назначение образа
+enum OtaTarget {
+    OTA_TARGET_FIRMWARE,
+    OTA_TARGET_FILESYSTEM
+};
+
+/**
+ * @brief Поиск назначения по имени ("firmware", "filesystem")
+ *
+ * @return true если имя известно
+ */
+bool parseOtaTarget(const char* name, OtaTarget& target);
+
+/**
+ * @brief Проверка возможности обновления без его начала
+ *
+ * Процесс и другое обновление не должны идти, SHA-256 должен состоять из
+ * 64 шестнадцатеричных символов, образ - помещаться в раздел.
+ *
+ * @return Код ответа: 200, 400 (неверные параметры), 409 (занято), 500
+ */
+int checkOta(OtaTarget target, const char* sha256, size_t size, const char*& error);
+
+/**
+ * @brief Начало приема образа
+ *
+ * Выполняет проверки checkOta(). Для файловой системы закрывает доступ к
+ * файлам всем модулям (fs_gate.h) и размонтирует LittleFS; если начатые
+ * обращения к файлам не закончились за OTA_FILE_ACCESS_TIMEOUT_MS, прием
+ * не начинается.
+ *
+ * @param owner Владелец обновления (запрос), передается в остальные вызовы
+ * @param target Назначение образа
+ * @param sha256 Ожидаемый SHA-256 (64 шестнадцатеричных символа)
+ * @param size Размер образа (байт)
+ * @param error Текст ошибки
+ * @return Код ответа: 200, 400 (неверные параметры), 409 (занято), 500,
+ *         503 (файловая система занята)
+ */
+int beginOta(const void* owner, OtaTarget target, const char* sha256, size_t size, const char*& error);
+
+/**
+ * @brief Ошибка, с которой beginOta() отказал этому владельцу
+ *
+ * Прием начинается в обработчике тела запроса, а ответ отправляется после
+ * приема всего тела; ошибка выдается один раз.
+ *
+ * @return Код ответа beginOta() или 0, если отказа не было
+ */
+int getOtaBeginError(const void* owner, const char*& error);
+
+/**
+ * @brief Запись очередной части образа
+ *
+ * @return false если владелец не совпал или запись не удалась
+ *         (обновление при этом прерывается)
+ */
+bool writeOta(const void* owner, const uint8_t* data, size_t length);
+
+/**
+ * @brief Завершение приема: проверка размера и SHA-256, активация образа
+ *
+ * @param error Текст ошибки
+ * @param restart Признак необходимости перезагрузки (успех или
+ *                недействительная файловая система)
+ * @return Код ответа: 200, 400 (образ не совпал), 500
+ */
+int finishOta(const void* owner, const char*& error, bool& restart);
+
+/**
+ * @brief Прерывание приема (обрыв соединения)
+ *
+ * Ничего не делает, если владелец не совпал или обновление завершено.
+ * Если образ файловой системы уже начал записываться, перезагружает
+ * контроллер.
+ */
+void abortOta(const void* owner);
+
+/**
+ * @brief Признак идущего приема образа
+ */
+bool isOtaInProgress();
+
+/**
+ * @brief Признак владения текущим обновлением
+ */
+bool isOtaOwner(const void* owner);
+
+/**
+ * @brief Проверка состояния запущенной прошивки при загрузке
+ *
+ * Определяет, ожидает ли прошивка подтверждения после обновления.
+ */
+void initOtaHealthCheck();
+
+/**
+ * @brief Проверка новой прошивки
+ *
+ * Вызывается из задачи безопасности вместе с checkHeartbeats(). Пропуск
+ * сигнала активности во время проверки или задача без сигналов к ее концу
+ * приводят к откату и перезагрузке.
+ *
+ * @param heartbeatsOk Результат checkHeartbeats()
+ */
+void updateOtaHealthCheck(bool heartbeatsOk);
+
+/**
+ * @brief Запись состояния обновления (объект)
+ */
+void writeOtaStatus(JsonWriter& json);
+
+#endif // OTA_H
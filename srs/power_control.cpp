@@ -1,6 +1,9 @@
 #include "power_control.h"
 #include "temp_sensors.h"
 #include "utils.h"
+#include "fault_injection.h"
+#include "event_log.h"
+#include "safety.h"
 #include <PZEM004Tv30.h>
 
 // Глобальные переменные для управления мощностью
@@ -20,6 +23,15 @@ static unsigned long pidLastUpdateTime = 0; // Время последнего 
     HardwareSerial PzemSerial(1);  // Используем UART1 для ESP32
     PZEM004Tv30 pzem(PzemSerial, PZEM_RX_PIN, PZEM_TX_PIN);
     static bool pzemInitialized = false;
+    
+    // Показания опрашиваются только задачей управления: порт PZEM не
+    // используется из других задач, а чтение показаний не блокирует
+    #define PZEM_POLL_INTERVAL 1000
+    static unsigned long lastPzemPoll = 0;
+    static float pzemVoltage = 0.0;
+    static float pzemCurrent = 0.0;
+    static float pzemPower = 0.0;
+    static float pzemEnergy = 0.0;
 #endif
 
 // Инициализация управления мощностью
@@ -59,6 +71,11 @@ void setPowerPercent(int percent) {
     // Ограничиваем значение в диапазоне 0-100%
     percent = constrain(percent, 0, 100);
     
+    // При зафиксированной остановке мощность не подается
+    if (getSafetyRuleAction() >= SAFETY_ACTION_STOP) {
+        percent = 0;
+    }
+    
     currentPowerPercent = percent;
 }
 
@@ -88,6 +105,16 @@ int getCurrentPowerWatts() {
 void updatePowerControl() {
     unsigned long currentTime = millis();
     
+    #ifdef PZEM_RX_PIN
+        if (sysSettings.pzemEnabled && pzemInitialized && currentTime - lastPzemPoll >= PZEM_POLL_INTERVAL) {
+            lastPzemPoll = currentTime;
+            pzemVoltage = pzem.voltage();
+            pzemCurrent = pzem.current();
+            pzemPower = pzem.power();
+            pzemEnergy = pzem.energy();
+        }
+    #endif
+    
     // Обрабатываем управление мощностью в зависимости от выбранного режима
     if (systemRunning && !systemPaused) {
         switch (sysSettings.powerControlMode) {
@@ -109,7 +136,11 @@ void updatePowerControl() {
                     if (sysSettings.pzemEnabled && pzemInitialized && 
                         currentTime - lastPowerUpdate >= POWER_CONTROL_INTERVAL) {
                         
-                        float pzemPower = pzem.power();
+                        // Последнее показание, опрошенное выше; порт здесь не читается
+                        float measuredPower = pzemPower;
+                        #ifdef FAULT_INJECTION
+                        measuredPower = injectPzemFault(measuredPower);
+                        #endif
                         int targetPower = 0;
                         
                         // Определяем целевую мощность в зависимости от режима
@@ -149,11 +180,11 @@ void updatePowerControl() {
                         }
                         
                         // Если текущая мощность отличается от целевой больше чем на 5%
-                        if (abs(pzemPower - targetPower) > (targetPower * 0.05)) {
+                        if (abs(measuredPower - targetPower) > (targetPower * 0.05)) {
                             // Корректируем мощность
                             float adjustment = 0;
                             
-                            if (pzemPower < targetPower) {
+                            if (measuredPower < targetPower) {
                                 adjustment = 5.0; // Увеличиваем на 5%
                             } else {
                                 adjustment = -5.0; // Уменьшаем на 5%
@@ -263,7 +294,7 @@ void setPITargetTemperature(float targetTemp, int sensorIndex) {
 void updatePIControl() {
     // Проверяем, что датчик подключен
     if (!isSensorConnected(pidSensorIndex)) {
-        Serial.println("Ошибка PI-регулятора: датчик не подключен");
+        logRecord(EV_PI_SENSOR_MISSING);
         return;
     }
     
@@ -293,26 +324,15 @@ void updatePIControl() {
     // Запоминаем текущую ошибку
     pidLastError = error;
     
-    // Отладочная информация
-    Serial.print("PI: цель=");
-    Serial.print(pidTargetTemp);
-    Serial.print("°C, текущая=");
-    Serial.print(currentTemp);
-    Serial.print("°C, ошибка=");
-    Serial.print(error);
-    Serial.print(", P=");
-    Serial.print(p);
-    Serial.print(", I=");
-    Serial.print(i);
-    Serial.print(", выход=");
-    Serial.println(output);
+    // Отладочная информация (уровень debug модуля heater)
+    logRecord(EV_PI_UPDATE, pidTargetTemp, currentTemp, error, p, i, output);
 }
 
 // Получение текущей мощности от PZEM-004T (если подключен)
 float getPzemPowerWatts() {
     #ifdef PZEM_RX_PIN
         if (sysSettings.pzemEnabled && pzemInitialized) {
-            return pzem.power();
+            return pzemPower;
         }
     #endif
     return 0.0;
@@ -322,7 +342,7 @@ float getPzemPowerWatts() {
 float getPzemVoltage() {
     #ifdef PZEM_RX_PIN
         if (sysSettings.pzemEnabled && pzemInitialized) {
-            return pzem.voltage();
+            return pzemVoltage;
         }
     #endif
     return 0.0;
@@ -332,7 +352,7 @@ float getPzemVoltage() {
 float getPzemCurrent() {
     #ifdef PZEM_RX_PIN
         if (sysSettings.pzemEnabled && pzemInitialized) {
-            return pzem.current();
+            return pzemCurrent;
         }
     #endif
     return 0.0;
@@ -342,7 +362,7 @@ float getPzemCurrent() {
 float getPzemEnergy() {
     #ifdef PZEM_RX_PIN
         if (sysSettings.pzemEnabled && pzemInitialized) {
-            return pzem.energy();
+            return pzemEnergy;
         }
     #endif
     return 0.0;
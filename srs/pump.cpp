@@ -1,5 +1,6 @@
 #include "pump.h"
 #include "utils.h"
+#include "safety.h"
 
 // Статус насоса
 static bool pumpEnabled = false;
@@ -35,6 +36,13 @@ void initPump() {
 
 // Включение насоса с заданной скоростью отбора (мл/час)
 void enablePump(float flowRateMlPerHour) {
+    // При зафиксированной остановке насос не включается
+    if (getSafetyRuleAction() >= SAFETY_ACTION_STOP) {
+        Serial.println("Насос заблокирован аварийной остановкой");
+        disablePump();
+        return;
+    }
+    
     // Если скорость отбора слишком мала, выключаем насос
     if (flowRateMlPerHour < pumpSettings.minFlowRate) {
         disablePump();
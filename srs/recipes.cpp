@@ -0,0 +1,596 @@
+/**
+ * @file recipes.cpp
+ * @brief Реализация управления рецептами
+ */
+
+#include "recipes.h"
+#include "settings_schema.h"
+#include "fs_gate.h"
+#include <LittleFS.h>
+#include <rom/crc.h>
+#include <stddef.h>
+
+// Сигнатура и версия формата бинарного кэша рецепта
+#define RECIPE_CACHE_MAGIC 0x52435031  // "RCP1"
+#define RECIPE_CACHE_FORMAT 1
+
+// Файл с именем последнего загруженного рецепта
+#define RECIPE_ACTIVE_FILE RECIPES_DIR "/active"
+
+// Файл начальных настроек, из которого создается рецепт по умолчанию
+#define RECIPE_SEED_FILE "/settings.json"
+
+// Размер JSON-документа рецепта
+#define RECIPE_JSON_SIZE 2048
+
+// Содержимое рецепта
+struct RecipeData {
+    RectificationSettings rect;
+    DistillationSettings dist;
+    PumpSettings pump;
+};
+
+// Заголовок бинарного кэша рецепта
+struct RecipeCacheHeader {
+    uint32_t magic;         // Сигнатура файла
+    uint16_t format;        // Версия формата кэша
+    uint16_t version;       // Версия рецепта
+    uint32_t dataSize;      // Размер структуры RecipeData
+    uint32_t jsonSize;      // Размер JSON-файла, из которого построен кэш
+    uint32_t jsonTime;      // Время изменения JSON-файла
+    uint32_t crc;           // CRC32 данных рецепта
+};
+
+// Раздел рецепта: раздел настроек и смещение его копии в RecipeData.
+// В рецепт входят только поля с флагом SF_RECIPE.
+struct RecipeSection {
+    SettingsSectionId id;        // Раздел настроек
+    size_t offset;               // Смещение раздела в RecipeData
+};
+
+static const RecipeSection recipeSections[] = {
+    { SETTINGS_SECTION_RECTIFICATION, offsetof(RecipeData, rect) },
+    { SETTINGS_SECTION_DISTILLATION, offsetof(RecipeData, dist) },
+    { SETTINGS_SECTION_PUMP, offsetof(RecipeData, pump) }
+};
+
+static const size_t recipeSectionCount = sizeof(recipeSections) / sizeof(recipeSections[0]);
+
+// Имя последнего загруженного рецепта
+static char activeRecipeName[RECIPE_NAME_MAX_LEN + 1] = "";
+
+// Формирование пути к файлу рецепта
+static void recipePath(char* buf, size_t len, const char* name, const char* ext) {
+    snprintf(buf, len, "%s/%s.%s", RECIPES_DIR, name, ext);
+}
+
+// Заполнение рецепта текущими настройками
+static void fillFromCurrent(RecipeData& data) {
+    memset(&data, 0, sizeof(data));
+    data.rect = sysSettings.rectificationSettings;
+    data.dist = sysSettings.distillationSettings;
+    data.pump = sysSettings.pumpSettings;
+}
+
+// Данные раздела в рецепте
+static void* recipeSectionData(RecipeData& data, const RecipeSection& section) {
+    return (uint8_t*)&data + section.offset;
+}
+
+static const void* recipeSectionData(const RecipeData& data, const RecipeSection& section) {
+    return (const uint8_t*)&data + section.offset;
+}
+
+// Разбор разделов рецепта из JSON (раздел с недопустимыми значениями не применяется)
+static void recipeFromJson(JsonObjectConst root, RecipeData& data) {
+    for (size_t s = 0; s < recipeSectionCount; s++) {
+        const SettingsSection& section = getSettingsSection(recipeSections[s].id);
+        JsonObjectConst obj = root[section.name];
+        if (obj.isNull()) {
+            continue;
+        }
+        String error;
+        if (!settingsSectionFromJson(section, recipeSectionData(data, recipeSections[s]), obj, SF_RECIPE, error)) {
+            Serial.printf("Рецепт: %s\n", error.c_str());
+        }
+    }
+}
+
+// Запись разделов рецепта в JSON
+static void recipeToJson(const RecipeData& data, JsonObject root) {
+    for (size_t s = 0; s < recipeSectionCount; s++) {
+        const SettingsSection& section = getSettingsSection(recipeSections[s].id);
+        JsonObject obj = root.createNestedObject(section.name);
+        settingsSectionToJson(section, recipeSectionData(data, recipeSections[s]), obj, SF_RECIPE);
+    }
+}
+
+// Запись бинарного кэша рецепта
+static bool writeRecipeCache(const char* name, const RecipeData& data, uint16_t version) {
+    char jsonPath[64];
+    char binPath[64];
+    recipePath(jsonPath, sizeof(jsonPath), name, "json");
+    recipePath(binPath, sizeof(binPath), name, "bin");
+
+    File jsonFile = LittleFS.open(jsonPath, "r");
+    if (!jsonFile) {
+        return false;
+    }
+
+    RecipeCacheHeader header;
+    header.magic = RECIPE_CACHE_MAGIC;
+    header.format = RECIPE_CACHE_FORMAT;
+    header.version = version;
+    header.dataSize = sizeof(RecipeData);
+    header.jsonSize = jsonFile.size();
+    header.jsonTime = (uint32_t)jsonFile.getLastWrite();
+    header.crc = crc32_le(0, (const uint8_t*)&data, sizeof(RecipeData));
+    jsonFile.close();
+
+    File binFile = LittleFS.open(binPath, "w");
+    if (!binFile) {
+        Serial.printf("Ошибка создания кэша рецепта %s\n", name);
+        return false;
+    }
+
+    bool ok = binFile.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              binFile.write((const uint8_t*)&data, sizeof(RecipeData)) == sizeof(RecipeData);
+    binFile.close();
+
+    if (!ok) {
+        LittleFS.remove(binPath);
+        Serial.printf("Ошибка записи кэша рецепта %s\n", name);
+    }
+    return ok;
+}
+
+// Чтение бинарного кэша рецепта (false, если кэш отсутствует или устарел)
+static bool readRecipeCache(const char* name, RecipeData& data, uint16_t& version) {
+    char jsonPath[64];
+    char binPath[64];
+    recipePath(jsonPath, sizeof(jsonPath), name, "json");
+    recipePath(binPath, sizeof(binPath), name, "bin");
+
+    File jsonFile = LittleFS.open(jsonPath, "r");
+    if (!jsonFile) {
+        return false;
+    }
+    uint32_t jsonSize = jsonFile.size();
+    uint32_t jsonTime = (uint32_t)jsonFile.getLastWrite();
+    jsonFile.close();
+
+    File binFile = LittleFS.open(binPath, "r");
+    if (!binFile) {
+        return false;
+    }
+
+    RecipeCacheHeader header;
+    bool ok = binFile.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+              header.magic == RECIPE_CACHE_MAGIC &&
+              header.format == RECIPE_CACHE_FORMAT &&
+              header.dataSize == sizeof(RecipeData) &&
+              header.jsonSize == jsonSize &&
+              header.jsonTime == jsonTime &&
+              binFile.read((uint8_t*)&data, sizeof(RecipeData)) == sizeof(RecipeData) &&
+              crc32_le(0, (const uint8_t*)&data, sizeof(RecipeData)) == header.crc;
+    binFile.close();
+
+    if (ok) {
+        version = header.version;
+    }
+    return ok;
+}
+
+// Чтение JSON-файла рецепта
+static bool readRecipeJson(const char* name, RecipeData& data, uint16_t& version) {
+    char path[64];
+    recipePath(path, sizeof(path), name, "json");
+
+    File file = LittleFS.open(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    DynamicJsonDocument doc(RECIPE_JSON_SIZE);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        Serial.printf("Ошибка разбора рецепта %s: %s\n", name, error.c_str());
+        return false;
+    }
+
+    // Поля, отсутствующие в файле, берутся из текущих настроек
+    fillFromCurrent(data);
+    recipeFromJson(doc.as<JsonObjectConst>(), data);
+    version = doc["version"] | 1;
+    return true;
+}
+
+// Запись JSON-файла рецепта
+static bool writeRecipeJson(const char* name, const RecipeData& data, uint16_t version) {
+    char path[64];
+    recipePath(path, sizeof(path), name, "json");
+
+    DynamicJsonDocument doc(RECIPE_JSON_SIZE);
+    JsonObject root = doc.to<JsonObject>();
+    root["name"] = name;
+    root["version"] = version;
+    recipeToJson(data, root);
+
+    File file = LittleFS.open(path, "w");
+    if (!file) {
+        Serial.printf("Ошибка создания файла рецепта %s\n", name);
+        return false;
+    }
+    size_t written = serializeJsonPretty(doc, file);
+    file.close();
+
+    if (written == 0) {
+        Serial.printf("Ошибка записи рецепта %s\n", name);
+        return false;
+    }
+    return true;
+}
+
+// Чтение рецепта: из кэша, а при его отсутствии - из JSON с обновлением кэша
+static bool readRecipe(const char* name, RecipeData& data, uint16_t& version) {
+    if (readRecipeCache(name, data, version)) {
+        return true;
+    }
+    if (!readRecipeJson(name, data, version)) {
+        return false;
+    }
+    writeRecipeCache(name, data, version);
+    return true;
+}
+
+// Сохранение рецепта в JSON и кэш
+static bool writeRecipe(const char* name, const RecipeData& data, uint16_t version) {
+    if (!writeRecipeJson(name, data, version)) {
+        return false;
+    }
+    return writeRecipeCache(name, data, version);
+}
+
+// Проверка существования рецепта
+static bool recipeExists(const char* name) {
+    char path[64];
+    recipePath(path, sizeof(path), name, "json");
+    return LittleFS.exists(path);
+}
+
+// Создание рецепта по умолчанию из файла начальных настроек
+static void seedDefaultRecipe() {
+    File file = LittleFS.open(RECIPE_SEED_FILE, "r");
+    if (!file) {
+        return;
+    }
+
+    DynamicJsonDocument doc(RECIPE_JSON_SIZE);
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+
+    if (error) {
+        Serial.printf("Ошибка разбора %s: %s\n", RECIPE_SEED_FILE, error.c_str());
+        return;
+    }
+
+    const char* name = doc["recipe"]["name"] | "default";
+    uint16_t version = doc["recipe"]["version"] | 1;
+    if (!isValidRecipeName(name)) {
+        name = "default";
+    }
+
+    RecipeData data;
+    fillFromCurrent(data);
+    recipeFromJson(doc.as<JsonObjectConst>(), data);
+
+    if (writeRecipe(name, data, version)) {
+        Serial.printf("Создан рецепт по умолчанию: %s\n", name);
+    }
+}
+
+static int scanRecipes(RecipeInfo* list, int maxCount);
+
+// Инициализация модуля рецептов
+bool initRecipes() {
+    if (!LittleFS.exists(RECIPES_DIR) && !LittleFS.mkdir(RECIPES_DIR)) {
+        Serial.println("Ошибка создания каталога рецептов");
+        return false;
+    }
+
+    RecipeInfo list[1];
+    if (scanRecipes(list, 1) == 0) {
+        seedDefaultRecipe();
+    }
+
+    // Восстанавливаем имя активного рецепта
+    File file = LittleFS.open(RECIPE_ACTIVE_FILE, "r");
+    if (file) {
+        size_t len = file.readBytes(activeRecipeName, RECIPE_NAME_MAX_LEN);
+        activeRecipeName[len] = '\0';
+        file.close();
+        if (!isValidRecipeName(activeRecipeName) || !recipeExists(activeRecipeName)) {
+            activeRecipeName[0] = '\0';
+        }
+    }
+
+    Serial.println("Модуль рецептов инициализирован");
+    return true;
+}
+
+// Обход каталога рецептов
+static int scanRecipes(RecipeInfo* list, int maxCount) {
+    File dir = LittleFS.open(RECIPES_DIR);
+    if (!dir || !dir.isDirectory()) {
+        return 0;
+    }
+
+    int count = 0;
+    File file = dir.openNextFile();
+    while (file && count < maxCount) {
+        const char* fileName = file.name();
+        const char* slash = strrchr(fileName, '/');
+        if (slash) {
+            fileName = slash + 1;
+        }
+
+        const char* ext = strrchr(fileName, '.');
+        size_t nameLen = ext ? (size_t)(ext - fileName) : 0;
+
+        if (!file.isDirectory() && ext && strcmp(ext, ".json") == 0 &&
+            nameLen > 0 && nameLen <= RECIPE_NAME_MAX_LEN) {
+            RecipeInfo& info = list[count];
+            memcpy(info.name, fileName, nameLen);
+            info.name[nameLen] = '\0';
+            info.size = file.size();
+
+            // Кэш здесь не пересоздаем, чтобы не менять каталог во время обхода
+            RecipeData data;
+            uint16_t version = 0;
+            file.close();
+            if (!readRecipeCache(info.name, data, version) &&
+                !readRecipeJson(info.name, data, version)) {
+                version = 0;
+            }
+            info.version = version;
+            count++;
+        } else {
+            file.close();
+        }
+        file = dir.openNextFile();
+    }
+    dir.close();
+
+    return count;
+}
+
+// Получение списка сохраненных рецептов
+int listRecipes(RecipeInfo* list, int maxCount) {
+    if (!beginFileAccess()) {
+        return 0;
+    }
+    int count = scanRecipes(list, maxCount);
+    endFileAccess();
+    return count;
+}
+
+// Чтение рецепта и применение его к текущим настройкам
+static bool applyRecipe(const char* name) {
+    if (!isValidRecipeName(name)) {
+        return false;
+    }
+
+    RecipeData data;
+    uint16_t version = 0;
+    if (!readRecipe(name, data, version)) {
+        Serial.printf("Рецепт %s не найден\n", name);
+        return false;
+    }
+
+    float calibrationFactor = sysSettings.pumpSettings.calibrationFactor;
+    sysSettings.rectificationSettings = data.rect;
+    sysSettings.distillationSettings = data.dist;
+    sysSettings.pumpSettings = data.pump;
+    sysSettings.pumpSettings.calibrationFactor = calibrationFactor;
+
+    if (!saveSystemSettings()) {
+        return false;
+    }
+
+    strncpy(activeRecipeName, name, RECIPE_NAME_MAX_LEN);
+    activeRecipeName[RECIPE_NAME_MAX_LEN] = '\0';
+
+    File file = LittleFS.open(RECIPE_ACTIVE_FILE, "w");
+    if (file) {
+        file.print(activeRecipeName);
+        file.close();
+    }
+
+    Serial.printf("Загружен рецепт %s (версия %u)\n", name, version);
+    return true;
+}
+
+// Загрузка рецепта и применение его к текущим настройкам
+bool loadRecipe(const char* name) {
+    if (!beginFileAccess()) {
+        return false;
+    }
+    bool ok = applyRecipe(name);
+    endFileAccess();
+    return ok;
+}
+
+// Запись текущих настроек в файлы рецепта
+static bool storeRecipe(const char* name) {
+    if (!isValidRecipeName(name)) {
+        return false;
+    }
+
+    uint16_t version = 0;
+    bool exists = recipeExists(name);
+    if (exists) {
+        RecipeData old;
+        if (!readRecipe(name, old, version)) {
+            version = 0;
+        }
+    } else {
+        RecipeInfo list[MAX_RECIPES];
+        if (scanRecipes(list, MAX_RECIPES) >= MAX_RECIPES) {
+            Serial.println("Достигнуто максимальное количество рецептов");
+            return false;
+        }
+    }
+
+    RecipeData data;
+    fillFromCurrent(data);
+
+    if (!writeRecipe(name, data, version + 1)) {
+        return false;
+    }
+
+    Serial.printf("Рецепт %s сохранен (версия %u)\n", name, version + 1);
+    return true;
+}
+
+// Сохранение текущих настроек как рецепта
+bool saveRecipe(const char* name) {
+    if (!beginFileAccess()) {
+        return false;
+    }
+    bool ok = storeRecipe(name);
+    endFileAccess();
+    return ok;
+}
+
+// Запись копии рецепта под новым именем
+static bool copyRecipe(const char* srcName, const char* dstName) {
+    if (!isValidRecipeName(srcName) || !isValidRecipeName(dstName) || recipeExists(dstName)) {
+        return false;
+    }
+
+    RecipeData data;
+    uint16_t version = 0;
+    if (!readRecipe(srcName, data, version)) {
+        return false;
+    }
+
+    return writeRecipe(dstName, data, 1);
+}
+
+// Копирование рецепта под новым именем
+bool duplicateRecipe(const char* srcName, const char* dstName) {
+    if (!beginFileAccess()) {
+        return false;
+    }
+    bool ok = copyRecipe(srcName, dstName);
+    endFileAccess();
+    return ok;
+}
+
+// Удаление файлов рецепта
+static bool removeRecipe(const char* name) {
+    if (!isValidRecipeName(name) || !recipeExists(name)) {
+        return false;
+    }
+
+    char path[64];
+    recipePath(path, sizeof(path), name, "bin");
+    LittleFS.remove(path);
+    recipePath(path, sizeof(path), name, "json");
+
+    if (strcmp(activeRecipeName, name) == 0) {
+        activeRecipeName[0] = '\0';
+        LittleFS.remove(RECIPE_ACTIVE_FILE);
+    }
+
+    return LittleFS.remove(path);
+}
+
+// Удаление рецепта
+bool deleteRecipe(const char* name) {
+    if (!beginFileAccess()) {
+        return false;
+    }
+    bool ok = removeRecipe(name);
+    endFileAccess();
+    return ok;
+}
+
+// Сравнение полей двух рецептов
+static bool compareRecipes(const char* nameA, const char* nameB, JsonArray diff) {
+    if (!isValidRecipeName(nameA) || !isValidRecipeName(nameB)) {
+        return false;
+    }
+
+    RecipeData a;
+    RecipeData b;
+    uint16_t versionA = 0;
+    uint16_t versionB = 0;
+    if (!readRecipe(nameA, a, versionA) || !readRecipe(nameB, b, versionB)) {
+        return false;
+    }
+
+    for (size_t s = 0; s < recipeSectionCount; s++) {
+        const SettingsSection& section = getSettingsSection(recipeSections[s].id);
+        const void* sectionA = recipeSectionData(a, recipeSections[s]);
+        const void* sectionB = recipeSectionData(b, recipeSections[s]);
+        for (uint8_t f = 0; f < section.count; f++) {
+            const SettingField& field = section.fields[f];
+            if (!(field.flags & SF_RECIPE) || settingFieldEquals(field, sectionA, sectionB)) {
+                continue;
+            }
+
+            JsonObject entry = diff.createNestedObject();
+            entry["section"] = section.name;
+            entry["field"] = field.key;
+
+            // Значения записываем под ключами "a" и "b"
+            StaticJsonDocument<64> tmp;
+            JsonObject values = tmp.to<JsonObject>();
+            settingFieldToJson(field, sectionA, values);
+            entry["a"] = values[field.key];
+            settingFieldToJson(field, sectionB, values);
+            entry["b"] = values[field.key];
+        }
+    }
+
+    return true;
+}
+
+// Сравнение двух рецептов
+bool diffRecipes(const char* nameA, const char* nameB, JsonArray diff) {
+    if (!beginFileAccess()) {
+        return false;
+    }
+    bool ok = compareRecipes(nameA, nameB, diff);
+    endFileAccess();
+    return ok;
+}
+
+// Проверка корректности имени рецепта
+bool isValidRecipeName(const char* name) {
+    if (name == nullptr) {
+        return false;
+    }
+
+    size_t len = strlen(name);
+    if (len == 0 || len > RECIPE_NAME_MAX_LEN) {
+        return false;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
+        if (!isalnum((unsigned char)c) && c != '-' && c != '_') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Получение имени последнего загруженного рецепта
+const char* getActiveRecipeName() {
+    return activeRecipeName;
+}
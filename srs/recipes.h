@@ -0,0 +1,122 @@
+/**
+ * @file recipes.h
+ * @brief Управление рецептами (профилями процесса)
+ *
+ * Рецепт - именованный набор настроек ректификации, дистилляции и скоростей
+ * отбора насоса. Рецепты хранятся на LittleFS в каталоге /recipes в виде
+ * JSON-файлов (/recipes/<имя>.json), рядом с каждым хранится бинарный кэш
+ * (/recipes/<имя>.bin) с готовыми структурами настроек, поэтому переключение
+ * рецепта при запуске процесса не требует разбора JSON.
+ */
+
+#ifndef RECIPES_H
+#define RECIPES_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "settings.h"
+
+// Каталог рецептов на файловой системе
+#define RECIPES_DIR "/recipes"
+
+// Максимальная длина имени рецепта (без завершающего нуля)
+#define RECIPE_NAME_MAX_LEN 24
+
+// Максимальное количество рецептов
+#define MAX_RECIPES 16
+
+// Краткая информация о рецепте для списка
+struct RecipeInfo {
+    char name[RECIPE_NAME_MAX_LEN + 1];  // Имя рецепта
+    uint16_t version;                    // Версия рецепта (увеличивается при каждом сохранении)
+    size_t size;                         // Размер JSON-файла рецепта
+};
+
+/**
+ * @brief Инициализация модуля рецептов
+ *
+ * Создает каталог рецептов и, если он пуст, создает рецепт по умолчанию
+ * из файла /settings.json.
+ *
+ * @return true если инициализация прошла успешно
+ */
+bool initRecipes();
+
+/**
+ * @brief Получение списка сохраненных рецептов
+ *
+ * @param list Массив для записи информации о рецептах
+ * @param maxCount Размер массива
+ * @return int Количество найденных рецептов
+ */
+int listRecipes(RecipeInfo* list, int maxCount);
+
+/**
+ * @brief Загрузка рецепта и применение его к текущим настройкам
+ *
+ * Использует бинарный кэш, если он актуален, иначе разбирает JSON
+ * и пересоздает кэш. Применённые настройки сохраняются.
+ *
+ * @param name Имя рецепта
+ * @return true если рецепт загружен
+ */
+bool loadRecipe(const char* name);
+
+/**
+ * @brief Сохранение текущих настроек как рецепта
+ *
+ * Если рецепт с таким именем существует, его версия увеличивается.
+ *
+ * @param name Имя рецепта
+ * @return true если рецепт сохранен
+ */
+bool saveRecipe(const char* name);
+
+/**
+ * @brief Копирование рецепта под новым именем
+ *
+ * @param srcName Имя исходного рецепта
+ * @param dstName Имя нового рецепта
+ * @return true если копия создана
+ */
+bool duplicateRecipe(const char* srcName, const char* dstName);
+
+/**
+ * @brief Удаление рецепта
+ *
+ * @param name Имя рецепта
+ * @return true если рецепт удален
+ */
+bool deleteRecipe(const char* name);
+
+/**
+ * @brief Сравнение двух рецептов
+ *
+ * Добавляет в массив по объекту на каждое отличающееся поле:
+ * {"section", "field", "a", "b"}.
+ *
+ * @param nameA Имя первого рецепта
+ * @param nameB Имя второго рецепта
+ * @param diff Массив для записи отличий
+ * @return true если оба рецепта прочитаны
+ */
+bool diffRecipes(const char* nameA, const char* nameB, JsonArray diff);
+
+/**
+ * @brief Проверка корректности имени рецепта
+ *
+ * Допустимы латинские буквы, цифры, '-' и '_'.
+ *
+ * @param name Имя рецепта
+ * @return true если имя допустимо
+ */
+bool isValidRecipeName(const char* name);
+
+/**
+ * @brief Получение имени последнего загруженного рецепта
+ *
+ * @return const char* Имя рецепта или пустая строка
+ */
+const char* getActiveRecipeName();
+
+#endif // RECIPES_H
@@ -6,6 +6,12 @@
 #include "settings.h"
 #include "display.h"
 #include "utils.h"
+#include "column_monitor.h"
+#include "forecast.h"
+#include "checkpoint.h"
+#include "safety.h"
+#include "telemetry.h"
+#include "event_log.h"
 #include <Arduino.h>
 
 // Фазы ректификации
@@ -42,6 +48,22 @@ int tailsCollected = 0;
 bool refluxState = false;
 unsigned long lastRefluxToggleTime = 0;
 
+// Время, сэкономленное автоопределением стабилизации (мс)
+unsigned long stabilizationSavedTime = 0;
+
+// Состояние детектора окончания голов
+float headsEndConfidence = 0;
+bool headsEndProposed = false;
+int headsEndDetectedVolume = -1;
+
+// Состояние режима "старт-стоп" при отборе тела
+float bodyFlowRate = 0;
+float lockedBodyTemp = 0;
+bool bodyStopped = false;
+unsigned long startStopExcessSince = 0;  // Начало превышения температуры (0 - нет превышения)
+int startStopCount = 0;
+StartStopRecord startStopHistory[START_STOP_HISTORY_SIZE];
+
 // Последние измеренные температуры
 float lastCubeTemp = 0;
 float lastColumnTemp = 0;
@@ -65,6 +87,13 @@ void initRectification() {
     refluxState = false;
     lastRefluxToggleTime = 0;
     
+    stabilizationSavedTime = 0;
+    resetColumnMonitor();
+    
+    headsEndConfidence = 0;
+    headsEndProposed = false;
+    headsEndDetectedVolume = -1;
+    
     // Обновляем температуры
     updateTemperatures();
     lastCubeTemp = getTemperature(TEMP_CUBE);
@@ -81,6 +110,12 @@ bool startRectification() {
         return false;
     }
     
+    // Зафиксированная аварийная остановка снимается только оператором
+    if (getSafetyRuleAction() >= SAFETY_ACTION_STOP) {
+        Serial.println("Ошибка: Аварийная остановка не сброшена");
+        return false;
+    }
+    
     // Проверяем наличие датчиков
     if (!isSensorConnected(TEMP_CUBE) || !isSensorConnected(TEMP_REFLUX)) {
         Serial.println("Ошибка: Не подключены необходимые датчики");
@@ -112,6 +147,23 @@ bool startRectification() {
     refluxState = false;
     lastRefluxToggleTime = 0;
     
+    // Сбрасываем статистику стабилизации
+    stabilizationSavedTime = 0;
+    resetColumnMonitor();
+    
+    // Сбрасываем детектор окончания голов
+    headsEndConfidence = 0;
+    headsEndProposed = false;
+    headsEndDetectedVolume = -1;
+    
+    // Сбрасываем режим "старт-стоп"
+    bodyStopped = false;
+    startStopExcessSince = 0;
+    startStopCount = 0;
+    
+    // Сбрасываем прогноз
+    resetForecast();
+    
     // Включаем нагреватель на начальной мощности
     setHeaterPower(sysSettings.rectificationSettings.heatingPowerWatts);
     
@@ -127,7 +179,11 @@ bool startRectification() {
     rectificationRunning = true;
     rectificationPaused = false;
     
-    Serial.println("Процесс ректификации запущен");
+    // Новая запись телеметрии и первая контрольная точка процесса
+    startTelemetryRun(CHECKPOINT_RECTIFICATION);
+    saveCheckpoint();
+    
+    logRecord(EV_RECT_STARTED);
     
     return true;
 }
@@ -152,7 +208,13 @@ void stopRectification() {
     rectificationPaused = false;
     setRectificationPhase(RECT_PHASE_IDLE);
     
-    Serial.println("Процесс ректификации остановлен");
+    // Остановленный процесс не предлагается к продолжению
+    clearCheckpoint();
+    
+    // Остановка по правилу безопасности выполнена
+    acknowledgeSafetyStop();
+    
+    logRecord(EV_RECT_STOPPED);
 }
 
 // Пауза процесса ректификации
@@ -175,7 +237,9 @@ void pauseRectification() {
     
     rectificationPaused = true;
     
-    Serial.println("Процесс ректификации на паузе");
+    saveCheckpoint();
+    
+    logRecord(EV_RECT_PAUSED);
 }
 
 // Возобновление процесса ректификации
@@ -189,6 +253,9 @@ void resumeRectification() {
     rectStartTime += pauseDuration;
     phaseStartTime += pauseDuration;
     
+    // Отсчеты до паузы не отражают текущее состояние колонны
+    resetColumnMonitor();
+    
     // Восстанавливаем мощность нагревателя в зависимости от фазы
     switch (currentPhase) {
         case RECT_PHASE_HEATING:
@@ -214,7 +281,7 @@ void resumeRectification() {
     
     rectificationPaused = false;
     
-    Serial.println("Процесс ректификации возобновлен");
+    logRecord(EV_RECT_RESUMED);
 }
 
 // Обработка процесса ректификации
@@ -226,7 +293,7 @@ void processRectification() {
     
     // Проверяем условия безопасности
     if (!checkRectificationSafety()) {
-        Serial.println("Сработала защита! Процесс ректификации остановлен");
+        logRecord(EV_RECT_SAFETY_STOP);
         setRectificationPhase(RECT_PHASE_ERROR);
         stopRectification();
         return;
@@ -238,6 +305,9 @@ void processRectification() {
     lastColumnTemp = getTemperature(TEMP_COLUMN);
     lastRefluxTemp = getTemperature(TEMP_REFLUX);
     
+    // Накапливаем выборку для анализа стабильности колонны
+    updateColumnMonitor(lastRefluxTemp, isSensorConnected(TEMP_COLUMN) ? lastColumnTemp : NAN);
+    
     // Обрабатываем текущую фазу
     switch (currentPhase) {
         case RECT_PHASE_HEATING:
@@ -269,6 +339,13 @@ void processRectification() {
             stopRectification();
             break;
     }
+    
+    // Обновляем прогноз времени завершения, телеметрию и периодическую контрольную точку
+    if (rectificationRunning) {
+        updateForecast();
+        updateTelemetry();
+        updateCheckpoint();
+    }
 }
 
 // Обработка фазы нагрева
@@ -283,15 +360,36 @@ void processHeatingPhase() {
     }
 }
 
-// Обработка фазы стабилизации
-void processStabilizationPhase() {
-    // Фаза стабилизации: выдерживаем колонну определенное время для стабилизации
-    
-    // Проверяем, прошло ли заданное время стабилизации
+// Проверка завершения стабилизации
+// Фиксированное время задает верхнюю границу; при включенном автоопределении
+// фаза завершается раньше, если после минимального времени колонна стабильна.
+static bool isStabilizationComplete(int minTimeMinutes, int maxTimeMinutes) {
     unsigned long phaseTime = millis() - phaseStartTime;
-    unsigned long stabilizationTimeMs = sysSettings.rectificationSettings.stabilizationTime * 60000; // минуты -> миллисекунды
+    unsigned long maxTimeMs = (unsigned long)maxTimeMinutes * 60000UL; // минуты -> миллисекунды
+    unsigned long minTimeMs = (unsigned long)minTimeMinutes * 60000UL;
     
-    if (phaseTime >= stabilizationTimeMs) {
+    if (phaseTime >= maxTimeMs) {
+        return true;
+    }
+    
+    if (!sysSettings.rectificationSettings.autoStabilization || phaseTime < minTimeMs) {
+        return false;
+    }
+    
+    if (!isRectificationColumnStable()) {
+        return false;
+    }
+    
+    stabilizationSavedTime += maxTimeMs - phaseTime;
+    logRecord(EV_RECT_STABILIZED_EARLY, (maxTimeMs - phaseTime) / 1000);
+    return true;
+}
+
+// Обработка фазы стабилизации
+void processStabilizationPhase() {
+    // Фаза стабилизации: выдерживаем колонну до стабилизации температур
+    if (isStabilizationComplete(sysSettings.rectificationSettings.stabilizationMinTime,
+                                sysSettings.rectificationSettings.stabilizationTime)) {
         // Переходим к фазе отбора голов
         setRectificationPhase(RECT_PHASE_HEADS);
     }
@@ -301,57 +399,100 @@ void processStabilizationPhase() {
     }
 }
 
+// Завершение отбора голов и переход к следующей фазе согласно модели
+void finishHeadsPhase() {
+    // Журнал для сравнения детектора с фиксированным критерием
+    if (headsEndDetectedVolume >= 0) {
+        logRecord(EV_RECT_HEADS_DONE_DETECTED, headsCollected, headsEndDetectedVolume);
+    } else {
+        logRecord(EV_RECT_HEADS_DONE, headsCollected);
+    }
+    
+    if (sysSettings.rectificationSettings.model == 0) {
+        // Классическая модель: переходим к фазе отбора тела
+        setHeaterPower(sysSettings.rectificationSettings.bodyPowerWatts);
+        setRectificationPhase(RECT_PHASE_BODY);
+    } else {
+        // Альтернативная модель: переходим к фазе стабилизации после голов
+        pumpStop();
+        valveClose();
+        setRectificationPhase(RECT_PHASE_POST_HEADS_STAB);
+    }
+}
+
+// Обработка детектора окончания голов
+// Возвращает true, если детектор завершил фазу отбора голов
+static bool processHeadsEndDetector() {
+    int mode = sysSettings.rectificationSettings.headsEndMode;
+    if (mode == HEADS_END_OFF) {
+        return false;
+    }
+    
+    headsEndConfidence = getHeadsEndConfidence(sysSettings.rectificationSettings.stabilizationWindow,
+                                               sysSettings.rectificationSettings.headsEndMaxSlope,
+                                               sysSettings.rectificationSettings.headsEndMaxDelta);
+    
+    if (headsEndConfidence < sysSettings.rectificationSettings.headsEndConfidence) {
+        return false;
+    }
+    
+    // Запоминаем объем голов при первом срабатывании для сравнения с фиксированным критерием
+    if (headsEndDetectedVolume < 0) {
+        headsEndDetectedVolume = headsCollected;
+        logRecord(EV_RECT_HEADS_END_DETECTED, headsEndConfidence, headsCollected);
+    }
+    
+    if (mode == HEADS_END_AUTO) {
+        finishHeadsPhase();
+        return true;
+    }
+    
+    if (!headsEndProposed) {
+        headsEndProposed = true;
+        sendWebNotification(NOTIFY_INFO, "Головы отобраны? Подтвердите переход к отбору тела");
+    }
+    return false;
+}
+
 // Обработка фазы отбора голов
 void processHeadsPhase() {
+    // Детектор может завершить фазу раньше фиксированного критерия
+    if (processHeadsEndDetector()) {
+        return;
+    }
+    
     // Проверяем модель ректификации
     if (sysSettings.rectificationSettings.model == 0) {
         // Классическая модель: отбираем заданный объем голов
         if (headsCollected >= sysSettings.rectificationSettings.headsVolume) {
-            // Переходим к фазе отбора тела
-            setHeaterPower(sysSettings.rectificationSettings.bodyPowerWatts);
-            setRectificationPhase(RECT_PHASE_BODY);
+            finishHeadsPhase();
             return;
         }
-        
-        // Отбираем головы через насос
-        float headRate = sysSettings.pumpSettings.headsFlowRate;
-        pumpStart(headRate);
-        valveOpen();
-        
-        // Увеличиваем счетчик отбора голов
-        headsCollected += pumpGetExtractedVolume();
-        
     } else {
         // Альтернативная модель: отбираем головы заданное время
         unsigned long phaseTime = millis() - phaseStartTime;
         unsigned long headsTimeMs = sysSettings.rectificationSettings.headsTargetTime * 60000; // минуты -> миллисекунды
         
         if (phaseTime >= headsTimeMs) {
-            // Переходим к фазе стабилизации после голов
-            pumpStop();
-            valveClose();
-            setRectificationPhase(RECT_PHASE_POST_HEADS_STAB);
+            finishHeadsPhase();
             return;
         }
-        
-        // Отбираем головы с заданной скоростью
-        pumpStart(sysSettings.pumpSettings.headsFlowRate);
-        valveOpen();
-        
-        // Увеличиваем счетчик отбора голов
-        headsCollected += pumpGetExtractedVolume();
     }
+    
+    // Отбираем головы с заданной скоростью
+    pumpStart(sysSettings.pumpSettings.headsFlowRate);
+    valveOpen();
+    
+    // Увеличиваем счетчик отбора голов
+    headsCollected += pumpGetExtractedVolume();
 }
 
 // Обработка фазы стабилизации после отбора голов
 void processPostHeadsStabilizationPhase() {
     // Фаза стабилизации после отбора голов (только для альтернативной модели)
     
-    // Проверяем, прошло ли заданное время стабилизации после голов
-    unsigned long phaseTime = millis() - phaseStartTime;
-    unsigned long stabilizationTimeMs = sysSettings.rectificationSettings.postHeadsStabilizationTime * 60000; // минуты -> миллисекунды
-    
-    if (phaseTime >= stabilizationTimeMs) {
+    if (isStabilizationComplete(sysSettings.rectificationSettings.postHeadsStabilizationMinTime,
+                                sysSettings.rectificationSettings.postHeadsStabilizationTime)) {
         // Переходим к фазе отбора тела
         setHeaterPower(sysSettings.rectificationSettings.bodyPowerWatts);
         setRectificationPhase(RECT_PHASE_BODY);
@@ -362,6 +503,66 @@ void processPostHeadsStabilizationPhase() {
     }
 }
 
+// Обработка режима "старт-стоп" при отборе тела
+// Возвращает true, если отбор тела завершен и выполнен переход к хвостам
+static bool processStartStop() {
+    float stopTemp = lockedBodyTemp + sysSettings.rectificationSettings.startStopDelta;
+    // Отбор возобновляется при возврате температуры в пределы половины дельты
+    float resumeTemp = lockedBodyTemp + sysSettings.rectificationSettings.startStopDelta / 2;
+    
+    if (bodyStopped) {
+        if (lastRefluxTemp <= resumeTemp) {
+            bodyStopped = false;
+            logRecord(EV_RECT_BODY_RESUMED, bodyFlowRate);
+        }
+        return false;
+    }
+    
+    if (lastRefluxTemp <= stopTemp) {
+        startStopExcessSince = 0;
+        return false;
+    }
+    
+    // Превышение должно удерживаться startStopHoldTime, чтобы единичный
+    // выброс показаний датчика не снизил скорость отбора до конца процесса
+    unsigned long currentTime = millis();
+    if (startStopExcessSince == 0) {
+        startStopExcessSince = currentTime ? currentTime : 1;
+    }
+    if (currentTime - startStopExcessSince < sysSettings.rectificationSettings.startStopHoldTime * 1000UL) {
+        return false;
+    }
+    startStopExcessSince = 0;
+    
+    float minRate = sysSettings.pumpSettings.bodyFlowRate * sysSettings.rectificationSettings.startStopMinRate / 100.0f;
+    
+    // Остановка на минимальной скорости означает, что тело закончилось
+    if (bodyFlowRate <= minRate) {
+        logRecord(EV_RECT_BODY_MIN_RATE);
+        setHeaterPower(sysSettings.rectificationSettings.tailsPowerWatts);
+        setRectificationPhase(RECT_PHASE_TAILS);
+        return true;
+    }
+    
+    bodyFlowRate *= 1.0f - sysSettings.rectificationSettings.startStopBackoff / 100.0f;
+    if (bodyFlowRate < minRate) {
+        bodyFlowRate = minRate;
+    }
+    
+    StartStopRecord& record = startStopHistory[startStopCount % START_STOP_HISTORY_SIZE];
+    record.time = getRectificationUptime();
+    record.refluxTemp = lastRefluxTemp;
+    record.flowRate = bodyFlowRate;
+    startStopCount++;
+    
+    bodyStopped = true;
+    pumpStop();
+    valveClose();
+    
+    logRecord(EV_RECT_START_STOP, startStopCount, bodyFlowRate);
+    return false;
+}
+
 // Обработка фазы отбора тела
 void processBodyPhase() {
     // Проверяем модель ректификации
@@ -395,9 +596,14 @@ void processBodyPhase() {
         controlReflux();
     }
     
+    // Режим "старт-стоп": остановка при росте температуры узла отбора
+    if (sysSettings.rectificationSettings.bodyStartStop && processStartStop()) {
+        return;
+    }
+    
     // Отбираем тело с заданной скоростью
-    if (!refluxState) {
-        pumpStart(sysSettings.pumpSettings.bodyFlowRate);
+    if (!refluxState && !bodyStopped) {
+        pumpStart(bodyFlowRate);
         valveOpen();
         
         // Увеличиваем счетчик отбора тела
@@ -463,13 +669,17 @@ void controlReflux() {
             pumpStop();
         } else {
             // Орошение выключено - открываем клапан отбора
+            // (кроме остановки отбора тела в режиме "старт-стоп")
+            if (currentPhase == RECT_PHASE_BODY && bodyStopped) {
+                return;
+            }
             valveOpen();
             
             // Запускаем насос при отборе с заданной скоростью в зависимости от фазы
             if (currentPhase == RECT_PHASE_HEADS) {
                 pumpStart(sysSettings.pumpSettings.headsFlowRate);
             } else if (currentPhase == RECT_PHASE_BODY) {
-                pumpStart(sysSettings.pumpSettings.bodyFlowRate);
+                pumpStart(bodyFlowRate);
             } else if (currentPhase == RECT_PHASE_TAILS) {
                 pumpStart(sysSettings.pumpSettings.tailsFlowRate);
             }
@@ -479,15 +689,11 @@ void controlReflux() {
 
 // Проверка условий безопасности для ректификации
 bool checkRectificationSafety() {
-    // Проверка максимальной температуры куба
-    if (lastCubeTemp > sysSettings.rectificationSettings.maxCubeTemp) {
-        Serial.println("Превышена максимальная температура куба!");
-        return false;
-    }
+    // Правила безопасности оцениваются общим движком с набором правил режима
+    updateSafety();
     
-    // Проверка наличия датчиков температуры
-    if (!isSensorConnected(TEMP_CUBE) || !isSensorConnected(TEMP_REFLUX)) {
-        Serial.println("Один из необходимых датчиков отключен!");
+    // Сработавшее правило записывает в журнал задача безопасности
+    if (getSafetyRuleAction() >= SAFETY_ACTION_STOP) {
         return false;
     }
     
@@ -508,10 +714,10 @@ void setRectificationPhase(RectificationPhase phase) {
     currentPhase = phase;
     phaseStartTime = millis();
     
-    Serial.print("Изменение фазы ректификации: ");
-    Serial.print(phaseNames[prevPhase]);
-    Serial.print(" -> ");
-    Serial.println(phaseNames[currentPhase]);
+    // Статистика колонны оценивается в пределах одной фазы
+    resetColumnMonitor();
+    
+    logRecord(EV_RECT_PHASE, phaseNames[prevPhase], phaseNames[currentPhase]);
     
     // Действия при переходе на новую фазу
     switch (phase) {
@@ -536,6 +742,12 @@ void setRectificationPhase(RectificationPhase phase) {
             pumpStop();
             break;
         case RECT_PHASE_BODY:
+            // Фиксируем температуру тела и начальную скорость отбора
+            lockedBodyTemp = lastRefluxTemp;
+            bodyFlowRate = sysSettings.pumpSettings.bodyFlowRate;
+            bodyStopped = false;
+            startStopExcessSince = 0;
+            startStopCount = 0;
             setHeaterPower(sysSettings.rectificationSettings.bodyPowerWatts);
             valveOpen();
             pumpStart(sysSettings.rectificationSettings.bodyFlowRate);
@@ -556,11 +768,17 @@ void setRectificationPhase(RectificationPhase phase) {
             setHeaterPower(0);
             valveClose();
             pumpStop();
+            clearCheckpoint();
             break;
         default:
             break;
     }
     
+    // Смена фазы запущенного процесса сохраняется сразу
+    if (rectificationRunning && phase >= RECT_PHASE_HEATING && phase <= RECT_PHASE_TAILS) {
+        saveCheckpoint();
+    }
+    
     // Обновляем информацию на дисплее
     updateDisplay();
 }
@@ -631,6 +849,77 @@ unsigned long getRectificationPhaseTime() {
     return (millis() - phaseStartTime) / 1000; // секунды
 }
 
+// Получение времени, сэкономленного автоопределением стабилизации
+unsigned long getRectificationStabilizationSavedTime() {
+    return stabilizationSavedTime / 1000; // секунды
+}
+
+// Проверка стабильности колонны по данным скользящего окна
+bool isRectificationColumnStable() {
+    return isColumnStable(sysSettings.rectificationSettings.stabilizationWindow,
+                          sysSettings.rectificationSettings.stabilizationMaxStdDev,
+                          sysSettings.rectificationSettings.stabilizationMaxSlope);
+}
+
+// Получение уверенности детектора окончания голов
+float getRectificationHeadsEndConfidence() {
+    return (currentPhase == RECT_PHASE_HEADS) ? headsEndConfidence : 0.0f;
+}
+
+// Проверка, предложен ли детектором переход к отбору тела
+bool isRectificationHeadsEndProposed() {
+    return headsEndProposed && currentPhase == RECT_PHASE_HEADS;
+}
+
+// Подтверждение окончания отбора голов оператором
+bool acceptRectificationHeadsEnd() {
+    if (!rectificationRunning || currentPhase != RECT_PHASE_HEADS) {
+        return false;
+    }
+    
+    Serial.println("Окончание отбора голов подтверждено оператором");
+    finishHeadsPhase();
+    return true;
+}
+
+// Получение объема голов на момент срабатывания детектора
+int getRectificationHeadsEndDetectedVolume() {
+    return headsEndDetectedVolume;
+}
+
+// Получение текущей скорости отбора тела
+float getRectificationBodyFlowRate() {
+    return bodyFlowRate;
+}
+
+// Проверка, остановлен ли отбор тела в режиме "старт-стоп"
+bool isRectificationBodyStopped() {
+    return bodyStopped && currentPhase == RECT_PHASE_BODY;
+}
+
+// Получение зафиксированной температуры тела
+float getRectificationLockedBodyTemp() {
+    return lockedBodyTemp;
+}
+
+// Получение количества остановок отбора тела
+int getRectificationStartStopCount() {
+    return startStopCount;
+}
+
+// Получение истории остановок отбора тела
+int getRectificationStartStopHistory(StartStopRecord* history, int maxCount) {
+    int stored = startStopCount < START_STOP_HISTORY_SIZE ? startStopCount : START_STOP_HISTORY_SIZE;
+    int first = startStopCount - stored;
+    int count = 0;
+    
+    for (int i = 0; i < stored && count < maxCount; i++) {
+        history[count++] = startStopHistory[(first + i) % START_STOP_HISTORY_SIZE];
+    }
+    
+    return count;
+}
+
 // Получение текущей температуры куба
 float getRectificationCubeTemp() {
     return lastCubeTemp;
@@ -649,4 +938,95 @@ float getRectificationRefluxTemp() {
 // Получение статуса орошения (true - включено)
 bool getRectificationRefluxStatus() {
     return refluxState;
-}
\ No newline at end of file
+}
+
+// Заполнение контрольной точки текущим состоянием ректификации
+void fillRectificationCheckpoint(ProcessCheckpoint& cp) {
+    cp.phase = currentPhase;
+    cp.uptime = getRectificationUptime();
+    cp.phaseTime = getRectificationPhaseTime();
+    cp.volumes[0] = headsCollected;
+    cp.volumes[1] = bodyCollected;
+    cp.volumes[2] = tailsCollected;
+    cp.cubeTemp = lastCubeTemp;
+    cp.refluxTemp = lastRefluxTemp;
+    cp.bodyFlowRate = bodyFlowRate;
+    cp.lockedBodyTemp = lockedBodyTemp;
+    cp.startStopCount = startStopCount;
+    
+    if (rectificationPaused) {
+        cp.flags |= CHECKPOINT_FLAG_PAUSED;
+    }
+    if (refluxState) {
+        cp.flags |= CHECKPOINT_FLAG_REFLUX;
+    }
+    if (bodyStopped) {
+        cp.flags |= CHECKPOINT_FLAG_BODY_STOPPED;
+    }
+}
+
+// Восстановление ректификации из контрольной точки
+bool restoreRectificationFromCheckpoint(const ProcessCheckpoint& cp, bool fromHeating) {
+    if (rectificationRunning) {
+        return false;
+    }
+    
+    RectificationPhase phase = fromHeating ? RECT_PHASE_HEATING : (RectificationPhase)cp.phase;
+    if (phase < RECT_PHASE_HEATING || phase > RECT_PHASE_TAILS) {
+        return false;
+    }
+    
+    // Восстанавливаем счетчики и общее время процесса
+    rectStartTime = millis() - cp.uptime * 1000UL;
+    rectPauseTime = 0;
+    headsCollected = cp.volumes[0];
+    bodyCollected = cp.volumes[1];
+    tailsCollected = cp.volumes[2];
+    
+    // Последние показания задачи опроса датчиков: восстановление вызывается
+    // из обработчика запроса, и опрос шины 1-Wire здесь мешал бы этой задаче
+    lastCubeTemp = getTemperature(TEMP_CUBE);
+    lastColumnTemp = getTemperature(TEMP_COLUMN);
+    lastRefluxTemp = getTemperature(TEMP_REFLUX);
+    
+    refluxState = false;
+    lastRefluxToggleTime = 0;
+    headsEndConfidence = 0;
+    headsEndProposed = false;
+    
+    // Вход в фазу выполняет действия с нагревателем, клапаном и насосом
+    currentPhase = RECT_PHASE_IDLE;
+    setRectificationPhase(phase);
+    
+    if (phase == RECT_PHASE_HEADS) {
+        setHeaterPower(sysSettings.rectificationSettings.stabilizationPowerWatts);
+    }
+    
+    // Продолжение в той же фазе сохраняет ее время и состояние отбора тела
+    if (phase == (RectificationPhase)cp.phase) {
+        phaseStartTime = millis() - cp.phaseTime * 1000UL;
+        
+        if (phase == RECT_PHASE_BODY) {
+            lockedBodyTemp = cp.lockedBodyTemp;
+            bodyFlowRate = cp.bodyFlowRate;
+            startStopCount = cp.startStopCount;
+            bodyStopped = (cp.flags & CHECKPOINT_FLAG_BODY_STOPPED) != 0;
+            startStopExcessSince = 0;
+        }
+    }
+    
+    // Прогноз и статистика колонны набираются заново
+    resetForecast();
+    resetColumnMonitor();
+    
+    rectificationRunning = true;
+    rectificationPaused = false;
+    
+    if (cp.flags & CHECKPOINT_FLAG_PAUSED) {
+        pauseRectification();
+    }
+    
+    Serial.println("Процесс ректификации восстановлен из контрольной точки");
+    
+    return true;
+}
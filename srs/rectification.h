@@ -0,0 +1,296 @@
+/**
+ * @file rectification.h
+ * @brief Управление процессом ректификации
+ *
+ * Этот модуль управляет процессом ректификации, включая фазы: нагрев,
+ * стабилизация колонны, отбор голов, стабилизация после голов,
+ * отбор тела и отбор хвостов.
+ */
+
+#ifndef RECTIFICATION_H
+#define RECTIFICATION_H
+
+#include <Arduino.h>
+
+struct ProcessCheckpoint;
+
+// Фазы ректификации
+enum RectificationPhase {
+    RECT_PHASE_IDLE = 0,         // Процесс не запущен
+    RECT_PHASE_HEATING,          // Нагрев до рабочей температуры
+    RECT_PHASE_STABILIZATION,    // Стабилизация колонны
+    RECT_PHASE_HEADS,            // Отбор голов
+    RECT_PHASE_POST_HEADS_STAB,  // Стабилизация после отбора голов
+    RECT_PHASE_BODY,             // Отбор тела
+    RECT_PHASE_TAILS,            // Отбор хвостов
+    RECT_PHASE_COMPLETED,        // Процесс завершен
+    RECT_PHASE_ERROR             // Ошибка в процессе
+};
+
+// Размер истории скоростей отбора в режиме "старт-стоп"
+#define START_STOP_HISTORY_SIZE 16
+
+// Запись истории режима "старт-стоп" (фиксируется при каждой остановке)
+struct StartStopRecord {
+    unsigned long time;          // Время остановки от начала процесса (секунды)
+    float refluxTemp;            // Температура узла отбора при остановке
+    float flowRate;              // Скорость отбора после снижения
+};
+
+// Режимы автоопределения окончания отбора голов
+enum HeadsEndMode {
+    HEADS_END_OFF = 0,           // Только по объему/времени
+    HEADS_END_PROPOSE,           // Предлагать переход оператору
+    HEADS_END_AUTO               // Переходить автоматически
+};
+
+/**
+ * @brief Инициализация подсистемы ректификации
+ */
+void initRectification();
+
+/**
+ * @brief Запуск процесса ректификации
+ *
+ * @return true если процесс успешно запущен
+ */
+bool startRectification();
+
+/**
+ * @brief Остановка процесса ректификации
+ */
+void stopRectification();
+
+/**
+ * @brief Пауза процесса ректификации
+ */
+void pauseRectification();
+
+/**
+ * @brief Возобновление процесса ректификации после паузы
+ */
+void resumeRectification();
+
+/**
+ * @brief Обработка процесса ректификации, вызывается в основном цикле
+ */
+void processRectification();
+
+/**
+ * @brief Получение текущей фазы ректификации
+ *
+ * @return Текущая фаза процесса
+ */
+RectificationPhase getRectificationPhase();
+
+/**
+ * @brief Получение имени текущей фазы ректификации
+ *
+ * @return Имя фазы как строка
+ */
+const char* getRectificationPhaseName();
+
+/**
+ * @brief Проверка, запущен ли процесс ректификации
+ *
+ * @return true если процесс запущен
+ */
+bool isRectificationRunning();
+
+/**
+ * @brief Проверка, на паузе ли процесс ректификации
+ *
+ * @return true если процесс на паузе
+ */
+bool isRectificationPaused();
+
+/**
+ * @brief Получение объема собранных голов
+ *
+ * @return Объем голов в миллилитрах
+ */
+int getRectificationHeadsVolume();
+
+/**
+ * @brief Получение объема собранного тела
+ *
+ * @return Объем тела в миллилитрах
+ */
+int getRectificationBodyVolume();
+
+/**
+ * @brief Получение объема собранных хвостов
+ *
+ * @return Объем хвостов в миллилитрах
+ */
+int getRectificationTailsVolume();
+
+/**
+ * @brief Получение общего объема продукта
+ *
+ * @return Объем в миллилитрах
+ */
+int getRectificationTotalVolume();
+
+/**
+ * @brief Получение общего времени работы процесса
+ *
+ * @return Время работы в секундах
+ */
+unsigned long getRectificationUptime();
+
+/**
+ * @brief Получение времени работы текущей фазы
+ *
+ * @return Время работы фазы в секундах
+ */
+unsigned long getRectificationPhaseTime();
+
+/**
+ * @brief Получение времени, сэкономленного автоопределением стабилизации
+ *
+ * Разница между верхней границей времени стабилизации и фактической
+ * длительностью фаз стабилизации в текущем запуске.
+ *
+ * @return Сэкономленное время в секундах
+ */
+unsigned long getRectificationStabilizationSavedTime();
+
+/**
+ * @brief Проверка стабильности колонны по данным скользящего окна
+ *
+ * @return true если колонна стабильна
+ */
+bool isRectificationColumnStable();
+
+/**
+ * @brief Получение уверенности детектора окончания голов
+ *
+ * @return Уверенность от 0 до 1 (0 вне фазы отбора голов)
+ */
+float getRectificationHeadsEndConfidence();
+
+/**
+ * @brief Проверка, предложен ли детектором переход к отбору тела
+ *
+ * @return true если переход ожидает подтверждения оператора
+ */
+bool isRectificationHeadsEndProposed();
+
+/**
+ * @brief Подтверждение окончания отбора голов оператором
+ *
+ * @return true если процесс находился в фазе отбора голов и переход выполнен
+ */
+bool acceptRectificationHeadsEnd();
+
+/**
+ * @brief Получение объема голов на момент срабатывания детектора
+ *
+ * Используется для сравнения с фиксированным критерием окончания голов.
+ *
+ * @return Объем в миллилитрах или -1, если детектор не срабатывал
+ */
+int getRectificationHeadsEndDetectedVolume();
+
+/**
+ * @brief Получение текущей скорости отбора тела
+ *
+ * @return Скорость отбора с учетом снижений в режиме "старт-стоп"
+ */
+float getRectificationBodyFlowRate();
+
+/**
+ * @brief Проверка, остановлен ли отбор тела в режиме "старт-стоп"
+ *
+ * @return true если отбор остановлен до восстановления колонны
+ */
+bool isRectificationBodyStopped();
+
+/**
+ * @brief Получение зафиксированной температуры тела
+ *
+ * @return Температура узла отбора на момент начала отбора тела
+ */
+float getRectificationLockedBodyTemp();
+
+/**
+ * @brief Получение количества остановок отбора тела
+ *
+ * @return Количество остановок в текущем запуске
+ */
+int getRectificationStartStopCount();
+
+/**
+ * @brief Получение истории остановок отбора тела
+ *
+ * Записи возвращаются от старых к новым, хранятся последние
+ * START_STOP_HISTORY_SIZE остановок.
+ *
+ * @param history Массив для записи истории
+ * @param maxCount Размер массива
+ * @return int Количество записанных элементов
+ */
+int getRectificationStartStopHistory(StartStopRecord* history, int maxCount);
+
+/**
+ * @brief Получение текущей температуры куба
+ *
+ * @return Температура в градусах Цельсия
+ */
+float getRectificationCubeTemp();
+
+/**
+ * @brief Получение текущей температуры колонны
+ *
+ * @return Температура в градусах Цельсия
+ */
+float getRectificationColumnTemp();
+
+/**
+ * @brief Получение текущей температуры в узле отбора
+ *
+ * @return Температура в градусах Цельсия
+ */
+float getRectificationRefluxTemp();
+
+/**
+ * @brief Получение статуса орошения
+ *
+ * @return true если орошение включено
+ */
+bool getRectificationRefluxStatus();
+
+/**
+ * @brief Заполнение контрольной точки текущим состоянием ректификации
+ *
+ * @param cp Контрольная точка
+ */
+void fillRectificationCheckpoint(ProcessCheckpoint& cp);
+
+/**
+ * @brief Восстановление ректификации из контрольной точки
+ *
+ * Объемы отбора и общее время процесса восстанавливаются всегда,
+ * время фазы и состояние отбора тела - только при продолжении
+ * с сохраненной фазы.
+ *
+ * @param cp Контрольная точка прерванного процесса
+ * @param fromHeating true если куб остыл и процесс продолжается с нагрева
+ * @return true если процесс восстановлен
+ */
+bool restoreRectificationFromCheckpoint(const ProcessCheckpoint& cp, bool fromHeating);
+
+// Приватные функции (не включаются в заголовочный файл для внешнего использования)
+void processHeatingPhase();
+void processStabilizationPhase();
+void processHeadsPhase();
+void finishHeadsPhase();
+void processPostHeadsStabilizationPhase();
+void processBodyPhase();
+void processTailsPhase();
+void controlReflux();
+bool checkRectificationSafety();
+void setRectificationPhase(RectificationPhase phase);
+
+#endif // RECTIFICATION_H
@@ -11,6 +11,14 @@
 #include "config.h"
 #include "display.h"
 #include "utils.h"
+#include "checkpoint.h"
+#include "supervisor.h"
+#include "event_log.h"
+#include "ota.h"
+#include "fault_injection.h"
+#include "settings.h"
+#include "rectification.h"
+#include "distillation.h"
 #include <Arduino.h>
 
 #ifdef ESP32
@@ -24,7 +32,7 @@
 #define DEFAULT_MIN_WATER_OUT_TEMP 5.0f     // Минимальная температура выхода воды
 #define DEFAULT_MAX_WATER_OUT_TEMP 50.0f    // Максимальная температура выхода воды
 #define WATCHDOG_TIMEOUT_SECONDS 30         // Таймаут сторожевого таймера в секундах
-#define SAFETY_CHECK_INTERVAL 1000          // Интервал проверки безопасности (мс)
+#define TEMP_HISTORY_INTERVAL 6000          // Интервал записи истории температур (мс), 10 записей - минута
 
 // Параметры безопасности
 static float maxCubeTemp = DEFAULT_MAX_CUBE_TEMP;
@@ -35,6 +43,13 @@ static int maxRuntimeHours = DEFAULT_MAX_RUNTIME_HOURS;
 
 // Время последней проверки безопасности
 static unsigned long lastSafetyCheck = 0;
+static unsigned long lastHistoryUpdate = 0;
+
+// Задача безопасности и время последнего снимка датчиков
+static TaskHandle_t safetyTaskHandle = NULL;
+static volatile unsigned long snapshotMicros = 0;
+static volatile unsigned long snapshotMillis = 0;
+static unsigned long lastEvaluationTime = 0;
 
 // Время начала процесса
 static unsigned long processStartTime = 0;
@@ -43,7 +58,8 @@ static bool processRunning = false;
 // Состояние сторожевого таймера
 static bool watchdogEnabled = false;
 
-// Текущее состояние безопасности
+// Текущее состояние безопасности; меняется задачей безопасности,
+// копия для других задач снимается под statusLock
 static SafetyStatus currentStatus = {
     true,                      // isSystemSafe
     SAFETY_OK,                 // errorCode
@@ -58,12 +74,98 @@ static SafetyStatus currentStatus = {
     false                      // isWatchdogReset
 };
 
+static portMUX_TYPE statusLock = portMUX_INITIALIZER_UNLOCKED;
+
 // История предыдущих показаний температуры для определения скорости изменения
 #define TEMP_HISTORY_SIZE 10
 static float tempHistory[MAX_TEMP_SENSORS][TEMP_HISTORY_SIZE];
 static unsigned long tempHistoryTime[TEMP_HISTORY_SIZE];
 static int tempHistoryIndex = 0;
 
+void updateTemperatureHistory();
+float calculateTempRiseRate(int sensorIndex);
+static void startSafetyTask();
+
+// Правила безопасности по режимам.
+// Порядок полей: имя, канал, условие, источник порога, реакция, код ошибки,
+// удержание (мс), константа порога, гистерезис.
+static const SafetyRule idleRules[] = {
+    {"cube_max", SAFETY_CH_CUBE_TEMP, SAFETY_CMP_ABOVE, SAFETY_THR_MAX_CUBE_TEMP,
+     SAFETY_ACTION_EMERGENCY, SAFETY_ERROR_TEMPERATURE_HIGH, 2000, 0, 2.0f},
+    {"water_out_max", SAFETY_CH_WATER_OUT_TEMP, SAFETY_CMP_ABOVE, SAFETY_THR_MAX_WATER_OUT_TEMP,
+     SAFETY_ACTION_WARN, SAFETY_ERROR_WATER_FLOW_LOW, 5000, 0, 3.0f},
+};
+
+static const SafetyRule rectificationRules[] = {
+    {"cube_sensor", SAFETY_CH_CUBE_SENSOR, SAFETY_CMP_BELOW, SAFETY_THR_CONST,
+     SAFETY_ACTION_STOP, SAFETY_ERROR_SENSOR_DISCONNECT, 3000, 0.5f, 0},
+    {"reflux_sensor", SAFETY_CH_REFLUX_SENSOR, SAFETY_CMP_BELOW, SAFETY_THR_CONST,
+     SAFETY_ACTION_STOP, SAFETY_ERROR_SENSOR_DISCONNECT, 3000, 0.5f, 0},
+    {"cube_process_max", SAFETY_CH_CUBE_TEMP, SAFETY_CMP_ABOVE, SAFETY_THR_PROCESS_MAX_CUBE_TEMP,
+     SAFETY_ACTION_STOP, SAFETY_ERROR_TEMPERATURE_HIGH, 2000, 0, 1.0f},
+    {"cube_max", SAFETY_CH_CUBE_TEMP, SAFETY_CMP_ABOVE, SAFETY_THR_MAX_CUBE_TEMP,
+     SAFETY_ACTION_EMERGENCY, SAFETY_ERROR_TEMPERATURE_HIGH, 2000, 0, 2.0f},
+    {"water_out_max", SAFETY_CH_WATER_OUT_TEMP, SAFETY_CMP_ABOVE, SAFETY_THR_MAX_WATER_OUT_TEMP,
+     SAFETY_ACTION_EMERGENCY, SAFETY_ERROR_WATER_FLOW_LOW, 5000, 0, 3.0f},
+    {"cube_rise_rate", SAFETY_CH_CUBE_RISE_RATE, SAFETY_CMP_ABOVE, SAFETY_THR_MAX_TEMP_RISE_RATE,
+     SAFETY_ACTION_WARN, SAFETY_ERROR_TEMPERATURE_RISE, 10000, 0, 0.5f},
+    {"runtime", SAFETY_CH_RUNTIME, SAFETY_CMP_ABOVE, SAFETY_THR_MAX_RUNTIME,
+     SAFETY_ACTION_STOP, SAFETY_ERROR_MAX_RUNTIME_EXCEEDED, 0, 0, 0},
+    {"snapshot_age", SAFETY_CH_SNAPSHOT_AGE, SAFETY_CMP_ABOVE, SAFETY_THR_CONST,
+     SAFETY_ACTION_STOP, SAFETY_ERROR_SENSOR_DISCONNECT, 0, SAFETY_SNAPSHOT_TIMEOUT_MS / 1000.0f,
+     SAFETY_SNAPSHOT_HYSTERESIS_S},
+};
+
+static const SafetyRule distillationRules[] = {
+    {"cube_sensor", SAFETY_CH_CUBE_SENSOR, SAFETY_CMP_BELOW, SAFETY_THR_CONST,
+     SAFETY_ACTION_STOP, SAFETY_ERROR_SENSOR_DISCONNECT, 3000, 0.5f, 0},
+    {"cube_process_max", SAFETY_CH_CUBE_TEMP, SAFETY_CMP_ABOVE, SAFETY_THR_PROCESS_MAX_CUBE_TEMP,
+     SAFETY_ACTION_STOP, SAFETY_ERROR_TEMPERATURE_HIGH, 2000, 0, 1.0f},
+    {"cube_max", SAFETY_CH_CUBE_TEMP, SAFETY_CMP_ABOVE, SAFETY_THR_MAX_CUBE_TEMP,
+     SAFETY_ACTION_EMERGENCY, SAFETY_ERROR_TEMPERATURE_HIGH, 2000, 0, 2.0f},
+    {"water_out_max", SAFETY_CH_WATER_OUT_TEMP, SAFETY_CMP_ABOVE, SAFETY_THR_MAX_WATER_OUT_TEMP,
+     SAFETY_ACTION_EMERGENCY, SAFETY_ERROR_WATER_FLOW_LOW, 5000, 0, 3.0f},
+    {"cube_rise_rate", SAFETY_CH_CUBE_RISE_RATE, SAFETY_CMP_ABOVE, SAFETY_THR_MAX_TEMP_RISE_RATE,
+     SAFETY_ACTION_WARN, SAFETY_ERROR_TEMPERATURE_RISE, 10000, 0, 0.5f},
+    {"runtime", SAFETY_CH_RUNTIME, SAFETY_CMP_ABOVE, SAFETY_THR_MAX_RUNTIME,
+     SAFETY_ACTION_STOP, SAFETY_ERROR_MAX_RUNTIME_EXCEEDED, 0, 0, 0},
+    {"snapshot_age", SAFETY_CH_SNAPSHOT_AGE, SAFETY_CMP_ABOVE, SAFETY_THR_CONST,
+     SAFETY_ACTION_STOP, SAFETY_ERROR_SENSOR_DISCONNECT, 0, SAFETY_SNAPSHOT_TIMEOUT_MS / 1000.0f,
+     SAFETY_SNAPSHOT_HYSTERESIS_S},
+};
+
+#define RULE_COUNT(rules) (sizeof(rules) / sizeof(rules[0]))
+
+// Набор правил режима
+struct SafetyRuleSet {
+    const SafetyRule* rules;
+    uint8_t count;
+};
+
+static const SafetyRuleSet ruleSets[SAFETY_MODE_COUNT] = {
+    {idleRules, RULE_COUNT(idleRules)},
+    {rectificationRules, RULE_COUNT(rectificationRules)},
+    {distillationRules, RULE_COUNT(distillationRules)},
+};
+
+// Наибольший размер набора правил
+#define MAX_SAFETY_RULES RULE_COUNT(rectificationRules)
+
+// Состояние правил текущего режима (отдельно от неизменяемой таблицы)
+struct SafetyRuleState {
+    unsigned long conditionSince;       // Начало выполнения условия (0 - не выполняется)
+    bool tripped;                       // Правило сработало
+};
+
+static SafetyRuleState ruleStates[MAX_SAFETY_RULES];
+static SafetyMode ruleMode = SAFETY_MODE_IDLE;
+static SafetyAction ruleAction = SAFETY_ACTION_NONE;
+// Зафиксированная реакция: STOP снимает процесс подтверждением остановки,
+// EMERGENCY - только оператор
+static volatile SafetyAction latchedAction = SAFETY_ACTION_NONE;
+static const char* trippedRuleName = "";
+static SafetyRuleStats ruleStats;
+
 // Инициализация системы безопасности
 bool initSafety() {
     // Сброс истории температур
@@ -84,7 +186,7 @@ bool initSafety() {
     currentStatus.isSystemSafe = true;
     currentStatus.errorCode = SAFETY_OK;
     currentStatus.errorTime = 0;
-    currentStatus.errorDescription = "";
+    currentStatus.errorDescription[0] = '\0';
     currentStatus.isSensorError = false;
     currentStatus.isTemperatureError = false;
     currentStatus.isWaterFlowError = false;
@@ -101,9 +203,21 @@ bool initSafety() {
     }
     #endif
     
+    // Ищем процесс, прерванный сбоем питания или перезагрузкой
+    initCheckpoint();
+    
+    // Контроль задач (восстанавливает неисправность, записанную до перезагрузки)
+    initSupervisor();
+    
+    // Новая прошивка после обновления подтверждается задачей безопасности
+    initOtaHealthCheck();
+    
     // Запуск сторожевого таймера
     startSafetyWatchdog(WATCHDOG_TIMEOUT_SECONDS);
     
+    // Запуск задачи безопасности (после сторожевого таймера, на который она подписывается)
+    startSafetyTask();
+    
     Serial.println("Система безопасности инициализирована");
     return true;
 }
@@ -118,7 +232,11 @@ bool isSafetyOK() {
 
 // Получение статуса безопасности
 SafetyStatus getSafetyStatus() {
-    return currentStatus;
+    SafetyStatus status;
+    portENTER_CRITICAL(&statusLock);
+    status = currentStatus;
+    portEXIT_CRITICAL(&statusLock);
+    return status;
 }
 
 // Сброс ошибок безопасности
@@ -129,87 +247,390 @@ bool resetSafetyErrors() {
         return false;
     }
     
+    portENTER_CRITICAL(&statusLock);
     currentStatus.isSystemSafe = true;
     currentStatus.errorCode = SAFETY_OK;
-    currentStatus.errorDescription = "";
+    currentStatus.errorDescription[0] = '\0';
     currentStatus.isTemperatureError = false;
     currentStatus.isWaterFlowError = false;
     currentStatus.isPressureError = false;
     currentStatus.isRuntimeError = false;
+    portEXIT_CRITICAL(&statusLock);
     
     Serial.println("Ошибки безопасности сброшены");
     return true;
 }
 
-// Проверка безопасности для процесса дистилляции
-SafetyErrorCode checkDistillationSafety(float cubeTemp, float waterOutTemp) {
-    // Проверка подключения необходимых датчиков
-    if (!isSensorConnected(TEMP_CUBE)) {
-        return SAFETY_ERROR_SENSOR_DISCONNECT;
+// Шкала времени системы безопасности
+static unsigned long safetyMillis() {
+    #ifdef FAULT_INJECTION
+    return millis() + getFaultClockOffset();
+    #else
+    return millis();
+    #endif
+}
+
+// Определение режима по запущенному процессу
+SafetyMode getSafetyMode() {
+    if (isRectificationRunning()) {
+        return SAFETY_MODE_RECTIFICATION;
+    }
+    if (isDistillationRunning()) {
+        return SAFETY_MODE_DISTILLATION;
     }
+    return SAFETY_MODE_IDLE;
+}
+
+// Возраст снимка датчиков (мс). Время снимка читается один раз: задача
+// опроса на другом ядре может записать его уже после currentTime, тогда
+// разность отрицательна и считается нулевой
+static unsigned long snapshotAge(unsigned long currentTime) {
+    unsigned long snapshot = snapshotMillis;
+    long age = (long)(currentTime - snapshot);
+    return age > 0 ? (unsigned long)age : 0;
+}
+
+// Снятие значений всех каналов (NAN - нет данных, правило не оценивается)
+static void sampleSafetyChannels(SafetyMode mode, float* values, unsigned long currentTime) {
+    values[SAFETY_CH_CUBE_TEMP] = isSensorConnected(TEMP_CUBE) ? getTemperature(TEMP_CUBE) : NAN;
+    values[SAFETY_CH_WATER_OUT_TEMP] = isSensorConnected(TEMP_WATER_OUT) ? getTemperature(TEMP_WATER_OUT) : NAN;
+    values[SAFETY_CH_CUBE_RISE_RATE] = calculateTempRiseRate(TEMP_CUBE);
+    values[SAFETY_CH_CUBE_SENSOR] = isSensorConnected(TEMP_CUBE) ? 1.0f : 0.0f;
+    values[SAFETY_CH_REFLUX_SENSOR] = isSensorConnected(TEMP_REFLUX) ? 1.0f : 0.0f;
+    values[SAFETY_CH_SNAPSHOT_AGE] = snapshotMillis ? snapshotAge(currentTime) / 1000.0f : NAN;
+    
+    switch (mode) {
+        case SAFETY_MODE_RECTIFICATION:
+            values[SAFETY_CH_RUNTIME] = getRectificationUptime() / 3600.0f;
+            break;
+        case SAFETY_MODE_DISTILLATION:
+            values[SAFETY_CH_RUNTIME] = getDistillationUptime() / 3600.0f;
+            break;
+        default:
+            values[SAFETY_CH_RUNTIME] = NAN;
+            break;
+    }
+}
+
+// Расчет порогов для текущего режима
+static void resolveSafetyThresholds(SafetyMode mode, float* thresholds) {
+    thresholds[SAFETY_THR_CONST] = 0;
+    thresholds[SAFETY_THR_MAX_CUBE_TEMP] = maxCubeTemp;
+    thresholds[SAFETY_THR_MAX_WATER_OUT_TEMP] = maxWaterOutTemp;
+    thresholds[SAFETY_THR_MAX_TEMP_RISE_RATE] = maxTempRiseRate;
+    thresholds[SAFETY_THR_MAX_RUNTIME] = maxRuntimeHours;
+    
+    switch (mode) {
+        case SAFETY_MODE_RECTIFICATION:
+            thresholds[SAFETY_THR_PROCESS_MAX_CUBE_TEMP] = sysSettings.rectificationSettings.maxCubeTemp;
+            break;
+        case SAFETY_MODE_DISTILLATION:
+            thresholds[SAFETY_THR_PROCESS_MAX_CUBE_TEMP] = sysSettings.distillationSettings.maxCubeTemp;
+            break;
+        default:
+            thresholds[SAFETY_THR_PROCESS_MAX_CUBE_TEMP] = maxCubeTemp;
+            break;
+    }
+}
+
+// Фиксация реакции; более слабая реакция не заменяет зафиксированную
+static void latchSafetyAction(SafetyAction action) {
+    portENTER_CRITICAL(&statusLock);
+    if (action > latchedAction) {
+        latchedAction = action;
+    }
+    portEXIT_CRITICAL(&statusLock);
+}
+
+// Отметка ошибки в статусе безопасности
+static void applySafetyError(SafetyErrorCode errorCode, unsigned long currentTime) {
+    portENTER_CRITICAL(&statusLock);
+    currentStatus.isSystemSafe = false;
+    currentStatus.errorCode = errorCode;
+    currentStatus.errorTime = currentTime;
+    strlcpy(currentStatus.errorDescription, getSafetyErrorDescription(errorCode),
+            sizeof(currentStatus.errorDescription));
     
-    // Проверка температуры куба
-    if (cubeTemp > maxCubeTemp) {
-        return SAFETY_ERROR_TEMPERATURE_HIGH;
+    // Устанавливаем соответствующий флаг ошибки
+    switch (errorCode) {
+        case SAFETY_ERROR_SENSOR_DISCONNECT:
+            currentStatus.isSensorError = true;
+            break;
+        case SAFETY_ERROR_TEMPERATURE_HIGH:
+        case SAFETY_ERROR_TEMPERATURE_RISE:
+            currentStatus.isTemperatureError = true;
+            break;
+        case SAFETY_ERROR_WATER_FLOW_LOW:
+            currentStatus.isWaterFlowError = true;
+            break;
+        case SAFETY_ERROR_MAX_RUNTIME_EXCEEDED:
+            currentStatus.isRuntimeError = true;
+            break;
+        case SAFETY_ERROR_PRESSURE_HIGH:
+            currentStatus.isPressureError = true;
+            break;
+        default:
+            break;
+    }
+    portEXIT_CRITICAL(&statusLock);
+}
+
+// Отключение нагревателя и насоса без участия цикла процесса
+static void cutSafetyOutputs() {
+    setHeaterPower(0);
+    pumpStop();
+}
+
+// Оценка правил текущего режима за один проход
+// (fromSnapshot - проверка вызвана новым снимком датчиков, учитывается задержка реакции)
+static void evaluateSafetyRules(unsigned long currentTime, bool fromSnapshot) {
+    unsigned long startMicros = micros();
+    unsigned long sampleMicros = snapshotMicros;
+    
+    // При смене режима состояние правил начинается заново
+    SafetyMode mode = getSafetyMode();
+    if (mode != ruleMode) {
+        memset(ruleStates, 0, sizeof(ruleStates));
+        ruleMode = mode;
+        ruleAction = SAFETY_ACTION_NONE;
+        trippedRuleName = "";
     }
     
-    // Проверка температуры охлаждающей воды
-    if (isSensorConnected(TEMP_WATER_OUT)) {
-        if (waterOutTemp > maxWaterOutTemp) {
-            return SAFETY_ERROR_WATER_FLOW_LOW;
+    float values[SAFETY_CH_COUNT];
+    float thresholds[SAFETY_THR_COUNT];
+    // Шкала времени ушла назад: таймеры удержания и возраст снимка отсчитываются заново,
+    // иначе разность времен переполнится и правила сработают мгновенно
+    if (currentTime < lastEvaluationTime) {
+        for (uint8_t i = 0; i < MAX_SAFETY_RULES; i++) {
+            if (ruleStates[i].conditionSince != 0) {
+                ruleStates[i].conditionSince = currentTime ? currentTime : 1;
+            }
+        }
+        if (snapshotAge(currentTime) == 0) {
+            snapshotMillis = currentTime;
         }
+        Serial.println("Скачок шкалы времени безопасности назад, таймеры удержания перезапущены");
     }
+    lastEvaluationTime = currentTime;
+    
+    sampleSafetyChannels(mode, values, currentTime);
+    resolveSafetyThresholds(mode, thresholds);
     
-    // Проверка скорости изменения температуры
-    float tempRiseRate = calculateTempRiseRate(TEMP_CUBE);
-    if (tempRiseRate > maxTempRiseRate) {
-        return SAFETY_ERROR_TEMPERATURE_RISE;
+    const SafetyRuleSet& set = ruleSets[mode];
+    SafetyAction action = SAFETY_ACTION_NONE;
+    
+    for (uint8_t i = 0; i < set.count; i++) {
+        const SafetyRule& rule = set.rules[i];
+        SafetyRuleState& state = ruleStates[i];
+        
+        float value = values[rule.channel];
+        float threshold = rule.threshold == SAFETY_THR_CONST ? rule.constant : thresholds[rule.threshold];
+        
+        // Сработавшее правило возвращается в норму только с учетом гистерезиса
+        bool above = (rule.comparator == SAFETY_CMP_ABOVE);
+        if (state.tripped) {
+            threshold += above ? -rule.hysteresis : rule.hysteresis;
+        }
+        bool condition = above ? (value > threshold) : (value < threshold);
+        
+        if (!condition) {
+            state.conditionSince = 0;
+            state.tripped = false;
+            continue;
+        }
+        
+        // Условие должно удерживаться holdMs, чтобы единичный выброс не вызвал срабатывание
+        if (state.conditionSince == 0) {
+            state.conditionSince = currentTime ? currentTime : 1;
+        }
+        
+        if (!state.tripped && currentTime - state.conditionSince >= rule.holdMs) {
+            state.tripped = true;
+            trippedRuleName = rule.name;
+            
+            // Выходы отключаются сразу, процесс перейдет в ошибку в своем цикле.
+            // Реакция фиксируется: правило может вернуться в норму раньше,
+            // чем цикл процесса ее проверит
+            if (rule.action >= SAFETY_ACTION_STOP) {
+                cutSafetyOutputs();
+                latchSafetyAction((SafetyAction)rule.action);
+                
+                // Задержка от снимка, на котором истекло удержание, до отключения
+                // выходов; само удержание holdMs в нее не входит
+                if (fromSnapshot) {
+                    unsigned long latency = micros() - sampleMicros;
+                    ruleStats.lastCutLatencyMicros = latency;
+                    if (latency > ruleStats.maxCutLatencyMicros) {
+                        ruleStats.maxCutLatencyMicros = latency;
+                    }
+                }
+                ruleStats.trips++;
+            }
+            
+            // Запись журнала не блокирует задачу безопасности (event_log.h)
+            logRecord(EV_SAFETY_RULE_TRIPPED, rule.name, value, threshold);
+            
+            applySafetyError((SafetyErrorCode)rule.errorCode, currentTime);
+            
+            if (rule.action == SAFETY_ACTION_EMERGENCY) {
+                emergencyStop(getSafetyErrorDescription((SafetyErrorCode)rule.errorCode));
+            }
+        }
+        
+        if (state.tripped && rule.action > action) {
+            action = (SafetyAction)rule.action;
+        }
     }
     
-    // Проверка максимального времени работы
-    if (processRunning && (millis() - processStartTime) > (maxRuntimeHours * 3600000UL)) {
-        return SAFETY_ERROR_MAX_RUNTIME_EXCEEDED;
+    ruleAction = action;
+    
+    // Учет затрат на оценку правил
+    unsigned long elapsed = micros() - startMicros;
+    ruleStats.passes++;
+    ruleStats.rulesEvaluated += set.count;
+    ruleStats.lastMicros = elapsed;
+    ruleStats.totalMicros += elapsed;
+    if (elapsed > ruleStats.maxMicros) {
+        ruleStats.maxMicros = elapsed;
     }
     
-    return SAFETY_OK;
+    if (fromSnapshot) {
+        unsigned long latency = micros() - sampleMicros;
+        ruleStats.lastLatencyMicros = latency;
+        if (latency > ruleStats.maxLatencyMicros) {
+            ruleStats.maxLatencyMicros = latency;
+        }
+    }
 }
 
-// Проверка безопасности для процесса ректификации
-SafetyErrorCode checkRectificationSafety(float cubeTemp, float columnTemp, float refluxTemp, float waterOutTemp, float tsaTemp) {
-    // Проверка подключения необходимых датчиков
-    if (!isSensorConnected(TEMP_CUBE) || !isSensorConnected(TEMP_REFLUX)) {
-        return SAFETY_ERROR_SENSOR_DISCONNECT;
+// Запись истории температур с интервалом, достаточным для оценки скорости роста
+static void updateSafetyHistory(unsigned long currentTime) {
+    if (currentTime - lastHistoryUpdate >= TEMP_HISTORY_INTERVAL) {
+        lastHistoryUpdate = currentTime;
+        updateTemperatureHistory();
     }
-    
-    // Проверка температуры куба
-    if (cubeTemp > maxCubeTemp) {
-        return SAFETY_ERROR_TEMPERATURE_HIGH;
+}
+
+#ifdef ESP32
+// Задача безопасности: оценивает правила по каждому новому снимку датчиков
+static void safetyTask(void* parameter) {
+    // Собственная подписка на сторожевой таймер
+    esp_task_wdt_add(NULL);
+    
+    while (true) {
+        // Ждем снимок; при его отсутствии проверяем по таймауту,
+        // чтобы сработало правило возраста снимка
+        bool fromSnapshot = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SAFETY_TASK_MAX_WAIT_MS)) > 0;
+        
+        esp_task_wdt_reset();
+        
+        unsigned long currentTime = safetyMillis();
+        updateSafetyHistory(currentTime);
+        evaluateSafetyRules(currentTime, fromSnapshot);
+        
+        // Сигналы активности остальных задач; по ним же проверяется новая прошивка
+        updateOtaHealthCheck(checkHeartbeats());
+        
+        #ifdef FAULT_INJECTION
+        updateFaultInjection();
+        #endif
     }
-    
-    // Проверка температуры охлаждающей воды
-    if (isSensorConnected(TEMP_WATER_OUT)) {
-        if (waterOutTemp > maxWaterOutTemp) {
-            return SAFETY_ERROR_WATER_FLOW_LOW;
-        }
+}
+#endif
+
+// Запуск задачи безопасности
+static void startSafetyTask() {
+    #ifdef ESP32
+    BaseType_t result = xTaskCreatePinnedToCore(safetyTask, "safety", SAFETY_TASK_STACK_SIZE, NULL,
+                                                SAFETY_TASK_PRIORITY, &safetyTaskHandle, SAFETY_TASK_CORE);
+    if (result != pdPASS) {
+        safetyTaskHandle = NULL;
+        Serial.println("Ошибка запуска задачи безопасности, проверки выполняются в основном цикле");
+        return;
     }
+    Serial.println("Задача безопасности запущена");
+    #endif
+}
+
+// Уведомление о новом снимке показаний датчиков
+void notifySafetySnapshot() {
+    snapshotMicros = micros();
+    snapshotMillis = safetyMillis();
     
-    // Проверка скорости изменения температуры
-    float tempRiseRate = calculateTempRiseRate(TEMP_CUBE);
-    if (tempRiseRate > maxTempRiseRate) {
-        return SAFETY_ERROR_TEMPERATURE_RISE;
+    if (safetyTaskHandle != NULL) {
+        xTaskNotifyGive(safetyTaskHandle);
     }
-    
-    // Проверка максимального времени работы
-    if (processRunning && (millis() - processStartTime) > (maxRuntimeHours * 3600000UL)) {
-        return SAFETY_ERROR_MAX_RUNTIME_EXCEEDED;
+}
+
+// Проверка, работает ли отдельная задача безопасности
+bool isSafetyTaskRunning() {
+    return safetyTaskHandle != NULL;
+}
+
+// Получение наиболее серьезной реакции среди сработавших правил
+SafetyAction getSafetyRuleAction() {
+    SafetyAction latched = latchedAction;
+    return latched > ruleAction ? latched : ruleAction;
+}
+
+// Подтверждение остановки процесса по правилу безопасности
+void acknowledgeSafetyStop() {
+    portENTER_CRITICAL(&statusLock);
+    if (latchedAction == SAFETY_ACTION_STOP) {
+        latchedAction = SAFETY_ACTION_NONE;
     }
+    portEXIT_CRITICAL(&statusLock);
+}
+
+// Сброс аварийной остановки оператором
+bool resetSafetyLatch() {
+    if (ruleAction >= SAFETY_ACTION_STOP) {
+        return false;
+    }
+    
+    portENTER_CRITICAL(&statusLock);
+    latchedAction = SAFETY_ACTION_NONE;
+    currentStatus.isSystemSafe = true;
+    currentStatus.errorCode = SAFETY_OK;
+    currentStatus.errorDescription[0] = '\0';
+    currentStatus.isSensorError = false;
+    currentStatus.isTemperatureError = false;
+    currentStatus.isWaterFlowError = false;
+    currentStatus.isPressureError = false;
+    currentStatus.isRuntimeError = false;
+    currentStatus.isEmergencyStop = false;
+    portEXIT_CRITICAL(&statusLock);
     
-    return SAFETY_OK;
+    Serial.println("Аварийная остановка сброшена оператором");
+    return true;
+}
+
+// Получение кода последней ошибки безопасности
+SafetyErrorCode getSafetyErrorCode() {
+    return currentStatus.errorCode;
+}
+
+// Получение имени последнего сработавшего правила
+const char* getSafetyTrippedRuleName() {
+    return trippedRuleName;
+}
+
+// Получение статистики оценки правил
+const SafetyRuleStats& getSafetyRuleStats() {
+    return ruleStats;
 }
 
 // Обновление системы безопасности
 void updateSafety() {
-    unsigned long currentTime = millis();
+    unsigned long currentTime = safetyMillis();
+    
+    // Сброс сторожевого таймера
+    resetSafetyWatchdog();
+    
+    // Правила оцениваются задачей безопасности, если она запущена
+    if (safetyTaskHandle != NULL) {
+        return;
+    }
     
     // Проверяем безопасность только через определенные интервалы времени
     if (currentTime - lastSafetyCheck < SAFETY_CHECK_INTERVAL) {
@@ -218,74 +639,29 @@ void updateSafety() {
     
     lastSafetyCheck = currentTime;
     
-    // Сброс сторожевого таймера
-    resetSafetyWatchdog();
-    
     // Обновление истории температур
-    updateTemperatureHistory();
-    
-    // Проверка безопасности в зависимости от текущего процесса
-    if (processRunning) {
-        // Получаем все текущие температуры
-        float cubeTemp = getTemperature(TEMP_CUBE);
-        float columnTemp = getTemperature(TEMP_COLUMN);
-        float refluxTemp = getTemperature(TEMP_REFLUX);
-        float waterOutTemp = getTemperature(TEMP_WATER_OUT);
-        float tsaTemp = getTemperature(TEMP_TSA);
-        
-        SafetyErrorCode errorCode;
-        
-        // Проверяем безопасность для текущего процесса
-        // Здесь будет код, который определяет, какой процесс запущен и вызывает соответствующую проверку
-        // Для примера используем проверку для ректификации
-        errorCode = checkRectificationSafety(cubeTemp, columnTemp, refluxTemp, waterOutTemp, tsaTemp);
-        
-        // Если обнаружена ошибка безопасности
-        if (errorCode != SAFETY_OK) {
-            // Обновляем статус безопасности
-            currentStatus.isSystemSafe = false;
-            currentStatus.errorCode = errorCode;
-            currentStatus.errorTime = currentTime;
-            currentStatus.errorDescription = getSafetyErrorDescription(errorCode);
-            
-            // Устанавливаем соответствующий флаг ошибки
-            switch (errorCode) {
-                case SAFETY_ERROR_SENSOR_DISCONNECT:
-                    currentStatus.isSensorError = true;
-                    break;
-                case SAFETY_ERROR_TEMPERATURE_HIGH:
-                case SAFETY_ERROR_TEMPERATURE_RISE:
-                    currentStatus.isTemperatureError = true;
-                    break;
-                case SAFETY_ERROR_WATER_FLOW_LOW:
-                    currentStatus.isWaterFlowError = true;
-                    break;
-                case SAFETY_ERROR_MAX_RUNTIME_EXCEEDED:
-                    currentStatus.isRuntimeError = true;
-                    break;
-                case SAFETY_ERROR_PRESSURE_HIGH:
-                    currentStatus.isPressureError = true;
-                    break;
-                default:
-                    break;
-            }
-            
-            // Выполняем аварийную остановку при серьезных ошибках
-            if (errorCode == SAFETY_ERROR_TEMPERATURE_HIGH || 
-                errorCode == SAFETY_ERROR_PRESSURE_HIGH || 
-                errorCode == SAFETY_ERROR_WATER_FLOW_LOW) {
-                emergencyStop(currentStatus.errorDescription);
-            }
-        }
-    }
+    updateSafetyHistory(currentTime);
+    
+    // Оценка правил безопасности текущего режима
+    evaluateSafetyRules(currentTime, false);
+    
+    // Сигналы активности задач; по ним же проверяется новая прошивка
+    updateOtaHealthCheck(checkHeartbeats());
 }
 
 // Аварийная остановка
-void emergencyStop(const String &reason) {
-    // Установка флагов аварийной остановки
+void emergencyStop(const char* reason) {
+    // Установка флагов аварийной остановки; процессы остановятся в своем цикле
+    portENTER_CRITICAL(&statusLock);
     currentStatus.isSystemSafe = false;
     currentStatus.isEmergencyStop = true;
-    currentStatus.errorDescription = "АВАРИЙНАЯ ОСТАНОВКА: " + reason;
+    currentStatus.errorCode = SAFETY_ERROR_EMERGENCY_STOP;
+    snprintf(currentStatus.errorDescription, sizeof(currentStatus.errorDescription),
+             "АВАРИЙНАЯ ОСТАНОВКА: %s", reason);
+    if (latchedAction < SAFETY_ACTION_EMERGENCY) {
+        latchedAction = SAFETY_ACTION_EMERGENCY;
+    }
+    portEXIT_CRITICAL(&statusLock);
     
     // Остановка процесса
     processRunning = false;
@@ -299,15 +675,13 @@ void emergencyStop(const String &reason) {
     // Закрытие клапана
     valveClose();
     
-    // Вывод сообщения
-    Serial.println(currentStatus.errorDescription);
-    
-    // Обновление дисплея с сообщением об ошибке
-    displayShowError(currentStatus.errorDescription);
+    // Дисплей покажет ошибку в задаче интерфейса: шина I2C принадлежит ей
+    Serial.print("АВАРИЙНАЯ ОСТАНОВКА: ");
+    Serial.println(reason);
 }
 
 // Получение описания ошибки безопасности
-String getSafetyErrorDescription(SafetyErrorCode errorCode) {
+const char* getSafetyErrorDescription(SafetyErrorCode errorCode) {
     switch (errorCode) {
         case SAFETY_OK:
             return "Система в норме";
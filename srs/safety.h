@@ -12,6 +12,9 @@
 
 #include <Arduino.h>
 
+// Размер описания ошибки в статусе (байт)
+#define SAFETY_ERROR_TEXT_SIZE 128
+
 // Коды ошибок безопасности
 enum SafetyErrorCode {
     SAFETY_OK = 0,                      // Нет ошибок
@@ -31,7 +34,7 @@ struct SafetyStatus {
     bool isSystemSafe;                  // Общее состояние безопасности
     SafetyErrorCode errorCode;          // Код последней ошибки
     unsigned long errorTime;            // Время возникновения ошибки
-    String errorDescription;            // Описание ошибки
+    char errorDescription[SAFETY_ERROR_TEXT_SIZE]; // Описание ошибки
     bool isSensorError;                 // Флаг ошибки датчика
     bool isTemperatureError;            // Флаг ошибки температуры
     bool isWaterFlowError;              // Флаг ошибки потока воды
@@ -41,6 +44,78 @@ struct SafetyStatus {
     bool isWatchdogReset;               // Флаг сброса по сторожевому таймеру
 };
 
+// Режим работы, определяющий набор правил безопасности
+enum SafetyMode {
+    SAFETY_MODE_IDLE = 0,               // Процесс не запущен
+    SAFETY_MODE_RECTIFICATION,          // Ректификация
+    SAFETY_MODE_DISTILLATION,           // Дистилляция
+    SAFETY_MODE_COUNT
+};
+
+// Контролируемые каналы (значения снимаются один раз за проверку)
+enum SafetyChannel {
+    SAFETY_CH_CUBE_TEMP = 0,            // Температура куба (°C)
+    SAFETY_CH_WATER_OUT_TEMP,           // Температура выхода воды (°C)
+    SAFETY_CH_CUBE_RISE_RATE,           // Скорость роста температуры куба (°C/мин)
+    SAFETY_CH_RUNTIME,                  // Время работы процесса (часы)
+    SAFETY_CH_CUBE_SENSOR,              // Датчик куба подключен (1/0)
+    SAFETY_CH_REFLUX_SENSOR,            // Датчик узла отбора подключен (1/0)
+    SAFETY_CH_SNAPSHOT_AGE,             // Возраст последнего снимка датчиков (секунды)
+    SAFETY_CH_COUNT
+};
+
+// Источник порога правила
+enum SafetyThreshold {
+    SAFETY_THR_CONST = 0,               // Константа из правила
+    SAFETY_THR_MAX_CUBE_TEMP,           // Абсолютный предел температуры куба
+    SAFETY_THR_PROCESS_MAX_CUBE_TEMP,   // Предел куба из настроек текущего процесса
+    SAFETY_THR_MAX_WATER_OUT_TEMP,      // Предел температуры выхода воды
+    SAFETY_THR_MAX_TEMP_RISE_RATE,      // Предел скорости роста температуры
+    SAFETY_THR_MAX_RUNTIME,             // Предел времени работы
+    SAFETY_THR_COUNT
+};
+
+// Условие срабатывания
+enum SafetyComparator {
+    SAFETY_CMP_ABOVE = 0,               // Значение выше порога
+    SAFETY_CMP_BELOW                    // Значение ниже порога
+};
+
+// Реакция на срабатывание правила (по возрастанию серьезности)
+enum SafetyAction {
+    SAFETY_ACTION_NONE = 0,             // Правило не сработало
+    SAFETY_ACTION_WARN,                 // Только отметка в статусе
+    SAFETY_ACTION_STOP,                 // Остановка процесса с переходом в ошибку
+    SAFETY_ACTION_EMERGENCY             // Аварийная остановка
+};
+
+// Декларативное правило безопасности
+struct SafetyRule {
+    const char* name;                   // Имя правила для журнала
+    uint8_t channel;                    // Канал (SafetyChannel)
+    uint8_t comparator;                 // Условие (SafetyComparator)
+    uint8_t threshold;                  // Источник порога (SafetyThreshold)
+    uint8_t action;                     // Реакция (SafetyAction)
+    uint8_t errorCode;                  // Код ошибки (SafetyErrorCode)
+    uint16_t holdMs;                    // Время удержания условия до срабатывания
+    float constant;                     // Порог для SAFETY_THR_CONST
+    float hysteresis;                   // Гистерезис возврата в норму
+};
+
+// Статистика оценки правил
+struct SafetyRuleStats {
+    unsigned long passes;               // Количество проходов по правилам
+    unsigned long rulesEvaluated;       // Количество оцененных правил
+    unsigned long lastMicros;           // Длительность последнего прохода (мкс)
+    unsigned long maxMicros;            // Максимальная длительность прохода (мкс)
+    unsigned long totalMicros;          // Суммарная длительность проходов (мкс)
+    unsigned long lastLatencyMicros;    // От снимка датчиков до конца проверки (мкс)
+    unsigned long maxLatencyMicros;     // Максимальная задержка проверки снимка (мкс)
+    unsigned long lastCutLatencyMicros; // От снимка, на котором сработало правило, до отключения выходов (мкс)
+    unsigned long maxCutLatencyMicros;  // Максимальная задержка отключения выходов (мкс)
+    unsigned long trips;                // Количество срабатываний с отключением выходов
+};
+
 /**
  * @brief Инициализация системы безопасности
  * 
@@ -60,6 +135,9 @@ bool isSafetyOK();
 /**
  * @brief Получение статуса безопасности
  * 
+ * Статус копируется под блокировкой: задача безопасности меняет его
+ * на другом ядре.
+ * 
  * @return Структура с текущим состоянием безопасности
  */
 SafetyStatus getSafetyStatus();
@@ -74,42 +152,99 @@ SafetyStatus getSafetyStatus();
 bool resetSafetyErrors();
 
 /**
- * @brief Проверка безопасности для процесса дистилляции
+ * @brief Обновление системы безопасности
  * 
- * @param cubeTemp Текущая температура куба
- * @param waterOutTemp Текущая температура выхода воды
- * @return SafetyErrorCode: SAFETY_OK если все в порядке, иначе код ошибки
+ * Выполняет периодические проверки безопасности и обновляет состояние.
+ * Правила текущего режима оцениваются за один проход по таблице.
+ * Вызывается в основном цикле программы и из проверок процессов.
  */
-SafetyErrorCode checkDistillationSafety(float cubeTemp, float waterOutTemp);
+void updateSafety();
 
 /**
- * @brief Проверка безопасности для процесса ректификации
+ * @brief Уведомление о новом снимке показаний датчиков
  * 
- * @param cubeTemp Текущая температура куба
- * @param columnTemp Текущая температура колонны
- * @param refluxTemp Текущая температура в узле отбора
- * @param waterOutTemp Текущая температура выхода воды
- * @param tsaTemp Текущая температура ТСА (если используется)
- * @return SafetyErrorCode: SAFETY_OK если все в порядке, иначе код ошибки
+ * Вызывается после каждого опроса датчиков и будит задачу безопасности,
+ * которая сразу оценивает правила по новым показаниям.
  */
-SafetyErrorCode checkRectificationSafety(float cubeTemp, float columnTemp, float refluxTemp, float waterOutTemp, float tsaTemp);
+void notifySafetySnapshot();
 
 /**
- * @brief Обновление системы безопасности
+ * @brief Проверка, работает ли отдельная задача безопасности
  * 
- * Выполняет периодические проверки безопасности и обновляет состояние.
- * Вызывается в основном цикле программы.
+ * @return true если правила оцениваются в задаче безопасности
  */
-void updateSafety();
+bool isSafetyTaskRunning();
+
+/**
+ * @brief Получение текущего режима правил безопасности
+ * 
+ * @return SafetyMode Режим, определенный по запущенному процессу
+ */
+SafetyMode getSafetyMode();
+
+/**
+ * @brief Получение кода последней ошибки безопасности
+ * 
+ * В отличие от getSafetyStatus() не копирует описание ошибки.
+ * 
+ * @return SafetyErrorCode Код ошибки (SAFETY_OK если ошибок нет)
+ */
+SafetyErrorCode getSafetyErrorCode();
+
+/**
+ * @brief Получение наиболее серьезной реакции среди сработавших правил
+ * 
+ * Учитывает зафиксированную реакцию: STOP и EMERGENCY остаются в силе и
+ * после возврата правила в норму, пока процесс не подтвердит остановку
+ * (acknowledgeSafetyStop) или оператор не сбросит аварию (resetSafetyLatch).
+ * 
+ * @return SafetyAction Реакция (SAFETY_ACTION_NONE если все правила в норме)
+ */
+SafetyAction getSafetyRuleAction();
+
+/**
+ * @brief Подтверждение остановки процесса по правилу безопасности
+ * 
+ * Вызывается при остановке процесса и снимает зафиксированную реакцию
+ * STOP. Аварийная остановка (EMERGENCY) остается в силе.
+ */
+void acknowledgeSafetyStop();
+
+/**
+ * @brief Сброс аварийной остановки оператором
+ * 
+ * Снимает зафиксированную реакцию и флаги ошибок, если ни одно правило
+ * со STOP или EMERGENCY не выполняется сейчас.
+ * 
+ * @return true если авария сброшена
+ */
+bool resetSafetyLatch();
+
+/**
+ * @brief Получение имени последнего сработавшего правила
+ * 
+ * @return const char* Имя правила или пустая строка
+ */
+const char* getSafetyTrippedRuleName();
+
+/**
+ * @brief Получение статистики оценки правил
+ * 
+ * @return const SafetyRuleStats& Счетчики проходов и затраченного времени
+ */
+const SafetyRuleStats& getSafetyRuleStats();
 
 /**
  * @brief Аварийная остановка
  * 
- * Немедленно останавливает все процессы и выключает все нагревательные элементы.
+ * Выключает нагреватель, насос и клапан и фиксирует реакцию EMERGENCY:
+ * процессы останавливаются в своем цикле, а дисплей показывает ошибку в
+ * задаче интерфейса. Может вызываться из задачи безопасности: не обращается
+ * к дисплею и не выделяет память.
  * 
  * @param reason Причина аварийной остановки
  */
-void emergencyStop(const String &reason);
+void emergencyStop(const char* reason);
 
 /**
  * @brief Получение описания ошибки безопасности
@@ -117,7 +252,7 @@ void emergencyStop(const String &reason);
  * @param errorCode Код ошибки
  * @return Текстовое описание ошибки
  */
-String getSafetyErrorDescription(SafetyErrorCode errorCode);
+const char* getSafetyErrorDescription(SafetyErrorCode errorCode);
 
 /**
  * @brief Установка максимального времени непрерывной работы (в часах)
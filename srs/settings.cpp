@@ -5,21 +5,111 @@
 
 #include "settings.h"
 #include "config.h"
+#include "settings_schema.h"
 #include <EEPROM.h>
 #include <Arduino.h>
+#include <stddef.h>
+#include <rom/crc.h>
 
 // Адрес начала хранения настроек в EEPROM
 #define SETTINGS_EEPROM_ADDRESS 0
 
 // Текущая версия структуры настроек
-#define SETTINGS_VERSION 1
+#define SETTINGS_VERSION 7
 
 // Размер EEPROM для хранения настроек
 #define EEPROM_SIZE 2048
 
+// Сигнатура блока настроек ("DVST"); настройки, сохраненные до перехода
+// на блок, начинаются прямо со структуры, первое поле которой - версия
+#define SETTINGS_BLOB_MAGIC 0x54535644
+
+// Заголовок блока настроек
+struct SettingsBlobHeader {
+    uint32_t magic;            // Сигнатура SETTINGS_BLOB_MAGIC
+    uint16_t settingsVersion;  // Версия структуры настроек
+    uint16_t length;           // Размер данных (байт)
+    uint32_t crc;              // CRC32 данных
+};
+
+static_assert(sizeof(SettingsBlobHeader) + sizeof(SystemSettings) <= EEPROM_SIZE,
+              "Настройки не помещаются в EEPROM");
+
+// Поля, добавленные в версии формата: диапазон [offset, offset + size)
+// текущей структуры. При чтении старой версии эти поля получают значения
+// по умолчанию, остальные копируются из сохраненной структуры по порядку
+struct SettingsMigration {
+    uint32_t version;          // Версия, в которой добавлены поля
+    size_t offset;             // Смещение первого поля
+    size_t size;               // Размер полей вместе с выравниванием
+};
+
+// Диапазон полей от first до поля next (не включая)
+#define SETTINGS_FIELDS(first, next) \
+    offsetof(SystemSettings, first), \
+    offsetof(SystemSettings, next) - offsetof(SystemSettings, first)
+
+// Таблица миграций в порядке расположения полей в структуре
+static const SettingsMigration settingsMigrations[] = {
+    {5, SETTINGS_FIELDS(rectificationSettings.bodyStartStop, rectificationSettings.startStopHoldTime)},
+    {7, SETTINGS_FIELDS(rectificationSettings.startStopHoldTime, rectificationSettings.stabilizationTime)},
+    {3, SETTINGS_FIELDS(rectificationSettings.autoStabilization, rectificationSettings.headsTargetTime)},
+    {2, SETTINGS_FIELDS(rectificationSettings.headsTargetTime, rectificationSettings.headsEndMode)},
+    {4, SETTINGS_FIELDS(rectificationSettings.headsEndMode, rectificationSettings.headsVolume)},
+    {2, SETTINGS_FIELDS(rectificationSettings.bodyFlowRate, rectificationSettings.useSameFlowForTails)},
+    {6, SETTINGS_FIELDS(mqttSettings, wifiSsid)},
+};
+
+#define SETTINGS_MIGRATION_COUNT (sizeof(settingsMigrations) / sizeof(settingsMigrations[0]))
+
 // Глобальный экземпляр настроек
 SystemSettings sysSettings;
 
+// Копия настроек, записанных в EEPROM (запись без изменений пропускается)
+static SystemSettings savedSettings;
+static bool savedSettingsValid = false;
+
+// Буфер сохраненной структуры при загрузке
+static uint8_t settingsImage[sizeof(SystemSettings)];
+
+// Счетчики записи настроек
+static SettingsStats settingsStats;
+
+// Заполнение структуры значениями по умолчанию
+static void setDefaultSettings(SystemSettings& settings);
+
+// Размер структуры настроек указанной версии
+static size_t getSettingsImageSize(uint32_t version) {
+    size_t size = sizeof(SystemSettings);
+    for (size_t i = 0; i < SETTINGS_MIGRATION_COUNT; i++) {
+        if (settingsMigrations[i].version > version) {
+            size -= settingsMigrations[i].size;
+        }
+    }
+    return size;
+}
+
+// Перенос структуры старой версии: поля, добавленные позже version,
+// получают значения по умолчанию
+static void migrateSettings(const uint8_t* image, uint32_t version, SystemSettings& settings) {
+    setDefaultSettings(settings);
+    
+    uint8_t* target = (uint8_t*)&settings;
+    size_t from = 0;
+    for (size_t i = 0; i < SETTINGS_MIGRATION_COUNT; i++) {
+        const SettingsMigration& migration = settingsMigrations[i];
+        if (migration.version <= version) {
+            continue;
+        }
+        memcpy(target + from, image, migration.offset - from);
+        image += migration.offset - from;
+        from = migration.offset + migration.size;
+    }
+    memcpy(target + from, image, sizeof(SystemSettings) - from);
+    
+    settings.settingsVersion = SETTINGS_VERSION;
+}
+
 // Инициализация системы настроек
 bool initSettings() {
     Serial.println("Инициализация системы настроек...");
@@ -43,302 +133,134 @@ bool initSettings() {
 
 // Загрузка настроек из энергонезависимой памяти
 bool loadSystemSettings() {
-    // Считываем структуру настроек из EEPROM
-    EEPROM.get(SETTINGS_EEPROM_ADDRESS, sysSettings);
+    unsigned long startTime = micros();
     
-    // Проверяем версию настроек
-    if (sysSettings.settingsVersion != SETTINGS_VERSION) {
-        Serial.println("Версия настроек не соответствует текущей версии!");
-        return false;
-    }
-    
-    Serial.println("Настройки успешно загружены");
-    printSystemSettings();
-    return true;
-}
-
-// Сохранение настроек в энергонезависимую память
-bool saveSystemSettings() {
-    // Устанавливаем текущую версию настроек
-    sysSettings.settingsVersion = SETTINGS_VERSION;
+    SettingsBlobHeader header;
+    EEPROM.get(SETTINGS_EEPROM_ADDRESS, header);
     
-    // Сохраняем структуру настроек в EEPROM
-    EEPROM.put(SETTINGS_EEPROM_ADDRESS, sysSettings);
+    bool blob = header.magic == SETTINGS_BLOB_MAGIC;
+    uint32_t version = blob ? header.settingsVersion : header.magic;
     
-    // Фиксируем изменения
-    if (!EEPROM.commit()) {
-        Serial.println("Ошибка сохранения настроек в EEPROM!");
+    // Проверяем версию настроек
+    if (version < 1 || version > SETTINGS_VERSION) {
+        Serial.println("Версия настроек не поддерживается!");
         return false;
     }
     
-    Serial.println("Настройки успешно сохранены");
-    return true;
-}
-
-// Сброс настроек к значениям по умолчанию
-void resetSystemSettings() {
-    Serial.println("Сброс настроек к значениям по умолчанию...");
-    
-    // Обнуляем всю структуру
-    memset(&sysSettings, 0, sizeof(SystemSettings));
-    
-    // Устанавливаем версию настроек
-    sysSettings.settingsVersion = SETTINGS_VERSION;
-    
-    // Сброс настроек датчиков температуры
-    for (int i = 0; i < MAX_TEMP_SENSORS; i++) {
-        sysSettings.tempSensorEnabled[i] = false;
-        sysSettings.tempSensorCalibration[i] = 0.0f;
-        memset(sysSettings.tempSensorAddresses[i], 0, 8);
+    size_t length = getSettingsImageSize(version);
+    if (blob && header.length != length) {
+        Serial.println("Размер блока настроек не соответствует версии!");
+        return false;
     }
     
-    // Настройки нагревателя по умолчанию
-    sysSettings.heaterSettings.maxPowerWatts = 2000;
-    sysSettings.heaterSettings.volts = 220;
-    
-    // Настройки насоса по умолчанию
-    sysSettings.pumpSettings.headsFlowRate = 50.0f;
-    sysSettings.pumpSettings.bodyFlowRate = 250.0f;
-    sysSettings.pumpSettings.tailsFlowRate = 350.0f;
-    sysSettings.pumpSettings.calibrationFactor = 1.0f;
-    
-    // Настройки ректификации по умолчанию
-    sysSettings.rectificationSettings.model = 0;
-    sysSettings.rectificationSettings.heatingPowerWatts = 1800;
-    sysSettings.rectificationSettings.stabilizationPowerWatts = 1200;
-    sysSettings.rectificationSettings.bodyPowerWatts = 1000;
-    sysSettings.rectificationSettings.tailsPowerWatts = 1200;
-    sysSettings.rectificationSettings.headsTemp = 78.0f;
-    sysSettings.rectificationSettings.bodyTemp = 78.3f;
-    sysSettings.rectificationSettings.tailsTemp = 92.0f;
-    sysSettings.rectificationSettings.endTemp = 97.0f;
-    sysSettings.rectificationSettings.maxCubeTemp = 101.0f;
-    sysSettings.rectificationSettings.tailsCubeTemp = 95.0f;
-    sysSettings.rectificationSettings.tempDeltaEndBody = 0.5f;
-    sysSettings.rectificationSettings.stabilizationTime = 30;
-    sysSettings.rectificationSettings.postHeadsStabilizationTime = 10;
-    sysSettings.rectificationSettings.headsVolume = 150;
-    sysSettings.rectificationSettings.bodyVolume = 2000;
-    sysSettings.rectificationSettings.refluxRatio = 3.0f;
-    sysSettings.rectificationSettings.refluxPeriod = 60;
-    sysSettings.rectificationSettings.useSameFlowForTails = true;
-    
-    // Настройки дистилляции по умолчанию
-    sysSettings.distillationSettings.heatingPowerWatts = 2000;
-    sysSettings.distillationSettings.distillationPowerWatts = 1500;
-    sysSettings.distillationSettings.startCollectingTemp = 70.0f;
-    sysSettings.distillationSettings.endTemp = 97.0f;
-    sysSettings.distillationSettings.maxCubeTemp = 101.0f;
-    sysSettings.distillationSettings.separateHeads = true;
-    sysSettings.distillationSettings.headsVolume = 200;
-    sysSettings.distillationSettings.flowRate = 800.0f;
-    sysSettings.distillationSettings.headsFlowRate = 200.0f;
-    
-    // Настройки безопасности
-    sysSettings.safetySettings.maxRuntimeHours = SAFETY_MAX_RUNTIME_HOURS_DEFAULT;
-    sysSettings.safetySettings.maxCubeTemp = SAFETY_MAX_CUBE_TEMP_DEFAULT;
-    sysSettings.safetySettings.maxTempRiseRate = SAFETY_MAX_TEMP_RISE_RATE_DEFAULT;
-    sysSettings.safetySettings.minWaterOutTemp = SAFETY_MIN_WATER_OUT_TEMP_DEFAULT;
-    sysSettings.safetySettings.maxWaterOutTemp = SAFETY_MAX_WATER_OUT_TEMP_DEFAULT;
-    sysSettings.safetySettings.emergencyStopEnabled = true;
-    sysSettings.safetySettings.watchdogEnabled = true;
-    
-    // Настройки WiFi
-    strncpy(sysSettings.wifiSsid, WIFI_AP_SSID, sizeof(sysSettings.wifiSsid) - 1);
-    strncpy(sysSettings.wifiPassword, WIFI_AP_PASSWORD, sizeof(sysSettings.wifiPassword) - 1);
-    sysSettings.useAccessPoint = true;
-    
-    Serial.println("Настройки сброшены к значениям по умолчанию");
-}
-
-// Вывод текущих настроек в последовательный порт
-void printSystemSettings() {
-    Serial.println("Текущие настройки системы:");
-    Serial.println("----------------------------");
-    
-    Serial.println("Настройки нагревателя:");
-    Serial.print("  Максимальная мощность: ");
-    Serial.print(sysSettings.heaterSettings.maxPowerWatts);
-    Serial.println(" Вт");
-    
-    Serial.println("Настройки насоса:");
-    Serial.print("  Скорость отбора голов: ");
-    Serial.print(sysSettings.pumpSettings.headsFlowRate);
-    Serial.println(" мл/мин");
-    Serial.print("  Скорость отбора тела: ");
-    Serial.print(sysSettings.pumpSettings.bodyFlowRate);
-    Serial.println(" мл/мин");
-    
-    Serial.println("Настройки ректификации:");
-    Serial.print("  Модель: ");
-    Serial.println(sysSettings.rectificationSettings.model);
-    Serial.print("  Температура голов: ");
-    Serial.print(sysSettings.rectificationSettings.headsTemp);
-    Serial.println(" °C");
-    
-    Serial.println("Настройки дистилляции:");
-    Serial.print("  Температура начала отбора: ");
-    Serial.print(sysSettings.distillationSettings.startCollectingTemp);
-    Serial.println(" °C");
-    
-    Serial.println("Настройки безопасности:");
-    Serial.print("  Макс. время работы: ");
-    Serial.print(sysSettings.safetySettings.maxRuntimeHours);
-    Serial.println(" ч");
-    Serial.print("  Макс. температура куба: ");
-    Serial.print(sysSettings.safetySettings.maxCubeTemp);
-    Serial.println(" °C");
-    
-    Serial.println("----------------------------");
-}/**
- * @file settings.cpp
- * @brief Реализация управления настройками системы
- */
-
-#include "settings.h"
-#include "config.h"
-#include <EEPROM.h>
-#include <Arduino.h>
-
-// Адрес начала хранения настроек в EEPROM
-#define SETTINGS_EEPROM_ADDRESS 0
-
-// Текущая версия структуры настроек
-#define SETTINGS_VERSION 1
-
-// Размер EEPROM для хранения настроек
-#define EEPROM_SIZE 2048
-
-// Глобальный экземпляр настроек
-SystemSettings sysSettings;
-
-// Инициализация системы настроек
-bool initSettings() {
-    Serial.println("Инициализация системы настроек...");
-    
-    // Инициализация EEPROM
-    if (!EEPROM.begin(EEPROM_SIZE)) {
-        Serial.println("Ошибка инициализации EEPROM!");
+    EEPROM.readBytes(SETTINGS_EEPROM_ADDRESS + (blob ? sizeof(header) : 0), settingsImage, length);
+    if (blob && crc32_le(0, settingsImage, length) != header.crc) {
+        Serial.println("Ошибка контрольной суммы настроек!");
         return false;
     }
     
-    // Загружаем сохраненные настройки
-    if (!loadSystemSettings()) {
-        Serial.println("Настройки не загружены, устанавливаем значения по умолчанию.");
-        resetSystemSettings();
-        saveSystemSettings();
+    if (blob && version == SETTINGS_VERSION) {
+        memcpy(&sysSettings, settingsImage, sizeof(SystemSettings));
+        savedSettings = sysSettings;
+        savedSettingsValid = true;
+    } else {
+        migrateSettings(settingsImage, version, sysSettings);
+        savedSettingsValid = false;
     }
     
-    Serial.println("Система настроек инициализирована");
-    return true;
-}
-
-// Загрузка настроек из энергонезависимой памяти
-bool loadSystemSettings() {
-    // Считываем структуру настроек из EEPROM
-    EEPROM.get(SETTINGS_EEPROM_ADDRESS, sysSettings);
+    Serial.print("Настройки успешно загружены (");
+    Serial.print(micros() - startTime);
+    Serial.println(" мкс)");
     
-    // Проверяем версию настроек
-    if (sysSettings.settingsVersion != SETTINGS_VERSION) {
-        Serial.println("Версия настроек не соответствует текущей версии!");
-        return false;
+    // Настройки старой версии сразу переписываем в текущем формате
+    if (!savedSettingsValid) {
+        Serial.print("Настройки перенесены из версии ");
+        Serial.println(version);
+        saveSystemSettings();
     }
     
-    Serial.println("Настройки успешно загружены");
     printSystemSettings();
     return true;
 }
 
 // Сохранение настроек в энергонезависимую память
 bool saveSystemSettings() {
+    unsigned long startTime = micros();
+    
     // Устанавливаем текущую версию настроек
     sysSettings.settingsVersion = SETTINGS_VERSION;
     
-    // Сохраняем структуру настроек в EEPROM
-    EEPROM.put(SETTINGS_EEPROM_ADDRESS, sysSettings);
+    // Настройки без изменений не перезаписываем
+    if (savedSettingsValid && memcmp(&savedSettings, &sysSettings, sizeof(SystemSettings)) == 0) {
+        settingsStats.skipped++;
+        Serial.println("Настройки не изменились, запись пропущена");
+        return true;
+    }
+    
+    // Сохраняем заголовок и структуру настроек в EEPROM
+    SettingsBlobHeader header;
+    header.magic = SETTINGS_BLOB_MAGIC;
+    header.settingsVersion = SETTINGS_VERSION;
+    header.length = sizeof(SystemSettings);
+    header.crc = crc32_le(0, (const uint8_t*)&sysSettings, sizeof(SystemSettings));
+    EEPROM.put(SETTINGS_EEPROM_ADDRESS, header);
+    EEPROM.put(SETTINGS_EEPROM_ADDRESS + sizeof(header), sysSettings);
     
     // Фиксируем изменения
     if (!EEPROM.commit()) {
+        settingsStats.errors++;
+        savedSettingsValid = false;
         Serial.println("Ошибка сохранения настроек в EEPROM!");
         return false;
     }
+    settingsStats.writes++;
+    
+    savedSettings = sysSettings;
+    savedSettingsValid = true;
     
-    Serial.println("Настройки успешно сохранены");
+    Serial.print("Настройки успешно сохранены (");
+    Serial.print(micros() - startTime);
+    Serial.println(" мкс)");
     return true;
 }
 
-// Сброс настроек к значениям по умолчанию
-void resetSystemSettings() {
-    Serial.println("Сброс настроек к значениям по умолчанию...");
-    
+// Получение счетчиков записи настроек
+const SettingsStats& getSettingsStats() {
+    return settingsStats;
+}
+
+// Заполнение структуры значениями по умолчанию
+static void setDefaultSettings(SystemSettings& settings) {
     // Обнуляем всю структуру
-    memset(&sysSettings, 0, sizeof(SystemSettings));
+    memset(&settings, 0, sizeof(SystemSettings));
     
     // Устанавливаем версию настроек
-    sysSettings.settingsVersion = SETTINGS_VERSION;
+    settings.settingsVersion = SETTINGS_VERSION;
     
     // Сброс настроек датчиков температуры
     for (int i = 0; i < MAX_TEMP_SENSORS; i++) {
-        sysSettings.tempSensorEnabled[i] = false;
-        sysSettings.tempSensorCalibration[i] = 0.0f;
-        memset(sysSettings.tempSensorAddresses[i], 0, 8);
+        settings.tempSensorEnabled[i] = false;
+        settings.tempSensorCalibration[i] = 0.0f;
+        memset(settings.tempSensorAddresses[i], 0, 8);
     }
     
-    // Настройки нагревателя по умолчанию
-    sysSettings.heaterSettings.maxPowerWatts = 2000;
-    sysSettings.heaterSettings.volts = 220;
-    
-    // Настройки насоса по умолчанию
-    sysSettings.pumpSettings.headsFlowRate = 50.0f;
-    sysSettings.pumpSettings.bodyFlowRate = 250.0f;
-    sysSettings.pumpSettings.tailsFlowRate = 350.0f;
-    sysSettings.pumpSettings.calibrationFactor = 1.0f;
-    
-    // Настройки ректификации по умолчанию
-    sysSettings.rectificationSettings.model = 0;
-    sysSettings.rectificationSettings.heatingPowerWatts = 1800;
-    sysSettings.rectificationSettings.stabilizationPowerWatts = 1200;
-    sysSettings.rectificationSettings.bodyPowerWatts = 1000;
-    sysSettings.rectificationSettings.tailsPowerWatts = 1200;
-    sysSettings.rectificationSettings.headsTemp = 78.0f;
-    sysSettings.rectificationSettings.bodyTemp = 78.3f;
-    sysSettings.rectificationSettings.tailsTemp = 92.0f;
-    sysSettings.rectificationSettings.endTemp = 97.0f;
-    sysSettings.rectificationSettings.maxCubeTemp = 101.0f;
-    sysSettings.rectificationSettings.tailsCubeTemp = 95.0f;
-    sysSettings.rectificationSettings.tempDeltaEndBody = 0.5f;
-    sysSettings.rectificationSettings.stabilizationTime = 30;
-    sysSettings.rectificationSettings.postHeadsStabilizationTime = 10;
-    sysSettings.rectificationSettings.headsVolume = 150;
-    sysSettings.rectificationSettings.bodyVolume = 2000;
-    sysSettings.rectificationSettings.refluxRatio = 3.0f;
-    sysSettings.rectificationSettings.refluxPeriod = 60;
-    sysSettings.rectificationSettings.useSameFlowForTails = true;
-    
-    // Настройки дистилляции по умолчанию
-    sysSettings.distillationSettings.heatingPowerWatts = 2000;
-    sysSettings.distillationSettings.distillationPowerWatts = 1500;
-    sysSettings.distillationSettings.startCollectingTemp = 70.0f;
-    sysSettings.distillationSettings.endTemp = 97.0f;
-    sysSettings.distillationSettings.maxCubeTemp = 101.0f;
-    sysSettings.distillationSettings.separateHeads = true;
-    sysSettings.distillationSettings.headsVolume = 200;
-    sysSettings.distillationSettings.flowRate = 800.0f;
-    sysSettings.distillationSettings.headsFlowRate = 200.0f;
-    
-    // Настройки безопасности
-    sysSettings.safetySettings.maxRuntimeHours = SAFETY_MAX_RUNTIME_HOURS_DEFAULT;
-    sysSettings.safetySettings.maxCubeTemp = SAFETY_MAX_CUBE_TEMP_DEFAULT;
-    sysSettings.safetySettings.maxTempRiseRate = SAFETY_MAX_TEMP_RISE_RATE_DEFAULT;
-    sysSettings.safetySettings.minWaterOutTemp = SAFETY_MIN_WATER_OUT_TEMP_DEFAULT;
-    sysSettings.safetySettings.maxWaterOutTemp = SAFETY_MAX_WATER_OUT_TEMP_DEFAULT;
-    sysSettings.safetySettings.emergencyStopEnabled = true;
-    sysSettings.safetySettings.watchdogEnabled = true;
+    // Значения по умолчанию разделов из описания полей (settings_schema.h)
+    for (int i = 0; i < SETTINGS_SECTION_COUNT; i++) {
+        const SettingsSection& section = getSettingsSection((SettingsSectionId)i);
+        applySettingsDefaults(section, getSettingsSectionData(settings, section));
+    }
     
     // Настройки WiFi
-    strncpy(sysSettings.wifiSsid, WIFI_AP_SSID, sizeof(sysSettings.wifiSsid) - 1);
-    strncpy(sysSettings.wifiPassword, WIFI_AP_PASSWORD, sizeof(sysSettings.wifiPassword) - 1);
-    sysSettings.useAccessPoint = true;
+    strncpy(settings.wifiSsid, WIFI_AP_SSID, sizeof(settings.wifiSsid) - 1);
+    strncpy(settings.wifiPassword, WIFI_AP_PASSWORD, sizeof(settings.wifiPassword) - 1);
+    settings.useAccessPoint = true;
+}
+
+// Сброс настроек к значениям по умолчанию
+void resetSystemSettings() {
+    Serial.println("Сброс настроек к значениям по умолчанию...");
+    
+    setDefaultSettings(sysSettings);
     
     Serial.println("Настройки сброшены к значениям по умолчанию");
 }
@@ -381,5 +303,15 @@ void printSystemSettings() {
     Serial.print(sysSettings.safetySettings.maxCubeTemp);
     Serial.println(" °C");
     
+    Serial.println("Настройки MQTT:");
+    Serial.print("  Брокер: ");
+    if (sysSettings.mqttSettings.enabled) {
+        Serial.print(sysSettings.mqttSettings.host);
+        Serial.print(":");
+        Serial.println(sysSettings.mqttSettings.port);
+    } else {
+        Serial.println("выключен");
+    }
+    
     Serial.println("----------------------------");
-}
\ No newline at end of file
+}
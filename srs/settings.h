@@ -3,6 +3,12 @@
  * @brief Управление настройками системы
  * 
  * Этот модуль отвечает за хранение, загрузку и сохранение настроек системы.
+ *
+ * Настройки хранятся в EEPROM одним блоком: заголовок с версией структуры,
+ * размером и CRC32, за ним структура SystemSettings. Настройки без
+ * изменений не перезаписываются. Настройки предыдущих версий переносятся
+ * при загрузке: сохраненные поля сохраняются, поля, добавленные позже,
+ * получают значения по умолчанию.
  */
 
 #ifndef SETTINGS_H
@@ -41,12 +47,30 @@ struct RectificationSettings {
     float maxCubeTemp;              // Максимальная температура куба
     float tailsCubeTemp;            // Температура куба для перехода к хвостам
     float tempDeltaEndBody;         // Дельта температуры для окончания отбора тела (для альт. модели)
-    int stabilizationTime;          // Время стабилизации колонны (минуты)
-    int postHeadsStabilizationTime; // Время стабилизации после отбора голов (минуты)
+    bool bodyStartStop;             // Отбор тела в режиме "старт-стоп"
+    float startStopDelta;           // Превышение температуры узла отбора над зафиксированной для остановки отбора (°C)
+    float startStopBackoff;         // Снижение скорости отбора при каждой остановке (%)
+    float startStopMinRate;         // Минимальная скорость отбора (% от начальной)
+    int startStopHoldTime;          // Время удержания превышения до остановки отбора (секунды)
+    int stabilizationTime;          // Время стабилизации колонны (минуты, верхняя граница при автоопределении)
+    int postHeadsStabilizationTime; // Время стабилизации после отбора голов (минуты, верхняя граница)
+    bool autoStabilization;         // Определять стабилизацию колонны по статистике температур
+    int stabilizationMinTime;       // Минимальное время стабилизации колонны (минуты)
+    int postHeadsStabilizationMinTime; // Минимальное время стабилизации после голов (минуты)
+    int stabilizationWindow;        // Окно анализа стабильности (секунды)
+    float stabilizationMaxStdDev;   // Допустимое СКО температур в окне (°C)
+    float stabilizationMaxSlope;    // Допустимая скорость изменения температур в окне (°C/мин)
+    int headsTargetTime;            // Целевое время отбора голов для альт. модели (минуты)
+    int headsEndMode;               // Автоопределение конца голов (0 - выкл, 1 - предлагать, 2 - автоматически)
+    float headsEndConfidence;       // Порог уверенности для окончания голов (0..1)
+    float headsEndMaxSlope;         // Порог наклона температуры узла отбора для плато (°C/мин)
+    float headsEndMaxDelta;         // Порог разности температур колонны и узла отбора (°C)
     int headsVolume;                // Объем голов (мл)
     int bodyVolume;                 // Объем тела (мл)
     float refluxRatio;              // Соотношение орошения (R/D)
     int refluxPeriod;               // Период цикла орошения (секунды)
+    float bodyFlowRate;             // Скорость отбора тела (мл/час)
+    float tailsFlowRate;            // Скорость отбора хвостов (мл/час)
     bool useSameFlowForTails;       // Использовать ту же скорость отбора для хвостов
 };
 
@@ -74,6 +98,18 @@ struct SafetySettings {
     bool watchdogEnabled;         // Включен ли сторожевой таймер
 };
 
+// Настройки моста MQTT
+struct MqttSettings {
+    bool enabled;                 // Подключаться к брокеру
+    char host[64];                // Имя или адрес брокера
+    int port;                     // Порт брокера
+    char user[32];                // Имя пользователя (пусто - без авторизации)
+    char password[64];            // Пароль
+    char prefix[48];              // Префикс топиков (пусто - drivevision/<MAC>)
+    int qos;                      // QoS публикаций телеметрии и статуса (0..2)
+    int publishInterval;          // Период публикации статуса и телеметрии (секунды)
+};
+
 // Основная структура настроек системы
 struct SystemSettings {
     // Версия настроек для совместимости при обновлениях
@@ -99,12 +135,22 @@ struct SystemSettings {
     // Настройки безопасности
     SafetySettings safetySettings;
     
+    // Настройки MQTT
+    MqttSettings mqttSettings;
+    
     // Настройки сети
     char wifiSsid[32];      // SSID WiFi сети
     char wifiPassword[64];  // Пароль WiFi сети
     bool useAccessPoint;    // Использовать режим точки доступа
 };
 
+// Счетчики записи настроек
+struct SettingsStats {
+    unsigned long writes;   // Записей в EEPROM
+    unsigned long skipped;  // Пропущено записей без изменений
+    unsigned long errors;   // Ошибок записи
+};
+
 // Глобальный экземпляр настроек
 extern SystemSettings sysSettings;
 
@@ -134,6 +180,11 @@ bool saveSystemSettings();
  */
 void resetSystemSettings();
 
+/**
+ * @brief Получение счетчиков записи настроек
+ */
+const SettingsStats& getSettingsStats();
+
 /**
  * @brief Вывод текущих настроек в последовательный порт
  */
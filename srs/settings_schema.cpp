@@ -0,0 +1,194 @@
+/**
+ * @file settings_schema.cpp
+ * @brief Таблицы дескрипторов настроек и операции над ними
+ */
+
+#include "settings_schema.h"
+#include "json_writer.h"
+#include <stddef.h>
+
+// Построение дескрипторов полей из строк списков
+#define HEATER_FIELD(field, type, def, lo, hi, flags) \
+    { #field, type, offsetof(HeaterSettings, field), flags, (float)(def), (float)(lo), (float)(hi) },
+#define PUMP_FIELD(field, type, def, lo, hi, flags) \
+    { #field, type, offsetof(PumpSettings, field), flags, (float)(def), (float)(lo), (float)(hi) },
+#define RECT_FIELD(field, type, def, lo, hi, flags) \
+    { #field, type, offsetof(RectificationSettings, field), flags, (float)(def), (float)(lo), (float)(hi) },
+#define DIST_FIELD(field, type, def, lo, hi, flags) \
+    { #field, type, offsetof(DistillationSettings, field), flags, (float)(def), (float)(lo), (float)(hi) },
+#define SAFETY_FIELD(field, type, def, lo, hi, flags) \
+    { #field, type, offsetof(SafetySettings, field), flags, (float)(def), (float)(lo), (float)(hi) },
+#define MQTT_FIELD(field, type, def, lo, hi, flags) \
+    { #field, type, offsetof(MqttSettings, field), flags, (float)(def), (float)(lo), (float)(hi) },
+
+static const SettingField heaterFields[] = { HEATER_SETTINGS_SCHEMA(HEATER_FIELD) };
+static const SettingField pumpFields[] = { PUMP_SETTINGS_SCHEMA(PUMP_FIELD) };
+static const SettingField rectFields[] = { RECTIFICATION_SETTINGS_SCHEMA(RECT_FIELD) };
+static const SettingField distFields[] = { DISTILLATION_SETTINGS_SCHEMA(DIST_FIELD) };
+static const SettingField safetyFields[] = { SAFETY_SETTINGS_SCHEMA(SAFETY_FIELD) };
+static const SettingField mqttFields[] = { MQTT_SETTINGS_SCHEMA(MQTT_FIELD) };
+
+#define FIELD_COUNT(fields) (uint8_t)(sizeof(fields) / sizeof(fields[0]))
+
+// Порядок совпадает с SettingsSectionId
+static const SettingsSection sections[SETTINGS_SECTION_COUNT] = {
+    { "heater", heaterFields, FIELD_COUNT(heaterFields), offsetof(SystemSettings, heaterSettings) },
+    { "pump", pumpFields, FIELD_COUNT(pumpFields), offsetof(SystemSettings, pumpSettings) },
+    { "rectification", rectFields, FIELD_COUNT(rectFields), offsetof(SystemSettings, rectificationSettings) },
+    { "distillation", distFields, FIELD_COUNT(distFields), offsetof(SystemSettings, distillationSettings) },
+    { "safety", safetyFields, FIELD_COUNT(safetyFields), offsetof(SystemSettings, safetySettings) },
+    { "mqtt", mqttFields, FIELD_COUNT(mqttFields), offsetof(SystemSettings, mqttSettings) }
+};
+
+// Получение описания раздела настроек
+const SettingsSection& getSettingsSection(SettingsSectionId id) {
+    return sections[id < SETTINGS_SECTION_COUNT ? id : 0];
+}
+
+// Поиск раздела настроек по имени
+const SettingsSection* findSettingsSection(const char* name) {
+    for (int i = 0; i < SETTINGS_SECTION_COUNT; i++) {
+        if (strcmp(sections[i].name, name) == 0) {
+            return &sections[i];
+        }
+    }
+    return nullptr;
+}
+
+// Получение данных раздела в структуре настроек
+void* getSettingsSectionData(SystemSettings& settings, const SettingsSection& section) {
+    return (uint8_t*)&settings + section.offset;
+}
+
+// Поиск поля раздела по ключу
+static const SettingField* findSettingField(const SettingsSection& section, const char* key) {
+    for (uint8_t i = 0; i < section.count; i++) {
+        if (strcmp(section.fields[i].key, key) == 0) {
+            return &section.fields[i];
+        }
+    }
+    return nullptr;
+}
+
+// Запись значения в поле
+static void setFieldValue(const SettingField& field, void* data, JsonVariantConst value) {
+    uint8_t* ptr = (uint8_t*)data + field.offset;
+    switch (field.type) {
+        case SF_INT:   *(int*)ptr = value.as<int>(); break;
+        case SF_FLOAT: *(float*)ptr = value.as<float>(); break;
+        case SF_BOOL:  *(bool*)ptr = value.as<bool>(); break;
+        case SF_STRING: strlcpy((char*)ptr, value.as<const char*>(), (size_t)field.maxValue); break;
+    }
+}
+
+// Установка значений по умолчанию для всех полей раздела
+void applySettingsDefaults(const SettingsSection& section, void* data) {
+    for (uint8_t i = 0; i < section.count; i++) {
+        const SettingField& field = section.fields[i];
+        uint8_t* ptr = (uint8_t*)data + field.offset;
+        switch (field.type) {
+            case SF_INT:   *(int*)ptr = (int)field.defaultValue; break;
+            case SF_FLOAT: *(float*)ptr = field.defaultValue; break;
+            case SF_BOOL:  *(bool*)ptr = field.defaultValue != 0; break;
+            case SF_STRING: *(char*)ptr = '\0'; break;
+        }
+    }
+}
+
+// Запись значения поля в JSON-объект
+void settingFieldToJson(const SettingField& field, const void* data, JsonObject obj) {
+    const uint8_t* ptr = (const uint8_t*)data + field.offset;
+    switch (field.type) {
+        case SF_INT:   obj[field.key] = *(const int*)ptr; break;
+        case SF_FLOAT: obj[field.key] = *(const float*)ptr; break;
+        case SF_BOOL:  obj[field.key] = *(const bool*)ptr; break;
+        case SF_STRING: obj[field.key] = (const char*)ptr; break;
+    }
+}
+
+// Запись полей раздела в JSON-объект
+void settingsSectionToJson(const SettingsSection& section, const void* data, JsonObject obj, uint8_t flags) {
+    for (uint8_t i = 0; i < section.count; i++) {
+        const uint8_t fieldFlags = section.fields[i].flags;
+        if ((fieldFlags & flags) == flags && !(fieldFlags & SF_SECRET)) {
+            settingFieldToJson(section.fields[i], data, obj);
+        }
+    }
+}
+
+// Потоковая запись полей раздела
+void writeSettingsSection(const SettingsSection& section, const void* data, JsonWriter& json, uint8_t flags) {
+    for (uint8_t i = 0; i < section.count; i++) {
+        const SettingField& field = section.fields[i];
+        if ((field.flags & flags) != flags || (field.flags & SF_SECRET)) {
+            continue;
+        }
+        const uint8_t* ptr = (const uint8_t*)data + field.offset;
+        switch (field.type) {
+            case SF_INT:   json.add(field.key, *(const int*)ptr); break;
+            case SF_FLOAT: json.add(field.key, *(const float*)ptr); break;
+            case SF_BOOL:  json.add(field.key, *(const bool*)ptr); break;
+            case SF_STRING: json.add(field.key, (const char*)ptr); break;
+        }
+    }
+}
+
+// Проверка значений раздела в JSON-объекте
+bool validateSettingsSection(const SettingsSection& section, JsonObjectConst obj, uint8_t flags, String& error) {
+    // Перебираются только переданные ключи, а не все поля раздела
+    for (JsonPairConst kv : obj) {
+        const SettingField* field = findSettingField(section, kv.key().c_str());
+        if (field == nullptr || (field->flags & flags) != flags) {
+            continue;
+        }
+
+        JsonVariantConst value = kv.value();
+        bool valid;
+        if (field->type == SF_BOOL) {
+            valid = value.is<bool>();
+        } else if (field->type == SF_STRING) {
+            // Максимум строкового поля - размер массива вместе с завершающим нулем
+            valid = value.is<const char*>() && strlen(value.as<const char*>()) < (size_t)field->maxValue;
+        } else {
+            valid = value.is<float>();
+            if (valid) {
+                float number = value.as<float>();
+                valid = number >= field->minValue && number <= field->maxValue;
+            }
+        }
+
+        if (!valid) {
+            error = String("Недопустимое значение ") + section.name + "." + field->key;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Чтение полей раздела из JSON-объекта
+bool settingsSectionFromJson(const SettingsSection& section, void* data, JsonObjectConst obj, uint8_t flags, String& error) {
+    if (!validateSettingsSection(section, obj, flags, error)) {
+        return false;
+    }
+
+    for (JsonPairConst kv : obj) {
+        const SettingField* field = findSettingField(section, kv.key().c_str());
+        if (field != nullptr && (field->flags & flags) == flags) {
+            setFieldValue(*field, data, kv.value());
+        }
+    }
+    return true;
+}
+
+// Сравнение значения поля в двух структурах раздела
+bool settingFieldEquals(const SettingField& field, const void* a, const void* b) {
+    const uint8_t* pa = (const uint8_t*)a + field.offset;
+    const uint8_t* pb = (const uint8_t*)b + field.offset;
+    switch (field.type) {
+        case SF_INT:   return *(const int*)pa == *(const int*)pb;
+        case SF_FLOAT: return *(const float*)pa == *(const float*)pb;
+        case SF_BOOL:  return *(const bool*)pa == *(const bool*)pb;
+        case SF_STRING: return strcmp((const char*)pa, (const char*)pb) == 0;
+    }
+    return true;
+}
@@ -0,0 +1,253 @@
+/**
+ * @file settings_schema.h
+ * @brief Единое описание полей настроек
+ *
+ * Каждое поле разделов настроек описывается один раз в списке X-макросов:
+ * имя (оно же ключ в JSON), тип, значение по умолчанию, допустимый диапазон
+ * и флаги. Из списков строятся таблицы дескрипторов, по которым выполняются
+ * установка значений по умолчанию, выдача и разбор JSON (веб-интерфейс и
+ * рецепты), проверка диапазонов и сравнение значений. Новое поле достаточно
+ * добавить в структуру в settings.h и в список раздела.
+ *
+ * Строковое поле - массив char в структуре; максимумом для него служит
+ * размер массива, значение по умолчанию - пустая строка.
+ */
+
+#ifndef SETTINGS_SCHEMA_H
+#define SETTINGS_SCHEMA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "settings.h"
+#include "config.h"
+
+class JsonWriter;
+
+// Тип поля настроек
+enum SettingFieldType {
+    SF_INT,
+    SF_FLOAT,
+    SF_BOOL,
+    SF_STRING
+};
+
+// Флаги поля
+#define SF_RECIPE 0x01              // Поле входит в рецепт
+#define SF_SECRET 0x02              // Поле принимается, но не выдается в JSON (пароли)
+
+// Поля разделов: X(поле, тип, по умолчанию, минимум, максимум, флаги)
+// Для логических полей диапазон не проверяется.
+
+#define HEATER_SETTINGS_SCHEMA(X) \
+    X(maxPowerWatts,                 SF_INT,   2000,  0,     10000,  0) \
+    X(volts,                         SF_INT,   220,   100,   250,    0)
+
+// Калибровка насоса относится к оборудованию, а не к рецепту
+#define PUMP_SETTINGS_SCHEMA(X) \
+    X(headsFlowRate,                 SF_FLOAT, 50.0f,  0,    10000,  SF_RECIPE) \
+    X(bodyFlowRate,                  SF_FLOAT, 250.0f, 0,    10000,  SF_RECIPE) \
+    X(tailsFlowRate,                 SF_FLOAT, 350.0f, 0,    10000,  SF_RECIPE) \
+    X(calibrationFactor,             SF_FLOAT, 1.0f,   0.01f, 100,   0)
+
+#define RECTIFICATION_SETTINGS_SCHEMA(X) \
+    X(model,                         SF_INT,   0,      0,    1,      SF_RECIPE) \
+    X(heatingPowerWatts,             SF_INT,   1800,   0,    10000,  SF_RECIPE) \
+    X(stabilizationPowerWatts,       SF_INT,   1200,   0,    10000,  SF_RECIPE) \
+    X(bodyPowerWatts,                SF_INT,   1000,   0,    10000,  SF_RECIPE) \
+    X(tailsPowerWatts,               SF_INT,   1200,   0,    10000,  SF_RECIPE) \
+    X(headsTemp,                     SF_FLOAT, 78.0f,  0,    120,    SF_RECIPE) \
+    X(bodyTemp,                      SF_FLOAT, 78.3f,  0,    120,    SF_RECIPE) \
+    X(tailsTemp,                     SF_FLOAT, 92.0f,  0,    120,    SF_RECIPE) \
+    X(endTemp,                       SF_FLOAT, 97.0f,  0,    120,    SF_RECIPE) \
+    X(maxCubeTemp,                   SF_FLOAT, 101.0f, 0,    120,    SF_RECIPE) \
+    X(tailsCubeTemp,                 SF_FLOAT, 95.0f,  0,    120,    SF_RECIPE) \
+    X(tempDeltaEndBody,              SF_FLOAT, 0.5f,   0,    10,     SF_RECIPE) \
+    X(bodyStartStop,                 SF_BOOL,  false,  0,    0,      SF_RECIPE) \
+    X(startStopDelta,                SF_FLOAT, 0.1f,   0,    5,      SF_RECIPE) \
+    X(startStopBackoff,              SF_FLOAT, 10.0f,  0,    100,    SF_RECIPE) \
+    X(startStopMinRate,              SF_FLOAT, 30.0f,  0,    100,    SF_RECIPE) \
+    X(startStopHoldTime,             SF_INT,   10,     0,    600,    SF_RECIPE) \
+    X(stabilizationTime,             SF_INT,   30,     0,    600,    SF_RECIPE) \
+    X(postHeadsStabilizationTime,    SF_INT,   10,     0,    600,    SF_RECIPE) \
+    X(autoStabilization,             SF_BOOL,  true,   0,    0,      SF_RECIPE) \
+    X(stabilizationMinTime,          SF_INT,   10,     0,    600,    SF_RECIPE) \
+    X(postHeadsStabilizationMinTime, SF_INT,   3,      0,    600,    SF_RECIPE) \
+    X(stabilizationWindow,           SF_INT,   300,    10,   3600,   SF_RECIPE) \
+    X(stabilizationMaxStdDev,        SF_FLOAT, 0.05f,  0,    5,      SF_RECIPE) \
+    X(stabilizationMaxSlope,         SF_FLOAT, 0.02f,  0,    5,      SF_RECIPE) \
+    X(headsTargetTime,               SF_INT,   30,     0,    600,    SF_RECIPE) \
+    X(headsEndMode,                  SF_INT,   1,      0,    2,      SF_RECIPE) \
+    X(headsEndConfidence,            SF_FLOAT, 0.8f,   0,    1,      SF_RECIPE) \
+    X(headsEndMaxSlope,              SF_FLOAT, 0.05f,  0,    5,      SF_RECIPE) \
+    X(headsEndMaxDelta,              SF_FLOAT, 1.0f,   0,    20,     SF_RECIPE) \
+    X(headsVolume,                   SF_INT,   150,    0,    100000, SF_RECIPE) \
+    X(bodyVolume,                    SF_INT,   2000,   0,    100000, SF_RECIPE) \
+    X(refluxRatio,                   SF_FLOAT, 3.0f,   0,    100,    SF_RECIPE) \
+    X(refluxPeriod,                  SF_INT,   60,     1,    3600,   SF_RECIPE) \
+    X(bodyFlowRate,                  SF_FLOAT, 500.0f, 0,    10000,  SF_RECIPE) \
+    X(tailsFlowRate,                 SF_FLOAT, 800.0f, 0,    10000,  SF_RECIPE) \
+    X(useSameFlowForTails,           SF_BOOL,  true,   0,    0,      SF_RECIPE)
+
+#define DISTILLATION_SETTINGS_SCHEMA(X) \
+    X(heatingPowerWatts,             SF_INT,   2000,   0,    10000,  SF_RECIPE) \
+    X(distillationPowerWatts,        SF_INT,   1500,   0,    10000,  SF_RECIPE) \
+    X(startCollectingTemp,           SF_FLOAT, 70.0f,  0,    120,    SF_RECIPE) \
+    X(endTemp,                       SF_FLOAT, 97.0f,  0,    120,    SF_RECIPE) \
+    X(maxCubeTemp,                   SF_FLOAT, 101.0f, 0,    120,    SF_RECIPE) \
+    X(separateHeads,                 SF_BOOL,  true,   0,    0,      SF_RECIPE) \
+    X(headsVolume,                   SF_INT,   200,    0,    100000, SF_RECIPE) \
+    X(flowRate,                      SF_FLOAT, 800.0f, 0,    10000,  SF_RECIPE) \
+    X(headsFlowRate,                 SF_FLOAT, 200.0f, 0,    10000,  SF_RECIPE)
+
+#define SAFETY_SETTINGS_SCHEMA(X) \
+    X(maxRuntimeHours,      SF_INT,   SAFETY_MAX_RUNTIME_HOURS_DEFAULT,  1,    72,  0) \
+    X(maxCubeTemp,          SF_FLOAT, SAFETY_MAX_CUBE_TEMP_DEFAULT,      50,   120, 0) \
+    X(maxTempRiseRate,      SF_FLOAT, SAFETY_MAX_TEMP_RISE_RATE_DEFAULT, 0.1f, 50,  0) \
+    X(minWaterOutTemp,      SF_FLOAT, SAFETY_MIN_WATER_OUT_TEMP_DEFAULT, 0,    100, 0) \
+    X(maxWaterOutTemp,      SF_FLOAT, SAFETY_MAX_WATER_OUT_TEMP_DEFAULT, 0,    100, 0) \
+    X(emergencyStopEnabled, SF_BOOL,  true,                              0,    0,   0) \
+    X(watchdogEnabled,      SF_BOOL,  true,                              0,    0,   0)
+
+// Пустой префикс топиков заменяется на drivevision/<MAC> (mqtt_bridge.h)
+#define MQTT_SETTINGS_SCHEMA(X) \
+    X(enabled,         SF_BOOL,   false, 0, 0,                                0) \
+    X(host,            SF_STRING, 0,     0, sizeof(MqttSettings::host),     0) \
+    X(port,            SF_INT,    1883,  1, 65535,                            0) \
+    X(user,            SF_STRING, 0,     0, sizeof(MqttSettings::user),     0) \
+    X(password,        SF_STRING, 0,     0, sizeof(MqttSettings::password), SF_SECRET) \
+    X(prefix,          SF_STRING, 0,     0, sizeof(MqttSettings::prefix),   0) \
+    X(qos,             SF_INT,    0,     0, 2,                                0) \
+    X(publishInterval, SF_INT,    5,     1, 3600,                             0)
+
+// Описание поля настроек
+struct SettingField {
+    const char* key;                // Имя поля (ключ в JSON)
+    SettingFieldType type;          // Тип поля
+    uint16_t offset;                // Смещение поля в структуре раздела
+    uint8_t flags;                  // Флаги поля
+    float defaultValue;             // Значение по умолчанию
+    float minValue;                 // Минимальное допустимое значение
+    float maxValue;                 // Максимальное допустимое значение
+};
+
+// Описание раздела настроек
+struct SettingsSection {
+    const char* name;               // Имя раздела в JSON
+    const SettingField* fields;     // Поля раздела
+    uint8_t count;                  // Количество полей
+    uint16_t offset;                // Смещение раздела в SystemSettings
+};
+
+// Разделы настроек
+enum SettingsSectionId {
+    SETTINGS_SECTION_HEATER = 0,
+    SETTINGS_SECTION_PUMP,
+    SETTINGS_SECTION_RECTIFICATION,
+    SETTINGS_SECTION_DISTILLATION,
+    SETTINGS_SECTION_SAFETY,
+    SETTINGS_SECTION_MQTT,
+    SETTINGS_SECTION_COUNT
+};
+
+/**
+ * @brief Получение описания раздела настроек
+ *
+ * @param id Раздел
+ * @return const SettingsSection& Описание раздела
+ */
+const SettingsSection& getSettingsSection(SettingsSectionId id);
+
+/**
+ * @brief Поиск раздела настроек по имени
+ *
+ * @param name Имя раздела в JSON
+ * @return const SettingsSection* Описание раздела или nullptr
+ */
+const SettingsSection* findSettingsSection(const char* name);
+
+/**
+ * @brief Получение данных раздела в структуре настроек
+ *
+ * @param settings Структура настроек
+ * @param section Раздел
+ * @return void* Указатель на структуру раздела
+ */
+void* getSettingsSectionData(SystemSettings& settings, const SettingsSection& section);
+
+/**
+ * @brief Установка значений по умолчанию для всех полей раздела
+ *
+ * @param section Раздел
+ * @param data Структура раздела
+ */
+void applySettingsDefaults(const SettingsSection& section, void* data);
+
+/**
+ * @brief Запись значения поля в JSON-объект
+ *
+ * @param field Поле
+ * @param data Структура раздела
+ * @param obj Объект, в который добавляется ключ поля
+ */
+void settingFieldToJson(const SettingField& field, const void* data, JsonObject obj);
+
+/**
+ * @brief Запись полей раздела в JSON-объект
+ *
+ * Поля с флагом SF_SECRET не записываются.
+ *
+ * @param section Раздел
+ * @param data Структура раздела
+ * @param obj Объект раздела
+ * @param flags Записываются только поля с указанными флагами (0 - все поля)
+ */
+void settingsSectionToJson(const SettingsSection& section, const void* data, JsonObject obj, uint8_t flags = 0);
+
+/**
+ * @brief Потоковая запись полей раздела (без документа ArduinoJson)
+ *
+ * Поля с флагом SF_SECRET не записываются.
+ *
+ * @param section Раздел
+ * @param data Структура раздела
+ * @param json Запись JSON, в которой открыт объект раздела
+ * @param flags Записываются только поля с указанными флагами (0 - все поля)
+ */
+void writeSettingsSection(const SettingsSection& section, const void* data, JsonWriter& json, uint8_t flags = 0);
+
+/**
+ * @brief Проверка значений раздела в JSON-объекте
+ *
+ * Неизвестные ключи и поля без указанных флагов пропускаются.
+ *
+ * @param section Раздел
+ * @param obj Объект раздела
+ * @param flags Учитываются только поля с указанными флагами (0 - все поля)
+ * @param error Описание первой ошибки
+ * @return true если все значения корректного типа и в допустимом диапазоне
+ */
+bool validateSettingsSection(const SettingsSection& section, JsonObjectConst obj, uint8_t flags, String& error);
+
+/**
+ * @brief Чтение полей раздела из JSON-объекта
+ *
+ * Значения сначала проверяются; при ошибке раздел не изменяется.
+ * Отсутствующие в объекте поля не изменяются.
+ *
+ * @param section Раздел
+ * @param data Структура раздела
+ * @param obj Объект раздела
+ * @param flags Учитываются только поля с указанными флагами (0 - все поля)
+ * @param error Описание первой ошибки
+ * @return true если значения применены
+ */
+bool settingsSectionFromJson(const SettingsSection& section, void* data, JsonObjectConst obj, uint8_t flags, String& error);
+
+/**
+ * @brief Сравнение значения поля в двух структурах раздела
+ *
+ * @return true если значения равны
+ */
+bool settingFieldEquals(const SettingField& field, const void* a, const void* b);
+
+#endif // SETTINGS_SCHEMA_H
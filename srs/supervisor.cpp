@@ -0,0 +1,197 @@
+/**
+ * @file supervisor.cpp
+ * @brief Реализация контроля работоспособности задач
+ */
+
+#include "supervisor.h"
+#include "safety.h"
+
+// Сигнатура записи о неисправности в RTC-памяти
+#define SUPERVISOR_FAULT_MAGIC 0x53555056  // "SUPV"
+
+// Таблица сигналов активности
+static HeartbeatStats heartbeats[HEARTBEAT_MAX_TASKS];
+static bool heartbeatMissed[HEARTBEAT_MAX_TASKS];
+static volatile int heartbeatCount = 0;
+static portMUX_TYPE heartbeatLock = portMUX_INITIALIZER_UNLOCKED;
+
+// Неисправность; копия в RTC-памяти переживает программную перезагрузку
+static SupervisorFault fault;
+RTC_NOINIT_ATTR static SupervisorFault savedFault;
+RTC_NOINIT_ATTR static uint32_t savedFaultMagic;
+
+// Пустая статистика для неверного идентификатора
+static const HeartbeatStats emptyStats = {"", "", 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+// Инициализация контроля задач
+void initSupervisor() {
+    memset(&fault, 0, sizeof(fault));
+
+    if (savedFaultMagic == SUPERVISOR_FAULT_MAGIC && savedFault.active) {
+        fault = savedFault;
+        fault.task[sizeof(fault.task) - 1] = '\0';
+        fault.state[sizeof(fault.state) - 1] = '\0';
+
+        Serial.print("Неисправность до перезагрузки: задача ");
+        Serial.print(fault.task);
+        Serial.print(" не отвечала ");
+        Serial.print(fault.silentTime);
+        Serial.print(" мс, состояние: ");
+        Serial.println(fault.state);
+    } else {
+        savedFaultMagic = 0;
+    }
+}
+
+// Регистрация сигнала активности задачи
+int registerHeartbeat(const char* name, unsigned long expectedPeriod, unsigned long timeout) {
+    // Задачи регистрируются с обоих ядер: выбор и заполнение записи неделимы
+    portENTER_CRITICAL(&heartbeatLock);
+    if (heartbeatCount >= HEARTBEAT_MAX_TASKS) {
+        portEXIT_CRITICAL(&heartbeatLock);
+        Serial.println("Ошибка: переполнена таблица контроля задач");
+        return -1;
+    }
+
+    int id = heartbeatCount;
+    HeartbeatStats& hb = heartbeats[id];
+    hb.name = name;
+    hb.state = "";
+    hb.expectedPeriod = expectedPeriod;
+    hb.timeout = timeout;
+    hb.lastBeat = millis();
+    hb.lastPeriod = 0;
+    hb.minPeriod = 0;
+    hb.maxPeriod = 0;
+    hb.avgPeriod = expectedPeriod;
+    hb.beats = 0;
+    hb.overruns = 0;
+    hb.misses = 0;
+    heartbeatMissed[id] = false;
+
+    // Задача становится видимой для проверки только после заполнения записи
+    heartbeatCount = id + 1;
+    portEXIT_CRITICAL(&heartbeatLock);
+    return id;
+}
+
+// Отметка сигнала активности задачи
+void feedHeartbeat(int id) {
+    if (id < 0 || id >= heartbeatCount) {
+        return;
+    }
+
+    HeartbeatStats& hb = heartbeats[id];
+    unsigned long now = millis();
+    unsigned long period = now - hb.lastBeat;
+
+    if (hb.beats > 0) {
+        hb.lastPeriod = period;
+        if (hb.minPeriod == 0 || period < hb.minPeriod) {
+            hb.minPeriod = period;
+        }
+        if (period > hb.maxPeriod) {
+            hb.maxPeriod = period;
+        }
+        hb.avgPeriod += HEARTBEAT_PERIOD_SMOOTHING * ((float)period - hb.avgPeriod);
+        if (period > hb.expectedPeriod * HEARTBEAT_OVERRUN_FACTOR) {
+            hb.overruns++;
+        }
+    }
+
+    hb.beats++;
+    hb.lastBeat = now;
+    heartbeatMissed[id] = false;
+}
+
+// Отметка текущего состояния задачи
+void setHeartbeatState(int id, const char* state) {
+    if (id < 0 || id >= heartbeatCount) {
+        return;
+    }
+    heartbeats[id].state = state;
+}
+
+// Запись неисправности и перевод в безопасное состояние
+static void raiseSupervisorFault(const HeartbeatStats& hb, unsigned long silentTime) {
+    if (!fault.active) {
+        fault.active = true;
+        strncpy(fault.task, hb.name, sizeof(fault.task) - 1);
+        fault.task[sizeof(fault.task) - 1] = '\0';
+        strncpy(fault.state, hb.state, sizeof(fault.state) - 1);
+        fault.state[sizeof(fault.state) - 1] = '\0';
+        fault.silentTime = silentTime;
+        fault.uptime = millis();
+
+        savedFault = fault;
+        savedFaultMagic = SUPERVISOR_FAULT_MAGIC;
+    }
+
+    // Аварийная остановка фиксируется до сброса оператором: процесс
+    // останавливается в своем цикле, выходы не включаются снова
+    char reason[SAFETY_ERROR_TEXT_SIZE];
+    snprintf(reason, sizeof(reason), "Задача %s не отвечает (%s)", hb.name, hb.state);
+    emergencyStop(reason);
+}
+
+// Проверка сигналов всех задач
+bool checkHeartbeats() {
+    bool ok = true;
+    int count = heartbeatCount;
+
+    for (int i = 0; i < count; i++) {
+        HeartbeatStats& hb = heartbeats[i];
+
+        // Время сигнала читается до текущего времени, чтобы разность не стала отрицательной
+        unsigned long lastBeat = hb.lastBeat;
+        unsigned long silentTime = millis() - lastBeat;
+
+        if (silentTime <= hb.timeout) {
+            continue;
+        }
+
+        ok = false;
+
+        // Пропуск фиксируется один раз до следующего сигнала задачи
+        if (heartbeatMissed[i]) {
+            continue;
+        }
+        heartbeatMissed[i] = true;
+        hb.misses++;
+
+        Serial.print("Задача ");
+        Serial.print(hb.name);
+        Serial.print(" не отвечает ");
+        Serial.print(silentTime);
+        Serial.print(" мс, последнее состояние: ");
+        Serial.println(hb.state);
+
+        raiseSupervisorFault(hb, silentTime);
+    }
+
+    return ok;
+}
+
+// Получение количества зарегистрированных задач
+int getHeartbeatCount() {
+    return heartbeatCount;
+}
+
+// Получение статистики сигнала активности
+const HeartbeatStats& getHeartbeatStats(int id) {
+    if (id < 0 || id >= heartbeatCount) {
+        return emptyStats;
+    }
+    return heartbeats[id];
+}
+
+// Получение записи о неисправности задачи
+const SupervisorFault& getSupervisorFault() {
+    return fault;
+}
+
+// Сброс записи о неисправности
+void clearSupervisorFault() {
+    memset(&fault, 0, sizeof(fault));
+    savedFaultMagic = 0;
+}
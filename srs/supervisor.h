@@ -0,0 +1,125 @@
+/**
+ * @file supervisor.h
+ * @brief Контроль работоспособности задач по сигналам активности
+ *
+ * Каждая задача (опрос датчиков, управление, интерфейс) регистрирует
+ * сигнал активности с ожидаемым периодом и
+ * допустимым таймаутом и отмечает его на каждом цикле. Перед долгими
+ * операциями задача отмечает свое состояние, чтобы при зависании было
+ * видно, где она остановилась.
+ *
+ * Проверка выполняется задачей безопасности. Пропуск таймаута любой
+ * задачей переводит систему в безопасное состояние: фиксируется аварийная
+ * остановка (safety.h), которую снимает только оператор, и записывается
+ * неисправность, которая сохраняется в RTC-памяти и доступна после
+ * перезагрузки.
+ */
+
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <Arduino.h>
+
+// Максимальное количество контролируемых задач
+#define HEARTBEAT_MAX_TASKS 8
+
+// Коэффициент сглаживания среднего периода
+#define HEARTBEAT_PERIOD_SMOOTHING 0.1f
+
+// Период длиннее ожидаемого во столько раз считается переполнением цикла
+#define HEARTBEAT_OVERRUN_FACTOR 2
+
+// Статистика сигнала активности задачи
+struct HeartbeatStats {
+    const char* name;              // Имя задачи
+    const char* state;             // Последнее отмеченное состояние задачи
+    unsigned long expectedPeriod;  // Ожидаемый период (мс)
+    unsigned long timeout;         // Допустимое время без сигнала (мс)
+    unsigned long lastBeat;        // Время последнего сигнала (мс)
+    unsigned long lastPeriod;      // Последний измеренный период (мс)
+    unsigned long minPeriod;       // Минимальный период (мс)
+    unsigned long maxPeriod;       // Максимальный период (мс)
+    float avgPeriod;               // Средний период (мс, сглаженный)
+    unsigned long beats;           // Количество сигналов
+    unsigned long overruns;        // Количество периодов длиннее HEARTBEAT_OVERRUN_FACTOR ожидаемых
+    unsigned long misses;          // Количество пропусков таймаута
+};
+
+// Запись о неисправности задачи
+struct SupervisorFault {
+    bool active;                   // Неисправность зафиксирована
+    char task[16];                 // Имя задачи
+    char state[48];                // Последнее состояние задачи
+    unsigned long silentTime;      // Время без сигнала на момент обнаружения (мс)
+    unsigned long uptime;          // Время работы контроллера на момент обнаружения (мс)
+};
+
+/**
+ * @brief Инициализация контроля задач
+ *
+ * Восстанавливает неисправность, записанную до перезагрузки.
+ */
+void initSupervisor();
+
+/**
+ * @brief Регистрация сигнала активности задачи
+ *
+ * Может вызываться задачами на обоих ядрах одновременно.
+ *
+ * @param name Имя задачи (строковый литерал)
+ * @param expectedPeriod Ожидаемый период сигнала (мс)
+ * @param timeout Допустимое время без сигнала (мс)
+ * @return int Идентификатор сигнала или -1 при переполнении таблицы
+ */
+int registerHeartbeat(const char* name, unsigned long expectedPeriod, unsigned long timeout);
+
+/**
+ * @brief Отметка сигнала активности задачи
+ *
+ * @param id Идентификатор сигнала
+ */
+void feedHeartbeat(int id);
+
+/**
+ * @brief Отметка текущего состояния задачи
+ *
+ * @param id Идентификатор сигнала
+ * @param state Состояние (строковый литерал)
+ */
+void setHeartbeatState(int id, const char* state);
+
+/**
+ * @brief Проверка сигналов всех задач, вызывается задачей безопасности
+ *
+ * @return true если все задачи укладываются в таймауты
+ */
+bool checkHeartbeats();
+
+/**
+ * @brief Получение количества зарегистрированных задач
+ *
+ * @return int Количество задач
+ */
+int getHeartbeatCount();
+
+/**
+ * @brief Получение статистики сигнала активности
+ *
+ * @param id Идентификатор сигнала
+ * @return const HeartbeatStats& Статистика
+ */
+const HeartbeatStats& getHeartbeatStats(int id);
+
+/**
+ * @brief Получение записи о неисправности задачи
+ *
+ * @return const SupervisorFault& Последняя зафиксированная неисправность
+ */
+const SupervisorFault& getSupervisorFault();
+
+/**
+ * @brief Сброс записи о неисправности
+ */
+void clearSupervisorFault();
+
+#endif // SUPERVISOR_H
@@ -6,7 +6,11 @@
 #include "utils.h"
 #include "display.h"
 #include "buttons.h"
-#include "webserver.h"
+#include "web.h"
+#include "mqtt_bridge.h"
+#include "supervisor.h"
+#include "safety.h"
+#include "fault_injection.h"
 
 // Идентификаторы задач FreeRTOS
 TaskHandle_t temperatureTaskHandle = NULL;
@@ -15,8 +19,6 @@ TaskHandle_t interfaceTaskHandle = NULL;
 
 // Время последнего обновления температур
 static unsigned long lastTempUpdate = 0;
-// Время последней отправки данных о температурах
-static unsigned long lastTempReport = 0;
 // Время последней проверки процесса
 static unsigned long lastProcessCheck = 0;
 
@@ -25,23 +27,26 @@ void temperatureTask(void* parameter) {
     const TickType_t xFrequency = pdMS_TO_TICKS(100); // Период 100 мс для проверки
     TickType_t xLastWakeTime = xTaskGetTickCount();
     
+    // Опрос датчиков блокирует задачу на время преобразования (до 750 мс)
+    int heartbeat = registerHeartbeat("temperature", 100, 5000);
+    
     while (true) {
         // Синхронизация задачи
+        setHeartbeatState(heartbeat, "ожидание");
         vTaskDelayUntil(&xLastWakeTime, xFrequency);
+        feedHeartbeat(heartbeat);
+        #ifdef FAULT_INJECTION
+        injectTaskFault("temperature");
+        #endif
         
         unsigned long currentTime = millis();
         
         // Обновление температур с заданной периодичностью
         if (currentTime - lastTempUpdate >= sysSettings.tempUpdateInterval) {
+            setHeartbeatState(heartbeat, "опрос датчиков");
             updateTemperatures();
             lastTempUpdate = currentTime;
         }
-        
-        // Отправка данных о температурах с заданной периодичностью
-        if (currentTime - lastTempReport >= sysSettings.tempReportInterval) {
-            sendTemperaturesWebSocket();
-            lastTempReport = currentTime;
-        }
     }
 }
 
@@ -50,9 +55,16 @@ void controlTask(void* parameter) {
     const TickType_t xFrequency = pdMS_TO_TICKS(100); // Период 100 мс для проверки
     TickType_t xLastWakeTime = xTaskGetTickCount();
     
+    int heartbeat = registerHeartbeat("control", 100, 2000);
+    
     while (true) {
         // Синхронизация задачи
+        setHeartbeatState(heartbeat, "ожидание");
         vTaskDelayUntil(&xLastWakeTime, xFrequency);
+        feedHeartbeat(heartbeat);
+        #ifdef FAULT_INJECTION
+        injectTaskFault("control");
+        #endif
         
         unsigned long currentTime = millis();
         
@@ -60,6 +72,7 @@ void controlTask(void* parameter) {
         if (systemRunning && !systemPaused) {
             // Проверяем процесс каждые 500 мс
             if (currentTime - lastProcessCheck >= 500) {
+                setHeartbeatState(heartbeat, "обработка процесса");
                 if (currentMode == MODE_RECTIFICATION) {
                     processRectification();
                 } else if (currentMode == MODE_DISTILLATION) {
@@ -71,6 +84,7 @@ void controlTask(void* parameter) {
         }
         
         // Обновление состояния нагревателя
+        setHeartbeatState(heartbeat, "управление выходами");
         updateHeater();
         
         // Обновление состояния насоса
@@ -79,12 +93,13 @@ void controlTask(void* parameter) {
         // Обновление состояния клапана
         updateValve();
         
-        // Обновляем статус в веб-интерфейсе каждые 1000 мс
-        static unsigned long lastWebUpdate = 0;
-        if (currentTime - lastWebUpdate >= 1000) {
-            sendStatusWebSocket();
-            lastWebUpdate = currentTime;
-        }
+        // Обновляем статус в веб-интерфейсе (температуры входят в сообщение статуса)
+        setHeartbeatState(heartbeat, "отправка статуса");
+        updateWebSocket();
+        
+        // Публикация телеметрии и подключение к брокеру MQTT
+        setHeartbeatState(heartbeat, "мост MQTT");
+        updateMqttBridge();
     }
 }
 
@@ -93,23 +108,38 @@ void interfaceTask(void* parameter) {
     const TickType_t xFrequency = pdMS_TO_TICKS(50); // 50 мс для опроса кнопок
     TickType_t xLastWakeTime = xTaskGetTickCount();
     
+    int heartbeat = registerHeartbeat("interface", 50, 2000);
+    
     while (true) {
         // Синхронизация задачи
+        setHeartbeatState(heartbeat, "ожидание");
         vTaskDelayUntil(&xLastWakeTime, xFrequency);
+        feedHeartbeat(heartbeat);
+        #ifdef FAULT_INJECTION
+        injectTaskFault("interface");
+        #endif
         
         // Обновление состояния кнопок
+        setHeartbeatState(heartbeat, "опрос кнопок");
         updateButtons();
         
         // Обработка действий кнопок
         handleButtonActions();
         
         // Обновление дисплея
+        setHeartbeatState(heartbeat, "обновление дисплея");
         updateDisplay();
     }
 }
 
 // Обработка процесса ректификации
 void processRectification() {
+    // Зафиксированная остановка (правило безопасности или неисправность задачи)
+    if (getSafetyRuleAction() >= SAFETY_ACTION_STOP) {
+        emergencyHeaterShutdown("Аварийная остановка");
+        return;
+    }
+    
     // Проверка безопасности - максимальная температура куба
     if (temperatures[TEMP_CUBE] > rectParams.maxCubeTemp) {
         sendWebNotification(NOTIFY_ERROR, "Превышена максимальная температура куба");
@@ -382,6 +412,12 @@ void processRectification() {
 
 // Обработка процесса дистилляции
 void processDistillation() {
+    // Зафиксированная остановка (правило безопасности или неисправность задачи)
+    if (getSafetyRuleAction() >= SAFETY_ACTION_STOP) {
+        emergencyHeaterShutdown("Аварийная остановка");
+        return;
+    }
+    
     // Проверка безопасности - максимальная температура куба
     if (temperatures[TEMP_CUBE] > distParams.maxCubeTemp) {
         sendWebNotification(NOTIFY_ERROR, "Превышена максимальная температура куба");
@@ -0,0 +1,1127 @@
+/**
+ * @file telemetry.cpp
+ * @brief Реализация журнала телеметрии процесса
+ */
+
+#include "telemetry.h"
+#include "config.h"
+#include "checkpoint.h"
+#include "temp_sensors.h"
+#include "heater.h"
+#include "pump.h"
+#include "rectification.h"
+#include "distillation.h"
+#include "json_writer.h"
+#include "fs_gate.h"
+#include <LittleFS.h>
+
+// Сигнатура заголовка сегмента журнала
+#define TELEMETRY_LOG_MAGIC 0x544C4732  // "TLG2"
+
+// Ожидание доступа к журналу из цикла процесса (мс)
+#define TELEMETRY_LOCK_TIMEOUT_MS 5
+
+// Ожидание доступа к отсчетам из задачи веб-сервера (мс)
+#define TELEMETRY_READ_TIMEOUT_MS 50
+
+// Размер пути к файлу сегмента
+#define TELEMETRY_PATH_SIZE 32
+
+// Длина строки CSV: время (10 цифр), фаза и три группы значений каналов
+// (температура до 7 символов "-327.68", мощность и насос до 6 "-32768").
+// Строка дополняется пробелами перед временем до этой длины, поэтому
+// размер выгрузки определяется числом записей
+#define TELEMETRY_CSV_ROW_SIZE (10 + 4 + 3 * (MAX_TEMP_SENSORS * 8 + 2 * 7) + 1)
+
+// Заголовок файла-сегмента журнала агрегатов. Пишется один раз при
+// создании сегмента, дальше записи только дописываются в конец файла
+struct TelemetrySegmentHeader {
+    uint32_t magic;            // Сигнатура TELEMETRY_LOG_MAGIC
+    uint16_t recordSize;       // Размер записи
+    uint16_t interval;         // Интервал агрегации (секунды)
+    uint32_t sequence;         // Номер сегмента от начала процесса
+    uint8_t process;           // Тип процесса (CheckpointProcess)
+    uint8_t reserved[3];
+    uint32_t runId;            // Идентификатор процесса, одинаковый во всех сегментах
+};
+
+// Журнал агрегатов одного разрешения - кольцо из TELEMETRY_LOG_SEGMENTS
+// файлов. Записи дописываются в последний сегмент, заполненный сегмент
+// сменяется новым на месте самого старого, поэтому хранится от 3/4 до
+// полной емкости. LittleFS при записи копирует измененный блок и все блоки
+// до конца файла: запись в середину файла переписывала бы весь журнал,
+// дописывание затрагивает только последний блок.
+struct TelemetryLog {
+    const char* name;          // Начало имени файлов на LittleFS
+    uint16_t interval;         // Интервал агрегации (секунды)
+    uint32_t capacity;         // Емкость кольца (записей)
+    bool ready;                // Файлы доступны
+    uint8_t process;           // Тип процесса (CheckpointProcess)
+    uint32_t runId;            // Идентификатор процесса
+    uint32_t firstSequence;    // Самый старый сегмент
+    uint32_t lastSequence;     // Сегмент, в который дописываются записи
+    uint32_t lastCount;        // Записей в последнем сегменте
+    uint32_t count;            // Всего записей
+
+    // Накопитель текущего интервала
+    bool pending;
+    TelemetryRollup acc;
+    int32_t sum[TELEMETRY_CHANNELS];
+    uint8_t valid[TELEMETRY_CHANNELS];
+};
+
+static TelemetryLog logs[] = {
+    { "/telemetry_10s", 10, TELEMETRY_LOG_10S_RECORDS },
+    { "/telemetry_60s", 60, TELEMETRY_LOG_60S_RECORDS }
+};
+
+#define TELEMETRY_LOG_COUNT (int)(sizeof(logs) / sizeof(logs[0]))
+
+// Отсчеты полной частоты
+static TelemetrySample samples[TELEMETRY_RAM_SAMPLES];
+static int sampleHead = 0;
+static int sampleCount = 0;
+
+// Состояние записи
+static bool runActive = false;
+static uint8_t runProcess = CHECKPOINT_NONE;
+static unsigned long runStartMillis = 0;
+static uint32_t runTimeOffset = 0;
+static unsigned long lastSampleMillis = 0;
+static uint32_t runNumber = 0;             // Номер записи, меняется при сбросе кольца отсчетов
+
+// Доступ из цикла процесса, задачи записи и веб-сервера
+static SemaphoreHandle_t telemetryMutex = NULL;
+
+// Операция задачи записи журналов на LittleFS
+enum TelemetryWriteOp : uint8_t {
+    TELEMETRY_WRITE_APPEND,    // Дописать агрегат
+    TELEMETRY_WRITE_RESET      // Очистить журналы перед новым процессом
+};
+
+struct TelemetryWrite {
+    uint8_t op;                // TelemetryWriteOp
+    uint8_t log;               // Журнал агрегата
+    uint8_t process;           // Тип процесса для очистки
+    uint32_t run;              // Номер записи, в которой снят агрегат
+    uint32_t runId;            // Идентификатор процесса для очистки
+    TelemetryRollup rollup;
+};
+
+// Запись во флеш-память выполняет отдельная задача: цикл процесса только
+// ставит агрегат в очередь и не ждет файловую систему
+static QueueHandle_t writeQueue = NULL;
+static TaskHandle_t telemetryTaskHandle = NULL;
+
+static bool lockTelemetry(TickType_t timeout) {
+    return telemetryMutex == NULL || xSemaphoreTake(telemetryMutex, timeout) == pdTRUE;
+}
+
+static void unlockTelemetry() {
+    if (telemetryMutex != NULL) {
+        xSemaphoreGive(telemetryMutex);
+    }
+}
+
+// Записей в одном сегменте журнала
+static uint32_t segmentRecords(const TelemetryLog& log) {
+    return log.capacity / TELEMETRY_LOG_SEGMENTS;
+}
+
+// Путь к файлу сегмента; номер сегмента определяет его место в кольце
+static void segmentPath(const TelemetryLog& log, uint32_t sequence, char* path, size_t size) {
+    snprintf(path, size, "%s_%u.bin", log.name, (unsigned int)(sequence % TELEMETRY_LOG_SEGMENTS));
+}
+
+// Создание пустого сегмента
+static bool createSegment(const TelemetryLog& log, const char* path, uint32_t sequence, uint8_t process,
+                          uint32_t runId) {
+    TelemetrySegmentHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TELEMETRY_LOG_MAGIC;
+    header.recordSize = sizeof(TelemetryRollup);
+    header.interval = log.interval;
+    header.sequence = sequence;
+    header.process = process;
+    header.runId = runId;
+
+    File file = LittleFS.open(path, "w");
+    bool ok = file && file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+    if (file) {
+        file.close();
+    }
+    if (!ok) {
+        Serial.print("Ошибка создания журнала телеметрии ");
+        Serial.println(path);
+    }
+    return ok;
+}
+
+// Очистка журнала: сегменты удаляются, создается первый пустой
+static bool createLog(TelemetryLog& log, uint8_t process, uint32_t runId) {
+    char path[TELEMETRY_PATH_SIZE];
+    for (uint32_t i = 0; i < TELEMETRY_LOG_SEGMENTS; i++) {
+        segmentPath(log, i, path, sizeof(path));
+        if (LittleFS.exists(path)) {
+            LittleFS.remove(path);
+        }
+    }
+    segmentPath(log, 0, path, sizeof(path));
+    bool ok = createSegment(log, path, 0, process, runId);
+
+    lockTelemetry(portMAX_DELAY);
+    log.process = process;
+    log.runId = runId;
+    log.firstSequence = 0;
+    log.lastSequence = 0;
+    log.lastCount = 0;
+    log.count = 0;
+    log.ready = ok;
+    unlockTelemetry();
+    return ok;
+}
+
+// Открытие журнала, оставшегося от предыдущего процесса
+static bool openLog(TelemetryLog& log) {
+    log.pending = false;
+
+    // Запись в LittleFS атомарна до закрытия файла, поэтому размер сегмента
+    // всегда кратен записи; иное означает повреждение
+    TelemetrySegmentHeader headers[TELEMETRY_LOG_SEGMENTS];
+    uint32_t counts[TELEMETRY_LOG_SEGMENTS];
+    bool present[TELEMETRY_LOG_SEGMENTS];
+    uint32_t records = segmentRecords(log);
+    uint32_t first = 0;
+    bool found = false;
+
+    for (uint32_t slot = 0; slot < TELEMETRY_LOG_SEGMENTS; slot++) {
+        char path[TELEMETRY_PATH_SIZE];
+        segmentPath(log, slot, path, sizeof(path));
+        present[slot] = false;
+
+        File file = LittleFS.open(path, "r");
+        if (!file) {
+            continue;
+        }
+        TelemetrySegmentHeader& header = headers[slot];
+        size_t size = file.size();
+        bool valid = file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+                     header.magic == TELEMETRY_LOG_MAGIC &&
+                     header.recordSize == sizeof(TelemetryRollup) &&
+                     header.interval == log.interval &&
+                     header.sequence % TELEMETRY_LOG_SEGMENTS == slot &&
+                     (size - sizeof(header)) % sizeof(TelemetryRollup) == 0;
+        file.close();
+
+        counts[slot] = valid ? (size - sizeof(header)) / sizeof(TelemetryRollup) : 0;
+        if (!valid || counts[slot] > records) {
+            return false;
+        }
+        present[slot] = true;
+        if (!found || header.sequence < first) {
+            first = header.sequence;
+            found = true;
+        }
+    }
+    if (!found) {
+        return false;
+    }
+
+    // Сегменты идут подряд от самого старого, все кроме последнего заполнены
+    uint8_t process = headers[first % TELEMETRY_LOG_SEGMENTS].process;
+    uint32_t runId = headers[first % TELEMETRY_LOG_SEGMENTS].runId;
+    uint32_t last = first;
+    int chain = 0;
+    for (uint32_t sequence = first; sequence - first < TELEMETRY_LOG_SEGMENTS; sequence++) {
+        uint32_t slot = sequence % TELEMETRY_LOG_SEGMENTS;
+        if (!present[slot] || headers[slot].sequence != sequence || headers[slot].process != process ||
+            headers[slot].runId != runId) {
+            break;
+        }
+        last = sequence;
+        chain++;
+    }
+    int total = 0;
+    for (uint32_t slot = 0; slot < TELEMETRY_LOG_SEGMENTS; slot++) {
+        total += present[slot] ? 1 : 0;
+    }
+    if (total != chain) {
+        return false;
+    }
+    for (uint32_t sequence = first; sequence < last; sequence++) {
+        if (counts[sequence % TELEMETRY_LOG_SEGMENTS] != records) {
+            return false;
+        }
+    }
+
+    log.process = process;
+    log.runId = runId;
+    log.firstSequence = first;
+    log.lastSequence = last;
+    log.lastCount = counts[last % TELEMETRY_LOG_SEGMENTS];
+    log.count = (last - first) * records + log.lastCount;
+    log.ready = true;
+    return true;
+}
+
+// Чтение записей журнала; файл сегмента остается открытым для следующих записей
+struct RollupReader {
+    File file;
+    uint32_t sequence;
+};
+
+static void closeReader(RollupReader& reader) {
+    if (reader.file) {
+        reader.file.close();
+    }
+}
+
+// Чтение записи журнала по порядку (0 - самая старая)
+static bool readRollup(RollupReader& reader, const TelemetryLog& log, uint32_t order, TelemetryRollup& rollup) {
+    uint32_t records = segmentRecords(log);
+    uint32_t sequence = log.firstSequence + order / records;
+    if (!reader.file || reader.sequence != sequence) {
+        closeReader(reader);
+        char path[TELEMETRY_PATH_SIZE];
+        segmentPath(log, sequence, path, sizeof(path));
+        reader.file = LittleFS.open(path, "r");
+        reader.sequence = sequence;
+    }
+    return reader.file &&
+           reader.file.seek(sizeof(TelemetrySegmentHeader) + (order % records) * sizeof(TelemetryRollup)) &&
+           reader.file.read((uint8_t*)&rollup, sizeof(rollup)) == sizeof(rollup);
+}
+
+// Время записи журнала по порядку
+static bool rollupTime(const TelemetryLog& log, uint32_t order, uint32_t& time) {
+    if (!log.ready || order >= log.count) {
+        return false;
+    }
+    RollupReader reader;
+    TelemetryRollup rollup;
+    bool ok = readRollup(reader, log, order, rollup);
+    closeReader(reader);
+    time = rollup.time;
+    return ok;
+}
+
+// Дописывание агрегата в журнал (задача записи)
+static void appendRollup(TelemetryLog& log, uint32_t run, const TelemetryRollup& rollup) {
+    uint32_t records = segmentRecords(log);
+
+    // Самый старый сегмент исключается из журнала до того, как его файл
+    // будет перезаписан новым сегментом
+    lockTelemetry(portMAX_DELAY);
+    bool current = run == runNumber && log.ready;
+    bool rotate = current && log.lastCount >= records;
+    uint32_t sequence = rotate ? log.lastSequence + 1 : log.lastSequence;
+    uint8_t process = log.process;
+    uint32_t runId = log.runId;
+    if (rotate && sequence - log.firstSequence >= TELEMETRY_LOG_SEGMENTS) {
+        log.firstSequence++;
+        log.count -= records;
+    }
+    unlockTelemetry();
+
+    // Агрегат предыдущего процесса не пишется
+    if (!current) {
+        return;
+    }
+
+    char path[TELEMETRY_PATH_SIZE];
+    segmentPath(log, sequence, path, sizeof(path));
+    bool ok = !rotate || createSegment(log, path, sequence, process, runId);
+    if (ok) {
+        File file = LittleFS.open(path, "a");
+        ok = file && file.write((const uint8_t*)&rollup, sizeof(rollup)) == sizeof(rollup);
+        if (file) {
+            file.close();
+        }
+    }
+    if (!ok) {
+        Serial.print("Ошибка записи журнала телеметрии ");
+        Serial.println(path);
+        return;
+    }
+
+    // Запись становится видимой для чтения только после закрытия файла
+    lockTelemetry(portMAX_DELAY);
+    if (run == runNumber) {
+        log.lastSequence = sequence;
+        log.lastCount = rotate ? 1 : log.lastCount + 1;
+        log.count++;
+    }
+    unlockTelemetry();
+}
+
+// Выполнение операции записи. Пока доступ к файлам закрыт (запись образа
+// файловой системы, после нее контроллер перезагружается), операция отбрасывается
+static void processTelemetryWrite(const TelemetryWrite& item) {
+    if (!beginFileAccess()) {
+        return;
+    }
+    if (item.op == TELEMETRY_WRITE_RESET) {
+        for (int i = 0; i < TELEMETRY_LOG_COUNT; i++) {
+            createLog(logs[i], item.process, item.runId);
+        }
+    } else if (item.log < TELEMETRY_LOG_COUNT) {
+        appendRollup(logs[item.log], item.run, item.rollup);
+    }
+    endFileAccess();
+}
+
+#ifdef ESP32
+// Задача записи журналов на LittleFS
+static void telemetryTask(void* parameter) {
+    TelemetryWrite item;
+    while (true) {
+        if (xQueueReceive(writeQueue, &item, portMAX_DELAY) == pdTRUE) {
+            processTelemetryWrite(item);
+        }
+    }
+}
+#endif
+
+// Постановка операции в очередь записи без ожидания
+static bool queueTelemetryWrite(const TelemetryWrite& item) {
+    if (writeQueue == NULL || xQueueSend(writeQueue, &item, 0) != pdTRUE) {
+        Serial.println("Очередь записи журнала телеметрии переполнена");
+        return false;
+    }
+    return true;
+}
+
+// Завершение интервала и передача агрегата на запись
+static void flushAccumulator(int index) {
+    TelemetryLog& log = logs[index];
+    if (!log.pending) {
+        return;
+    }
+    for (int c = 0; c < TELEMETRY_CHANNELS; c++) {
+        log.acc.avgValues[c] = log.valid[c] ? (int16_t)(log.sum[c] / log.valid[c]) : TELEMETRY_NO_VALUE;
+    }
+
+    TelemetryWrite item;
+    item.op = TELEMETRY_WRITE_APPEND;
+    item.log = index;
+    item.process = runProcess;
+    item.run = runNumber;
+    item.rollup = log.acc;
+    queueTelemetryWrite(item);
+    log.pending = false;
+}
+
+// Учет отсчета в агрегатах журнала
+static void accumulateSample(int index, const TelemetrySample& sample) {
+    TelemetryLog& log = logs[index];
+    uint32_t start = sample.time - sample.time % log.interval;
+    if (log.pending && start != log.acc.time) {
+        flushAccumulator(index);
+    }
+
+    if (!log.pending) {
+        memset(&log.acc, 0, sizeof(log.acc));
+        memset(log.sum, 0, sizeof(log.sum));
+        memset(log.valid, 0, sizeof(log.valid));
+        log.acc.time = start;
+        for (int c = 0; c < TELEMETRY_CHANNELS; c++) {
+            log.acc.minValues[c] = TELEMETRY_NO_VALUE;
+            log.acc.maxValues[c] = TELEMETRY_NO_VALUE;
+        }
+        log.pending = true;
+    }
+
+    log.acc.phase = sample.phase;
+    if (log.acc.count < 255) {
+        log.acc.count++;
+    }
+
+    for (int c = 0; c < TELEMETRY_CHANNELS; c++) {
+        int16_t value = sample.values[c];
+        if (value == TELEMETRY_NO_VALUE) {
+            continue;
+        }
+        if (log.valid[c] == 0 || value < log.acc.minValues[c]) {
+            log.acc.minValues[c] = value;
+        }
+        if (log.valid[c] == 0 || value > log.acc.maxValues[c]) {
+            log.acc.maxValues[c] = value;
+        }
+        log.sum[c] += value;
+        log.valid[c]++;
+    }
+}
+
+// Ограничение значения диапазоном отсчета
+static int16_t toSampleValue(float value) {
+    if (isnan(value)) {
+        return TELEMETRY_NO_VALUE;
+    }
+    return (int16_t)constrain(lroundf(value), (long)INT16_MIN + 1, (long)INT16_MAX);
+}
+
+// Снятие отсчета текущих показаний
+static void takeSample(TelemetrySample& sample) {
+    memset(&sample, 0, sizeof(sample));
+    sample.time = runTimeOffset + (millis() - runStartMillis) / 1000;
+
+    for (int i = 0; i < MAX_TEMP_SENSORS; i++) {
+        sample.values[i] = (sysSettings.tempSensorEnabled[i] && isSensorConnected(i)) ?
+            toSampleValue(getTemperature(i) * TELEMETRY_TEMP_SCALE) : TELEMETRY_NO_VALUE;
+    }
+    sample.values[TELEMETRY_CHANNEL_POWER] = toSampleValue(getHeaterPowerWatts());
+    sample.values[TELEMETRY_CHANNEL_PUMP] = toSampleValue(getCurrentFlowRate());
+
+    sample.phase = (runProcess == CHECKPOINT_RECTIFICATION) ?
+        (uint8_t)getRectificationPhase() : (uint8_t)getDistillationPhase();
+}
+
+// Инициализация журнала телеметрии
+bool initTelemetry() {
+    if (telemetryMutex == NULL) {
+        telemetryMutex = xSemaphoreCreateMutex();
+    }
+
+    bool ok = true;
+    for (int i = 0; i < TELEMETRY_LOG_COUNT; i++) {
+        // Журнал прежнего формата (один файл с заголовком) не читается
+        String legacyPath = String(logs[i].name) + ".bin";
+        if (LittleFS.exists(legacyPath)) {
+            LittleFS.remove(legacyPath);
+        }
+        if (!openLog(logs[i]) && !createLog(logs[i], CHECKPOINT_NONE, 0)) {
+            ok = false;
+        }
+    }
+
+    runProcess = logs[0].process;
+    Serial.print("Журнал телеметрии: записей по 10 с - ");
+    Serial.print(logs[0].count);
+    Serial.print(", по 1 мин - ");
+    Serial.println(logs[1].count);
+
+    #ifdef ESP32
+    if (writeQueue == NULL) {
+        writeQueue = xQueueCreate(TELEMETRY_WRITE_QUEUE, sizeof(TelemetryWrite));
+    }
+    if (writeQueue != NULL && telemetryTaskHandle == NULL) {
+        BaseType_t result = xTaskCreatePinnedToCore(telemetryTask, "telemetry", TELEMETRY_TASK_STACK_SIZE, NULL,
+                                                    TELEMETRY_TASK_PRIORITY, &telemetryTaskHandle, TELEMETRY_TASK_CORE);
+        if (result != pdPASS) {
+            telemetryTaskHandle = NULL;
+            Serial.println("Ошибка запуска задачи записи телеметрии");
+            ok = false;
+        }
+    }
+    #endif
+    return ok;
+}
+
+// Начало записи нового процесса
+void startTelemetryRun(uint8_t process) {
+    lockTelemetry(portMAX_DELAY);
+
+    sampleHead = 0;
+    sampleCount = 0;
+    runNumber++;
+
+    // Журналы недоступны для чтения, пока задача записи их не очистит;
+    // очистка ставится в очередь раньше агрегатов нового процесса.
+    // Идентификатор процесса входит в ETag выгрузки
+    uint32_t runId = esp_random();
+    for (int i = 0; i < TELEMETRY_LOG_COUNT; i++) {
+        logs[i].ready = false;
+        logs[i].pending = false;
+        logs[i].count = 0;
+        logs[i].process = process;
+        logs[i].runId = runId;
+    }
+    TelemetryWrite item;
+    memset(&item, 0, sizeof(item));
+    item.op = TELEMETRY_WRITE_RESET;
+    item.process = process;
+    item.run = runNumber;
+    item.runId = runId;
+    queueTelemetryWrite(item);
+
+    runProcess = process;
+    runStartMillis = millis();
+    runTimeOffset = 0;
+    lastSampleMillis = runStartMillis - TELEMETRY_SAMPLE_INTERVAL;
+    runActive = true;
+
+    unlockTelemetry();
+}
+
+// Продолжение записи после восстановления процесса
+void resumeTelemetryRun(uint8_t process) {
+    bool fileAccess = beginFileAccess();
+    lockTelemetry(portMAX_DELAY);
+
+    // Время продолжается после последней записи самого подробного журнала
+    bool sameRun = fileAccess && logs[0].ready && logs[0].process == process;
+    uint32_t lastTime = 0;
+    if (sameRun && rollupTime(logs[0], logs[0].count - 1, lastTime)) {
+        lastTime += logs[0].interval;
+    }
+
+    unlockTelemetry();
+    if (fileAccess) {
+        endFileAccess();
+    }
+
+    if (!sameRun) {
+        startTelemetryRun(process);
+        return;
+    }
+
+    lockTelemetry(portMAX_DELAY);
+    sampleHead = 0;
+    sampleCount = 0;
+    runNumber++;
+    runProcess = process;
+    runStartMillis = millis();
+    runTimeOffset = lastTime;
+    lastSampleMillis = runStartMillis - TELEMETRY_SAMPLE_INTERVAL;
+    runActive = true;
+    unlockTelemetry();
+}
+
+// Снятие отсчета
+void updateTelemetry() {
+    if (!runActive || millis() - lastSampleMillis < TELEMETRY_SAMPLE_INTERVAL) {
+        return;
+    }
+
+    // Цикл процесса не ждет, пока веб-сервер читает журнал; отсчет снимется на следующем проходе
+    if (!lockTelemetry(pdMS_TO_TICKS(TELEMETRY_LOCK_TIMEOUT_MS))) {
+        return;
+    }
+
+    lastSampleMillis = millis();
+
+    TelemetrySample& sample = samples[sampleHead];
+    takeSample(sample);
+    sampleHead = (sampleHead + 1) % TELEMETRY_RAM_SAMPLES;
+    if (sampleCount < TELEMETRY_RAM_SAMPLES) {
+        sampleCount++;
+    }
+
+    for (int i = 0; i < TELEMETRY_LOG_COUNT; i++) {
+        accumulateSample(i, sample);
+    }
+
+    unlockTelemetry();
+}
+
+// Диапазон отсчетов полной частоты в ОЗУ
+bool getTelemetrySampleRange(uint32_t& run, uint32_t& first, uint32_t& last) {
+    if (!lockTelemetry(pdMS_TO_TICKS(TELEMETRY_READ_TIMEOUT_MS))) {
+        return false;
+    }
+    bool found = sampleCount > 0;
+    if (found) {
+        run = runNumber;
+        first = samples[(sampleHead - sampleCount + TELEMETRY_RAM_SAMPLES) % TELEMETRY_RAM_SAMPLES].time;
+        last = samples[(sampleHead + TELEMETRY_RAM_SAMPLES - 1) % TELEMETRY_RAM_SAMPLES].time;
+    }
+    unlockTelemetry();
+    return found;
+}
+
+// Чтение отсчетов полной частоты из ОЗУ
+int readTelemetrySamples(uint32_t run, uint32_t from, TelemetrySample* out, int maxCount) {
+    if (!lockTelemetry(pdMS_TO_TICKS(TELEMETRY_READ_TIMEOUT_MS))) {
+        return 0;
+    }
+    int count = 0;
+    if (run == runNumber) {
+        int first = (sampleHead - sampleCount + TELEMETRY_RAM_SAMPLES) % TELEMETRY_RAM_SAMPLES;
+        for (int i = 0; i < sampleCount && count < maxCount; i++) {
+            const TelemetrySample& sample = samples[(first + i) % TELEMETRY_RAM_SAMPLES];
+            if (sample.time >= from) {
+                out[count++] = sample;
+            }
+        }
+    }
+    unlockTelemetry();
+    return count;
+}
+
+// Запись отсчетов в формате точек /api/telemetry
+void writeTelemetrySamples(JsonWriter& json, const TelemetrySample* samples, int count) {
+    json.beginArray();
+    for (int i = 0; i < count; i++) {
+        json.beginArray();
+        json.add(samples[i].time);
+        json.add((unsigned int)samples[i].phase);
+        json.beginArray();
+        for (int c = 0; c < TELEMETRY_CHANNELS; c++) {
+            int16_t value = samples[i].values[c];
+            if (value == TELEMETRY_NO_VALUE) {
+                json.add((const char*)nullptr);
+            } else if (c < MAX_TEMP_SENSORS) {
+                json.add((float)value / TELEMETRY_TEMP_SCALE);
+            } else {
+                json.add((int)value);
+            }
+        }
+        json.endArray();
+        json.endArray();
+    }
+    json.endArray();
+}
+
+// Сигнатура двоичной выгрузки
+#define TELEMETRY_EXPORT_MAGIC 0x44564831  // "DVH1"
+
+// Поиск первой записи журнала не раньше заданного времени
+static uint32_t findRollup(RollupReader& reader, const TelemetryLog& log, uint32_t time) {
+    uint32_t low = 0;
+    uint32_t high = log.count;
+    TelemetryRollup rollup;
+    while (low < high) {
+        uint32_t mid = (low + high) / 2;
+        if (readRollup(reader, log, mid, rollup) && rollup.time < time) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Индекс самого старого отсчета в ОЗУ
+static int oldestSample() {
+    return (sampleHead - sampleCount + TELEMETRY_RAM_SAMPLES) % TELEMETRY_RAM_SAMPLES;
+}
+
+// Записи журнала в диапазоне выгрузки. Запоминает процесс и время первой
+// записи: по ним продолжение выгрузки проверяет, что журнал не сдвинулся
+static uint32_t rollupsInRange(TelemetryExport& exp) {
+    const TelemetryLog& log = logs[exp.log];
+    RollupReader reader;
+    TelemetryRollup rollup;
+    uint32_t lower = findRollup(reader, log, exp.from);
+    uint32_t upper = findRollup(reader, log, exp.to + 1);
+    uint32_t count = upper > lower && readRollup(reader, log, lower, rollup) ? upper - lower : 0;
+    closeReader(reader);
+
+    exp.run = log.runId;
+    exp.firstTime = count > 0 ? rollup.time : 0;
+    return count;
+}
+
+// Выборка каждой stride-й записи журнала от начала диапазона
+static void setExportStride(TelemetryExport& exp, uint32_t inRange, uint32_t stride) {
+    exp.stride = stride > 1 ? stride : 1;
+    exp.total = (inRange + exp.stride - 1) / exp.stride;
+    exp.finished = exp.total == 0;
+}
+
+// Позиция следующей записи выгрузки в журнале; UINT32_MAX, если с начала
+// выгрузки журнал очищен или его начало вытеснило первую запись диапазона
+static uint32_t locateExportRollup(TelemetryExport& exp, RollupReader& reader) {
+    const TelemetryLog& log = logs[exp.log];
+    if (!log.ready || log.runId != exp.run) {
+        return UINT32_MAX;
+    }
+    TelemetryRollup rollup;
+    uint32_t lower = findRollup(reader, log, exp.from);
+    if (!readRollup(reader, log, lower, rollup) || rollup.time != exp.firstTime) {
+        return UINT32_MAX;
+    }
+    return lower + exp.records * exp.stride;
+}
+
+// Подготовка ответа /api/telemetry
+bool beginTelemetryQuery(TelemetryExport& exp, uint32_t from, uint32_t to, uint16_t maxPoints) {
+    if (maxPoints == 0) {
+        maxPoints = 1;
+    }
+    memset(&exp, 0, sizeof(exp));
+    exp.format = TELEMETRY_EXPORT_JSON;
+    exp.from = from;
+    exp.nextTime = from;
+
+    if (!beginFileAccess()) {
+        return false;
+    }
+    if (!lockTelemetry(pdMS_TO_TICKS(TELEMETRY_READ_TIMEOUT_MS))) {
+        endFileAccess();
+        return false;
+    }
+
+    // Конец диапазона ограничивается последним записанным временем
+    uint32_t latest = 0;
+    if (sampleCount > 0) {
+        latest = samples[(sampleHead + TELEMETRY_RAM_SAMPLES - 1) % TELEMETRY_RAM_SAMPLES].time;
+    } else if (rollupTime(logs[0], logs[0].count - 1, latest)) {
+        latest += logs[0].interval;
+    }
+    if (to > latest) {
+        to = latest;
+    }
+    if (to < from) {
+        to = from;
+    }
+    uint32_t span = to - from;
+
+    // Самое подробное разрешение, которое покрывает начало диапазона и укладывается в число точек
+    int resolution = -1;
+    uint16_t sampleSeconds = TELEMETRY_SAMPLE_INTERVAL / 1000;
+    if (sampleCount > 0 && from >= samples[oldestSample()].time && span / sampleSeconds < maxPoints) {
+        resolution = TELEMETRY_LOG_COUNT;
+    }
+    for (int i = 0; i < TELEMETRY_LOG_COUNT && resolution < 0; i++) {
+        uint32_t oldest;
+        if (rollupTime(logs[i], 0, oldest) && from >= oldest && span / logs[i].interval < maxPoints) {
+            resolution = i;
+        }
+    }
+    if (resolution < 0) {
+        // Диапазон не укладывается ни в одно разрешение - самый грубый журнал с прореживанием
+        resolution = logs[TELEMETRY_LOG_COUNT - 1].count > 0 ? TELEMETRY_LOG_COUNT - 1 :
+                     (sampleCount > 0 ? TELEMETRY_LOG_COUNT : 0);
+    }
+
+    // Отсчеты в ОЗУ прореживаются шагом по времени: кольцо сдвигается
+    // каждую секунду. Агрегаты - каждой stride-й записью от начала диапазона
+    exp.log = resolution;
+    exp.to = to;
+    if (resolution == TELEMETRY_LOG_COUNT) {
+        uint32_t inRange = 0;
+        int first = oldestSample();
+        for (int i = 0; i < sampleCount; i++) {
+            uint32_t time = samples[(first + i) % TELEMETRY_RAM_SAMPLES].time;
+            if (time >= from && time <= to) {
+                inRange++;
+            }
+        }
+        uint32_t stride = (inRange + maxPoints - 1) / maxPoints;
+        exp.run = runNumber;
+        exp.step = (stride > 1 ? stride : 1) * sampleSeconds;
+        exp.finished = inRange == 0;
+    } else {
+        uint32_t inRange = rollupsInRange(exp);
+        setExportStride(exp, inRange, (inRange + maxPoints - 1) / maxPoints);
+    }
+
+    unlockTelemetry();
+    endFileAccess();
+    return true;
+}
+
+// Добавление текста в строку выгрузки
+static void appendExportText(TelemetryExport& exp, const char* text) {
+    size_t length = strlen(text);
+    if (length > sizeof(exp.line) - exp.lineLength) {
+        length = sizeof(exp.line) - exp.lineLength;
+    }
+    memcpy(exp.line + exp.lineLength, text, length);
+    exp.lineLength += length;
+}
+
+// Добавление значения канала в строку CSV
+static void appendExportValue(TelemetryExport& exp, int channel, int16_t value) {
+    char text[16] = ",";
+    if (value != TELEMETRY_NO_VALUE) {
+        if (channel < MAX_TEMP_SENSORS) {
+            snprintf(text, sizeof(text), ",%.2f", (float)value / TELEMETRY_TEMP_SCALE);
+        } else {
+            snprintf(text, sizeof(text), ",%d", value);
+        }
+    }
+    appendExportText(exp, text);
+}
+
+// Добавление массива значений каналов в строку JSON
+static void appendJsonValues(TelemetryExport& exp, const int16_t* values) {
+    char text[16];
+    for (int c = 0; c < TELEMETRY_CHANNELS; c++) {
+        int16_t value = values[c];
+        const char* separator = c == 0 ? ",[" : ",";
+        if (value == TELEMETRY_NO_VALUE) {
+            snprintf(text, sizeof(text), "%snull", separator);
+        } else if (c < MAX_TEMP_SENSORS) {
+            snprintf(text, sizeof(text), "%s%.2f", separator, (float)value / TELEMETRY_TEMP_SCALE);
+        } else {
+            snprintf(text, sizeof(text), "%s%d", separator, value);
+        }
+        appendExportText(exp, text);
+    }
+    appendExportText(exp, "]");
+}
+
+// Начало точки JSON: [время,фаза
+static void appendJsonPoint(TelemetryExport& exp, uint32_t time, uint8_t phase) {
+    char text[32];
+    snprintf(text, sizeof(text), "%s[%lu,%u", exp.records > 0 ? "," : "", (unsigned long)time, phase);
+    appendExportText(exp, text);
+}
+
+// Заголовок выгрузки
+static void buildExportHeader(TelemetryExport& exp) {
+    if (exp.format == TELEMETRY_EXPORT_BIN) {
+        TelemetryExportHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = TELEMETRY_EXPORT_MAGIC;
+        header.recordSize = sizeof(TelemetryRollup);
+        header.step = exp.step;
+        header.channels = TELEMETRY_CHANNELS;
+        header.process = logs[exp.log].process;
+        header.tempScale = TELEMETRY_TEMP_SCALE;
+        header.from = exp.from;
+        header.to = exp.to;
+        memcpy(exp.line, &header, sizeof(header));
+        exp.lineLength = sizeof(header);
+        return;
+    }
+
+    if (exp.format == TELEMETRY_EXPORT_JSON) {
+        char text[80];
+        unsigned int resolution = exp.log == TELEMETRY_LOG_COUNT ?
+            TELEMETRY_SAMPLE_INTERVAL / 1000 : logs[exp.log].interval;
+        snprintf(text, sizeof(text), "{\"process\":%u,\"running\":%s,\"resolution\":%u,\"channels\":[",
+                 runProcess, runActive ? "true" : "false", resolution);
+        appendExportText(exp, text);
+        for (int i = 0; i < MAX_TEMP_SENSORS; i++) {
+            appendExportText(exp, "\"");
+            appendExportText(exp, getTempSensorName(i));
+            appendExportText(exp, "\",");
+        }
+        appendExportText(exp, "\"power\",\"pump\"],\"points\":[");
+        return;
+    }
+
+    static const char* const suffixes[] = { "_avg", "_min", "_max" };
+    appendExportText(exp, "time,phase");
+    for (int s = 0; s < 3; s++) {
+        for (int c = 0; c < TELEMETRY_CHANNELS; c++) {
+            appendExportText(exp, ",");
+            if (c < MAX_TEMP_SENSORS) {
+                appendExportText(exp, getTempSensorName(c));
+            } else {
+                appendExportText(exp, c == TELEMETRY_CHANNEL_POWER ? "power" : "pump");
+            }
+            appendExportText(exp, suffixes[s]);
+        }
+    }
+    appendExportText(exp, "\n");
+}
+
+// Строка выгрузки для записи журнала
+static void buildExportRecord(TelemetryExport& exp, const TelemetryRollup& rollup) {
+    if (exp.format == TELEMETRY_EXPORT_BIN) {
+        memcpy(exp.line, &rollup, sizeof(rollup));
+        exp.lineLength = sizeof(rollup);
+        return;
+    }
+
+    const int16_t* groups[] = { rollup.avgValues, rollup.minValues, rollup.maxValues };
+
+    if (exp.format == TELEMETRY_EXPORT_JSON) {
+        appendJsonPoint(exp, rollup.time, rollup.phase);
+        for (int s = 0; s < 3; s++) {
+            appendJsonValues(exp, groups[s]);
+        }
+        appendExportText(exp, "]");
+        return;
+    }
+
+    // Строка собирается без времени, затем сдвигается вправо, а время
+    // выравнивается пробелами по правому краю до TELEMETRY_CSV_ROW_SIZE
+    char text[24];
+    snprintf(text, sizeof(text), ",%u", rollup.phase);
+    appendExportText(exp, text);
+    for (int s = 0; s < 3; s++) {
+        for (int c = 0; c < TELEMETRY_CHANNELS; c++) {
+            appendExportValue(exp, c, groups[s][c]);
+        }
+    }
+    appendExportText(exp, "\n");
+
+    size_t width = TELEMETRY_CSV_ROW_SIZE - exp.lineLength;
+    memmove(exp.line + width, exp.line, exp.lineLength);
+    size_t length = snprintf(text, sizeof(text), "%lu", (unsigned long)rollup.time);
+    memset(exp.line, ' ', width - length);
+    memcpy(exp.line + width - length, text, length);
+    exp.lineLength = TELEMETRY_CSV_ROW_SIZE;
+}
+
+// Подготовка выгрузки журнала
+bool beginTelemetryExport(TelemetryExport& exp, uint8_t format, uint32_t from, uint32_t to,
+                          uint16_t step, uint32_t offset) {
+    memset(&exp, 0, sizeof(exp));
+    exp.format = format;
+    exp.log = step < logs[1].interval ? 0 : 1;
+    exp.from = from;
+
+    if (!beginFileAccess()) {
+        return false;
+    }
+    if (!lockTelemetry(pdMS_TO_TICKS(TELEMETRY_READ_TIMEOUT_MS))) {
+        endFileAccess();
+        return false;
+    }
+
+    const TelemetryLog& log = logs[exp.log];
+    uint32_t last = 0;
+    bool found = rollupTime(log, log.count - 1, last);
+    exp.to = to > last ? last : to;
+
+    uint32_t stride = step / log.interval;
+    exp.step = (stride > 1 ? stride : 1) * log.interval;
+    setExportStride(exp, found && from <= exp.to ? rollupsInRange(exp) : 0, stride);
+    unlockTelemetry();
+    endFileAccess();
+
+    // Все записи одной длины, поэтому размер и позиция продолжения
+    // вычисляются по числу записей без формирования выгрузки
+    buildExportHeader(exp);
+    uint32_t headerLength = exp.lineLength;
+    uint32_t recordSize = format == TELEMETRY_EXPORT_BIN ? sizeof(TelemetryRollup) : TELEMETRY_CSV_ROW_SIZE;
+    exp.lineLength = 0;
+    exp.size = headerLength + exp.total * recordSize;
+    snprintf(exp.tag, sizeof(exp.tag), "\"%08lx-%lx-%lx\"",
+             (unsigned long)exp.run, (unsigned long)exp.firstTime, (unsigned long)exp.size);
+
+    if (offset >= headerLength) {
+        exp.headerDone = true;
+        exp.records = (offset - headerLength) / recordSize;
+        exp.skip = (offset - headerLength) % recordSize;
+        if (exp.records >= exp.total) {
+            exp.finished = true;
+        }
+    } else {
+        exp.skip = offset;
+    }
+    return true;
+}
+
+// Следующий агрегат журнала для выгрузки
+static bool nextExportRollup(TelemetryExport& exp, RollupReader& reader, uint32_t& order) {
+    const TelemetryLog& log = logs[exp.log];
+    TelemetryRollup rollup;
+    if (exp.records >= exp.total || order >= log.count || !readRollup(reader, log, order, rollup)) {
+        return false;
+    }
+    buildExportRecord(exp, rollup);
+    order += exp.stride;
+    exp.records++;
+    return true;
+}
+
+// Следующий отсчет из ОЗУ для ответа /api/telemetry
+static bool nextExportSample(TelemetryExport& exp, uint32_t& order) {
+    // Кольцо отсчетов сброшено новым процессом
+    if (exp.run != runNumber) {
+        return false;
+    }
+    int first = oldestSample();
+    while (order < (uint32_t)sampleCount) {
+        const TelemetrySample& sample = samples[(first + order) % TELEMETRY_RAM_SAMPLES];
+        order++;
+        if (sample.time >= exp.nextTime) {
+            if (sample.time > exp.to) {
+                return false;
+            }
+            appendJsonPoint(exp, sample.time, sample.phase);
+            appendJsonValues(exp, sample.values);
+            appendExportText(exp, "]");
+            exp.nextTime = sample.time + exp.step;
+            exp.records++;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Подготовка следующей строки выгрузки
+static bool nextExportLine(TelemetryExport& exp, RollupReader& reader, bool& positioned, uint32_t& order) {
+    exp.lineLength = 0;
+    exp.linePos = 0;
+
+    if (!exp.headerDone) {
+        buildExportHeader(exp);
+        exp.headerDone = true;
+        return true;
+    }
+
+    if (!exp.finished) {
+        bool fromSamples = exp.log == TELEMETRY_LOG_COUNT;
+        if (!positioned) {
+            // Отсчеты ищутся по времени, агрегаты - по номеру от первой записи
+            // диапазона, поэтому новые записи между частями позицию не сдвигают
+            order = fromSamples ? 0 : locateExportRollup(exp, reader);
+            positioned = true;
+        }
+        // Внутри части журнал не меняется, следующие записи читаются подряд
+        bool found = fromSamples ? nextExportSample(exp, order) : nextExportRollup(exp, reader, order);
+        if (found) {
+            return true;
+        }
+        exp.finished = true;
+    }
+
+    if (exp.format == TELEMETRY_EXPORT_JSON && !exp.footerDone) {
+        appendExportText(exp, "]}");
+        exp.footerDone = true;
+        return true;
+    }
+    return false;
+}
+
+// Чтение очередной части выгрузки
+size_t readTelemetryExport(TelemetryExport& exp, uint8_t* buffer, size_t maxLen) {
+    bool fileAccess = beginFileAccess();
+    if (!lockTelemetry(pdMS_TO_TICKS(TELEMETRY_LOCK_TIMEOUT_MS))) {
+        if (fileAccess) {
+            endFileAccess();
+        }
+        return TELEMETRY_EXPORT_BUSY;
+    }
+
+    // Пока доступ к файлам закрыт, выгрузка агрегатов завершается
+    if (!fileAccess && exp.log < TELEMETRY_LOG_COUNT) {
+        exp.finished = true;
+    }
+
+    RollupReader reader;
+    bool positioned = false;
+    uint32_t order = 0;
+    size_t length = 0;
+
+    while (length < maxLen) {
+        if (exp.linePos < exp.lineLength) {
+            size_t count = exp.lineLength - exp.linePos;
+            if (count > maxLen - length) {
+                count = maxLen - length;
+            }
+            memcpy(buffer + length, exp.line + exp.linePos, count);
+            exp.linePos += count;
+            length += count;
+            continue;
+        }
+
+        if (!nextExportLine(exp, reader, positioned, order)) {
+            break;
+        }
+
+        // Уже полученная клиентом часть пропускается
+        if (exp.skip >= exp.lineLength) {
+            exp.skip -= exp.lineLength;
+            exp.linePos = exp.lineLength;
+        } else {
+            exp.linePos = exp.skip;
+            exp.skip = 0;
+        }
+    }
+
+    closeReader(reader);
+    unlockTelemetry();
+    if (fileAccess) {
+        endFileAccess();
+    }
+    return length;
+}
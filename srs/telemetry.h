@@ -0,0 +1,228 @@
+/**
+ * @file telemetry.h
+ * @brief Журнал телеметрии процесса
+ *
+ * Во время процесса раз в секунду снимаются температуры всех датчиков,
+ * мощность нагревателя, скорость насоса и фаза. Последние отсчеты полной
+ * частоты хранятся в кольце в ОЗУ, а агрегаты за 10 с и 1 мин
+ * (минимум, максимум, среднее) записываются в два журнала на LittleFS.
+ * Каждый журнал - кольцо из нескольких файлов, в которые записи только
+ * дописываются, поэтому занимаемое место ограничено независимо от
+ * длительности процесса. Запись во флеш-память выполняет отдельная задача
+ * с низким приоритетом, цикл процесса ее не ждет.
+ *
+ * Запрос диапазона выбирает самое подробное разрешение, которое покрывает
+ * диапазон и укладывается в заданное число точек, что позволяет заново
+ * открытой странице загрузить график всего процесса одним запросом.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "settings.h"
+
+class JsonWriter;
+
+// Каналы: датчики температуры, мощность (Вт), скорость насоса (мл/ч)
+#define TELEMETRY_CHANNEL_POWER MAX_TEMP_SENSORS
+#define TELEMETRY_CHANNEL_PUMP (MAX_TEMP_SENSORS + 1)
+#define TELEMETRY_CHANNELS (MAX_TEMP_SENSORS + 2)
+
+// Отсутствующее значение (датчик отключен)
+#define TELEMETRY_NO_VALUE INT16_MIN
+
+// Масштаб температур в отсчетах (сотые доли градуса)
+#define TELEMETRY_TEMP_SCALE 100
+
+// Отсчет полной частоты
+struct TelemetrySample {
+    uint32_t time;                          // Время от начала процесса (секунды)
+    int16_t values[TELEMETRY_CHANNELS];     // Значения каналов
+    uint8_t phase;                          // Фаза процесса
+    uint8_t reserved;
+};
+
+// Агрегат за интервал
+struct TelemetryRollup {
+    uint32_t time;                          // Начало интервала от начала процесса (секунды)
+    uint8_t phase;                          // Фаза в конце интервала
+    uint8_t count;                          // Количество отсчетов в интервале
+    uint16_t reserved;
+    int16_t minValues[TELEMETRY_CHANNELS];  // Минимумы
+    int16_t maxValues[TELEMETRY_CHANNELS];  // Максимумы
+    int16_t avgValues[TELEMETRY_CHANNELS];  // Средние
+};
+
+// Формат выгрузки журнала
+enum TelemetryExportFormat {
+    TELEMETRY_EXPORT_CSV = 0,
+    TELEMETRY_EXPORT_BIN,
+    TELEMETRY_EXPORT_JSON      // Ответ /api/telemetry
+};
+
+// Результат чтения выгрузки, когда журнал занят записью
+#define TELEMETRY_EXPORT_BUSY ((size_t)-1)
+
+// Размер буфера строки выгрузки
+#define TELEMETRY_EXPORT_LINE_SIZE 512
+
+// Размер ETag выгрузки
+#define TELEMETRY_EXPORT_TAG_SIZE 32
+
+// Заголовок двоичной выгрузки, за ним следуют записи TelemetryRollup
+struct TelemetryExportHeader {
+    uint32_t magic;            // Сигнатура "DVH1"
+    uint16_t recordSize;       // Размер записи
+    uint16_t step;             // Шаг между записями (секунды)
+    uint8_t channels;          // Количество каналов
+    uint8_t process;           // Тип процесса (CheckpointProcess)
+    uint16_t tempScale;        // Масштаб температур
+    uint32_t from;             // Начало диапазона (секунды)
+    uint32_t to;               // Конец диапазона (секунды)
+};
+
+// Состояние выгрузки журнала
+struct TelemetryExport {
+    uint8_t format;            // TelemetryExportFormat
+    uint8_t log;               // Журнал (0 - 10 с, 1 - 1 мин, 2 - отсчеты в ОЗУ)
+    uint16_t step;             // Шаг между записями (секунды)
+    uint32_t from;             // Начало диапазона (секунды)
+    uint32_t to;               // Конец диапазона (секунды)
+    uint32_t nextTime;         // Время следующего отсчета из ОЗУ
+    uint32_t stride;           // Выдается каждая stride-я запись журнала
+    uint32_t total;            // Записей журнала в выгрузке
+    uint32_t firstTime;        // Время первой записи журнала в диапазоне
+    uint32_t size;             // Размер выгрузки CSV или двоичной (байт)
+    uint32_t skip;             // Сколько байт пропустить (продолжение загрузки)
+    bool headerDone;           // Заголовок выдан
+    bool finished;             // Записи закончились
+    bool footerDone;           // Окончание JSON выдано
+    uint32_t records;          // Выдано записей
+    uint32_t run;              // Номер записи отсчетов в ОЗУ или идентификатор процесса журнала
+    uint16_t lineLength;       // Длина подготовленной строки
+    uint16_t linePos;          // Выданная часть строки
+    char tag[TELEMETRY_EXPORT_TAG_SIZE];  // ETag выгрузки CSV или двоичной
+    char line[TELEMETRY_EXPORT_LINE_SIZE];
+};
+
+/**
+ * @brief Инициализация журнала телеметрии
+ *
+ * Журналы последнего процесса остаются доступными для запросов после
+ * перезагрузки.
+ *
+ * @return true если журналы на LittleFS доступны
+ */
+bool initTelemetry();
+
+/**
+ * @brief Начало записи нового процесса (журналы предыдущего очищаются)
+ *
+ * @param process Тип процесса (CheckpointProcess)
+ */
+void startTelemetryRun(uint8_t process);
+
+/**
+ * @brief Продолжение записи после восстановления процесса
+ *
+ * Время продолжается от последней записи журнала, если журнал
+ * принадлежит тому же типу процесса; иначе начинается новая запись.
+ *
+ * @param process Тип процесса (CheckpointProcess)
+ */
+void resumeTelemetryRun(uint8_t process);
+
+/**
+ * @brief Снятие отсчета, вызывается в цикле обработки процесса
+ */
+void updateTelemetry();
+
+/**
+ * @brief Диапазон отсчетов полной частоты в ОЗУ
+ *
+ * Номер записи меняется, когда кольцо отсчетов сбрасывается (начало или
+ * продолжение процесса), поэтому время отсчета вместе с номером записи
+ * однозначно определяет отсчет.
+ *
+ * @param run Номер записи
+ * @param first Время самого старого отсчета (секунды от начала процесса)
+ * @param last Время последнего отсчета
+ * @return false если отсчетов нет или журнал занят
+ */
+bool getTelemetrySampleRange(uint32_t& run, uint32_t& first, uint32_t& last);
+
+/**
+ * @brief Чтение отсчетов полной частоты из ОЗУ
+ *
+ * @param run Номер записи (getTelemetrySampleRange); если запись сменилась, отсчеты не читаются
+ * @param from Время первого отсчета (секунды от начала процесса)
+ * @param out Буфер отсчетов, от старых к новым
+ * @param maxCount Размер буфера
+ * @return Количество прочитанных отсчетов
+ */
+int readTelemetrySamples(uint32_t run, uint32_t from, TelemetrySample* out, int maxCount);
+
+/**
+ * @brief Запись отсчетов массивом [[время,фаза,[значения каналов]],...]
+ *
+ * Формат совпадает с точками /api/telemetry; используется потоком
+ * событий SSE и мостом MQTT.
+ */
+void writeTelemetrySamples(JsonWriter& json, const TelemetrySample* samples, int count);
+
+/**
+ * @brief Подготовка ответа /api/telemetry (JSON)
+ *
+ * Выбирает разрешение и шаг прореживания; сам ответ читается частями
+ * через readTelemetryExport(), поэтому память не зависит от числа точек.
+ *
+ * @param exp Состояние выгрузки
+ * @param from Начало диапазона (секунды от начала процесса)
+ * @param to Конец диапазона (секунды от начала процесса), ограничивается последним отсчетом
+ * @param maxPoints Максимальное количество точек
+ * @return false если журнал занят дольше допустимого ожидания или доступ
+ *         к файлам закрыт (fs_gate.h)
+ */
+bool beginTelemetryQuery(TelemetryExport& exp, uint32_t from, uint32_t to, uint16_t maxPoints);
+
+/**
+ * @brief Подготовка выгрузки журнала
+ *
+ * Шаг меньше минуты выгружается из журнала 10 с, иначе из журнала 1 мин;
+ * шаг округляется вниз до кратного интервалу журнала. Конец диапазона
+ * фиксируется по последней записи журнала, чтобы повторный запрос с тем же
+ * диапазоном давал те же байты.
+ *
+ * Строки CSV дополняются пробелами до одной длины, поэтому размер
+ * выгрузки (exp.size) и позиция продолжения вычисляются по числу записей.
+ * ETag (exp.tag) меняется, если журнал очищен новым процессом или
+ * вытеснил первую запись диапазона; такая выгрузка при чтении обрывается.
+ *
+ * @param exp Состояние выгрузки
+ * @param format Формат (TELEMETRY_EXPORT_CSV или TELEMETRY_EXPORT_BIN)
+ * @param from Начало диапазона (секунды от начала процесса)
+ * @param to Конец диапазона (секунды от начала процесса)
+ * @param step Шаг между записями (секунды)
+ * @param offset Смещение в байтах, с которого начинается выдача
+ * @return false если журнал занят дольше допустимого ожидания или доступ
+ *         к файлам закрыт (fs_gate.h)
+ */
+bool beginTelemetryExport(TelemetryExport& exp, uint8_t format, uint32_t from, uint32_t to,
+                          uint16_t step, uint32_t offset);
+
+/**
+ * @brief Чтение очередной части выгрузки
+ *
+ * Журнал блокируется только на время чтения одной части, запись отсчетов
+ * между частями не задерживается.
+ * Пока доступ к файлам закрыт, выгрузка агрегатов завершается.
+ *
+ * @param exp Состояние выгрузки
+ * @param buffer Буфер
+ * @param maxLen Размер буфера
+ * @return Количество байт, 0 в конце выгрузки или TELEMETRY_EXPORT_BUSY
+ */
+size_t readTelemetryExport(TelemetryExport& exp, uint8_t* buffer, size_t maxLen);
+
+#endif // TELEMETRY_H
@@ -3,6 +3,8 @@
 #include <DallasTemperature.h>
 #include "config.h"
 #include "utils.h"
+#include "safety.h"
+#include "fault_injection.h"
 
 // Создаем экземпляр класса для работы с OneWire
 OneWire oneWire(PIN_TEMP_SENSORS);
@@ -25,6 +27,9 @@ unsigned long lastSensorScanTime = 0;
 // Количество найденных датчиков
 int connectedSensorsCount = 0;
 
+// Статистика опроса датчиков
+static TempSensorStats sensorStats;
+
 // Имена датчиков температуры
 const char* tempSensorNames[MAX_TEMP_SENSORS] = {
     "Куб",
@@ -100,6 +105,8 @@ void initTempSensors() {
 
 // Обновление показаний датчиков
 void updateTemperatures() {
+    unsigned long startMicros = micros();
+    
     // Запрашиваем преобразование температуры на всех датчиках
     tempSensors.requestTemperatures();
     
@@ -112,11 +119,18 @@ void updateTemperatures() {
             // Применяем калибровку
             temp += sysSettings.tempSensorCalibration[i];
             
+            #ifdef FAULT_INJECTION
+            temp = injectTemperatureFault(i, temp);
+            #endif
+            
             // Проверяем, что температура в разумных пределах
             if (temp > -55.0 && temp < 125.0) {
                 temperatures[i] = temp;
                 lastTempUpdate[i] = millis();
             } else {
+                // Библиотека возвращает -127 при ошибке CRC и отсутствии ответа
+                sensorStats.readErrors[i]++;
+                
                 // Если получено недействительное значение, проверяем, как давно обновлялась температура
                 if (millis() - lastTempUpdate[i] > 10000) {
                     // Если больше 10 секунд нет данных, считаем датчик отключенным
@@ -125,6 +139,15 @@ void updateTemperatures() {
             }
         }
     }
+    
+    sensorStats.lastReadMicros = micros() - startMicros;
+    if (sensorStats.lastReadMicros > sensorStats.maxReadMicros) {
+        sensorStats.maxReadMicros = sensorStats.lastReadMicros;
+    }
+    sensorStats.reads++;
+    
+    // Новый снимок показаний сразу проверяется задачей безопасности
+    notifySafetySnapshot();
 }
 
 // Поиск и установка адресов датчиков
@@ -275,9 +298,14 @@ float getTemperatureRateOfChange(int sensorIndex, float periodSeconds) {
 }
 
 // Получение имени датчика
-String getTempSensorName(int sensorIndex) {
+const char* getTempSensorName(int sensorIndex) {
     if (sensorIndex >= 0 && sensorIndex < MAX_TEMP_SENSORS) {
-        return String(tempSensorNames[sensorIndex]);
+        return tempSensorNames[sensorIndex];
     }
     return "Неизвестный";
-}
\ No newline at end of file
+}
+
+// Получение статистики опроса датчиков
+const TempSensorStats& getTempSensorStats() {
+    return sensorStats;
+}
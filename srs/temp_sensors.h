@@ -21,6 +21,14 @@
 #define TEMP_TSA        3   // ТСА (теплообменник)
 #define TEMP_WATER_OUT  4   // Выход воды
 
+// Статистика опроса датчиков
+struct TempSensorStats {
+    unsigned long reads;                        // Количество опросов
+    unsigned long lastReadMicros;               // Длительность последнего опроса (мкс)
+    unsigned long maxReadMicros;                // Максимальная длительность опроса (мкс)
+    unsigned long readErrors[MAX_TEMP_SENSORS]; // Ошибочные чтения (CRC 1-Wire, нет ответа, вне диапазона)
+};
+
 /**
  * @brief Инициализация датчиков температуры
  */
@@ -103,6 +111,13 @@ float getTemperatureRateOfChange(int sensorIndex, float periodSeconds);
  * @param sensorIndex Индекс датчика
  * @return Имя датчика
  */
-String getTempSensorName(int sensorIndex);
+const char* getTempSensorName(int sensorIndex);
+
+/**
+ * @brief Получение статистики опроса датчиков
+ * 
+ * @return Счетчики опросов, длительность и ошибки чтения
+ */
+const TempSensorStats& getTempSensorStats();
 
 #endif // TEMP_SENSORS_H
\ No newline at end of file
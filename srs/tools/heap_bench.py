@@ -0,0 +1,105 @@
+"""
+Проверка фрагментации кучи под нагрузкой на /api/status.
+
+Опрашивает /api/status с заданной частотой и периодически снимает
+/api/web/stats: свободную память, минимум свободной памяти и наибольший
+свободный блок. В конце выводит изменение этих величин за прогон, число
+ошибок и время ответа. При отсутствии выделений памяти в обработчике
+свободная память и наибольший блок не должны дрейфовать.
+
+    python srs/tools/heap_bench.py 192.168.4.1 --rate 10 --duration 3600
+"""
+
+import argparse
+import http.client
+import json
+import time
+
+
+def get(host, path):
+    connection = http.client.HTTPConnection(host, timeout=10)
+    try:
+        connection.request("GET", path)
+        response = connection.getresponse()
+        body = response.read()
+        return response.status, body
+    finally:
+        connection.close()
+
+
+def heap_sample(host):
+    status, body = get(host, "/api/web/stats")
+    if status != 200:
+        return None
+    stats = json.loads(body)
+    return {
+        "free": stats["freeHeap"],
+        "minFree": stats["minFreeHeap"],
+        "maxAlloc": stats.get("maxAllocHeap", 0),
+        "pool": stats.get("jsonPool", {}),
+    }
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="адрес контроллера")
+    parser.add_argument("--rate", type=float, default=10.0, help="запросов /api/status в секунду")
+    parser.add_argument("--duration", type=float, default=3600.0, help="длительность прогона (с)")
+    parser.add_argument("--sample", type=float, default=60.0, help="период снятия статистики памяти (с)")
+    args = parser.parse_args()
+
+    period = 1.0 / args.rate
+    samples = [heap_sample(args.host)]
+    print("начало: свободно %(free)d, наибольший блок %(maxAlloc)d, минимум %(minFree)d" % samples[0])
+
+    latencies = []
+    errors = 0
+    started = time.monotonic()
+    next_request = started
+    next_sample = started + args.sample
+    while time.monotonic() - started < args.duration:
+        now = time.monotonic()
+        if now < next_request:
+            time.sleep(next_request - now)
+        next_request += period
+
+        request_started = time.monotonic()
+        try:
+            status, _ = get(args.host, "/api/status")
+            if status != 200:
+                errors += 1
+        except OSError:
+            errors += 1
+        latencies.append(time.monotonic() - request_started)
+
+        if time.monotonic() >= next_sample:
+            next_sample += args.sample
+            sample = heap_sample(args.host)
+            if sample:
+                samples.append(sample)
+                print("%6.0f с: свободно %d, наибольший блок %d, минимум %d, буферов JSON занято максимум %s" % (
+                    time.monotonic() - started, sample["free"], sample["maxAlloc"], sample["minFree"],
+                    sample["pool"].get("maxInUse", "-")))
+
+    samples.append(heap_sample(args.host))
+    first, last = samples[0], samples[-1]
+    print("запросов: %d, ошибок: %d" % (len(latencies), errors))
+    print("время ответа: медиана %.1f мс, p99 %.1f мс, максимум %.1f мс" % (
+        percentile(latencies, 0.5) * 1000, percentile(latencies, 0.99) * 1000, max(latencies) * 1000))
+    print("изменение свободной памяти: %+d байт" % (last["free"] - first["free"]))
+    print("изменение наибольшего блока: %+d байт" % (last["maxAlloc"] - first["maxAlloc"]))
+    print("минимум свободной памяти за прогон: %d байт" % min(s["minFree"] for s in samples))
+    pool = last["pool"]
+    if pool:
+        print("пул JSON: нехватка буферов %d, переполнений %d" % (pool.get("exhausted", 0), pool.get("overflows", 0)))
+
+
+if __name__ == "__main__":
+    main()
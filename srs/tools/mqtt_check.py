@@ -0,0 +1,222 @@
+"""
+Проверка моста MQTT через брокер (например, mosquitto на компьютере).
+
+Подписывается на <prefix>/# и в течение прогона считает статусы, пакеты
+телеметрии и ответы на команды. Для каждой записи телеметрии проверяется
+непрерывность времени отсчетов: после перезапуска брокера (или отключения
+WiFi) контроллер должен дослать накопленные отсчеты без пропусков и повторов.
+Скрипт сам переподключается к брокеру. С параметром --command отправляет
+команду и печатает ответ.
+
+    mosquitto -p 1883 -v
+    python srs/tools/mqtt_check.py 192.168.1.10 --prefix drivevision/a1b2c3 --duration 300
+    python srs/tools/mqtt_check.py localhost --prefix drivevision/a1b2c3 \\
+        --command heater.set --params '{"power":500}'
+
+Используется только стандартная библиотека (MQTT 3.1.1, QoS 0/1).
+"""
+
+import argparse
+import json
+import os
+import socket
+import struct
+import time
+
+KEEPALIVE = 30
+
+
+def encode_length(length):
+    result = bytearray()
+    while True:
+        byte = length % 128
+        length //= 128
+        result.append(byte | (0x80 if length else 0))
+        if not length:
+            return bytes(result)
+
+
+def encode_string(value):
+    data = value.encode()
+    return struct.pack("!H", len(data)) + data
+
+
+def packet(header, body):
+    return bytes([header]) + encode_length(len(body)) + body
+
+
+class Connection:
+    def __init__(self, host, port, client_id):
+        self.sock = socket.create_connection((host, port), timeout=10)
+        body = encode_string("MQTT") + bytes([4, 0x02]) + struct.pack("!H", KEEPALIVE) + encode_string(client_id)
+        self.sock.sendall(packet(0x10, body))
+        header, data = self.read_packet()
+        if header >> 4 != 2 or data[1] != 0:
+            raise ConnectionError("брокер отклонил подключение")
+        self.last_send = time.monotonic()
+
+    def read_packet(self, header=None):
+        """Пакет брокера: первый байт (тип и флаги) и тело."""
+        if header is None:
+            header = self.recv_exact(1)[0]
+        length, shift = 0, 0
+        while True:
+            byte = self.recv_exact(1)[0]
+            length += (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        return header, self.recv_exact(length) if length else b""
+
+    def recv_exact(self, size):
+        data = b""
+        while len(data) < size:
+            chunk = self.sock.recv(size - len(data))
+            if not chunk:
+                raise ConnectionError("брокер закрыл соединение")
+            data += chunk
+        return data
+
+    def send(self, data):
+        self.sock.sendall(data)
+        self.last_send = time.monotonic()
+
+    def subscribe(self, topic):
+        self.send(packet(0x82, struct.pack("!H", 1) + encode_string(topic) + bytes([1])))
+
+    def publish(self, topic, payload):
+        self.send(packet(0x30, encode_string(topic) + payload))
+
+    def poll(self, timeout):
+        """Следующее сообщение (topic, payload) или None по таймауту."""
+        if time.monotonic() - self.last_send > KEEPALIVE / 2:
+            self.send(bytes([0xC0, 0]))
+        # Таймаут только на начало пакета, чтобы не разорвать чтение посередине
+        self.sock.settimeout(timeout)
+        try:
+            first = self.recv_exact(1)[0]
+        except socket.timeout:
+            return None
+        finally:
+            self.sock.settimeout(10)
+        header, data = self.read_packet(first)
+        if header >> 4 != 3:
+            return None
+        qos = (header >> 1) & 0x03
+        topic_length = struct.unpack("!H", data[:2])[0]
+        topic = data[2:2 + topic_length].decode()
+        offset = 2 + topic_length
+        if qos:
+            packet_id = data[offset:offset + 2]
+            offset += 2
+            self.send(packet(0x40, packet_id))
+        return topic, data[offset:]
+
+    def close(self):
+        try:
+            self.send(bytes([0xE0, 0]))
+        except OSError:
+            pass
+        self.sock.close()
+
+
+class Report:
+    def __init__(self):
+        self.status = 0
+        self.telemetry = 0
+        self.samples = 0
+        self.gaps = []
+        self.duplicates = 0
+        self.runs = {}
+        self.online = []
+
+    def telemetry_message(self, payload):
+        message = json.loads(payload)
+        run = message["run"]
+        self.telemetry += 1
+        for sample in message["samples"]:
+            time_s = sample[0]
+            last = self.runs.get(run)
+            if last is not None:
+                if time_s <= last:
+                    self.duplicates += 1
+                    continue
+                if time_s != last + 1:
+                    self.gaps.append((run, last + 1, time_s - 1))
+            self.runs[run] = time_s
+            self.samples += 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("broker", help="адрес брокера")
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--prefix", required=True, help="префикс топиков контроллера")
+    parser.add_argument("--duration", type=float, default=60.0, help="длительность прогона (с)")
+    parser.add_argument("--command", help="метод RPC для отправки в <prefix>/cmd/<метод>")
+    parser.add_argument("--params", default="", help="параметры команды (JSON)")
+    args = parser.parse_args()
+
+    prefix = args.prefix.rstrip("/")
+    client_id = "mqtt-check-%s" % os.urandom(3).hex()
+    report = Report()
+    command_sent = False
+    deadline = time.monotonic() + args.duration
+    connection = None
+
+    while time.monotonic() < deadline:
+        if connection is None:
+            try:
+                connection = Connection(args.broker, args.port, client_id)
+                connection.subscribe(prefix + "/#")
+                print("подключено к брокеру")
+            except OSError as error:
+                print("нет связи с брокером: %s" % error)
+                time.sleep(2)
+                continue
+
+        if args.command and not command_sent:
+            connection.publish("%s/cmd/%s" % (prefix, args.command), args.params.encode())
+            command_sent = True
+
+        try:
+            message = connection.poll(1.0)
+        except OSError as error:
+            print("связь с брокером потеряна: %s" % error)
+            connection.sock.close()
+            connection = None
+            continue
+        if message is None:
+            continue
+
+        topic, payload = message
+        suffix = topic[len(prefix) + 1:]
+        if suffix == "status":
+            report.status += 1
+        elif suffix == "telemetry":
+            report.telemetry_message(payload)
+        elif suffix == "online":
+            report.online.append(payload.decode())
+            print("online: %s" % payload.decode())
+        elif suffix.startswith("reply/"):
+            print("%s: %s" % (suffix, payload.decode()))
+            if args.command and suffix == "reply/" + args.command:
+                deadline = min(deadline, time.monotonic() + 1)
+
+    if connection is not None:
+        connection.close()
+
+    print()
+    print("статусов: %d" % report.status)
+    print("пакетов телеметрии: %d, отсчетов: %d, повторов: %d" % (report.telemetry, report.samples, report.duplicates))
+    for run, last in sorted(report.runs.items()):
+        print("запись %d: последний отсчет %d с" % (run, last))
+    if report.gaps:
+        for run, start, end in report.gaps:
+            print("пропуск в записи %d: %d..%d с" % (run, start, end))
+    else:
+        print("пропусков нет")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,95 @@
+"""
+Обновление прошивки или файловой системы контроллера через /api/ota.
+
+Считает SHA-256 образа, передает его потоком (application/octet-stream) и
+ждет перезагрузки контроллера. После обновления прошивки печатает состояние
+проверки новой прошивки из GET /api/ota: через OTA_HEALTH_CHECK_MS она либо
+подтверждается, либо загрузчик возвращает предыдущую.
+
+    python srs/tools/ota_upload.py 192.168.4.1 .pio/build/esp32dev/firmware.bin
+    python srs/tools/ota_upload.py 192.168.4.1 .pio/build/esp32dev/littlefs.bin --type filesystem
+"""
+
+import argparse
+import hashlib
+import http.client
+import json
+import os
+import time
+
+
+def sha256_file(path):
+    digest = hashlib.sha256()
+    with open(path, "rb") as image:
+        for block in iter(lambda: image.read(65536), b""):
+            digest.update(block)
+    return digest.hexdigest()
+
+
+def upload(host, path, image_type, sha256):
+    size = os.path.getsize(path)
+    connection = http.client.HTTPConnection(host, timeout=60)
+    try:
+        with open(path, "rb") as image:
+            connection.request("POST", "/api/ota?type=%s&sha256=%s" % (image_type, sha256), body=image,
+                               headers={"Content-Type": "application/octet-stream", "Content-Length": str(size)})
+        response = connection.getresponse()
+        return response.status, response.read().decode()
+    finally:
+        connection.close()
+
+
+def ota_status(host):
+    connection = http.client.HTTPConnection(host, timeout=5)
+    try:
+        connection.request("GET", "/api/ota")
+        response = connection.getresponse()
+        return json.loads(response.read())
+    finally:
+        connection.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="адрес контроллера")
+    parser.add_argument("image", help="файл образа")
+    parser.add_argument("--type", choices=["firmware", "filesystem"], default="firmware")
+    parser.add_argument("--sha256", help="SHA-256 для передачи вместо вычисленного (проверка отказа)")
+    parser.add_argument("--wait", type=float, default=120.0, help="ожидание перезагрузки и проверки (с)")
+    args = parser.parse_args()
+
+    sha256 = args.sha256 or sha256_file(args.image)
+    print("образ %s: %d байт, sha256 %s" % (args.image, os.path.getsize(args.image), sha256))
+
+    target = ota_status(args.host).get("next") if args.type == "firmware" else None
+
+    started = time.monotonic()
+    status, body = upload(args.host, args.image, args.type, sha256)
+    print("ответ %d за %.1f с: %s" % (status, time.monotonic() - started, body))
+    if status != 200 or args.type != "firmware":
+        return
+
+    # Состояние читается после перезагрузки: до нее отвечает прежняя прошивка
+    rebooted = False
+    deadline = time.monotonic() + args.wait
+    while time.monotonic() < deadline:
+        time.sleep(2)
+        try:
+            state = ota_status(args.host)
+        except (OSError, ValueError):
+            rebooted = True
+            continue
+        if not rebooted:
+            continue
+        print("раздел %s, проверка: %s" % (state.get("running"), state.get("healthCheckPending")))
+        if state.get("running") != target:
+            print("новая прошивка не прошла проверку, откат к разделу %s" % state.get("running"))
+            return
+        if not state.get("healthCheckPending"):
+            print("новая прошивка подтверждена")
+            return
+    print("проверка новой прошивки не завершилась за %.0f с" % args.wait)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,186 @@
+"""
+Сборка статических ресурсов веб-интерфейса во флеш-память.
+
+Ресурсы из srs/data минифицируются, сжимаются gzip и записываются в
+srs/web_assets.h массивами PROGMEM. Стили и скрипты получают имена с хешем
+содержимого (styles.1a2b3c4d.css), ссылки на них в index.html заменяются,
+поэтому такие ресурсы кэшируются браузером без перепроверки. Для каждого
+ресурса вычисляется строгий ETag.
+
+Запускается PlatformIO перед сборкой (extra_scripts = pre:...) или вручную:
+    python srs/tools/web_assets.py
+"""
+
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+# Типы содержимого встраиваемых ресурсов
+MIME_TYPES = {
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".ico": "image/x-icon",
+    ".png": "image/png",
+    ".svg": "image/svg+xml",
+}
+
+# Ресурсы с хешем в имени (на них ссылается index.html)
+HASHED_EXTENSIONS = (".css", ".js")
+
+# Файлы данных, которые не являются ресурсами веб-интерфейса
+EXCLUDED_FILES = ("settings.json",)
+
+ENTRY_FILE = "index.html"
+
+
+def minify_html(text):
+    text = re.sub(r"<!--(?!\[).*?-->", "", text, flags=re.S)
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line)
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{};,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    # Без разбора синтаксиса: убираем отступы, пустые строки и строчные
+    # комментарии. Переводы строк сохраняются, чтобы не менять расстановку
+    # точек с запятой.
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line and not line.startswith("//"))
+
+
+MINIFIERS = {
+    ".html": minify_html,
+    ".css": minify_css,
+    ".js": minify_js,
+}
+
+
+def project_dir():
+    try:
+        Import("env")  # noqa: F821 - определена в SCons
+        return env.subst("$PROJECT_DIR")  # noqa: F821
+    except NameError:
+        return os.path.abspath(os.path.join(os.path.dirname(sys.argv[0]), "..", ".."))
+
+
+def collect_assets(data_dir):
+    assets = []
+    for root, _, files in os.walk(data_dir):
+        for name in sorted(files):
+            ext = os.path.splitext(name)[1].lower()
+            if ext not in MIME_TYPES or name in EXCLUDED_FILES:
+                continue
+            path = os.path.join(root, name)
+            with open(path, "rb") as f:
+                content = f.read()
+            if not content:
+                continue
+            rel = os.path.relpath(path, data_dir).replace(os.sep, "/")
+            minifier = MINIFIERS.get(ext)
+            if minifier:
+                content = minifier(content.decode("utf-8")).encode("utf-8")
+            assets.append({"source": rel, "ext": ext, "content": content})
+    return sorted(assets, key=lambda a: a["source"])
+
+
+def rewrite_references(text, renames):
+    for source, served in renames.items():
+        pattern = r"([\"'(])/?" + re.escape(source) + r"([\"')])"
+        text = re.sub(pattern, lambda m: m.group(1) + served + m.group(2), text)
+    return text
+
+
+def build(data_dir, output):
+    assets = collect_assets(data_dir)
+
+    # Имена с хешем для стилей и скриптов
+    renames = {}
+    for asset in assets:
+        source = asset["source"]
+        if asset["ext"] in HASHED_EXTENSIONS:
+            digest = hashlib.sha256(asset["content"]).hexdigest()[:8]
+            base, ext = os.path.splitext(source)
+            asset["path"] = "/%s.%s%s" % (base, digest, ext)
+            asset["immutable"] = True
+            renames[source] = asset["path"]
+        else:
+            asset["path"] = "/" + source
+            asset["immutable"] = False
+
+    for asset in assets:
+        if asset["ext"] == ".html":
+            text = rewrite_references(asset["content"].decode("utf-8"), renames)
+            asset["content"] = text.encode("utf-8")
+        asset["gzip"] = gzip.compress(asset["content"], 9, mtime=0)
+        asset["etag"] = '"%s"' % hashlib.sha256(asset["gzip"]).hexdigest()[:16]
+
+    lines = [
+        "// Сгенерировано srs/tools/web_assets.py из srs/data, не редактировать",
+        "",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "// Встроенный ресурс веб-интерфейса (содержимое сжато gzip)",
+        "struct WebAsset {",
+        "    const char* path;          // Путь запроса",
+        "    const char* contentType;   // Тип содержимого",
+        "    const uint8_t* data;       // Данные во флеш-памяти",
+        "    size_t length;             // Размер данных",
+        "    const char* etag;          // Строгий ETag",
+        "    bool immutable;            // Имя содержит хеш, ресурс не меняется",
+        "};",
+        "",
+    ]
+    for index, asset in enumerate(assets):
+        data = asset["gzip"]
+        lines.append("// %s: %d -> %d байт" % (asset["source"], len(asset["content"]), len(data)))
+        lines.append("static const uint8_t webAssetData%d[] PROGMEM = {" % index)
+        for offset in range(0, len(data), 16):
+            lines.append("    " + ", ".join("0x%02x" % b for b in data[offset:offset + 16]) + ",")
+        lines.append("};")
+        lines.append("")
+
+    lines.append("static const WebAsset webAssets[] = {")
+    for index, asset in enumerate(assets):
+        lines.append('    { "%s", "%s", webAssetData%d, sizeof(webAssetData%d), "%s", %s },' % (
+            asset["path"], MIME_TYPES[asset["ext"]], index, index,
+            asset["etag"].replace('"', '\\"'), "true" if asset["immutable"] else "false"))
+    lines.append("};")
+    lines.append("")
+    lines.append("#define WEB_ASSET_COUNT (sizeof(webAssets) / sizeof(webAssets[0]))")
+    lines.append('#define WEB_ASSET_ENTRY "/%s"' % ENTRY_FILE)
+    lines.append("")
+    lines.append("#endif // WEB_ASSETS_H")
+    lines.append("")
+    generated = "\n".join(lines)
+
+    # Перезапись только при изменении, чтобы не вызывать лишнюю пересборку
+    previous = None
+    if os.path.exists(output):
+        with open(output, "r", encoding="utf-8") as f:
+            previous = f.read()
+    if previous != generated:
+        with open(output, "w", encoding="utf-8") as f:
+            f.write(generated)
+
+    for asset in assets:
+        print("web_assets: %-32s %7d -> %6d байт" % (asset["path"], len(asset["content"]), len(asset["gzip"])))
+    print("web_assets: всего %d -> %d байт" % (
+        sum(len(a["content"]) for a in assets), sum(len(a["gzip"]) for a in assets)))
+
+
+# PlatformIO выполняет скрипт не как __main__, поэтому сборка запускается всегда
+_root = project_dir()
+build(os.path.join(_root, "srs", "data"), os.path.join(_root, "srs", "web_assets.h"))
@@ -0,0 +1,103 @@
+"""
+Замер загрузки веб-интерфейса с контроллера.
+
+Загружает главную страницу и все ресурсы, на которые она ссылается, дважды:
+без кэша (холодная загрузка) и с If-None-Match по полученным ETag (теплая
+загрузка, как при повторном открытии страницы). Для каждого прохода выводит
+переданные байты и время.
+
+    python srs/tools/web_bench.py 192.168.4.1 [--runs 5]
+"""
+
+import argparse
+import gzip
+import http.client
+import re
+import time
+
+REFERENCE_PATTERN = re.compile(r"""(?:src|href)=["'](/?[^"':]+?\.(?:css|js|ico|json|png))["']""")
+
+
+def fetch(host, path, etag=None):
+    headers = {"Accept-Encoding": "gzip"}
+    if etag:
+        headers["If-None-Match"] = etag
+    started = time.perf_counter()
+    connection = http.client.HTTPConnection(host, timeout=30)
+    connection.request("GET", path, headers=headers)
+    response = connection.getresponse()
+    body = response.read()
+    elapsed = time.perf_counter() - started
+    result = {
+        "path": path,
+        "status": response.status,
+        "bytes": len(body),
+        "time": elapsed,
+        "etag": response.getheader("ETag"),
+        "cache": response.getheader("Cache-Control"),
+        "body": body,
+        "encoding": response.getheader("Content-Encoding"),
+    }
+    connection.close()
+    return result
+
+
+def page_references(page):
+    body = page["body"]
+    if page["encoding"] == "gzip":
+        body = gzip.decompress(body)
+    paths = []
+    for reference in REFERENCE_PATTERN.findall(body.decode("utf-8", "replace")):
+        path = reference if reference.startswith("/") else "/" + reference
+        if path not in paths:
+            paths.append(path)
+    return paths
+
+
+def load_page(host, etags):
+    results = [fetch(host, "/", etags.get("/"))]
+    paths = page_references(results[0]) if results[0]["status"] == 200 else etags["__paths__"]
+    for path in paths:
+        # Неизменяемые ресурсы браузер берет из кэша без запроса
+        if etags.get(path) and "immutable" in (etags.get(path + "#cache") or ""):
+            continue
+        results.append(fetch(host, path, etags.get(path)))
+    return results, paths
+
+
+def report(title, runs):
+    print(title)
+    for result in runs[0]:
+        print("  %-32s %3d %8d байт %7.0f мс" % (result["path"], result["status"], result["bytes"],
+                                                result["time"] * 1000))
+    totals = [(sum(r["bytes"] for r in run), sum(r["time"] for r in run)) for run in runs]
+    print("  всего: %d байт, %.0f мс (среднее по %d проходам, запросов: %d)" % (
+        sum(t[0] for t in totals) / len(totals), sum(t[1] for t in totals) / len(totals) * 1000,
+        len(totals), len(runs[0])))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="адрес контроллера")
+    parser.add_argument("--runs", type=int, default=3, help="количество проходов")
+    args = parser.parse_args()
+
+    cold_runs = []
+    etags = {}
+    for _ in range(args.runs):
+        results, paths = load_page(args.host, {})
+        cold_runs.append(results)
+    etags["__paths__"] = paths
+    for result in cold_runs[-1]:
+        if result["etag"]:
+            etags[result["path"]] = result["etag"]
+            etags[result["path"] + "#cache"] = result["cache"]
+
+    warm_runs = [load_page(args.host, etags)[0] for _ in range(args.runs)]
+
+    report("Холодная загрузка:", cold_runs)
+    report("Теплая загрузка:", warm_runs)
+
+
+if __name__ == "__main__":
+    main()
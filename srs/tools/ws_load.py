@@ -0,0 +1,174 @@
+"""
+Нагрузочная проверка рассылки WebSocket с медленными клиентами.
+
+Подключает к контроллеру несколько клиентов WebSocket (по умолчанию 8):
+часть читает без ограничений, часть - с ограниченной скоростью, часть не
+читает совсем (зависший телефон). У медленных клиентов уменьшен приемный
+буфер сокета, чтобы очередь копилась на контроллере, а не в ОС. Во время
+прогона периодически снимается /api/web/stats; в конце выводится, сколько
+каждый клиент получил, был ли он отключен контроллером, и изменение
+свободной памяти.
+
+    python srs/tools/ws_load.py 192.168.4.1 --duration 120
+"""
+
+import argparse
+import base64
+import http.client
+import json
+import os
+import socket
+import threading
+import time
+
+# Профили клиентов: имя, скорость чтения (байт/с, 0 - без ограничения, None - не читает)
+DEFAULT_PROFILES = [
+    ("fast", 0), ("fast", 0),
+    ("slow", 2000), ("slow", 2000), ("slow", 500),
+    ("stalled", None), ("stalled", None), ("stalled", None),
+]
+
+SLOW_RCVBUF = 2048
+
+
+def stats(host):
+    connection = http.client.HTTPConnection(host, timeout=10)
+    try:
+        connection.request("GET", "/api/web/stats")
+        response = connection.getresponse()
+        return json.loads(response.read()) if response.status == 200 else None
+    finally:
+        connection.close()
+
+
+class Client(threading.Thread):
+    def __init__(self, host, name, rate, deadline):
+        super().__init__(daemon=True)
+        self.host, self.name, self.rate, self.deadline = host, name, rate, deadline
+        self.received = 0
+        self.messages = 0
+        self.closed_at = None
+        self.error = None
+        self.buffer = b""
+
+    def connect(self):
+        address, _, port = self.host.partition(":")
+        sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        if self.rate != 0:
+            sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, SLOW_RCVBUF)
+        sock.settimeout(10)
+        sock.connect((address, int(port or 80)))
+        key = base64.b64encode(os.urandom(16)).decode()
+        sock.sendall(("GET /ws HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                      "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n" % (self.host, key)).encode())
+        response = b""
+        while b"\r\n\r\n" not in response:
+            chunk = sock.recv(1)
+            if not chunk:
+                raise ConnectionError("соединение закрыто при подключении")
+            response += chunk
+        if b" 101 " not in response.split(b"\r\n", 1)[0]:
+            raise ConnectionError(response.split(b"\r\n", 1)[0].decode())
+        return sock
+
+    def count_frames(self, data):
+        # Кадры сервера не маскируются; считаются только целые сообщения
+        self.buffer += data
+        while len(self.buffer) >= 2:
+            length = self.buffer[1] & 0x7F
+            offset = 2
+            if length == 126:
+                if len(self.buffer) < 4:
+                    return
+                length = int.from_bytes(self.buffer[2:4], "big")
+                offset = 4
+            elif length == 127:
+                if len(self.buffer) < 10:
+                    return
+                length = int.from_bytes(self.buffer[2:10], "big")
+                offset = 10
+            if len(self.buffer) < offset + length:
+                return
+            self.buffer = self.buffer[offset + length:]
+            self.messages += 1
+
+    def run(self):
+        try:
+            sock = self.connect()
+        except OSError as error:
+            self.error = str(error)
+            return
+        started = time.monotonic()
+        try:
+            while time.monotonic() < self.deadline:
+                if self.rate is None:
+                    # Не читаем, только проверяем, не закрыл ли контроллер соединение
+                    time.sleep(1)
+                    sock.setblocking(False)
+                    try:
+                        if sock.recv(1, socket.MSG_PEEK) == b"":
+                            break
+                    except BlockingIOError:
+                        pass
+                    finally:
+                        sock.setblocking(True)
+                    continue
+                chunk_size = 4096 if self.rate == 0 else max(1, self.rate // 10)
+                sock.settimeout(1)
+                try:
+                    data = sock.recv(chunk_size)
+                except socket.timeout:
+                    continue
+                if not data:
+                    break
+                self.received += len(data)
+                self.count_frames(data)
+                if self.rate:
+                    time.sleep(len(data) / self.rate)
+            else:
+                return
+            self.closed_at = time.monotonic() - started
+        except OSError:
+            self.closed_at = time.monotonic() - started
+        finally:
+            sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="адрес контроллера")
+    parser.add_argument("--duration", type=float, default=120.0, help="длительность прогона (с)")
+    args = parser.parse_args()
+
+    before = stats(args.host)
+    deadline = time.monotonic() + args.duration
+    clients = [Client(args.host, name, rate, deadline) for name, rate in DEFAULT_PROFILES]
+    for client in clients:
+        client.start()
+
+    min_free = before["freeHeap"] if before else None
+    while time.monotonic() < deadline:
+        time.sleep(5)
+        sample = stats(args.host)
+        if sample:
+            min_free = min(min_free or sample["freeHeap"], sample["freeHeap"])
+            queues = ", ".join("#%d %d/%d" % (c["id"], c["maxOutstanding"], c["coalesced"])
+                               for c in sample.get("ws", {}).get("clients", []))
+            print("свободно %d, клиентов %d, очередь/пропущено: %s" % (sample["freeHeap"], sample["wsClients"], queues))
+
+    for client in clients:
+        client.join(timeout=15)
+    after = stats(args.host)
+
+    print()
+    for index, client in enumerate(clients):
+        state = "ошибка: " + client.error if client.error else (
+            "отключен через %.0f с" % client.closed_at if client.closed_at is not None else "подключен")
+        print("%d %-8s %6d сообщений %9d байт  %s" % (index, client.name, client.messages, client.received, state))
+    if before and after:
+        print("свободная память: %d -> %d (минимум за прогон %d)" % (before["freeHeap"], after["freeHeap"], min_free))
+        print("отключено зависших клиентов: %d" % after.get("ws", {}).get("stalledDisconnects", 0))
+
+
+if __name__ == "__main__":
+    main()
@@ -1,6 +1,7 @@
 #include "utils.h"
-#include "webserver.h"
+#include "web.h"
 #include "display.h"
+#include "event_log.h"
 
 // Воспроизведение звукового сигнала
 void playSound(SoundType type) {
@@ -84,13 +85,8 @@ void playSound(SoundType type) {
 
 // Логирование события
 void logEvent(const String& message) {
-    // Вывод в последовательный порт
-    Serial.print("[");
-    Serial.print(getFormattedUptime());
-    Serial.print("] ");
-    Serial.println(message);
-    
-    // Здесь можно добавить запись в файл лога, если нужно
+    // Текст копируется в журнал событий, вывод выполняет задача журнала
+    logText(LOG_MODULE_SYSTEM, LOG_LEVEL_INFO, message.c_str());
 }
 
 // Отправка уведомления в веб-интерфейс
@@ -283,7 +279,7 @@ int wattsToPercent(int watts) {
 }
 
 // Получение имени фазы ректификации на русском
-String getPhaseNameRussian(RectificationPhase phase) {
+const char* getPhaseNameRussian(RectificationPhase phase) {
     switch (phase) {
         case PHASE_NONE:
             return "Не начат";
@@ -307,7 +303,7 @@ String getPhaseNameRussian(RectificationPhase phase) {
 }
 
 // Получение имени фазы дистилляции на русском
-String getDistPhaseNameRussian(DistillationPhase phase) {
+const char* getDistPhaseNameRussian(DistillationPhase phase) {
     switch (phase) {
         case DIST_PHASE_NONE:
             return "Не начат";
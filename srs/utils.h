@@ -13,12 +13,6 @@ void logEvent(const String& message);
 // Отправка уведомления в веб-интерфейс
 void sendWebNotification(NotificationType type, const String& message);
 
-// Отправка данных о температуре клиентам
-void sendTemperaturesToClients();
-
-// Отправка данных о статусе процесса клиентам
-void sendStatusToClients();
-
 // Запуск процесса
 void startProcess();
 
@@ -38,10 +32,10 @@ int percentToWatts(int percent);
 int wattsToPercent(int watts);
 
 // Получение имени фазы ректификации на русском
-String getPhaseNameRussian(RectificationPhase phase);
+const char* getPhaseNameRussian(RectificationPhase phase);
 
 // Получение имени фазы дистилляции на русском
-String getDistPhaseNameRussian(DistillationPhase phase);
+const char* getDistPhaseNameRussian(DistillationPhase phase);
 
 // Получение строки с форматированным временем (ч:м:с)
 String getFormattedTime(unsigned long timeInMs);
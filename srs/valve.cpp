@@ -1,5 +1,6 @@
 #include "valve.h"
 #include "utils.h"
+#include "event_log.h"
 
 // Статус клапана
 static bool valveOpen = false;
@@ -71,10 +72,10 @@ void updateValve() {
             // Устанавливаем состояние клапана в зависимости от фазы
             if (refluxPhase == 0) { // Фаза орошения
                 disableValve(); // Закрываем клапан, чтобы жидкость возвращалась в колонну
-                Serial.println("Фаза орошения - клапан закрыт");
+                logRecord(EV_VALVE_REFLUX);
             } else { // Фаза отбора
                 enableValve(); // Открываем клапан для отбора
-                Serial.println("Фаза отбора - клапан открыт");
+                logRecord(EV_VALVE_COLLECT);
             }
         }
     }
@@ -113,11 +114,7 @@ void setRefluxRatio(float ratio, int periodSeconds) {
     // Сохраняем настройки
     saveRectificationParams();
     
-    Serial.print("Установлен режим орошения: соотношение ");
-    Serial.print(ratio);
-    Serial.print(", период ");
-    Serial.print(periodSeconds);
-    Serial.println(" с");
+    logRecord(EV_VALVE_REFLUX_SET, ratio, periodSeconds);
 }
 
 // Получение текущего состояния клапана (открыт/закрыт)
@@ -1,17 +1,41 @@
 #include "web.h"
 #include "settings.h"
+#include "settings_schema.h"
 #include "temp_sensors.h"
 #include "heater.h"
 #include "pump.h"
 #include "valve.h"
 #include "rectification.h"
 #include "distillation.h"
+#include "recipes.h"
+#include "forecast.h"
+#include "checkpoint.h"
+#include "safety.h"
+#include "supervisor.h"
+#include "fault_injection.h"
+#include "telemetry.h"
+#include "event_log.h"
+#include "json_writer.h"
+#include "ws_broadcast.h"
+#include "event_stream.h"
+#include "metrics.h"
+#include "mqtt_bridge.h"
+#include "ota.h"
+#include "fs_gate.h"
 #include <Arduino.h>
 #include <WiFi.h>
 #include <AsyncTCP.h>
 #include <ESPAsyncWebServer.h>
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include <memory>
+#include <atomic>
+
+// Ресурсы веб-интерфейса, встроенные во флеш-память (srs/tools/web_assets.py)
+#if __has_include("web_assets.h")
+#include "web_assets.h"
+#define WEB_ASSETS_EMBEDDED
+#endif
 
 // Объект веб-сервера на порту 80
 AsyncWebServer server(80);
@@ -22,6 +46,129 @@ bool webSocketActive = false;
 unsigned long lastWsUpdate = 0;
 const int wsUpdateInterval = 1000; // Обновление по WebSocket каждую секунду
 
+// Свободная память сразу после запуска веб-сервера
+static uint32_t bootFreeHeap = 0;
+
+// Маршрут API: метод, путь и обработчики
+struct WebRoute {
+    WebRequestMethodComposite method;
+    const char* path;
+    void (*handler)(AsyncWebServerRequest *request);
+    void (*upload)(AsyncWebServerRequest *request, const String& filename, size_t index,
+                   uint8_t *data, size_t len, bool final);
+    void (*body)(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+};
+
+// Статистика времени выполнения обработчика маршрута
+struct WebRouteStats {
+    uint32_t count;
+    uint32_t totalMicros;
+    uint32_t maxMicros;
+};
+
+// Метод RPC: пишет результат в json и возвращает код ответа (200 - успех).
+// При ошибке записывает в error текст и ничего не пишет в json.
+typedef int (*RpcHandler)(JsonObjectConst params, JsonWriter& json, const char*& error);
+
+struct RpcMethod {
+    const char* name;
+    RpcHandler handler;
+};
+
+// Добавление состояния режима "старт-стоп" в статус ректификации
+static void addStartStopStatus(JsonWriter& json) {
+    json.beginObject("startStop");
+    json.add("enabled", sysSettings.rectificationSettings.bodyStartStop);
+    json.add("stopped", isRectificationBodyStopped());
+    json.add("stops", getRectificationStartStopCount());
+    json.add("flowRate", getRectificationBodyFlowRate());
+    json.add("lockedTemp", getRectificationLockedBodyTemp());
+    
+    StartStopRecord history[START_STOP_HISTORY_SIZE];
+    int count = getRectificationStartStopHistory(history, START_STOP_HISTORY_SIZE);
+    json.beginArray("history");
+    for (int i = 0; i < count; i++) {
+        json.beginObject();
+        json.add("time", history[i].time);
+        json.add("temp", history[i].refluxTemp);
+        json.add("rate", history[i].flowRate);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+}
+
+// Добавление прогноза в статус ректификации
+static void addForecastStatus(JsonWriter& json) {
+    const RectificationForecast& fc = getRectificationForecast();
+    json.beginObject("forecast");
+    json.add("phaseRemaining", fc.phaseRemaining[getRectificationPhase()]);
+    json.add("eta", fc.totalRemaining);
+    json.add("etaComplete", fc.totalComplete);
+    json.add("mlPerHour", fc.extractionRate);
+    json.add("energyWh", fc.energyWh);
+    json.add("whPerMl", fc.energyPerMl);
+    json.add("cubeTempRate", fc.cubeTempRate);
+    
+    json.beginArray("phases");
+    for (int i = 0; i < FORECAST_PHASE_COUNT; i++) {
+        json.add(fc.phaseRemaining[i]);
+    }
+    json.endArray();
+    json.endObject();
+}
+
+// Добавление температур основных датчиков
+static void addTemperatures(JsonWriter& json) {
+    json.beginObject("temperatures");
+    json.add("cube", getTemperature(TEMP_CUBE));
+    json.add("column", getTemperature(TEMP_COLUMN));
+    json.add("reflux", getTemperature(TEMP_REFLUX));
+    json.add("tsa", getTemperature(TEMP_TSA));
+    json.add("waterOut", getTemperature(TEMP_WATER_OUT));
+    json.endObject();
+}
+
+// Добавление состояния текущего процесса; false, если процесс не запущен
+static bool addProcessStatus(JsonWriter& json) {
+    if (isRectificationRunning()) {
+        json.beginObject("rectification");
+        json.add("running", true);
+        json.add("paused", isRectificationPaused());
+        json.add("phase", getRectificationPhaseName());
+        json.add("uptime", getRectificationUptime());
+        json.add("phaseTime", getRectificationPhaseTime());
+        json.add("headsVolume", getRectificationHeadsVolume());
+        json.add("bodyVolume", getRectificationBodyVolume());
+        json.add("tailsVolume", getRectificationTailsVolume());
+        json.add("totalVolume", getRectificationTotalVolume());
+        json.add("refluxStatus", getRectificationRefluxStatus());
+        json.add("columnStable", isRectificationColumnStable());
+        json.add("stabilizationSaved", getRectificationStabilizationSavedTime());
+        json.add("headsEndConfidence", getRectificationHeadsEndConfidence());
+        json.add("headsEndProposed", isRectificationHeadsEndProposed());
+        json.add("headsEndDetectedVolume", getRectificationHeadsEndDetectedVolume());
+        addStartStopStatus(json);
+        addForecastStatus(json);
+        json.endObject();
+        return true;
+    }
+    if (isDistillationRunning()) {
+        json.beginObject("distillation");
+        json.add("running", true);
+        json.add("paused", isDistillationPaused());
+        json.add("phase", getDistillationPhaseName());
+        json.add("uptime", getDistillationUptime());
+        json.add("phaseTime", getDistillationPhaseTime());
+        json.add("productVolume", getDistillationProductVolume());
+        json.add("headsVolume", getDistillationHeadsVolume());
+        json.add("headsMode", isDistillationHeadsMode());
+        json.endObject();
+        return true;
+    }
+    return false;
+}
+
 // Инициализация модуля веб-сервера
 void initWebServer() {
     // Начинаем работу с файловой системой
@@ -30,10 +177,26 @@ void initWebServer() {
         return;
     }
     
+    // Инициализация рецептов (каталог /recipes на LittleFS)
+    initRecipes();
+    
+    // Журнал телеметрии (/telemetry_*.bin на LittleFS)
+    initTelemetry();
+    
+    // Журнал событий (/events.log на LittleFS)
+    initEventLog();
+    
     // Настройка обработчика WebSocket
+    initWsBroadcast();
     ws.onEvent(onWebSocketEvent);
     server.addHandler(&ws);
     
+    // Поток событий SSE (/events)
+    initEventStream(server);
+    
+    // Мост MQTT (подключение - из цикла задачи управления)
+    initMqttBridge();
+    
     // Настройка маршрутов API
     setupApiRoutes();
     
@@ -48,649 +211,1587 @@ void initWebServer() {
     // Запуск веб-сервера
     server.begin();
     
-    Serial.println("Веб-сервер запущен");
+    bootFreeHeap = ESP.getFreeHeap();
+    Serial.print("Веб-сервер запущен, свободно памяти: ");
+    Serial.print(bootFreeHeap);
+    Serial.println(" байт");
 }
 
 // Обновление состояния WebSocket соединения
 void updateWebSocket() {
-    if (!webSocketActive) {
-        return;
-    }
-    
     unsigned long currentTime = millis();
     if (currentTime - lastWsUpdate < wsUpdateInterval) {
         return;
     }
-    
     lastWsUpdate = currentTime;
     
-    // Создаем JSON объект для отправки статуса
-    DynamicJsonDocument doc(1024);
+    // Отсчеты телеметрии для потока SSE
+    publishTelemetry();
+    
+    if (!webSocketActive && !eventStreamActive()) {
+        return;
+    }
     
-    // Добавляем информацию о температуре
-    JsonObject temps = doc.createNestedObject("temperatures");
-    temps["cube"] = getTemperature(TEMP_CUBE);
-    temps["column"] = getTemperature(TEMP_COLUMN);
-    temps["reflux"] = getTemperature(TEMP_REFLUX);
-    temps["tsa"] = getTemperature(TEMP_TSA);
-    temps["waterOut"] = getTemperature(TEMP_WATER_OUT);
+    checkWsClients(ws);
+    sendStatusToClients();
+}
+
+// Запись сообщения о статусе системы
+void writeStatus(JsonWriter& json) {
+    json.beginObject();
+    addTemperatures(json);
     
     // Добавляем информацию о нагревателе
-    JsonObject heater = doc.createNestedObject("heater");
-    heater["power"] = getHeaterPowerWatts();
-    heater["percent"] = getHeaterPowerPercent();
+    json.beginObject("heater");
+    json.add("power", getHeaterPowerWatts());
+    json.add("percent", getHeaterPowerPercent());
+    json.endObject();
     
     // Добавляем информацию о системе
-    JsonObject system = doc.createNestedObject("system");
-    system["uptime"] = millis() / 1000;
+    json.beginObject("system");
+    json.add("uptime", millis() / 1000);
+    json.endObject();
     
     // Информация о текущем процессе
-    if (isRectificationRunning()) {
-        JsonObject process = doc.createNestedObject("rectification");
-        process["running"] = true;
-        process["paused"] = isRectificationPaused();
-        process["phase"] = getRectificationPhaseName();
-        process["uptime"] = getRectificationUptime();
-        process["phaseTime"] = getRectificationPhaseTime();
-        process["headsVolume"] = getRectificationHeadsVolume();
-        process["bodyVolume"] = getRectificationBodyVolume();
-        process["tailsVolume"] = getRectificationTailsVolume();
-        process["totalVolume"] = getRectificationTotalVolume();
-        process["refluxStatus"] = getRectificationRefluxStatus();
-    }
-    else if (isDistillationRunning()) {
-        JsonObject process = doc.createNestedObject("distillation");
-        process["running"] = true;
-        process["paused"] = isDistillationPaused();
-        process["phase"] = getDistillationPhaseName();
-        process["uptime"] = getDistillationUptime();
-        process["phaseTime"] = getDistillationPhaseTime();
-        process["productVolume"] = getDistillationProductVolume();
-        process["headsVolume"] = getDistillationHeadsVolume();
-        process["headsMode"] = isDistillationHeadsMode();
-    }
-    
-    // Сериализуем JSON в строку и отправляем
-    String jsonString;
-    serializeJson(doc, jsonString);
-    ws.textAll(jsonString);
+    addProcessStatus(json);
+    json.endObject();
 }
 
-// Настройка маршрутов API
-void setupApiRoutes() {
-    // Получение статуса системы
-    server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request) {
-        DynamicJsonDocument doc(1024);
-        
-        // Информация о температуре
-        JsonObject temps = doc.createNestedObject("temperatures");
-        temps["cube"] = getTemperature(TEMP_CUBE);
-        temps["column"] = getTemperature(TEMP_COLUMN);
-        temps["reflux"] = getTemperature(TEMP_REFLUX);
-        temps["tsa"] = getTemperature(TEMP_TSA);
-        temps["waterOut"] = getTemperature(TEMP_WATER_OUT);
-        
-        // Информация о подключенных датчиках
-        JsonObject sensors = doc.createNestedObject("sensors");
-        sensors["cube"] = isSensorConnected(TEMP_CUBE);
-        sensors["column"] = isSensorConnected(TEMP_COLUMN);
-        sensors["reflux"] = isSensorConnected(TEMP_REFLUX);
-        sensors["tsa"] = isSensorConnected(TEMP_TSA);
-        sensors["waterOut"] = isSensorConnected(TEMP_WATER_OUT);
-        
-        // Информация о нагревателе
-        JsonObject heater = doc.createNestedObject("heater");
-        heater["power"] = getHeaterPowerWatts();
-        heater["percent"] = getHeaterPowerPercent();
-        
-        // Информация о насосе
-        JsonObject pump = doc.createNestedObject("pump");
-        pump["running"] = isPumpRunning();
-        pump["flowRate"] = getPumpFlowRate();
-        
-        // Информация о клапане
-        JsonObject valve = doc.createNestedObject("valve");
-        valve["open"] = isValveOpen();
-        
-        // Информация о текущем процессе
-        if (isRectificationRunning()) {
-            JsonObject process = doc.createNestedObject("rectification");
-            process["running"] = true;
-            process["paused"] = isRectificationPaused();
-            process["phase"] = getRectificationPhaseName();
-            process["uptime"] = getRectificationUptime();
-            process["phaseTime"] = getRectificationPhaseTime();
-            process["headsVolume"] = getRectificationHeadsVolume();
-            process["bodyVolume"] = getRectificationBodyVolume();
-            process["tailsVolume"] = getRectificationTailsVolume();
-            process["totalVolume"] = getRectificationTotalVolume();
-            process["refluxStatus"] = getRectificationRefluxStatus();
-        }
-        else if (isDistillationRunning()) {
-            JsonObject process = doc.createNestedObject("distillation");
-            process["running"] = true;
-            process["paused"] = isDistillationPaused();
-            process["phase"] = getDistillationPhaseName();
-            process["uptime"] = getDistillationUptime();
-            process["phaseTime"] = getDistillationPhaseTime();
-            process["productVolume"] = getDistillationProductVolume();
-            process["headsVolume"] = getDistillationHeadsVolume();
-            process["headsMode"] = isDistillationHeadsMode();
-        }
-        else {
-            doc["process"] = "idle";
-        }
-        
-        // Отправляем ответ
-        String response;
-        serializeJson(doc, response);
-        request->send(200, "application/json", response);
-    });
-    
-    // Получение настроек
-    server.on("/api/settings", HTTP_GET, [](AsyncWebServerRequest *request) {
-        DynamicJsonDocument doc(2048);
-        
-        // Настройки нагревателя
-        JsonObject heater = doc.createNestedObject("heater");
-        heater["maxPowerWatts"] = sysSettings.heaterSettings.maxPowerWatts;
-        
-        // Настройки датчиков
-        JsonObject sensors = doc.createNestedObject("sensors");
-        
-        for (int i = 0; i < MAX_TEMP_SENSORS; i++) {
-            JsonObject sensor = sensors.createNestedObject(String(i));
-            sensor["name"] = getTempSensorName(i);
-            sensor["enabled"] = sysSettings.tempSensorEnabled[i];
-            sensor["calibration"] = sysSettings.tempSensorCalibration[i];
-            
-            String address = "";
-            for (int j = 0; j < 8; j++) {
-                char hex[3];
-                sprintf(hex, "%02X", sysSettings.tempSensorAddresses[i][j]);
-                address += hex;
-                if (j < 7) address += ":";
-            }
-            sensor["address"] = address;
-        }
-        
-        // Настройки насоса
-        JsonObject pump = doc.createNestedObject("pump");
-        pump["headsFlowRate"] = sysSettings.pumpSettings.headsFlowRate;
-        pump["bodyFlowRate"] = sysSettings.pumpSettings.bodyFlowRate;
-        pump["tailsFlowRate"] = sysSettings.pumpSettings.tailsFlowRate;
-        
-        // Настройки ректификации
-        JsonObject rect = doc.createNestedObject("rectification");
-        rect["model"] = sysSettings.rectificationSettings.model;
-        rect["heatingPowerWatts"] = sysSettings.rectificationSettings.heatingPowerWatts;
-        rect["stabilizationPowerWatts"] = sysSettings.rectificationSettings.stabilizationPowerWatts;
-        rect["bodyPowerWatts"] = sysSettings.rectificationSettings.bodyPowerWatts;
-        rect["tailsPowerWatts"] = sysSettings.rectificationSettings.tailsPowerWatts;
-        rect["headsTemp"] = sysSettings.rectificationSettings.headsTemp;
-        rect["bodyTemp"] = sysSettings.rectificationSettings.bodyTemp;
-        rect["tailsTemp"] = sysSettings.rectificationSettings.tailsTemp;
-        rect["endTemp"] = sysSettings.rectificationSettings.endTemp;
-        rect["maxCubeTemp"] = sysSettings.rectificationSettings.maxCubeTemp;
-        rect["stabilizationTime"] = sysSettings.rectificationSettings.stabilizationTime;
-        rect["postHeadsStabilizationTime"] = sysSettings.rectificationSettings.postHeadsStabilizationTime;
-        rect["headsVolume"] = sysSettings.rectificationSettings.headsVolume;
-        rect["bodyVolume"] = sysSettings.rectificationSettings.bodyVolume;
-        rect["refluxRatio"] = sysSettings.rectificationSettings.refluxRatio;
-        rect["refluxPeriod"] = sysSettings.rectificationSettings.refluxPeriod;
-        
-        // Настройки дистилляции
-        JsonObject dist = doc.createNestedObject("distillation");
-        dist["heatingPowerWatts"] = sysSettings.distillationSettings.heatingPowerWatts;
-        dist["distillationPowerWatts"] = sysSettings.distillationSettings.distillationPowerWatts;
-        dist["startCollectingTemp"] = sysSettings.distillationSettings.startCollectingTemp;
-        dist["endTemp"] = sysSettings.distillationSettings.endTemp;
-        dist["maxCubeTemp"] = sysSettings.distillationSettings.maxCubeTemp;
-        dist["separateHeads"] = sysSettings.distillationSettings.separateHeads;
-        dist["headsVolume"] = sysSettings.distillationSettings.headsVolume;
-        dist["flowRate"] = sysSettings.distillationSettings.flowRate;
-        dist["headsFlowRate"] = sysSettings.distillationSettings.headsFlowRate;
-        
-        // Отправляем ответ
-        String response;
-        serializeJson(doc, response);
-        request->send(200, "application/json", response);
-    });
-    
-    // Обновление настроек
-    server.on("/api/settings", HTTP_POST, [](AsyncWebServerRequest *request) {
-        request->send(200);
-    }, NULL, [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
-        DynamicJsonDocument doc(2048);
-        deserializeJson(doc, data, len);
-        
-        // Обновляем настройки, сохраняем и отправляем ответ
-        if (doc.containsKey("heater")) {
-            JsonObject heater = doc["heater"];
-            if (heater.containsKey("maxPowerWatts")) {
-                sysSettings.heaterSettings.maxPowerWatts = heater["maxPowerWatts"];
-            }
-        }
-        
-        // Обновляем настройки насоса
-        if (doc.containsKey("pump")) {
-            JsonObject pump = doc["pump"];
-            if (pump.containsKey("headsFlowRate")) {
-                sysSettings.pumpSettings.headsFlowRate = pump["headsFlowRate"];
-            }
-            if (pump.containsKey("bodyFlowRate")) {
-                sysSettings.pumpSettings.bodyFlowRate = pump["bodyFlowRate"];
-            }
-            if (pump.containsKey("tailsFlowRate")) {
-                sysSettings.pumpSettings.tailsFlowRate = pump["tailsFlowRate"];
-            }
-        }
-        
-        // Обновляем настройки датчиков
-        if (doc.containsKey("sensors")) {
-            JsonObject sensors = doc["sensors"];
-            for (JsonPair kv : sensors) {
-                int sensorIndex = atoi(kv.key().c_str());
-                if (sensorIndex >= 0 && sensorIndex < MAX_TEMP_SENSORS) {
-                    JsonObject sensor = kv.value().as<JsonObject>();
-                    
-                    if (sensor.containsKey("calibration")) {
-                        float calibration = sensor["calibration"];
-                        calibrateTempSensor(sensorIndex, calibration);
-                    }
-                }
-            }
-        }
-        
-        // Обновляем настройки ректификации
-        if (doc.containsKey("rectification")) {
-            JsonObject rect = doc["rectification"];
-            
-            if (rect.containsKey("model")) {
-                sysSettings.rectificationSettings.model = rect["model"];
-            }
-            if (rect.containsKey("heatingPowerWatts")) {
-                sysSettings.rectificationSettings.heatingPowerWatts = rect["heatingPowerWatts"];
-            }
-            if (rect.containsKey("stabilizationPowerWatts")) {
-                sysSettings.rectificationSettings.stabilizationPowerWatts = rect["stabilizationPowerWatts"];
-            }
-            if (rect.containsKey("bodyPowerWatts")) {
-                sysSettings.rectificationSettings.bodyPowerWatts = rect["bodyPowerWatts"];
-            }
-            if (rect.containsKey("tailsPowerWatts")) {
-                sysSettings.rectificationSettings.tailsPowerWatts = rect["tailsPowerWatts"];
-            }
-            if (rect.containsKey("headsTemp")) {
-                sysSettings.rectificationSettings.headsTemp = rect["headsTemp"];
-            }
-            if (rect.containsKey("bodyTemp")) {
-                sysSettings.rectificationSettings.bodyTemp = rect["bodyTemp"];
-            }
-            if (rect.containsKey("tailsTemp")) {
-                sysSettings.rectificationSettings.tailsTemp = rect["tailsTemp"];
-            }
-            if (rect.containsKey("endTemp")) {
-                sysSettings.rectificationSettings.endTemp = rect["endTemp"];
-            }
-            if (rect.containsKey("maxCubeTemp")) {
-                sysSettings.rectificationSettings.maxCubeTemp = rect["maxCubeTemp"];
-            }
-            if (rect.containsKey("stabilizationTime")) {
-                sysSettings.rectificationSettings.stabilizationTime = rect["stabilizationTime"];
-            }
-            if (rect.containsKey("postHeadsStabilizationTime")) {
-                sysSettings.rectificationSettings.postHeadsStabilizationTime = rect["postHeadsStabilizationTime"];
-            }
-            if (rect.containsKey("headsVolume")) {
-                sysSettings.rectificationSettings.headsVolume = rect["headsVolume"];
-            }
-            if (rect.containsKey("bodyVolume")) {
-                sysSettings.rectificationSettings.bodyVolume = rect["bodyVolume"];
-            }
-            if (rect.containsKey("refluxRatio")) {
-                sysSettings.rectificationSettings.refluxRatio = rect["refluxRatio"];
-            }
-            if (rect.containsKey("refluxPeriod")) {
-                sysSettings.rectificationSettings.refluxPeriod = rect["refluxPeriod"];
-            }
-        }
-        
-        // Обновляем настройки дистилляции
-        if (doc.containsKey("distillation")) {
-            JsonObject dist = doc["distillation"];
-            
-            if (dist.containsKey("heatingPowerWatts")) {
-                sysSettings.distillationSettings.heatingPowerWatts = dist["heatingPowerWatts"];
-            }
-            if (dist.containsKey("distillationPowerWatts")) {
-                sysSettings.distillationSettings.distillationPowerWatts = dist["distillationPowerWatts"];
-            }
-            if (dist.containsKey("startCollectingTemp")) {
-                sysSettings.distillationSettings.startCollectingTemp = dist["startCollectingTemp"];
-            }
-            if (dist.containsKey("endTemp")) {
-                sysSettings.distillationSettings.endTemp = dist["endTemp"];
-            }
-            if (dist.containsKey("maxCubeTemp")) {
-                sysSettings.distillationSettings.maxCubeTemp = dist["maxCubeTemp"];
-            }
-            if (dist.containsKey("separateHeads")) {
-                sysSettings.distillationSettings.separateHeads = dist["separateHeads"];
-            }
-            if (dist.containsKey("headsVolume")) {
-                sysSettings.distillationSettings.headsVolume = dist["headsVolume"];
-            }
-            if (dist.containsKey("flowRate")) {
-                sysSettings.distillationSettings.flowRate = dist["flowRate"];
-            }
-            if (dist.containsKey("headsFlowRate")) {
-                sysSettings.distillationSettings.headsFlowRate = dist["headsFlowRate"];
-            }
-        }
-        
-        // Сохраняем изменённые настройки
-        saveSystemSettings();
-        
-        request->send(200, "application/json", "{\"status\":\"ok\"}");
-    });
+// Отправка статуса системы клиентам WebSocket
+void sendStatusToClients() {
+    lastWsUpdate = millis();
     
-    // API для запуска процесса ректификации
-    server.on("/api/rectification/start", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (isDistillationRunning()) {
-            request->send(409, "application/json", "{\"error\":\"Процесс дистилляции уже запущен\"}");
-            return;
-        }
-        
-        bool started = startRectification();
-        if (started) {
-            request->send(200, "application/json", "{\"status\":\"ok\"}");
-        } else {
-            request->send(500, "application/json", "{\"error\":\"Не удалось запустить ректификацию\"}");
-        }
-    });
+    PooledJsonWriter json;
+    writeStatus(json);
+    if (json.ok()) {
+        wsBroadcast(ws, json.c_str(), json.length(), WS_MESSAGE_STATUS);
+        publishEvent(EVENT_STREAM_STATUS, json.c_str());
+    }
+}
+
+// Отправка уведомления клиентам WebSocket
+void sendNotificationToClients(NotificationType type, const String& message) {
+    if (ws.count() == 0 && !eventStreamActive()) {
+        return;
+    }
     
-    // API для остановки процесса ректификации
-    server.on("/api/rectification/stop", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (!isRectificationRunning()) {
-            request->send(400, "application/json", "{\"error\":\"Процесс не запущен\"}");
-            return;
-        }
-        
-        stopRectification();
-        request->send(200, "application/json", "{\"status\":\"ok\"}");
-    });
+    DynamicJsonDocument doc(512);
+    doc["type"] = "notification";
+    switch (type) {
+        case NOTIFY_SUCCESS: doc["notifyType"] = "success"; break;
+        case NOTIFY_WARNING: doc["notifyType"] = "warning"; break;
+        case NOTIFY_ERROR:   doc["notifyType"] = "error"; break;
+        default:             doc["notifyType"] = "info"; break;
+    }
+    doc["message"] = message;
     
-    // API для паузы процесса ректификации
-    server.on("/api/rectification/pause", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (!isRectificationRunning() || isRectificationPaused()) {
-            request->send(400, "application/json", "{\"error\":\"Процесс не запущен или уже на паузе\"}");
-            return;
+    String output;
+    serializeJson(doc, output);
+    wsBroadcast(ws, output.c_str(), output.length(), WS_MESSAGE_EVENT);
+    publishEvent(EVENT_STREAM_NOTIFICATION, output.c_str());
+}
+
+// Отправка записи журнала событий клиентам WebSocket
+void sendLogToClients(const char* json, size_t length) {
+    if (ws.count() > 0) {
+        wsBroadcast(ws, json, length, WS_MESSAGE_EVENT);
+    }
+    publishEvent(EVENT_STREAM_LOG, json);
+}
+
+// Запись ошибки {"error":"..."} в ответ на запрос
+static void sendJsonError(AsyncWebServerRequest *request, int code, const char* message) {
+    char buffer[192];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.beginObject();
+    json.add("error", message);
+    json.endObject();
+    request->send(code, "application/json", buffer);
+}
+
+// Запись ответа {"status":"ok"} для команд
+static int rpcOk(JsonWriter& json) {
+    json.beginObject();
+    json.add("status", "ok");
+    json.endObject();
+    return 200;
+}
+
+// Вызов метода RPC из REST-маршрута: параметры запроса передаются методу
+// как строки, результат или ошибка отправляются в ответ
+static void callFromRest(AsyncWebServerRequest *request, RpcHandler handler) {
+    StaticJsonDocument<256> params;
+    JsonObject obj = params.to<JsonObject>();
+    for (size_t i = 0; i < request->params(); i++) {
+        AsyncWebParameter* param = request->getParam(i);
+        if (!param->isFile()) {
+            obj[param->name()] = param->value();
         }
-        
-        pauseRectification();
-        request->send(200, "application/json", "{\"status\":\"ok\"}");
-    });
+    }
     
-    // API для возобновления процесса ректификации
-    server.on("/api/rectification/resume", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (!isRectificationRunning() || !isRectificationPaused()) {
-            request->send(400, "application/json", "{\"error\":\"Процесс не запущен или не на паузе\"}");
-            return;
-        }
-        
-        resumeRectification();
-        request->send(200, "application/json", "{\"status\":\"ok\"}");
-    });
+    PooledJsonWriter json;
+    const char* error = nullptr;
+    int code = handler(obj, json, error);
+    if (code == 200) {
+        json.send(request);
+    } else {
+        sendJsonError(request, code, error != nullptr ? error : "Ошибка выполнения запроса");
+    }
+}
+
+// Статус системы
+static int rpcStatusGet(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    json.beginObject();
+    addTemperatures(json);
     
-    // API для запуска процесса дистилляции
-    server.on("/api/distillation/start", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (isRectificationRunning()) {
-            request->send(409, "application/json", "{\"error\":\"Процесс ректификации уже запущен\"}");
-            return;
-        }
-        
-        bool started = startDistillation();
-        if (started) {
-            request->send(200, "application/json", "{\"status\":\"ok\"}");
-        } else {
-            request->send(500, "application/json", "{\"error\":\"Не удалось запустить дистилляцию\"}");
-        }
-    });
+    // Информация о подключенных датчиках
+    json.beginObject("sensors");
+    json.add("cube", isSensorConnected(TEMP_CUBE));
+    json.add("column", isSensorConnected(TEMP_COLUMN));
+    json.add("reflux", isSensorConnected(TEMP_REFLUX));
+    json.add("tsa", isSensorConnected(TEMP_TSA));
+    json.add("waterOut", isSensorConnected(TEMP_WATER_OUT));
+    json.endObject();
     
-    // API для остановки процесса дистилляции
-    server.on("/api/distillation/stop", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (!isDistillationRunning()) {
-            request->send(400, "application/json", "{\"error\":\"Процесс не запущен\"}");
-            return;
-        }
-        
-        stopDistillation();
-        request->send(200, "application/json", "{\"status\":\"ok\"}");
-    });
+    // Информация о нагревателе
+    json.beginObject("heater");
+    json.add("power", getHeaterPowerWatts());
+    json.add("percent", getHeaterPowerPercent());
+    json.endObject();
     
-    // API для паузы процесса дистилляции
-    server.on("/api/distillation/pause", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (!isDistillationRunning() || isDistillationPaused()) {
-            request->send(400, "application/json", "{\"error\":\"Процесс не запущен или уже на паузе\"}");
-            return;
-        }
-        
-        pauseDistillation();
-        request->send(200, "application/json", "{\"status\":\"ok\"}");
-    });
+    // Информация о насосе
+    json.beginObject("pump");
+    json.add("running", isPumpRunning());
+    json.add("flowRate", getPumpFlowRate());
+    json.endObject();
     
-    // API для возобновления процесса дистилляции
-    server.on("/api/distillation/resume", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (!isDistillationRunning() || !isDistillationPaused()) {
-            request->send(400, "application/json", "{\"error\":\"Процесс не запущен или не на паузе\"}");
-            return;
-        }
-        
-        resumeDistillation();
-        request->send(200, "application/json", "{\"status\":\"ok\"}");
-    });
+    // Информация о клапане
+    json.beginObject("valve");
+    json.add("open", isValveOpen());
+    json.endObject();
     
-    // API для ручного управления нагревателем
-    server.on("/api/heater/set", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (isRectificationRunning() || isDistillationRunning()) {
-            request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, ручное управление недоступно\"}");
-            return;
-        }
-        
-        int powerWatts = 0;
-        if (request->hasParam("power", true)) {
-            powerWatts = request->getParam("power", true)->value().toInt();
-        }
-        
-        setHeaterPower(powerWatts);
-        request->send(200, "application/json", "{\"status\":\"ok\", \"power\":" + String(powerWatts) + "}");
-    });
+    // Информация о текущем процессе
+    if (!addProcessStatus(json)) {
+        json.add("process", "idle");
+    }
     
-    // API для ручного управления насосом
-    server.on("/api/pump/set", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (isRectificationRunning() || isDistillationRunning()) {
-            request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, ручное управление недоступно\"}");
-            return;
-        }
-        
-        if (!request->hasParam("flowRate", true)) {
-            request->send(400, "application/json", "{\"error\":\"Параметр flowRate обязателен\"}");
-            return;
-        }
-        
-        float flowRate = request->getParam("flowRate", true)->value().toFloat();
-        
-        if (flowRate > 0) {
-            pumpStart(flowRate);
-        } else {
-            pumpStop();
+    // Информация о правилах безопасности
+    const SafetyRuleStats& ruleStats = getSafetyRuleStats();
+    json.beginObject("safety");
+    json.add("ok", getSafetyStatus().isSystemSafe);
+    json.add("action", (int)getSafetyRuleAction());
+    json.add("rule", getSafetyTrippedRuleName());
+    json.add("passes", ruleStats.passes);
+    json.add("lastMicros", ruleStats.lastMicros);
+    json.add("maxMicros", ruleStats.maxMicros);
+    json.add("task", isSafetyTaskRunning());
+    json.add("latencyMicros", ruleStats.lastLatencyMicros);
+    json.add("maxLatencyMicros", ruleStats.maxLatencyMicros);
+    json.add("cutLatencyMicros", ruleStats.lastCutLatencyMicros);
+    json.add("maxCutLatencyMicros", ruleStats.maxCutLatencyMicros);
+    json.add("trips", ruleStats.trips);
+    json.endObject();
+    json.endObject();
+    return 200;
+}
+
+// Настройки: все разделы или один раздел (параметр section)
+static int rpcSettingsGet(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    const char* name = params["section"] | (const char*)nullptr;
+    if (name != nullptr) {
+        const SettingsSection* section = findSettingsSection(name);
+        if (section == nullptr) {
+            error = "Раздел настроек не найден";
+            return 404;
         }
-        
-        request->send(200, "application/json", "{\"status\":\"ok\", \"flowRate\":" + String(flowRate) + "}");
-    });
+        json.beginObject();
+        writeSettingsSection(*section, getSettingsSectionData(sysSettings, *section), json);
+        json.endObject();
+        return 200;
+    }
     
-    // API для ручного управления клапаном
-    server.on("/api/valve/set", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (isRectificationRunning() || isDistillationRunning()) {
-            request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, ручное управление недоступно\"}");
-            return;
-        }
-        
-        if (!request->hasParam("open", true)) {
-            request->send(400, "application/json", "{\"error\":\"Параметр open обязателен\"}");
-            return;
-        }
-        
-        bool open = (request->getParam("open", true)->value() == "true");
-        
-        if (open) {
-            valveOpen();
-        } else {
-            valveClose();
-        }
-        
-        request->send(200, "application/json", "{\"status\":\"ok\", \"open\":" + String(open ? "true" : "false") + "}");
-    });
+    json.beginObject();
     
-    // API для калибровки датчиков
-    server.on("/api/sensor/calibrate", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (isRectificationRunning() || isDistillationRunning()) {
-            request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, калибровка недоступна\"}");
-            return;
-        }
-        
-        if (!request->hasParam("sensor", true) || !request->hasParam("offset", true)) {
-            request->send(400, "application/json", "{\"error\":\"Параметры sensor и offset обязательны\"}");
-            return;
-        }
-        
-        int sensorIndex = request->getParam("sensor", true)->value().toInt();
-        float offset = request->getParam("offset", true)->value().toFloat();
-        
-        if (sensorIndex < 0 || sensorIndex >= MAX_TEMP_SENSORS) {
-            request->send(400, "application/json", "{\"error\":\"Некорректный индекс датчика\"}");
-            return;
-        }
-        
-        calibrateTempSensor(sensorIndex, offset);
-        
-        request->send(200, "application/json", "{\"status\":\"ok\", \"sensor\":" + String(sensorIndex) + ", \"offset\":" + String(offset) + "}");
-    });
+    // Разделы настроек по описанию полей
+    for (int i = 0; i < SETTINGS_SECTION_COUNT; i++) {
+        const SettingsSection& section = getSettingsSection((SettingsSectionId)i);
+        json.beginObject(section.name);
+        writeSettingsSection(section, getSettingsSectionData(sysSettings, section), json);
+        json.endObject();
+    }
     
-    // API для сканирования датчиков
-    server.on("/api/sensors/scan", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (isRectificationRunning() || isDistillationRunning()) {
-            request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, сканирование недоступно\"}");
-            return;
-        }
-        
-        bool success = scanForTempSensors();
-        int count = getConnectedSensorsCount();
+    // Настройки датчиков
+    json.beginObject("sensors");
+    for (int i = 0; i < MAX_TEMP_SENSORS; i++) {
+        char key[4];
+        snprintf(key, sizeof(key), "%d", i);
+        json.beginObject(key);
+        json.add("name", getTempSensorName(i));
+        json.add("enabled", sysSettings.tempSensorEnabled[i]);
+        json.add("calibration", sysSettings.tempSensorCalibration[i]);
         
-        if (success) {
-            request->send(200, "application/json", "{\"status\":\"ok\", \"count\":" + String(count) + "}");
-        } else {
-            request->send(500, "application/json", "{\"error\":\"Не удалось найти датчики\"}");
-        }
-    });
+        char address[24];
+        const uint8_t* a = sysSettings.tempSensorAddresses[i];
+        snprintf(address, sizeof(address), "%02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X",
+                 a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+        json.add("address", address);
+        json.endObject();
+    }
+    json.endObject();
     
-    // API для сброса настроек к значениям по умолчанию
-    server.on("/api/settings/reset", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (isRectificationRunning() || isDistillationRunning()) {
-            request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, сброс настроек недоступен\"}");
-            return;
-        }
-        
-        resetSystemSettings();
-        saveSystemSettings();
-        
-        request->send(200, "application/json", "{\"status\":\"ok\"}");
-    });
+    // Активный рецепт
+    json.add("recipe", getActiveRecipeName());
+    json.endObject();
+    return 200;
 }
 
-// Настройка маршрутов для статических файлов
-void setupStaticRoutes() {
-    // Обработка корневого маршрута
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/index.html", "text/html");
-    });
-    
-    // Маршруты для статических файлов
-    server.on("/styles.css", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/styles.css", "text/css");
-    });
-    
-    server.on("/main.js", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/main.js", "application/javascript");
-    });
-    
-    server.on("/manifest.json", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/manifest.json", "application/json");
-    });
+// Сведения о контроллере
+static int rpcSystemInfo(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    char text[24];
+    json.beginObject();
+    json.add("version", FIRMWARE_VERSION);
+    json.add("buildDate", __DATE__);
+    json.add("deviceModel", ESP.getChipModel());
     
-    server.on("/favicon.ico", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/favicon.ico", "image/x-icon");
-    });
+    uint8_t mac[6];
+    WiFi.macAddress(mac);
+    snprintf(text, sizeof(text), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    json.add("macAddress", text);
     
-    // Маршрут для иконок
-    server.on("/icons/icon-192.png", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/icons/icon-192.png", "image/png");
-    });
+    IPAddress ip = WiFi.localIP();
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    json.add("ipAddress", text);
     
-    server.on("/icons/icon-512.png", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(LittleFS, "/icons/icon-512.png", "image/png");
-    });
+    json.add("freeMemory", ESP.getFreeHeap());
+    json.add("uptime", millis() / 1000);
+    json.endObject();
+    return 200;
 }
 
-// Обработчик событий WebSocket
-void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, 
-                      AwsEventType type, void *arg, uint8_t *data, size_t len) {
-    switch (type) {
-        case WS_EVT_CONNECT:
-            Serial.printf("WebSocket клиент #%u подключен от %s\n", client->id(), client->remoteIP().toString().c_str());
-            webSocketActive = true;
-            break;
-        case WS_EVT_DISCONNECT:
-            Serial.printf("WebSocket клиент #%u отключен\n", client->id());
-            webSocketActive = (ws.count() > 0);
-            break;
-        case WS_EVT_DATA:
-            // Обработка входящих данных WebSocket
-            handleWebSocketMessage(arg, data, len);
-            break;
-        case WS_EVT_ERROR:
-            Serial.printf("WebSocket ошибка #%u: %u\n", client->id(), *((uint16_t*)arg));
-            break;
+// Состояние и настройки датчиков температуры
+static int rpcSensorsInfo(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    json.beginArray();
+    for (int i = 0; i < MAX_TEMP_SENSORS; i++) {
+        json.beginObject();
+        json.add("name", getTempSensorName(i));
+        json.add("connected", isSensorConnected(i));
+        json.add("temperature", getTemperature(i));
+        json.add("enabled", sysSettings.tempSensorEnabled[i]);
+        json.add("calibration", sysSettings.tempSensorCalibration[i]);
+        
+        char address[24];
+        const uint8_t* a = sysSettings.tempSensorAddresses[i];
+        snprintf(address, sizeof(address), "%02X:%02X:%02X:%02X:%02X:%02X:%02X:%02X",
+                 a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7]);
+        json.add("address", address);
+        json.endObject();
     }
+    json.endArray();
+    return 200;
 }
 
-// Обработка сообщений WebSocket
-void handleWebSocketMessage(void *arg, uint8_t *data, size_t len) {
-    AwsFrameInfo *info = (AwsFrameInfo*)arg;
-    if (info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT) {
-        // Обеспечиваем завершение нулем для строки
-        data[len] = 0;
-        
-        // Разбираем JSON
-        DynamicJsonDocument doc(1024);
-        DeserializationError error = deserializeJson(doc, (char*)data);
-        
-        if (error) {
-            Serial.println("Ошибка разбора JSON сообщения WebSocket");
+// Получение статуса системы
+static void handleStatus(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcStatusGet);
+}
+
+// Получение настроек
+static void handleSettingsGet(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcSettingsGet);
+}
+
+// Сведения о контроллере
+static void handleSystemInfo(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcSystemInfo);
+}
+
+// Сведения о датчиках температуры
+static void handleSensorsInfo(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcSensorsInfo);
+}
+
+// Прием тела запроса настроек: части собираются в буфер запроса,
+// который сервер освобождает вместе с запросом
+static void handleSettingsBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (total > SETTINGS_BODY_MAX_SIZE) {
+        return;
+    }
+    if (index == 0 && request->_tempObject == NULL) {
+        request->_tempObject = malloc(total + 1);
+    }
+    char* body = (char*)request->_tempObject;
+    if (body == NULL || index + len > total) {
+        return;
+    }
+    memcpy(body + index, data, len);
+    if (index + len == total) {
+        body[total] = '\0';
+    }
+}
+
+// Обновление настроек; вызывается один раз после приема всего тела
+static void handleSettingsPost(AsyncWebServerRequest *request) {
+    size_t length = request->contentLength();
+    if (length == 0) {
+        request->send(400, "application/json", "{\"error\":\"Пустой запрос\"}");
+        return;
+    }
+    if (length > SETTINGS_BODY_MAX_SIZE) {
+        request->send(413, "application/json", "{\"error\":\"Слишком большой запрос\"}");
+        return;
+    }
+    if (request->_tempObject == NULL) {
+        request->send(500, "application/json", "{\"error\":\"Недостаточно памяти\"}");
+        return;
+    }
+    
+    DynamicJsonDocument doc(SETTINGS_DOC_SIZE);
+    if (deserializeJson(doc, (const char*)request->_tempObject, length)) {
+        request->send(400, "application/json", "{\"error\":\"Некорректный JSON\"}");
+        return;
+    }
+    
+    // Сначала проверяем все разделы, чтобы ошибка не оставила настройки частично измененными
+    String error;
+    for (int i = 0; i < SETTINGS_SECTION_COUNT; i++) {
+        const SettingsSection& section = getSettingsSection((SettingsSectionId)i);
+        JsonObjectConst obj = doc[section.name];
+        if (!obj.isNull() && !validateSettingsSection(section, obj, 0, error)) {
+            DynamicJsonDocument response(256);
+            response["error"] = error;
+            String body;
+            serializeJson(response, body);
+            request->send(400, "application/json", body);
             return;
         }
+    }
+    
+    // Обновляем разделы настроек по описанию полей
+    for (int i = 0; i < SETTINGS_SECTION_COUNT; i++) {
+        const SettingsSection& section = getSettingsSection((SettingsSectionId)i);
+        JsonObjectConst obj = doc[section.name];
+        if (!obj.isNull()) {
+            settingsSectionFromJson(section, getSettingsSectionData(sysSettings, section), obj, 0, error);
+        }
+    }
+    
+    // Обновляем настройки датчиков
+    if (doc.containsKey("sensors")) {
+        JsonObject sensors = doc["sensors"];
+        for (JsonPair kv : sensors) {
+            int sensorIndex = atoi(kv.key().c_str());
+            if (sensorIndex >= 0 && sensorIndex < MAX_TEMP_SENSORS) {
+                JsonObject sensor = kv.value().as<JsonObject>();
+                
+                if (sensor.containsKey("calibration")) {
+                    float calibration = sensor["calibration"];
+                    calibrateTempSensor(sensorIndex, calibration);
+                }
+            }
+        }
+    }
+    
+    // Сохраняем изменённые настройки
+    saveSystemSettings();
+    
+    request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// Проверка возможности запуска процесса; выполняется до применения рецепта,
+// чтобы рецепт не перезаписал настройки идущего процесса
+static bool canStartProcess(const char*& error) {
+    if (isRectificationRunning() || isDistillationRunning()) {
+        error = "Процесс уже запущен";
+        return false;
+    }
+    if (isOtaInProgress()) {
+        error = "Идет обновление прошивки";
+        return false;
+    }
+    // Зафиксированная аварийная остановка снимается только оператором
+    if (getSafetyRuleAction() >= SAFETY_ACTION_STOP) {
+        error = "Аварийная остановка не сброшена";
+        return false;
+    }
+    return true;
+}
+
+// Применение рецепта из необязательного параметра recipe перед запуском
+static bool applyStartRecipe(JsonObjectConst params, const char*& error) {
+    const char* recipe = params["recipe"] | (const char*)nullptr;
+    if (recipe != nullptr && !loadRecipe(recipe)) {
+        error = "Рецепт не найден";
+        return false;
+    }
+    return true;
+}
+
+// Запуск процесса ректификации
+static int rpcRectificationStart(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    if (!canStartProcess(error)) {
+        return 409;
+    }
+    if (!applyStartRecipe(params, error)) {
+        return 404;
+    }
+    if (!startRectification()) {
+        error = "Не удалось запустить ректификацию";
+        return 500;
+    }
+    return rpcOk(json);
+}
+
+// Остановка процесса ректификации
+static int rpcRectificationStop(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    if (!isRectificationRunning()) {
+        error = "Процесс не запущен";
+        return 400;
+    }
+    stopRectification();
+    return rpcOk(json);
+}
+
+// Пауза процесса ректификации
+static int rpcRectificationPause(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    if (!isRectificationRunning() || isRectificationPaused()) {
+        error = "Процесс не запущен или уже на паузе";
+        return 400;
+    }
+    pauseRectification();
+    return rpcOk(json);
+}
+
+// Возобновление процесса ректификации
+static int rpcRectificationResume(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    if (!isRectificationRunning() || !isRectificationPaused()) {
+        error = "Процесс не запущен или не на паузе";
+        return 400;
+    }
+    resumeRectification();
+    return rpcOk(json);
+}
+
+// Подтверждение окончания отбора голов
+static int rpcRectificationHeadsAccept(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    if (!acceptRectificationHeadsEnd()) {
+        error = "Процесс не находится в фазе отбора голов";
+        return 400;
+    }
+    return rpcOk(json);
+}
+
+// Запуск процесса дистилляции
+static int rpcDistillationStart(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    if (!canStartProcess(error)) {
+        return 409;
+    }
+    if (!applyStartRecipe(params, error)) {
+        return 404;
+    }
+    if (!startDistillation()) {
+        error = "Не удалось запустить дистилляцию";
+        return 500;
+    }
+    return rpcOk(json);
+}
+
+// Остановка процесса дистилляции
+static int rpcDistillationStop(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    if (!isDistillationRunning()) {
+        error = "Процесс не запущен";
+        return 400;
+    }
+    stopDistillation();
+    return rpcOk(json);
+}
+
+// Пауза процесса дистилляции
+static int rpcDistillationPause(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    if (!isDistillationRunning() || isDistillationPaused()) {
+        error = "Процесс не запущен или уже на паузе";
+        return 400;
+    }
+    pauseDistillation();
+    return rpcOk(json);
+}
+
+// Возобновление процесса дистилляции
+static int rpcDistillationResume(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    if (!isDistillationRunning() || !isDistillationPaused()) {
+        error = "Процесс не запущен или не на паузе";
+        return 400;
+    }
+    resumeDistillation();
+    return rpcOk(json);
+}
+
+// API для запуска процесса ректификации
+static void handleRectificationStart(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcRectificationStart);
+}
+
+// API для остановки процесса ректификации
+static void handleRectificationStop(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcRectificationStop);
+}
+
+// API для паузы процесса ректификации
+static void handleRectificationPause(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcRectificationPause);
+}
+
+// API для возобновления процесса ректификации
+static void handleRectificationResume(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcRectificationResume);
+}
+
+// API для подтверждения окончания отбора голов
+static void handleRectificationHeadsAccept(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcRectificationHeadsAccept);
+}
+
+// API для запуска процесса дистилляции
+static void handleDistillationStart(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcDistillationStart);
+}
+
+// API для остановки процесса дистилляции
+static void handleDistillationStop(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcDistillationStop);
+}
+
+// API для паузы процесса дистилляции
+static void handleDistillationPause(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcDistillationPause);
+}
+
+// API для возобновления процесса дистилляции
+static void handleDistillationResume(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcDistillationResume);
+}
+
+// Ручная установка мощности нагревателя (Вт)
+static int rpcHeaterSet(JsonObjectConst params, JsonWriter& json, const char*& error) {
+    if (isRectificationRunning() || isDistillationRunning()) {
+        error = "Процесс уже запущен, ручное управление недоступно";
+        return 409;
+    }
+    JsonVariantConst power = params["power"];
+    if (power.isNull()) {
+        error = "Параметр power обязателен";
+        return 400;
+    }
+    int powerWatts;
+    if (power.is<const char*>()) {
+        // Из REST-маршрута значение приходит строкой
+        const char* text = power.as<const char*>();
+        char* end;
+        long value = strtol(text, &end, 10);
+        if (end == text || *end != '\0') {
+            error = "Параметр power должен быть числом";
+            return 400;
+        }
+        powerWatts = (int)value;
+    } else if (power.is<int>() || power.is<float>()) {
+        powerWatts = power.as<int>();
+    } else {
+        error = "Параметр power должен быть числом";
+        return 400;
+    }
+    if (powerWatts < 0 || powerWatts > sysSettings.heaterSettings.maxPowerWatts) {
+        error = "Недопустимая мощность";
+        return 400;
+    }
+    setHeaterPowerWatts(powerWatts);
+    json.beginObject();
+    json.add("status", "ok");
+    json.add("power", powerWatts);
+    json.endObject();
+    return 200;
+}
+
+// Методы RPC через WebSocket и MQTT; те же функции обслуживают REST-маршруты
+static const RpcMethod rpcMethods[] = {
+    { "status.get",                  rpcStatusGet },
+    { "settings.get",                rpcSettingsGet },
+    { "system.info",                 rpcSystemInfo },
+    { "sensors.info",                rpcSensorsInfo },
+    { "rectification.start",         rpcRectificationStart },
+    { "rectification.stop",          rpcRectificationStop },
+    { "rectification.pause",         rpcRectificationPause },
+    { "rectification.resume",        rpcRectificationResume },
+    { "rectification.heads.accept",  rpcRectificationHeadsAccept },
+    { "distillation.start",          rpcDistillationStart },
+    { "distillation.stop",           rpcDistillationStop },
+    { "distillation.pause",          rpcDistillationPause },
+    { "distillation.resume",         rpcDistillationResume },
+    { "heater.set",                  rpcHeaterSet },
+};
+
+#define RPC_METHOD_COUNT (sizeof(rpcMethods) / sizeof(rpcMethods[0]))
+
+// API для ручного управления нагревателем
+static void handleHeaterSet(AsyncWebServerRequest *request) {
+    callFromRest(request, rpcHeaterSet);
+}
+
+// API для ручного управления насосом
+static void handlePumpSet(AsyncWebServerRequest *request) {
+    if (isRectificationRunning() || isDistillationRunning()) {
+        request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, ручное управление недоступно\"}");
+        return;
+    }
+    
+    if (!request->hasParam("flowRate", true)) {
+        request->send(400, "application/json", "{\"error\":\"Параметр flowRate обязателен\"}");
+        return;
+    }
+    
+    float flowRate = request->getParam("flowRate", true)->value().toFloat();
+    
+    if (flowRate > 0) {
+        pumpStart(flowRate);
+    } else {
+        pumpStop();
+    }
+    
+    request->send(200, "application/json", "{\"status\":\"ok\", \"flowRate\":" + String(flowRate) + "}");
+}
+
+// API для ручного управления клапаном
+static void handleValveSet(AsyncWebServerRequest *request) {
+    if (isRectificationRunning() || isDistillationRunning()) {
+        request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, ручное управление недоступно\"}");
+        return;
+    }
+    
+    if (!request->hasParam("open", true)) {
+        request->send(400, "application/json", "{\"error\":\"Параметр open обязателен\"}");
+        return;
+    }
+    
+    bool open = (request->getParam("open", true)->value() == "true");
+    
+    if (open) {
+        valveOpen();
+    } else {
+        valveClose();
+    }
+    
+    request->send(200, "application/json", "{\"status\":\"ok\", \"open\":" + String(open ? "true" : "false") + "}");
+}
+
+// API для калибровки датчиков
+static void handleSensorCalibrate(AsyncWebServerRequest *request) {
+    if (isRectificationRunning() || isDistillationRunning()) {
+        request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, калибровка недоступна\"}");
+        return;
+    }
+    
+    if (!request->hasParam("sensor", true) || !request->hasParam("offset", true)) {
+        request->send(400, "application/json", "{\"error\":\"Параметры sensor и offset обязательны\"}");
+        return;
+    }
+    
+    int sensorIndex = request->getParam("sensor", true)->value().toInt();
+    float offset = request->getParam("offset", true)->value().toFloat();
+    
+    if (sensorIndex < 0 || sensorIndex >= MAX_TEMP_SENSORS) {
+        request->send(400, "application/json", "{\"error\":\"Некорректный индекс датчика\"}");
+        return;
+    }
+    
+    calibrateTempSensor(sensorIndex, offset);
+    
+    request->send(200, "application/json", "{\"status\":\"ok\", \"sensor\":" + String(sensorIndex) + ", \"offset\":" + String(offset) + "}");
+}
+
+// API для сканирования датчиков
+static void handleSensorsScan(AsyncWebServerRequest *request) {
+    if (isRectificationRunning() || isDistillationRunning()) {
+        request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, сканирование недоступно\"}");
+        return;
+    }
+    
+    bool success = scanForTempSensors();
+    int count = getConnectedSensorsCount();
+    
+    if (success) {
+        request->send(200, "application/json", "{\"status\":\"ok\", \"count\":" + String(count) + "}");
+    } else {
+        request->send(500, "application/json", "{\"error\":\"Не удалось найти датчики\"}");
+    }
+}
+
+// API для сравнения двух рецептов (регистрируется раньше /api/recipes)
+static void handleRecipesDiff(AsyncWebServerRequest *request) {
+    if (!request->hasParam("a") || !request->hasParam("b")) {
+        request->send(400, "application/json", "{\"error\":\"Параметры a и b обязательны\"}");
+        return;
+    }
+    
+    String nameA = request->getParam("a")->value();
+    String nameB = request->getParam("b")->value();
+    
+    DynamicJsonDocument doc(4096);
+    doc["a"] = nameA;
+    doc["b"] = nameB;
+    JsonArray diff = doc.createNestedArray("differences");
+    
+    if (!diffRecipes(nameA.c_str(), nameB.c_str(), diff)) {
+        request->send(404, "application/json", "{\"error\":\"Рецепт не найден\"}");
+        return;
+    }
+    
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+// API для загрузки рецепта в текущие настройки
+static void handleRecipesLoad(AsyncWebServerRequest *request) {
+    if (isRectificationRunning() || isDistillationRunning()) {
+        request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, смена рецепта недоступна\"}");
+        return;
+    }
+    
+    if (!request->hasParam("name", true)) {
+        request->send(400, "application/json", "{\"error\":\"Параметр name обязателен\"}");
+        return;
+    }
+    
+    String name = request->getParam("name", true)->value();
+    if (!loadRecipe(name.c_str())) {
+        request->send(404, "application/json", "{\"error\":\"Рецепт не найден\"}");
+        return;
+    }
+    
+    request->send(200, "application/json", "{\"status\":\"ok\", \"recipe\":\"" + name + "\"}");
+}
+
+// API для сохранения текущих настроек как рецепта
+static void handleRecipesSave(AsyncWebServerRequest *request) {
+    if (!request->hasParam("name", true)) {
+        request->send(400, "application/json", "{\"error\":\"Параметр name обязателен\"}");
+        return;
+    }
+    
+    String name = request->getParam("name", true)->value();
+    if (!isValidRecipeName(name.c_str())) {
+        request->send(400, "application/json", "{\"error\":\"Некорректное имя рецепта\"}");
+        return;
+    }
+    
+    if (!saveRecipe(name.c_str())) {
+        request->send(500, "application/json", "{\"error\":\"Не удалось сохранить рецепт\"}");
+        return;
+    }
+    
+    request->send(200, "application/json", "{\"status\":\"ok\", \"recipe\":\"" + name + "\"}");
+}
+
+// API для копирования рецепта
+static void handleRecipesDuplicate(AsyncWebServerRequest *request) {
+    if (!request->hasParam("from", true) || !request->hasParam("to", true)) {
+        request->send(400, "application/json", "{\"error\":\"Параметры from и to обязательны\"}");
+        return;
+    }
+    
+    String from = request->getParam("from", true)->value();
+    String to = request->getParam("to", true)->value();
+    if (!isValidRecipeName(to.c_str())) {
+        request->send(400, "application/json", "{\"error\":\"Некорректное имя рецепта\"}");
+        return;
+    }
+    
+    if (!duplicateRecipe(from.c_str(), to.c_str())) {
+        request->send(409, "application/json", "{\"error\":\"Не удалось скопировать рецепт\"}");
+        return;
+    }
+    
+    request->send(200, "application/json", "{\"status\":\"ok\", \"recipe\":\"" + to + "\"}");
+}
+
+// API для удаления рецепта
+static void handleRecipesDelete(AsyncWebServerRequest *request) {
+    if (!request->hasParam("name", true)) {
+        request->send(400, "application/json", "{\"error\":\"Параметр name обязателен\"}");
+        return;
+    }
+    
+    String name = request->getParam("name", true)->value();
+    if (!deleteRecipe(name.c_str())) {
+        request->send(404, "application/json", "{\"error\":\"Рецепт не найден\"}");
+        return;
+    }
+    
+    request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// API для получения списка рецептов
+static void handleRecipes(AsyncWebServerRequest *request) {
+    RecipeInfo list[MAX_RECIPES];
+    int count = listRecipes(list, MAX_RECIPES);
+    
+    DynamicJsonDocument doc(2048);
+    doc["active"] = getActiveRecipeName();
+    JsonArray recipes = doc.createNestedArray("recipes");
+    
+    for (int i = 0; i < count; i++) {
+        JsonObject recipe = recipes.createNestedObject();
+        recipe["name"] = list[i].name;
+        recipe["version"] = list[i].version;
+        recipe["size"] = list[i].size;
+    }
+    
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+// API для сброса записи о неисправности задачи
+static void handleSupervisorClear(AsyncWebServerRequest *request) {
+    clearSupervisorFault();
+    request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// API для сброса аварийной остановки оператором
+static void handleSafetyReset(AsyncWebServerRequest *request) {
+    if (!resetSafetyLatch()) {
+        request->send(409, "application/json", "{\"error\":\"Условие аварии сохраняется\"}");
+        return;
+    }
+    request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// API для получения статистики задач
+static void handleSupervisor(AsyncWebServerRequest *request) {
+    DynamicJsonDocument doc(2048);
+    
+    JsonArray tasks = doc.createNestedArray("tasks");
+    for (int i = 0; i < getHeartbeatCount(); i++) {
+        const HeartbeatStats& hb = getHeartbeatStats(i);
+        unsigned long lastBeat = hb.lastBeat;
+        JsonObject task = tasks.createNestedObject();
+        task["name"] = hb.name;
+        task["state"] = hb.state;
+        task["expectedPeriod"] = hb.expectedPeriod;
+        task["timeout"] = hb.timeout;
+        task["silent"] = millis() - lastBeat;
+        task["lastPeriod"] = hb.lastPeriod;
+        task["minPeriod"] = hb.minPeriod;
+        task["maxPeriod"] = hb.maxPeriod;
+        task["avgPeriod"] = hb.avgPeriod;
+        task["beats"] = hb.beats;
+        task["overruns"] = hb.overruns;
+        task["misses"] = hb.misses;
+    }
+    
+    const SupervisorFault& fault = getSupervisorFault();
+    JsonObject faultObj = doc.createNestedObject("fault");
+    faultObj["active"] = fault.active;
+    if (fault.active) {
+        faultObj["task"] = fault.task;
+        faultObj["state"] = fault.state;
+        faultObj["silentTime"] = fault.silentTime;
+        faultObj["uptime"] = fault.uptime;
+    }
+    
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+#ifdef FAULT_INJECTION
+// API для запуска сценария внесения неисправности
+static void handleFaultsRun(AsyncWebServerRequest *request) {
+    if (!request->hasParam("scenario", true)) {
+        request->send(400, "application/json", "{\"error\":\"Не указан сценарий\"}");
+        return;
+    }
+    String scenario = request->getParam("scenario", true)->value();
+    
+    if (isFaultInjectionActive()) {
+        request->send(409, "application/json", "{\"error\":\"Сценарий уже выполняется\"}");
+        return;
+    }
+    if (!startFaultScenario(scenario.c_str())) {
+        request->send(404, "application/json", "{\"error\":\"Сценарий не найден\"}");
+        return;
+    }
+    request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// API для получения матрицы результатов сценариев
+static void handleFaults(AsyncWebServerRequest *request) {
+    DynamicJsonDocument doc(3072);
+    
+    doc["active"] = isFaultInjectionActive();
+    JsonArray list = doc.createNestedArray("scenarios");
+    for (int i = 0; i < getFaultScenarioCount(); i++) {
+        const FaultScenario& scenario = getFaultScenario(i);
+        const FaultResult& result = getFaultResult(i);
+        JsonObject item = list.createNestedObject();
+        item["name"] = scenario.name;
+        item["done"] = result.done;
+        if (result.done) {
+            item["running"] = result.running;
+            item["expected"] = (int)result.expected;
+            item["observed"] = (int)result.observed;
+            item["reactionTime"] = result.reactionTime;
+            item["maxReaction"] = scenario.maxReaction;
+            item["passed"] = result.passed;
+        }
+    }
+    
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+#endif
+
+// API для продолжения прерванного процесса
+static void handleCheckpointResume(AsyncWebServerRequest *request) {
+    if (!hasPendingCheckpoint()) {
+        request->send(404, "application/json", "{\"error\":\"Нет прерванного процесса\"}");
+        return;
+    }
+    
+    if (isOtaInProgress()) {
+        request->send(409, "application/json", "{\"error\":\"Идет обновление прошивки\"}");
+        return;
+    }
+    
+    if (!resumeFromCheckpoint()) {
+        request->send(409, "application/json", "{\"error\":\"Продолжение процесса небезопасно\"}");
+        return;
+    }
+    
+    request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// API для отказа от продолжения прерванного процесса
+static void handleCheckpointDiscard(AsyncWebServerRequest *request) {
+    discardCheckpoint();
+    request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// API для получения состояния прерванного процесса
+static void handleCheckpoint(AsyncWebServerRequest *request) {
+    DynamicJsonDocument doc(512);
+    doc["pending"] = hasPendingCheckpoint();
+    doc["decision"] = getCheckpointDecisionName(evaluateCheckpoint());
+    doc["restoreTime"] = getCheckpointRestoreTime();
+    doc["writes"] = getCheckpointWriteCount();
+    
+    if (hasPendingCheckpoint()) {
+        const ProcessCheckpoint& cp = getPendingCheckpoint();
+        doc["process"] = cp.process == CHECKPOINT_RECTIFICATION ? "rectification" : "distillation";
+        doc["phase"] = cp.phase;
+        doc["uptime"] = cp.uptime;
+        doc["paused"] = (cp.flags & CHECKPOINT_FLAG_PAUSED) != 0;
+        doc["savedCubeTemp"] = cp.cubeTemp;
+        doc["cubeTemp"] = getTemperature(TEMP_CUBE);
         
-        // Обрабатываем команды
-        if (doc.containsKey("cmd")) {
-            String command = doc["cmd"];
+        JsonArray volumes = doc.createNestedArray("volumes");
+        for (int i = 0; i < 3; i++) {
+            volumes.add(cp.volumes[i]);
+        }
+    }
+    
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+// API для получения телеметрии процесса за диапазон времени
+static void handleTelemetry(AsyncWebServerRequest *request) {
+    uint32_t from = request->hasParam("from") ? request->getParam("from")->value().toInt() : 0;
+    uint32_t to = request->hasParam("to") ? request->getParam("to")->value().toInt() : UINT32_MAX;
+    uint16_t points = request->hasParam("points") ?
+        constrain(request->getParam("points")->value().toInt(), 1, TELEMETRY_MAX_POINTS) : TELEMETRY_DEFAULT_POINTS;
+    
+    // Ответ отдается частями по мере отправки, память не зависит от числа точек
+    std::shared_ptr<TelemetryExport> exp = std::make_shared<TelemetryExport>();
+    if (!beginTelemetryQuery(*exp, from, to, points)) {
+        request->send(503, "application/json", "{\"error\":\"Журнал телеметрии занят\"}");
+        return;
+    }
+    
+    AwsResponseFiller filler = [exp](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        size_t length = readTelemetryExport(*exp, buffer, maxLen);
+        return length == TELEMETRY_EXPORT_BUSY ? RESPONSE_TRY_AGAIN : length;
+    };
+    request->send(request->beginChunkedResponse("application/json", filler));
+}
+
+// API для выгрузки журнала телеметрии (CSV или двоичный формат)
+static void handleHistory(AsyncWebServerRequest *request) {
+    String formatName = request->hasParam("format") ? request->getParam("format")->value() : String("csv");
+    if (formatName != "csv" && formatName != "bin") {
+        request->send(400, "application/json", "{\"error\":\"Неизвестный формат выгрузки\"}");
+        return;
+    }
+    
+    uint8_t format = formatName == "bin" ? TELEMETRY_EXPORT_BIN : TELEMETRY_EXPORT_CSV;
+    uint32_t from = request->hasParam("from") ? request->getParam("from")->value().toInt() : 0;
+    uint32_t to = request->hasParam("to") ? request->getParam("to")->value().toInt() : UINT32_MAX;
+    uint16_t step = request->hasParam("step") ? constrain(request->getParam("step")->value().toInt(), 1, 3600) : 10;
+    
+    // Продолжение прерванной загрузки: поддерживается диапазон вида bytes=N-
+    uint32_t offset = 0;
+    if (request->hasHeader("Range")) {
+        String range = request->getHeader("Range")->value();
+        if (range.startsWith("bytes=") && range.endsWith("-")) {
+            offset = range.substring(6, range.length() - 1).toInt();
+        }
+    }
+    
+    // Состояние выгрузки живет, пока ответ не отправлен; память не зависит от длины журнала
+    std::shared_ptr<TelemetryExport> exp = std::make_shared<TelemetryExport>();
+    if (!beginTelemetryExport(*exp, format, from, to, step, offset)) {
+        request->send(503, "application/json", "{\"error\":\"Журнал телеметрии занят\"}");
+        return;
+    }
+    
+    // Продолжение относится к той же выгрузке, только если ETag не изменился:
+    // If-Match отклоняется, при несовпадении If-Range выгрузка отдается целиком
+    if (request->hasHeader("If-Match") && request->getHeader("If-Match")->value() != exp->tag) {
+        request->send(412, "application/json", "{\"error\":\"Журнал изменился, загрузите выгрузку заново\"}");
+        return;
+    }
+    if (offset > 0 && request->hasHeader("If-Range") && request->getHeader("If-Range")->value() != exp->tag) {
+        offset = 0;
+        if (!beginTelemetryExport(*exp, format, from, to, step, 0)) {
+            request->send(503, "application/json", "{\"error\":\"Журнал телеметрии занят\"}");
+            return;
+        }
+    }
+    
+    AwsResponseFiller filler = [exp](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+        size_t length = readTelemetryExport(*exp, buffer, maxLen);
+        return length == TELEMETRY_EXPORT_BUSY ? RESPONSE_TRY_AGAIN : length;
+    };
+    
+    const char* contentType = format == TELEMETRY_EXPORT_BIN ? "application/octet-stream" : "text/csv";
+    AsyncWebServerResponse *response;
+    if (offset > 0) {
+        uint32_t total = exp->size;
+        if (offset >= total) {
+            response = request->beginResponse(416, "application/json", "{\"error\":\"Диапазон за пределами выгрузки\"}");
+            response->addHeader("Content-Range", "bytes */" + String(total));
+            response->addHeader("ETag", exp->tag);
+            request->send(response);
+            return;
+        }
+        response = request->beginResponse(contentType, total - offset, filler);
+        response->setCode(206);
+        response->addHeader("Content-Range", "bytes " + String(offset) + "-" + String(total - 1) + "/" + String(total));
+    } else {
+        response = request->beginChunkedResponse(contentType, filler);
+    }
+    
+    // Конец диапазона фиксируется при первом запросе, продолжение передает его в to
+    response->addHeader("Accept-Ranges", "bytes");
+    response->addHeader("ETag", exp->tag);
+    response->addHeader("X-History-To", String(exp->to));
+    response->addHeader("Content-Disposition", "attachment; filename=\"history." + formatName + "\"");
+    request->send(response);
+}
+
+// API для получения уровней журнала событий
+static void handleLog(AsyncWebServerRequest *request) {
+    DynamicJsonDocument doc(512);
+    doc["dropped"] = getEventLogDropped();
+    JsonObject levels = doc.createNestedObject("levels");
+    for (int i = 0; i < LOG_MODULE_COUNT; i++) {
+        levels[getLogModuleName((LogModule)i)] = getLogLevelName(getLogLevel((LogModule)i));
+    }
+    
+    String response;
+    serializeJson(doc, response);
+    request->send(200, "application/json", response);
+}
+
+// API для установки уровня журнала событий (module=all меняет все модули)
+static void handleLogLevel(AsyncWebServerRequest *request) {
+    if (!request->hasParam("module", true) || !request->hasParam("level", true)) {
+        request->send(400, "application/json", "{\"error\":\"Параметры module и level обязательны\"}");
+        return;
+    }
+    
+    String moduleName = request->getParam("module", true)->value();
+    LogLevel level;
+    if (!findLogLevel(request->getParam("level", true)->value().c_str(), level)) {
+        request->send(400, "application/json", "{\"error\":\"Неизвестный уровень журнала\"}");
+        return;
+    }
+    
+    if (moduleName == "all") {
+        for (int i = 0; i < LOG_MODULE_COUNT; i++) {
+            setLogLevel((LogModule)i, level);
+        }
+    } else {
+        LogModule module = findLogModule(moduleName.c_str());
+        if (module == LOG_MODULE_COUNT) {
+            request->send(404, "application/json", "{\"error\":\"Модуль журнала не найден\"}");
+            return;
+        }
+        setLogLevel(module, level);
+    }
+    
+    request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// API для сброса настроек к значениям по умолчанию
+static void handleSettingsReset(AsyncWebServerRequest *request) {
+    if (isRectificationRunning() || isDistillationRunning()) {
+        request->send(409, "application/json", "{\"error\":\"Процесс уже запущен, сброс настроек недоступен\"}");
+        return;
+    }
+    
+    resetSystemSettings();
+    saveSystemSettings();
+    
+    request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// Буфер страницы метрик; занят, пока ответ не отправлен
+static char metricsBuffer[METRICS_BUFFER_SIZE];
+static std::atomic<bool> metricsBufferUsed(false);
+
+// Метрики для Prometheus
+static void handleMetrics(AsyncWebServerRequest *request) {
+    bool expected = false;
+    if (!metricsBufferUsed.compare_exchange_strong(expected, true)) {
+        sendJsonError(request, 503, "Метрики уже формируются для другого запроса");
+        return;
+    }
+    
+    size_t length = writeMetrics(metricsBuffer, sizeof(metricsBuffer));
+    if (length == 0) {
+        metricsBufferUsed.store(false);
+        Serial.println("Метрики не помещаются в буфер");
+        sendJsonError(request, 500, "Метрики не помещаются в буфер");
+        return;
+    }
+    
+    // Ответ читает текст прямо из буфера, буфер освобождается после отправки
+    request->onDisconnect([]() {
+        metricsBufferUsed.store(false);
+    });
+    request->send_P(200, METRICS_CONTENT_TYPE, (const uint8_t*)metricsBuffer, length);
+}
+
+// Поток /events с неизвестным типом в параметре types: допустимые
+// запросы принимают обработчики потока событий, зарегистрированные раньше
+static void handleEventsInvalid(AsyncWebServerRequest *request) {
+    sendJsonError(request, 400, "Неизвестный тип событий (status, telemetry, notification, log)");
+}
+
+// Параметры обновления из строки запроса: назначение и SHA-256 образа
+static bool getOtaParams(AsyncWebServerRequest *request, OtaTarget& target, const char*& sha256, const char*& error) {
+    const char* type = request->hasParam("type") ? request->getParam("type")->value().c_str() : "firmware";
+    if (!parseOtaTarget(type, target)) {
+        error = "Параметр type: firmware или filesystem";
+        return false;
+    }
+    sha256 = request->hasParam("sha256") ? request->getParam("sha256")->value().c_str() : nullptr;
+    return true;
+}
+
+// Прием образа обновления: части тела сразу пишутся во флеш-память
+static void handleOtaBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+    if (index == 0) {
+        OtaTarget target;
+        const char* sha256 = nullptr;
+        const char* error = nullptr;
+        // Ошибку начала отправляет handleOta после приема тела
+        if (!getOtaParams(request, target, sha256, error) ||
+            beginOta(request, target, sha256, total, error) != 200) {
+            return;
+        }
+        // Обрыв соединения прерывает обновление
+        request->onDisconnect([request]() {
+            abortOta(request);
+        });
+    }
+    writeOta(request, data, len);
+}
+
+// Завершение обновления: проверка образа и перезагрузка
+static void handleOta(AsyncWebServerRequest *request) {
+    const char* error = nullptr;
+    if (!isOtaOwner(request)) {
+        // Прием не начался: возвращается отказ beginOta, а без него
+        // проверки повторяются, чтобы вернуть их ошибку
+        OtaTarget target;
+        const char* sha256 = nullptr;
+        int code = getOtaBeginError(request, error);
+        if (code == 0) {
+            code = getOtaParams(request, target, sha256, error) ?
+                   checkOta(target, sha256, request->contentLength(), error) : 400;
+        }
+        if (code == 200) {
+            code = 500;
+            error = "Не удалось начать запись образа";
+        }
+        sendJsonError(request, code, error);
+        return;
+    }
+    
+    bool restart = false;
+    int code = finishOta(request, error, restart);
+    if (restart) {
+        // Перезагрузка после отправки ответа, без задержки в обработчике
+        request->onDisconnect([]() {
+            ESP.restart();
+        });
+    }
+    if (code == 200) {
+        request->send(200, "application/json", "{\"status\":\"ok\"}");
+    } else {
+        sendJsonError(request, code, error);
+    }
+}
+
+// Состояние обновления и разделов прошивки
+static void handleOtaStatus(AsyncWebServerRequest *request) {
+    PooledJsonWriter json;
+    writeOtaStatus(json);
+    json.send(request);
+}
+
+// Перезагрузка контроллера
+static void handleReboot(AsyncWebServerRequest *request) {
+    if (isRectificationRunning() || isDistillationRunning()) {
+        request->send(409, "application/json", "{\"error\":\"Процесс запущен, перезагрузка недоступна\"}");
+        return;
+    }
+    
+    // Перезагрузка после отправки ответа, без задержки в обработчике
+    request->onDisconnect([]() {
+        ESP.restart();
+    });
+    request->send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+static void handleWebStats(AsyncWebServerRequest *request);
+
+// Таблица маршрутов API. Обработчик с путем /x также принимает /x/..., поэтому
+// более длинные пути с тем же началом и методом идут раньше.
+static constexpr WebRoute apiRoutes[] = {
+    { HTTP_GET,  "/api/status",                      handleStatus },
+    { HTTP_GET,  "/api/system/info",                 handleSystemInfo },
+    { HTTP_GET,  "/api/sensors/info",                handleSensorsInfo },
+    { HTTP_POST, "/api/settings/reset",              handleSettingsReset },
+    { HTTP_GET,  "/api/settings",                    handleSettingsGet },
+    { HTTP_POST, "/api/settings",                    handleSettingsPost, NULL, handleSettingsBody },
+    { HTTP_POST, "/api/rectification/start",         handleRectificationStart },
+    { HTTP_POST, "/api/rectification/stop",          handleRectificationStop },
+    { HTTP_POST, "/api/rectification/pause",         handleRectificationPause },
+    { HTTP_POST, "/api/rectification/resume",        handleRectificationResume },
+    { HTTP_POST, "/api/rectification/heads/accept",  handleRectificationHeadsAccept },
+    { HTTP_POST, "/api/distillation/start",          handleDistillationStart },
+    { HTTP_POST, "/api/distillation/stop",           handleDistillationStop },
+    { HTTP_POST, "/api/distillation/pause",          handleDistillationPause },
+    { HTTP_POST, "/api/distillation/resume",         handleDistillationResume },
+    { HTTP_POST, "/api/heater/set",                  handleHeaterSet },
+    { HTTP_POST, "/api/pump/set",                    handlePumpSet },
+    { HTTP_POST, "/api/valve/set",                   handleValveSet },
+    { HTTP_POST, "/api/sensor/calibrate",            handleSensorCalibrate },
+    { HTTP_POST, "/api/sensors/scan",                handleSensorsScan },
+    { HTTP_GET,  "/api/recipes/diff",                handleRecipesDiff },
+    { HTTP_POST, "/api/recipes/load",                handleRecipesLoad },
+    { HTTP_POST, "/api/recipes/save",                handleRecipesSave },
+    { HTTP_POST, "/api/recipes/duplicate",           handleRecipesDuplicate },
+    { HTTP_POST, "/api/recipes/delete",              handleRecipesDelete },
+    { HTTP_GET,  "/api/recipes",                     handleRecipes },
+    { HTTP_POST, "/api/safety/reset",                handleSafetyReset },
+    { HTTP_POST, "/api/supervisor/clear",            handleSupervisorClear },
+    { HTTP_GET,  "/api/supervisor",                  handleSupervisor },
+#ifdef FAULT_INJECTION
+    { HTTP_POST, "/api/faults/run",                  handleFaultsRun },
+    { HTTP_GET,  "/api/faults",                      handleFaults },
+#endif
+    { HTTP_POST, "/api/checkpoint/resume",           handleCheckpointResume },
+    { HTTP_POST, "/api/checkpoint/discard",          handleCheckpointDiscard },
+    { HTTP_GET,  "/api/checkpoint",                  handleCheckpoint },
+    { HTTP_GET,  "/api/telemetry",                   handleTelemetry },
+    { HTTP_GET,  "/api/history",                     handleHistory },
+    { HTTP_GET,  "/api/log",                         handleLog },
+    { HTTP_POST, "/api/log/level",                   handleLogLevel },
+    { HTTP_GET,  "/api/web/stats",                   handleWebStats },
+    { HTTP_GET,  "/metrics",                         handleMetrics },
+    { HTTP_GET,  "/api/ota",                         handleOtaStatus },
+    { HTTP_POST, "/api/ota",                         handleOta, NULL, handleOtaBody },
+    { HTTP_POST, "/api/reboot",                      handleReboot },
+    { HTTP_GET,  "/events",                          handleEventsInvalid },
+};
+
+#define API_ROUTE_COUNT (sizeof(apiRoutes) / sizeof(apiRoutes[0]))
+
+// Время выполнения обработчиков маршрутов
+static WebRouteStats routeStats[API_ROUTE_COUNT];
+
+// Статистика веб-сервера: память и время обработчиков
+static void handleWebStats(AsyncWebServerRequest *request) {
+    PooledJsonWriter json;
+    json.beginObject();
+    json.add("freeHeap", ESP.getFreeHeap());
+    json.add("minFreeHeap", ESP.getMinFreeHeap());
+    json.add("maxAllocHeap", ESP.getMaxAllocHeap());
+    json.add("bootFreeHeap", bootFreeHeap);
+    json.add("wsClients", ws.count());
+    json.key("ws");
+    writeWsClientStats(json);
+    json.key("sse");
+    writeEventStreamStats(json);
+    json.key("mqtt");
+    writeMqttBridgeStats(json);
+    
+    JsonPoolStats pool = getJsonPoolStats();
+    json.beginObject("jsonPool");
+    json.add("size", JSON_BUFFER_COUNT);
+    json.add("inUse", pool.inUse);
+    json.add("maxInUse", pool.maxInUse);
+    json.add("exhausted", pool.exhausted);
+    json.add("overflows", pool.overflows);
+    json.endObject();
+    
+    json.beginArray("routes");
+    for (size_t i = 0; i < API_ROUTE_COUNT; i++) {
+        const WebRouteStats& stats = routeStats[i];
+        if (stats.count == 0) {
+            continue;
+        }
+        json.beginObject();
+        json.add("path", apiRoutes[i].path);
+        json.add("method", apiRoutes[i].method == HTTP_GET ? "GET" : "POST");
+        json.add("count", stats.count);
+        json.add("avgUs", stats.totalMicros / stats.count);
+        json.add("maxUs", stats.maxMicros);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+    
+    json.send(request);
+}
+
+// Настройка маршрутов API
+void setupApiRoutes() {
+    for (size_t i = 0; i < API_ROUTE_COUNT; i++) {
+        const WebRoute& route = apiRoutes[i];
+        server.on(route.path, route.method, [i](AsyncWebServerRequest *request) {
+            unsigned long start = micros();
+            apiRoutes[i].handler(request);
+            unsigned long elapsed = micros() - start;
             
-            if (command == "getStatus") {
-                // Принудительно обновляем статус WebSocket
-                lastWsUpdate = 0;
-                updateWebSocket();
+            WebRouteStats& stats = routeStats[i];
+            stats.count++;
+            stats.totalMicros += elapsed;
+            if (elapsed > stats.maxMicros) {
+                stats.maxMicros = elapsed;
             }
-            // Можно добавить другие команды, если потребуется
+        }, route.upload, route.body);
+    }
+}
+
+// Настройка маршрутов для статических файлов
+#ifdef WEB_ASSETS_EMBEDDED
+// Отправка встроенного ресурса: 304 при совпадении ETag, иначе сжатые данные из флеш-памяти
+static void sendWebAsset(AsyncWebServerRequest *request, const WebAsset* asset) {
+    const char* cacheControl = asset->immutable ? "public, max-age=31536000, immutable" : "no-cache";
+    
+    AsyncWebServerResponse *response;
+    if (request->hasHeader("If-None-Match") &&
+        request->header("If-None-Match").indexOf(asset->etag) >= 0) {
+        response = request->beginResponse(304);
+    } else {
+        response = request->beginResponse_P(200, asset->contentType, asset->data, asset->length);
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", asset->etag);
+    response->addHeader("Cache-Control", cacheControl);
+    request->send(response);
+}
+#endif
+
+void setupStaticRoutes() {
+#ifdef WEB_ASSETS_EMBEDDED
+    for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        const WebAsset* asset = &webAssets[i];
+        server.on(asset->path, HTTP_GET, [asset](AsyncWebServerRequest *request) {
+            sendWebAsset(request, asset);
+        });
+        
+        // Корневой маршрут отдает главную страницу
+        if (strcmp(asset->path, WEB_ASSET_ENTRY) == 0) {
+            server.on("/", HTTP_GET, [asset](AsyncWebServerRequest *request) {
+                sendWebAsset(request, asset);
+            });
         }
     }
-}
\ No newline at end of file
+#else
+    // Сборка без встроенных ресурсов: файлы с LittleFS (при наличии отдается вариант .gz).
+    // Во время записи образа файловой системы файлы не отдаются
+    server.serveStatic("/", LittleFS, "/")
+        .setDefaultFile("index.html")
+        .setCacheControl("no-cache")
+        .setFilter([](AsyncWebServerRequest *request) {
+            return !isFileAccessClosed();
+        });
+#endif
+}
+
+// Обработчик событий WebSocket
+void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, 
+                      AwsEventType type, void *arg, uint8_t *data, size_t len) {
+    switch (type) {
+        case WS_EVT_CONNECT:
+            if (!wsClientConnected(client)) {
+                Serial.printf("WebSocket клиент #%u отклонен: превышено число клиентов\n", client->id());
+                client->close();
+                break;
+            }
+            Serial.printf("WebSocket клиент #%u подключен от %s\n", client->id(), client->remoteIP().toString().c_str());
+            webSocketActive = true;
+            break;
+        case WS_EVT_DISCONNECT:
+            Serial.printf("WebSocket клиент #%u отключен\n", client->id());
+            wsClientDisconnected(client->id());
+            webSocketActive = (ws.count() > 0);
+            break;
+        case WS_EVT_DATA:
+            // Обработка входящих данных WebSocket
+            handleWebSocketMessage(client, arg, data, len);
+            break;
+        case WS_EVT_ERROR:
+            Serial.printf("WebSocket ошибка #%u: %u\n", client->id(), *((uint16_t*)arg));
+            break;
+    }
+}
+
+// Поиск метода RPC по имени
+static const RpcMethod* findRpcMethod(const char* name) {
+    for (size_t i = 0; i < RPC_METHOD_COUNT; i++) {
+        if (strcmp(rpcMethods[i].name, name) == 0) {
+            return &rpcMethods[i];
+        }
+    }
+    return nullptr;
+}
+
+// Вызов метода RPC по имени
+int callRpcMethod(const char* name, JsonObjectConst params, JsonWriter& json, const char*& error) {
+    const RpcMethod* method = findRpcMethod(name);
+    if (method == nullptr) {
+        error = "Метод не найден";
+        return 404;
+    }
+    return method->handler(params, json, error);
+}
+
+// Запись полей ответа на один вызов RPC: id и result либо error
+static void writeRpcResponse(JsonObjectConst call, JsonWriter& json) {
+    JsonVariantConst id = call["id"];
+    if (id.is<long>()) {
+        json.add("id", id.as<long>());
+    } else if (id.is<const char*>()) {
+        json.add("id", id.as<const char*>());
+    } else {
+        json.add("id", (const char*)nullptr);
+    }
+    
+    const RpcMethod* method = findRpcMethod(call["method"] | "");
+    const char* error = "Метод не найден";
+    int code = 404;
+    
+    // Результат, не поместившийся в буфер, заменяется ошибкой
+    JsonWriterMark mark = json.mark();
+    if (method != nullptr) {
+        json.key("result");
+        error = nullptr;
+        code = method->handler(call["params"], json, error);
+        if (code == 200 && json.overflowed()) {
+            code = 413;
+            error = "Ответ не помещается в буфер";
+        }
+    }
+    if (code != 200) {
+        json.rewind(mark);
+        json.beginObject("error");
+        json.add("code", code);
+        json.add("message", error != nullptr ? error : "Ошибка выполнения запроса");
+        json.endObject();
+    }
+}
+
+// Отправка ошибки RPC, не относящейся к конкретному вызову
+static void sendRpcError(AsyncWebSocketClient *client, int code, const char* message) {
+    char buffer[192];
+    JsonWriter json(buffer, sizeof(buffer));
+    json.beginObject();
+    json.add("type", "rpc");
+    json.add("id", (const char*)nullptr);
+    json.beginObject("error");
+    json.add("code", code);
+    json.add("message", message);
+    json.endObject();
+    json.endObject();
+    wsSend(client, json.c_str(), json.length(), WS_MESSAGE_REPLY);
+}
+
+// Обработка сообщений WebSocket
+void handleWebSocketMessage(AsyncWebSocketClient *client, void *arg, uint8_t *data, size_t len) {
+    AwsFrameInfo *info = (AwsFrameInfo*)arg;
+    if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT) {
+        // Сообщения, разбитые на фрагменты, не поддерживаются
+        return;
+    }
+    
+    DynamicJsonDocument doc(WS_RPC_DOC_SIZE);
+    DeserializationError parseError = deserializeJson(doc, (const char*)data, len);
+    if (parseError) {
+        sendRpcError(client, 400, "Ошибка разбора JSON");
+        return;
+    }
+    
+    // Прежняя команда запроса статуса
+    if (doc.containsKey("cmd")) {
+        if (strcmp(doc["cmd"] | "", "getStatus") == 0) {
+            sendStatusToClients();
+        }
+        return;
+    }
+    
+    PooledJsonWriter json;
+    json.beginObject();
+    json.add("type", "rpc");
+    if (doc.is<JsonArray>()) {
+        JsonArrayConst calls = doc.as<JsonArrayConst>();
+        if (calls.size() > WS_RPC_MAX_BATCH) {
+            sendRpcError(client, 413, "Слишком много вызовов в пакете");
+            return;
+        }
+        json.beginArray("responses");
+        for (JsonObjectConst call : calls) {
+            json.beginObject();
+            writeRpcResponse(call, json);
+            json.endObject();
+        }
+        json.endArray();
+    } else {
+        writeRpcResponse(doc.as<JsonObjectConst>(), json);
+    }
+    json.endObject();
+    
+    if (json.ok()) {
+        wsSend(client, json.c_str(), json.length(), WS_MESSAGE_REPLY);
+    } else if (json.c_str() == nullptr) {
+        sendRpcError(client, 503, "Нет свободного буфера ответа");
+    } else {
+        sendRpcError(client, 413, "Ответ не помещается в буфер");
+    }
+}
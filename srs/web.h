@@ -10,6 +10,10 @@
 
 #include <Arduino.h>
 #include <AsyncWebSocket.h>
+#include <ArduinoJson.h>
+#include "config.h"
+
+class JsonWriter;
 
 /**
  * @brief Инициализация модуля веб-сервера
@@ -23,6 +27,37 @@ void initWebServer();
  */
 void updateWebSocket();
 
+/**
+ * @brief Запись сообщения о статусе системы
+ * 
+ * То же сообщение получают клиенты WebSocket, SSE и MQTT.
+ */
+void writeStatus(JsonWriter& json);
+
+/**
+ * @brief Отправка статуса системы клиентам WebSocket
+ * 
+ * Единственный источник сообщений о статусе: вызывается периодически из
+ * updateWebSocket() и внеочередно при смене состояния процесса.
+ */
+void sendStatusToClients();
+
+/**
+ * @brief Отправка уведомления клиентам WebSocket
+ * 
+ * @param type Тип уведомления
+ * @param message Текст уведомления
+ */
+void sendNotificationToClients(NotificationType type, const String& message);
+
+/**
+ * @brief Отправка записи журнала событий клиентам WebSocket
+ * 
+ * @param json Сообщение в формате JSON
+ * @param length Длина сообщения
+ */
+void sendLogToClients(const char* json, size_t length);
+
 /**
  * @brief Настройка маршрутов API
  * 
@@ -33,7 +68,10 @@ void setupApiRoutes();
 /**
  * @brief Настройка маршрутов для статических файлов
  * 
- * Настраивает маршруты для обслуживания HTML, CSS, JavaScript и других статических файлов.
+ * Ресурсы, встроенные в прошивку (web_assets.h), отдаются сжатыми gzip
+ * со строгим ETag и ответом 304 при совпадении If-None-Match. Ресурсы с хешем
+ * в имени кэшируются как неизменяемые, главная страница перепроверяется при
+ * каждой загрузке. Без web_assets.h файлы отдаются с LittleFS.
  */
 void setupStaticRoutes();
 
@@ -53,10 +91,31 @@ void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client,
 /**
  * @brief Обработка сообщений WebSocket
  * 
+ * Сообщение - вызов RPC {"id":1,"method":"status.get","params":{...}}
+ * или пакет таких вызовов в массиве. Ответ отправляется только
+ * отправившему клиенту: {"type":"rpc","id":1,"result":...} или
+ * {"type":"rpc","id":1,"error":{"code":404,"message":"..."}}, для пакета -
+ * {"type":"rpc","responses":[...]} одним сообщением.
+ * Поддерживается и прежняя команда {"cmd":"getStatus"}.
+ * 
+ * @param client Клиент, отправивший сообщение
  * @param arg Аргументы события
  * @param data Данные сообщения
  * @param len Длина данных
  */
-void handleWebSocketMessage(void *arg, uint8_t *data, size_t len);
+void handleWebSocketMessage(AsyncWebSocketClient *client, void *arg, uint8_t *data, size_t len);
+
+/**
+ * @brief Вызов метода RPC по имени
+ * 
+ * Та же таблица методов, что и для WebSocket; используется мостом MQTT.
+ * 
+ * @param name Имя метода ("rectification.start", "heater.set", ...)
+ * @param params Параметры вызова
+ * @param json Запись результата
+ * @param error Описание ошибки, если код ответа не 200
+ * @return Код ответа (200, 400, 404, 409, 500)
+ */
+int callRpcMethod(const char* name, JsonObjectConst params, JsonWriter& json, const char*& error);
 
 #endif // WEB_H
\ No newline at end of file
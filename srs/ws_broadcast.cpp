@@ -0,0 +1,280 @@
+/**
+ * @file ws_broadcast.cpp
+ * @brief Реализация рассылки WebSocket с учетом очереди клиентов
+ */
+
+#include "ws_broadcast.h"
+#include "json_writer.h"
+#include "event_log.h"
+
+// Состояние клиента
+struct WsClientState {
+    uint32_t id;                    // Идентификатор клиента (0 - место свободно)
+    uint32_t ip;                    // Адрес клиента
+    size_t maxSpace;                // Наибольшее свободное место в буфере TCP (размер буфера)
+    size_t backlog;                 // Сообщения в очереди библиотеки, не попавшие в TCP
+    size_t lastLength;              // Размер последнего отправленного сообщения
+    size_t outstanding;             // Последняя оценка неотправленных данных
+    size_t maxOutstanding;          // Наибольшая оценка неотправленных данных
+    unsigned long overBudgetSince;  // Начало превышения бюджета (0 - в пределах)
+    uint32_t messages;              // Отправлено сообщений
+    uint32_t bytes;                 // Отправлено байт
+    uint32_t coalesced;             // Пропущено статусов (клиент получит следующий)
+    uint32_t dropped;               // Отброшено уведомлений и записей журнала
+};
+
+static WsClientState clients[WS_MAX_CLIENTS];
+static uint32_t stalledDisconnects = 0;
+static uint32_t rejectedClients = 0;
+
+// Доступ из задачи управления, задачи журнала и задачи AsyncTCP
+static SemaphoreHandle_t clientsMutex = NULL;
+
+static bool lockClients() {
+    return clientsMutex == NULL || xSemaphoreTake(clientsMutex, pdMS_TO_TICKS(20)) == pdTRUE;
+}
+
+static void unlockClients() {
+    if (clientsMutex != NULL) {
+        xSemaphoreGive(clientsMutex);
+    }
+}
+
+static WsClientState* findClient(uint32_t id) {
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (clients[i].id == id) {
+            return &clients[i];
+        }
+    }
+    return nullptr;
+}
+
+// Оценка неотправленных данных клиента
+static size_t outstandingBytes(WsClientState& state, AsyncWebSocketClient *client) {
+    AsyncClient* tcp = client->client();
+    size_t space = tcp != nullptr ? tcp->space() : 0;
+    if (space > state.maxSpace) {
+        state.maxSpace = space;
+    }
+
+    // Библиотека переносит очередь в TCP по мере подтверждений: если в буфере
+    // TCP есть место для сообщения, очередь библиотеки уже пуста
+    if (space >= state.lastLength) {
+        state.backlog = 0;
+    }
+
+    size_t outstanding = (state.maxSpace - space) + state.backlog;
+    state.outstanding = outstanding;
+    if (outstanding > state.maxOutstanding) {
+        state.maxOutstanding = outstanding;
+    }
+    return outstanding;
+}
+
+// Отправка с учетом бюджета; вызывается под блокировкой
+static bool sendToClient(WsClientState& state, AsyncWebSocketClient *client,
+                         const char* data, size_t length, WsMessageKind kind) {
+    if (client->status() != WS_CONNECTED) {
+        return false;
+    }
+
+    size_t outstanding = outstandingBytes(state, client);
+    bool overBudget = outstanding + length > WS_CLIENT_BUDGET_BYTES || client->queueIsFull();
+
+    if (overBudget) {
+        if (state.overBudgetSince == 0) {
+            state.overBudgetSince = millis();
+        }
+        // Ответ RPC отправляется, пока очередь библиотеки не заполнена
+        if (kind != WS_MESSAGE_REPLY || client->queueIsFull()) {
+            if (kind == WS_MESSAGE_STATUS) {
+                state.coalesced++;
+            } else {
+                state.dropped++;
+            }
+            return false;
+        }
+    } else {
+        state.overBudgetSince = 0;
+    }
+
+    AsyncClient* tcp = client->client();
+    if (tcp == nullptr || tcp->space() < length) {
+        state.backlog += length;
+    }
+    state.lastLength = length;
+    state.messages++;
+    state.bytes += length;
+    client->text(data, length);
+    return true;
+}
+
+// Инициализация учета клиентов
+void initWsBroadcast() {
+    if (clientsMutex == NULL) {
+        clientsMutex = xSemaphoreCreateMutex();
+    }
+}
+
+// Регистрация подключившегося клиента
+bool wsClientConnected(AsyncWebSocketClient *client) {
+    if (!lockClients()) {
+        return false;
+    }
+    WsClientState* state = findClient(0);
+    if (state != nullptr) {
+        memset(state, 0, sizeof(WsClientState));
+        state->id = client->id();
+        state->ip = (uint32_t)client->remoteIP();
+    } else {
+        rejectedClients++;
+    }
+    unlockClients();
+    return state != nullptr;
+}
+
+// Удаление отключившегося клиента
+void wsClientDisconnected(uint32_t id) {
+    if (!lockClients()) {
+        return;
+    }
+    WsClientState* state = findClient(id);
+    if (state != nullptr) {
+        state->id = 0;
+    }
+    unlockClients();
+}
+
+// Рассылка сообщения всем клиентам
+void wsBroadcast(AsyncWebSocket& ws, const char* data, size_t length, WsMessageKind kind) {
+    if (!lockClients()) {
+        return;
+    }
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (clients[i].id == 0) {
+            continue;
+        }
+        AsyncWebSocketClient *client = ws.client(clients[i].id);
+        if (client != nullptr) {
+            sendToClient(clients[i], client, data, length, kind);
+        }
+    }
+    unlockClients();
+}
+
+// Отправка сообщения одному клиенту
+bool wsSend(AsyncWebSocketClient *client, const char* data, size_t length, WsMessageKind kind) {
+    if (!lockClients()) {
+        return false;
+    }
+    WsClientState* state = findClient(client->id());
+    bool sent = state != nullptr && sendToClient(*state, client, data, length, kind);
+    unlockClients();
+    return sent;
+}
+
+// Отключение клиентов, очередь которых не уходит дольше допустимого
+void checkWsClients(AsyncWebSocket& ws) {
+    uint32_t stalled[WS_MAX_CLIENTS];
+    int stalledCount = 0;
+
+    if (!lockClients()) {
+        return;
+    }
+    unsigned long now = millis();
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        WsClientState& state = clients[i];
+        if (state.id == 0) {
+            continue;
+        }
+        AsyncWebSocketClient *client = ws.client(state.id);
+        if (client == nullptr) {
+            // Событие отключения не дошло до таблицы - место освобождается здесь
+            state.id = 0;
+            continue;
+        }
+
+        // Очередь могла освободиться без новых отправок
+        if (state.overBudgetSince != 0 && !client->queueIsFull() &&
+            outstandingBytes(state, client) <= WS_CLIENT_BUDGET_BYTES / 2) {
+            state.overBudgetSince = 0;
+        }
+
+        if (state.overBudgetSince != 0 && now - state.overBudgetSince >= WS_CLIENT_STALL_MS) {
+            logRecord(EV_WS_CLIENT_STALLED, state.id, outstandingBytes(state, client),
+                      (now - state.overBudgetSince) / 1000);
+            stalledDisconnects++;
+            state.overBudgetSince = 0;
+            stalled[stalledCount++] = state.id;
+        }
+    }
+    unlockClients();
+
+    // Кадр закрытия WebSocket не уйдет через заполненную очередь, поэтому
+    // соединение TCP закрывается сразу. Закрытие вызывает событие отключения,
+    // которое берет блокировку, поэтому выполняется после ее освобождения.
+    for (int i = 0; i < stalledCount; i++) {
+        AsyncWebSocketClient *client = ws.client(stalled[i]);
+        if (client != nullptr && client->client() != nullptr) {
+            client->client()->close(true);
+        }
+    }
+}
+
+// Показатели очередей клиентов
+void writeWsClientStats(JsonWriter& json) {
+    json.beginObject();
+    json.add("budget", WS_CLIENT_BUDGET_BYTES);
+    json.add("stalledDisconnects", stalledDisconnects);
+    json.add("rejected", rejectedClients);
+    json.beginArray("clients");
+    if (lockClients()) {
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            const WsClientState& state = clients[i];
+            if (state.id == 0) {
+                continue;
+            }
+            char ip[16];
+            snprintf(ip, sizeof(ip), "%u.%u.%u.%u", (unsigned)(state.ip & 0xFF), (unsigned)((state.ip >> 8) & 0xFF),
+                     (unsigned)((state.ip >> 16) & 0xFF), (unsigned)(state.ip >> 24));
+            json.beginObject();
+            json.add("id", state.id);
+            json.add("ip", ip);
+            json.add("messages", state.messages);
+            json.add("bytes", state.bytes);
+            json.add("coalesced", state.coalesced);
+            json.add("dropped", state.dropped);
+            json.add("backlog", state.backlog);
+            json.add("maxOutstanding", state.maxOutstanding);
+            json.add("overBudgetMs", state.overBudgetSince != 0 ? millis() - state.overBudgetSince : 0UL);
+            json.endObject();
+        }
+        unlockClients();
+    }
+    json.endArray();
+    json.endObject();
+}
+
+// Сводные показатели рассылки
+WsBroadcastStats getWsBroadcastStats() {
+    WsBroadcastStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.stalledDisconnects = stalledDisconnects;
+    if (lockClients()) {
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            const WsClientState& state = clients[i];
+            if (state.id == 0) {
+                continue;
+            }
+            stats.clients++;
+            stats.queuedBytes += state.outstanding;
+            if (state.outstanding > stats.maxQueuedBytes) {
+                stats.maxQueuedBytes = state.outstanding;
+            }
+            stats.coalesced += state.coalesced;
+            stats.dropped += state.dropped;
+        }
+        unlockClients();
+    }
+    return stats;
+}
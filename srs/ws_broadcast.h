@@ -0,0 +1,89 @@
+/**
+ * @file ws_broadcast.h
+ * @brief Рассылка WebSocket с учетом очереди каждого клиента
+ *
+ * Для каждого клиента оценивается объем неотправленных данных: занятая
+ * часть буфера передачи TCP плюс сообщения, переданные библиотеке, когда
+ * места в буфере TCP не было. Пока оценка не превышает бюджет
+ * WS_CLIENT_BUDGET_BYTES, сообщения отправляются как обычно. Клиенту сверх
+ * бюджета статус не ставится в очередь: он получит следующий статус, когда
+ * очередь освободится (актуальное значение вместо истории), а уведомления и
+ * записи журнала для него отбрасываются. Клиент, остающийся сверх бюджета
+ * дольше WS_CLIENT_STALL_MS, отключается.
+ */
+
+#ifndef WS_BROADCAST_H
+#define WS_BROADCAST_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "config.h"
+
+class JsonWriter;
+
+// Вид сообщения определяет поведение при превышении бюджета
+enum WsMessageKind {
+    WS_MESSAGE_STATUS,      // Периодический статус: пропускается, придет следующий
+    WS_MESSAGE_EVENT,       // Уведомление, запись журнала: отбрасывается
+    WS_MESSAGE_REPLY        // Ответ RPC: отправляется, пока не заполнена очередь библиотеки
+};
+
+// Сводные показатели рассылки
+struct WsBroadcastStats {
+    uint32_t clients;               // Подключенных клиентов
+    uint32_t queuedBytes;           // Сумма оценок неотправленных данных (байт)
+    uint32_t maxQueuedBytes;        // Наибольшая оценка среди клиентов (байт)
+    uint32_t coalesced;             // Пропущено статусов
+    uint32_t dropped;               // Отброшено уведомлений и записей журнала
+    uint32_t stalledDisconnects;    // Отключено зависших клиентов
+};
+
+/**
+ * @brief Инициализация учета клиентов
+ */
+void initWsBroadcast();
+
+/**
+ * @brief Регистрация подключившегося клиента
+ *
+ * @return false если все места в таблице клиентов заняты (клиент отключается)
+ */
+bool wsClientConnected(AsyncWebSocketClient *client);
+
+/**
+ * @brief Удаление отключившегося клиента
+ */
+void wsClientDisconnected(uint32_t id);
+
+/**
+ * @brief Рассылка сообщения всем клиентам с учетом бюджета
+ */
+void wsBroadcast(AsyncWebSocket& ws, const char* data, size_t length, WsMessageKind kind);
+
+/**
+ * @brief Отправка сообщения одному клиенту с учетом бюджета
+ *
+ * @return true если сообщение поставлено в очередь
+ */
+bool wsSend(AsyncWebSocketClient *client, const char* data, size_t length, WsMessageKind kind);
+
+/**
+ * @brief Проверка клиентов: отключение зависших
+ *
+ * Вызывается периодически из цикла рассылки.
+ */
+void checkWsClients(AsyncWebSocket& ws);
+
+/**
+ * @brief Запись показателей очередей клиентов (массив объектов)
+ */
+void writeWsClientStats(JsonWriter& json);
+
+/**
+ * @brief Получение сводных показателей рассылки
+ *
+ * Оценка очереди - последняя, снятая при отправке или проверке клиентов.
+ */
+WsBroadcastStats getWsBroadcastStats();
+
+#endif // WS_BROADCAST_H